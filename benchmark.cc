@@ -29,10 +29,28 @@
 #include <sys/time.h>
 #endif
 
+#if defined(__linux) || defined(__MACH__)
+#include <sys/utsname.h>
+#endif
+
 #if defined(__MACH__)
 #include <mach/mach_time.h>
 #endif
 
+/* Use the time stamp counter to sample single operations */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define USE_RDTSC
+#endif
+
+/* Use the Linux performance counters */
+#if defined(__linux)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#define USE_PERF
+#endif
+
 /* Judy available on in x86 */
 #if defined(_WIN32)
 #include <windows.h>
@@ -59,6 +77,121 @@
 /* Tommy data structures */
 /* We directly include the C file to have functions automatically */
 /* expanded inline by the compiler like other implementations */
+/* With -P Tommy allocations are counted to get the high-water mark */
+/* of the memory used, including the transient peaks in resizes */
+/* Without it, they go directly to the allocator, like the other implementations */
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+int the_alloc_count; /**< If the Tommy allocations are counted. Set only at startup. */
+size_t the_alloc_size; /**< Memory allocated by Tommy. */
+size_t the_alloc_peak; /**< Max memory allocated by Tommy since the last reset. */
+
+#if defined(__GLIBC__)
+/* the allocation size is the real one, including the allocator slack */
+#define COUNT_HEADER 0
+#else
+/* the allocation size is stored before the allocation, keeping the alignment */
+#define COUNT_HEADER 16
+#endif
+
+void* count_alloc(void* ptr, size_t size)
+{
+	if (!ptr)
+		return 0;
+
+#if COUNT_HEADER
+	*(size_t*)ptr = size;
+	ptr = (char*)ptr + COUNT_HEADER;
+#else
+	(void)size;
+	size = malloc_usable_size(ptr);
+#endif
+
+	the_alloc_size += size;
+	if (the_alloc_size > the_alloc_peak)
+		the_alloc_peak = the_alloc_size;
+
+	return ptr;
+}
+
+void* count_release(void* ptr)
+{
+	if (!ptr)
+		return 0;
+
+#if COUNT_HEADER
+	ptr = (char*)ptr - COUNT_HEADER;
+	the_alloc_size -= *(size_t*)ptr;
+#else
+	the_alloc_size -= malloc_usable_size(ptr);
+#endif
+
+	return ptr;
+}
+
+inline void* count_malloc(size_t size)
+{
+	if (!the_alloc_count)
+		return malloc(size);
+
+	return count_alloc(malloc(size + COUNT_HEADER), size);
+}
+
+inline void* count_calloc(size_t count, size_t size)
+{
+	if (!the_alloc_count)
+		return calloc(count, size);
+
+	/* check the overflow, like calloc() */
+	if (size != 0 && count > (SIZE_MAX - COUNT_HEADER) / size)
+		return 0;
+
+	return count_alloc(calloc(1, count * size + COUNT_HEADER), count * size);
+}
+
+inline void* count_realloc(void* ptr, size_t size)
+{
+	void* base;
+	void* result;
+
+	if (!the_alloc_count)
+		return realloc(ptr, size);
+
+	if (!ptr)
+		return count_malloc(size);
+
+	base = count_release(ptr);
+	result = realloc(base, size + COUNT_HEADER);
+	if (!result) {
+		/* the old allocation is still valid, count it again */
+#if COUNT_HEADER
+		count_alloc(base, *(size_t*)base);
+#else
+		count_alloc(base, 0);
+#endif
+		return 0;
+	}
+
+	return count_alloc(result, size);
+}
+
+inline void count_free(void* ptr)
+{
+	if (!the_alloc_count) {
+		free(ptr);
+		return;
+	}
+
+	free(count_release(ptr));
+}
+
+#define tommy_malloc count_malloc
+#define tommy_calloc count_calloc
+#define tommy_realloc count_realloc
+#define tommy_free count_free
+
 #include "tommyds/tommy.h"
 #include "tommyds/tommy.c"
 
@@ -72,6 +205,17 @@
 #include <unordered_map>
 #endif
 
+/* C++ Strings for the string key test */
+#include <string>
+
+/* C++ Threads for the throughput test */
+#ifdef __cplusplus
+#include <thread>
+#include <mutex>
+#include <atomic>
+#define USE_THROUGHPUT
+#endif
+
 /* Google C dense hash table */
 /* http://code.google.com/p/google-sparsehash/ in the experimental/ directory */
 /* Disabled by default because it's superseeded by the C++ version. */
@@ -256,6 +400,26 @@ struct hashtable_object {
 	char payload[PAYLOAD];
 };
 
+struct hashtablec_object {
+	tommy_cnode node;
+	unsigned value;
+	char payload[PAYLOAD];
+};
+
+struct string_object {
+	tommy_node node;
+	const char* str;
+	size_t len;
+	char payload[PAYLOAD];
+};
+
+struct stringc_object {
+	tommy_cnode node;
+	const char* str;
+	size_t len;
+	char payload[PAYLOAD];
+};
+
 struct uthash_object {
 	UT_hash_handle hh;
 	unsigned value;
@@ -325,10 +489,19 @@ struct ck_object {
 	char payload[PAYLOAD];
 };
 
+struct mphf_object {
+	unsigned value;
+	char payload[PAYLOAD];
+};
+
 struct rbt_object* RBTREE;
 struct hashtable_object* HASHTABLE;
 struct hashtable_object* HASHDYN;
 struct hashtable_object* HASHLIN;
+struct hashtablec_object* HASHDYNC;
+struct hashtablec_object* HASHLINC;
+struct mphf_object* MPHF;
+tommy_uint64_t* MPHF_KEY;
 struct trie_object* TRIE;
 struct trie_inplace_object* TRIE_INPLACE;
 struct khash_object* KHASH;
@@ -450,6 +623,39 @@ int tommy_hashtable_compare(const void* void_arg, const void* void_obj)
 	return 1;
 }
 
+int tommy_hashtablec_compare(const void* void_arg, const void* void_obj)
+{
+	const unsigned* arg = (const unsigned*)void_arg;
+	const struct hashtablec_object* obj = (const struct hashtablec_object*)void_obj;
+
+	if (*arg == obj->value)
+		return 0;
+
+	return 1;
+}
+
+int tommy_string_compare(const void* void_arg, const void* void_obj)
+{
+	const std::string* arg = (const std::string*)void_arg;
+	const struct string_object* obj = (const struct string_object*)void_obj;
+
+	if (arg->size() == obj->len && memcmp(arg->data(), obj->str, obj->len) == 0)
+		return 0;
+
+	return 1;
+}
+
+int tommy_stringc_compare(const void* void_arg, const void* void_obj)
+{
+	const std::string* arg = (const std::string*)void_arg;
+	const struct stringc_object* obj = (const struct stringc_object*)void_obj;
+
+	if (arg->size() == obj->len && memcmp(arg->data(), obj->str, obj->len) == 0)
+		return 0;
+
+	return 1;
+}
+
 typedef rbt(struct rbt_object) rbtree_t;
 
 rb_gen(static, rbt_, rbtree_t, struct rbt_object, link, rbt_compare)
@@ -464,17 +670,22 @@ static size_t nedtrie_func(const struct nedtrie_object* r)
 NEDTRIE_GENERATE(static, nedtrie_t, nedtrie_object, link, nedtrie_func, NEDTRIE_NOBBLEZEROS(nedtrie_t));
 
 KHASH_MAP_INIT_INT(word, struct khash_object*)
+KHASH_MAP_INIT_STR(str, struct string_object*)
 
 rbtree_t tree;
 tommy_hashtable hashtable;
 tommy_hashdyn hashdyn;
 tommy_hashlin hashlin;
+tommy_hashdync hashdync;
+tommy_hashlinc hashlinc;
+tommy_mphf mphf;
 tommy_allocator trie_allocator;
 tommy_trie trie;
 tommy_trie_inplace trie_inplace;
 struct uthash_object* uthash = 0;
 struct nedtrie_t nedtrie;
 khash_t(word)* khash;
+khash_t(str)* khstring;
 #ifdef __cplusplus
 /* use a specialized hash, otherwise the performance depends on the STL implementation used. */
 class cpp_hash {
@@ -489,6 +700,8 @@ cppmap_t* cppmap;
 #ifdef USE_CPPUNORDEREDMAP
 typedef std::unordered_map<unsigned, struct cpp_object*, cpp_hash> cppunorderedmap_t;
 cppunorderedmap_t* cppunorderedmap;
+typedef std::unordered_map<std::string, struct string_object*> cppstringmap_t;
+cppstringmap_t* cppstringmap;
 #endif
 #ifdef USE_GOOGLELIBCHASH
 struct HashTable* googlelibhash;
@@ -590,6 +803,18 @@ static tommy_uint64_t nano(void)
 	return ret;
 }
 
+/**
+ * Ticks of the fast counter used to sample single operations.
+ */
+static tommy_uint64_t tick(void)
+{
+#if defined(USE_RDTSC)
+	return __rdtsc();
+#else
+	return nano();
+#endif
+}
+
 /******************************************************************************/
 /* random */
 
@@ -657,7 +882,9 @@ loop:
 #define OPERATION_SIZE 3
 #define OPERATION_CHANGE 4
 #define OPERATION_REMOVE 5
-#define OPERATION_MAX 6
+#define OPERATION_PEAK 6
+#define OPERATION_RSS 7
+#define OPERATION_MAX 8
 
 const char* OPERATION_NAME[OPERATION_MAX] = {
 	"insert",
@@ -666,6 +893,57 @@ const char* OPERATION_NAME[OPERATION_MAX] = {
 	"size",
 	"change",
 	"remove",
+	"peak",
+	"rss",
+};
+
+/**
+ * Latency percentiles.
+ */
+#define PERCENTILE_50 0
+#define PERCENTILE_90 1
+#define PERCENTILE_99 2
+#define PERCENTILE_999 3
+#define PERCENTILE_MAX_VALUE 4
+#define PERCENTILE_MAX 5
+
+const char* PERCENTILE_NAME[PERCENTILE_MAX] = {
+	"p50",
+	"p90",
+	"p99",
+	"p999",
+	"max",
+};
+
+/**
+ * Fraction of the operations of each percentile, in 1/1000.
+ */
+const unsigned PERCENTILE_FRACTION[PERCENTILE_MAX] = {
+	500,
+	900,
+	990,
+	999,
+	1000,
+};
+
+/**
+ * Hardware performance counters.
+ */
+#define COUNTER_CYCLE 0
+#define COUNTER_INSTRUCTION 1
+#define COUNTER_L1D 2
+#define COUNTER_LLC 3
+#define COUNTER_DTLB 4
+#define COUNTER_BRANCH 5
+#define COUNTER_MAX 6
+
+const char* COUNTER_NAME[COUNTER_MAX] = {
+	"cycle",
+	"instruction",
+	"l1d",
+	"llc",
+	"dtlb",
+	"branch",
 };
 
 /**
@@ -673,11 +951,19 @@ const char* OPERATION_NAME[OPERATION_MAX] = {
  */
 #define ORDER_FORWARD 0
 #define ORDER_RANDOM 1
-#define ORDER_MAX 2
+#define ORDER_ZIPF 2 /**< Random, with Zipf distributed searches. */
+#define ORDER_HOTSPOT 3 /**< Random, with 80% of the searches in 20% of the keys. */
+#define ORDER_LATEST 4 /**< Random, with Zipf distributed searches biased to the last inserted keys. */
+#define ORDER_TRACE 5 /**< Random, with the searches replayed from a trace file. */
+#define ORDER_MAX 6
 
 const char* ORDER_NAME[ORDER_MAX] = {
 	"forward",
 	"random",
+	"zipf",
+	"hotspot",
+	"latest",
+	"trace",
 };
 
 /**
@@ -709,7 +995,10 @@ const char* ORDER_NAME[ORDER_MAX] = {
 #ifdef USE_CK
 #define DATA_CK 19
 #endif
-#define DATA_MAX 20
+#define DATA_MPHF 20
+#define DATA_HASHDYNC 21
+#define DATA_HASHLINC 22
+#define DATA_MAX 23
 
 const char* DATA_NAME[DATA_MAX] = {
 	"tommy-hashtable",
@@ -732,6 +1021,9 @@ const char* DATA_NAME[DATA_MAX] = {
 	"libdynamic",
 	"googlelibchash",
 	"concurrencykit",
+	"tommy-mphf",
+	"tommy-hashdync",
+	"tommy-hashlinc",
 };
 
 /** 
@@ -739,6 +1031,16 @@ const char* DATA_NAME[DATA_MAX] = {
  */
 unsigned LOG[RETRY_MAX][DATA_MAX][ORDER_MAX][OPERATION_MAX];
 
+/**
+ * Logged latency percentiles.
+ */
+unsigned LAT[RETRY_MAX][DATA_MAX][ORDER_MAX][OPERATION_MAX][PERCENTILE_MAX];
+
+/**
+ * Logged counters, as events for operation.
+ */
+double CNT[RETRY_MAX][DATA_MAX][ORDER_MAX][OPERATION_MAX][COUNTER_MAX];
+
 /**
  * Time limit in nanosecond. 
  * We stop measuring degenerated cases after this limit.
@@ -761,6 +1063,8 @@ unsigned the_order; /**< Order in test. */
 unsigned the_max; /**< Number of elements in test. */
 tommy_uint64_t the_time; /**< Start time of the test. */
 unsigned the_start_data; /**< Saved data structure in the last START command, simply to avoid to repeat it for STOP. */
+unsigned the_period; /**< Period of the sampled operations for the latency, 0 if disabled. */
+unsigned the_string; /**< Hash function used with string keys, 0 if using integer keys. */
 
 /**
  * Control flow state.
@@ -787,625 +1091,2686 @@ tommy_bool_t is_select(unsigned data)
 	return the_data == data;
 }
 
-tommy_bool_t start(unsigned data)
+/**
+ * If the operation measures the memory and not the time.
+ */
+tommy_bool_t is_memory(unsigned operation)
 {
-	the_start_data = data;
-
-	if (!is_select(the_start_data))
-		return 0;
-
-	if (!the_log)
-		printf("%10s, %10s, %12s, ", ORDER_NAME[the_order], OPERATION_NAME[the_operation], DATA_NAME[data]);
-
-	the_time = nano();
-	return 1;
+	return operation == OPERATION_SIZE || operation == OPERATION_PEAK || operation == OPERATION_RSS;
 }
 
-void stop(void)
+/******************************************************************************/
+/* latency */
+
+/**
+ * Latency histogram with logarithmic buckets, each one divided in linear sub-buckets,
+ * like HDR histograms. Values are stored with a precision of 1/HIST_SUB.
+ */
+#define HIST_SUB_BIT 4
+#define HIST_SUB (1U << HIST_SUB_BIT)
+#define HIST_MAX ((64 - HIST_SUB_BIT + 1) * HIST_SUB)
+
+tommy_uint64_t HIST[HIST_MAX]; /**< Number of samples in each bucket. */
+tommy_uint64_t the_hist_count; /**< Number of samples. */
+tommy_uint64_t the_hist_max; /**< Max sample. */
+tommy_uint64_t the_sample_bias; /**< Ticks spent to take a sample, subtracted from each one. */
+tommy_uint64_t the_sample_time; /**< Start tick of the sampled operation. */
+double the_tick_per_ns; /**< Ticks for each nanosecond. */
+tommy_bool_t the_sample_run; /**< If the current segment is a sampled operation. */
+tommy_bool_t the_sample_next; /**< If the next segment is a sampled operation. */
+unsigned the_begin; /**< Begin of the current segment of operations. */
+unsigned the_end; /**< End of the current segment of operations. */
+
+unsigned hist_index(tommy_uint64_t v)
 {
-	tommy_uint64_t elapsed = nano() - the_time;
+	unsigned e;
 
-	if (!is_select(the_start_data))
-		return;
+	if (v < HIST_SUB)
+		return (unsigned)v;
 
-	if (!the_log) {
-		printf("%4u [ns]\n", (unsigned)(elapsed / the_max));
-	} 
+	if (v >> 32)
+		e = 32 + tommy_ilog2_u32((tommy_uint32_t)(v >> 32));
+	else
+		e = tommy_ilog2_u32((tommy_uint32_t)v);
 
-	LOG[the_retry][the_data][the_order][the_operation] = (unsigned)(elapsed / the_max);
+	return (e - HIST_SUB_BIT + 1) * HIST_SUB + (unsigned)((v >> (e - HIST_SUB_BIT)) & (HIST_SUB - 1));
 }
 
-void mem(unsigned data, tommy_size_t v)
+/**
+ * Highest value stored in the bucket.
+ */
+tommy_uint64_t hist_value(unsigned index)
 {
-	if (!the_log) {
-		printf("%10s, %10s, %12s, ", ORDER_NAME[the_order], OPERATION_NAME[the_operation], DATA_NAME[data]);
-		printf("%4u [byte]\n", (unsigned)(v / the_max));
-	} 
+	unsigned e;
 
-	LOG[the_retry][the_data][the_order][the_operation] = (unsigned)(v / the_max);
-}
+	if (index < HIST_SUB)
+		return index;
 
-#define COND(s) if (is_select(s))
-#define START(s) if (start(s)) for(i=0;i<the_max;++i)
-#define STOP() stop()
-#define MEM(s, v) if (is_select(s)) mem(s, v)
-#define OPERATION(operation) the_operation = operation
-#define ORDER(order) the_order = order
-#define DATA(data) the_data = data
+	e = index / HIST_SUB + HIST_SUB_BIT - 1;
 
-FILE* open(const char* mode)
-{
-	char buf[128];
-	sprintf(buf, "dat_%s_%s.lst", ORDER_NAME[the_order], OPERATION_NAME[the_operation]);
-	return fopen(buf, mode);
+	return (((tommy_uint64_t)(HIST_SUB + index % HIST_SUB) + 1) << (e - HIST_SUB_BIT)) - 1;
 }
 
-/******************************************************************************/
-/* test */
-
-/**
- * Cache clearing buffer.
- */
-unsigned char CACHE[8*1024*1024];
+void hist_reset(void)
+{
+	memset(HIST, 0, sizeof(HIST));
+	the_hist_count = 0;
+	the_hist_max = 0;
+}
 
-void cache_clear(void)
+tommy_uint64_t hist_percentile(unsigned fraction)
 {
+	tommy_uint64_t target;
+	tommy_uint64_t sum;
 	unsigned i;
 
-	/* read & write */
-	for(i=0;i<sizeof(CACHE);i += 32)
-		CACHE[i] += 1;
+	if (fraction == 1000)
+		return the_hist_max;
 
-#ifdef WIN32
-	Sleep(0);
-#endif
-}
+	/* number of samples that must be lower or equal */
+	target = (the_hist_count * fraction + 999) / 1000;
 
-/**
- * Different orders used.
- */ 
-unsigned* FORWARD;
-unsigned* RAND0;
-unsigned* RAND1;
+	sum = 0;
+	for(i=0;i<HIST_MAX;++i) {
+		sum += HIST[i];
+		if (sum >= target && sum != 0)
+			break;
+	}
 
-void order_init(int max, int sparse)
-{
-	int i;
+	if (i == HIST_MAX)
+		return the_hist_max;
 
-	FORWARD = (unsigned*)malloc(max * sizeof(unsigned));
-	RAND0 = (unsigned*)malloc(max * sizeof(unsigned));
-	RAND1 = (unsigned*)malloc(max * sizeof(unsigned));
+	/* the bucket value cannot be more than the real max */
+	if (hist_value(i) > the_hist_max)
+		return the_hist_max;
 
-	/* generated forward orders */
-	if (sparse) {
-		for(i=0;i<max;++i) {
-			FORWARD[i] = 0xffffffff / max * i;
-			RAND0[i] = FORWARD[i];
-			RAND1[i] = FORWARD[i];
-		}
-	} else {
-		for(i=0;i<max;++i) {
-			FORWARD[i] = 0x80000000 + i * 2;
-			RAND0[i] = FORWARD[i];
-			RAND1[i] = FORWARD[i];
-		}
-	}
+	return hist_value(i);
+}
 
-	/* randomize using the Fisher-Yates shuffle, http://en.wikipedia.org/wiki/Fisher-Yates_shuffle */
-	for(i=max-1;i>=0;--i) {
-		unsigned j, t;
-		j = rnd(i+1);
-		t = RAND0[i];
-		RAND0[i] = RAND0[j];
-		RAND0[j] = t;
+/**
+ * Calibrates the ticks, and measures the ticks spent to take a sample.
+ */
+void sample_init(void)
+{
+	tommy_uint64_t begin_nano;
+	tommy_uint64_t begin_tick;
+	tommy_uint64_t elapsed_nano;
+	unsigned i;
 
-		j = rnd(i+1);
-		t = RAND1[i];
-		RAND1[i] = RAND1[j];
-		RAND1[j] = t;
+	/* count the ticks in 10 ms */
+	begin_nano = nano();
+	begin_tick = tick();
+	do {
+		elapsed_nano = nano() - begin_nano;
+	} while (elapsed_nano < 10000000);
+	the_tick_per_ns = (double)(tick() - begin_tick) / elapsed_nano;
+
+	the_sample_bias = (tommy_uint64_t)-1;
+	for(i=0;i<1000;++i) {
+		tommy_uint64_t begin = tick();
+		tommy_uint64_t elapsed = tick() - begin;
+		if (elapsed < the_sample_bias)
+			the_sample_bias = elapsed;
 	}
 }
 
-void order_done(void)
+/**
+ * Stores the time of a sampled operation in the histogram.
+ */
+void sample_store(tommy_uint64_t elapsed)
 {
-	free(FORWARD);
-	free(RAND0);
-	free(RAND1); 
+	if (elapsed > the_sample_bias)
+		elapsed -= the_sample_bias;
+	else
+		elapsed = 0;
+
+	++HIST[hist_index(elapsed)];
+	++the_hist_count;
+	if (elapsed > the_hist_max)
+		the_hist_max = elapsed;
 }
 
-void test_alloc(void)
+/**
+ * Moves to the next segment of operations.
+ * Operations are split in segments, to keep the loop running them
+ * unchanged, and without any overhead when not sampling.
+ * When sampling, a segment with a single sampled operation is followed by
+ * a segment with the other operations of the period.
+ * \return 0 when all the operations are done.
+ */
+tommy_bool_t segment(void)
 {
-	COND(DATA_TREE) {
-		rbt_new(&tree);
-		RBTREE = (struct rbt_object*)malloc(sizeof(struct rbt_object) * the_max);
+	if (the_sample_run) {
+		sample_store(tick() - the_sample_time);
+		the_sample_run = 0;
 	}
 
-	COND(DATA_HASHTABLE) {
-		tommy_hashtable_init(&hashtable, 2 * the_max);
-		HASHTABLE = (struct hashtable_object*)malloc(sizeof(struct hashtable_object) * the_max);
+	if (the_end >= the_max)
+		return 0;
+
+	the_begin = the_end;
+
+	if (!the_period) {
+		the_end = the_max;
+		return 1;
 	}
 
-	COND(DATA_HASHDYN) {
-		tommy_hashdyn_init(&hashdyn);
-		HASHDYN = (struct hashtable_object*)malloc(sizeof(struct hashtable_object) * the_max);
+	if (the_sample_next) {
+		the_end = the_begin + 1;
+		the_sample_next = 0;
+		the_sample_run = 1;
+		the_sample_time = tick();
+		return 1;
 	}
 
-	COND(DATA_HASHLIN) {
-		tommy_hashlin_init(&hashlin);
-		HASHLIN = (struct hashtable_object*)malloc(sizeof(struct hashtable_object) * the_max);
-	}
-
-	COND(DATA_TRIE) {
-		tommy_allocator_init(&trie_allocator, TOMMY_TRIE_BLOCK_SIZE, TOMMY_TRIE_BLOCK_SIZE);
-		tommy_trie_init(&trie, &trie_allocator);
-		TRIE = (struct trie_object*)malloc(sizeof(struct trie_object) * the_max);
-	}
+	the_end = the_begin + the_period - 1;
+	if (the_end > the_max)
+		the_end = the_max;
+	the_sample_next = 1;
+	return 1;
+}
 
-	COND(DATA_TRIE_INPLACE) {
-		tommy_trie_inplace_init(&trie_inplace);
-		TRIE_INPLACE = (struct trie_inplace_object*)malloc(sizeof(struct trie_inplace_object) * the_max);
-	}
+/******************************************************************************/
+/* counter */
 
-	COND(DATA_KHASH) {
-		KHASH = (struct khash_object*)malloc(sizeof(struct khash_object) * the_max);
-		khash = kh_init(word);
-	}
+tommy_bool_t the_counter; /**< If the hardware performance counters are read. */
 
-#ifdef USE_GOOGLELIBCHASH
-	COND(DATA_GOOGLELIBCHASH) {
-		GOOGLELIBCHASH = (struct google_object*)malloc(sizeof(struct google_object) * the_max);
-		googlelibhash = AllocateHashTable(sizeof(void*), 0);
-	}
-#endif
+/**
+ * Descriptors of the opened counters, -1 if not available.
+ */
+int COUNTER_FD[COUNTER_MAX];
 
-#ifdef USE_GOOGLEDENSEHASH
-	COND(DATA_GOOGLEDENSEHASH) {
-		GOOGLEDENSEHASH = (struct google_object*)malloc(sizeof(struct google_object) * the_max);
-		googledensehash = new googledensehash_t;
-		googledensehash->set_empty_key(-1);
-		googledensehash->set_deleted_key(-2);
-	}
-#endif
+#ifdef USE_PERF
+/**
+ * Type and configuration of the counters for perf_event_open().
+ */
+#define PERF_CACHE_MISS(cache) ((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16))
+
+const tommy_uint32_t COUNTER_TYPE[COUNTER_MAX] = {
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HARDWARE,
+	PERF_TYPE_HW_CACHE,
+	PERF_TYPE_HW_CACHE,
+	PERF_TYPE_HW_CACHE,
+	PERF_TYPE_HARDWARE,
+};
 
-#ifdef USE_GOOGLEBTREE
-	COND(DATA_GOOGLEBTREE) {
-		GOOGLEBTREE = (struct google_object*)malloc(sizeof(struct google_object) * the_max);
-		googlebtree = new googlebtree_t;
-	}
-#endif
+const tommy_uint64_t COUNTER_CONFIG[COUNTER_MAX] = {
+	PERF_COUNT_HW_CPU_CYCLES,
+	PERF_COUNT_HW_INSTRUCTIONS,
+	PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_L1D),
+	PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_LL),
+	PERF_CACHE_MISS(PERF_COUNT_HW_CACHE_DTLB),
+	PERF_COUNT_HW_BRANCH_MISSES,
+};
 
-#ifdef USE_STXBTREE
-	COND(DATA_STXBTREE) {
-		STX = (struct stx_object*)malloc(sizeof(struct stx_object) * the_max);
-		stxbtree = new stxbtree_t;
-	}
+int counter_open(unsigned counter)
+{
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = COUNTER_TYPE[counter];
+	attr.config = COUNTER_CONFIG[counter];
+	attr.disabled = 1;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+	/* the counters are opened separately, and they may be multiplexed */
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	return (int)syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+}
 #endif
 
-#ifdef USE_CPPMAP
-	COND(DATA_CPPMAP) {
-		CPP = (struct cpp_object*)malloc(sizeof(struct cpp_object) * the_max);
-		cppmap = new cppmap_t;
-	}
+/**
+ * Opens the counters.
+ * \return 0 if no counter is available.
+ */
+tommy_bool_t counter_init(void)
+{
+	tommy_bool_t any = 0;
+	unsigned c;
+
+	for(c=0;c<COUNTER_MAX;++c) {
+#ifdef USE_PERF
+		COUNTER_FD[c] = counter_open(c);
+		if (COUNTER_FD[c] < 0)
+			printf("Counter %s not available, %s\n", COUNTER_NAME[c], strerror(errno));
+		else
+			any = 1;
+#else
+		COUNTER_FD[c] = -1;
 #endif
-
-#ifdef USE_CPPUNORDEREDMAP
-	COND(DATA_CPPUNORDEREDMAP) {
-		CPP = (struct cpp_object*)malloc(sizeof(struct cpp_object) * the_max);
-		cppunorderedmap = new cppunorderedmap_t;
 	}
-#endif
 
-	COND(DATA_UTHASH) {
-		UTHASH = (struct uthash_object*)malloc(sizeof(struct uthash_object) * the_max);
-	}
+	if (!any)
+		printf("Performance counters not available, disabled\n");
 
-	COND(DATA_NEDTRIE) {
-		NEDTRIE_INIT(&nedtrie);
-		NEDTRIE = (struct nedtrie_object*)malloc(sizeof(struct nedtrie_object) * the_max);
-	}
+	return any;
+}
 
-#ifdef USE_JUDY
-	COND(DATA_JUDY) {
-		JUDY = (struct judy_object*)malloc(sizeof(struct judy_object) * the_max);
+void counter_start(void)
+{
+#ifdef USE_PERF
+	unsigned c;
+
+	for(c=0;c<COUNTER_MAX;++c) {
+		if (COUNTER_FD[c] < 0)
+			continue;
+		ioctl(COUNTER_FD[c], PERF_EVENT_IOC_RESET, 0);
+		ioctl(COUNTER_FD[c], PERF_EVENT_IOC_ENABLE, 0);
 	}
 #endif
+}
 
-#ifdef USE_JUDYARRAY
-	COND(DATA_JUDYARRAY) {
-		JUDYARRAY = (struct judyarray_object*)malloc(sizeof(struct judyarray_object) * the_max);
-		judyarray = (Judy*)judy_open(1024, 1);
-	}
-#endif
+/**
+ * Stops the counters, and gets their value scaled to the whole run.
+ * A value of -1 means that the counter is not available.
+ */
+void counter_stop(double* value)
+{
+	unsigned c;
 
-#ifdef USE_CUBE
-	COND(DATA_CUBE) {
-		CUBE = (struct cube_object*)malloc(sizeof(struct cube_object) * the_max);
-		cube = create_cube();
+#ifdef USE_PERF
+	for(c=0;c<COUNTER_MAX;++c) {
+		if (COUNTER_FD[c] >= 0)
+			ioctl(COUNTER_FD[c], PERF_EVENT_IOC_DISABLE, 0);
 	}
 #endif
 
-#ifdef USE_LIBDYNAMIC
-	COND(DATA_LIBDYNAMIC) {
-		LIBDYNAMIC = (struct libdynamic_object*)malloc(sizeof(struct libdynamic_object) * the_max);
-		map_construct(&libdynamic, sizeof(struct libdynamic_object*), &libdynamic_empty_ptr, libdynamic_set);
-	}
-#endif
+	for(c=0;c<COUNTER_MAX;++c) {
+		value[c] = -1;
+#ifdef USE_PERF
+		if (COUNTER_FD[c] >= 0) {
+			tommy_uint64_t buf[3]; /* value, time enabled, time running */
 
-#ifdef USE_CK
-	COND(DATA_CK) {
-		CK = (struct ck_object*)malloc(sizeof(struct ck_object) * the_max);
-		/* Adding CK_HS_MODE_DELETE makes the performance worse */
-		/* when the number of elements is near and just a little lower than a */
-		/* power of 2. For example, with 63095 elements: */
-/*
-63095 ck forward
-   forward,     insert,           ck,  200 [ns]
-   forward,     change,           ck, 23977 [ns] <<<<<
-   forward,        hit,           ck,  338 [ns]
-   forward,       miss,           ck,  209 [ns]
-   forward,     remove,           ck,  325 [ns]
-63095 ck random
-    random,     insert,           ck,  197 [ns]
-    random,     change,           ck, 24025 [ns] <<<<<
-    random,        hit,           ck,  342 [ns]
-    random,       miss,           ck,  206 [ns]
-    random,     remove,           ck,  337 [ns]
-*/
-		/* Without CK_HS_MODE_DELETE performance are better, but still */
-		/* very slow: */
-/*
-63095 ck forward
-   forward,     insert,           ck,  193 [ns]
-   forward,     change,           ck, 3102 [ns] <<<<<
-   forward,        hit,           ck,  344 [ns]
-   forward,       miss,           ck, 3330 [ns] <<<<<
-   forward,     remove,           ck,  327 [ns]
-63095 ck random
-    random,     insert,           ck,  193 [ns]
-    random,     change,           ck, 2984 [ns] <<<<<
-    random,        hit,           ck,  340 [ns]
-    random,       miss,           ck, 3261 [ns] <<<<<
-    random,     remove,           ck,  341 [ns]
-*/
-		ck_hs_init(&ck, CK_HS_MODE_OBJECT, hs_hash, hs_compare, &my_allocator, 32, 0);
-	}
-#endif
-}
+			if (read(COUNTER_FD[c], buf, sizeof(buf)) != (ssize_t)sizeof(buf))
+				continue;
 
-void test_free(void)
-{
-	COND(DATA_TREE) {
-		free(RBTREE);
-	}
+			/* if never scheduled, there is no value */
+			if (buf[2] == 0)
+				continue;
 
-	COND(DATA_HASHTABLE) {
-		if (tommy_hashtable_count(&hashtable) != 0)
-			abort();
-		tommy_hashtable_done(&hashtable);
-		free(HASHTABLE);
+			value[c] = (double)buf[0] * buf[1] / buf[2];
+		}
+#endif
 	}
+}
 
-	COND(DATA_HASHDYN) {
-		if (tommy_hashdyn_count(&hashdyn) != 0)
-			abort();
-		tommy_hashdyn_done(&hashdyn);
-		free(HASHDYN);
-	}
+/******************************************************************************/
+/* memory */
 
-	COND(DATA_HASHLIN) {
-		if (tommy_hashlin_count(&hashlin) != 0)
-			abort();
-		tommy_hashlin_done(&hashlin);
-		free(HASHLIN);
-	}
+size_t the_alloc_base; /**< Memory allocated by Tommy at the start of the test. */
+size_t the_alloc_steady; /**< Memory allocated by Tommy when measuring the size. */
+tommy_size_t the_rss_base; /**< RSS at the start of the test, 0 if the peak RSS is not available. */
 
-	COND(DATA_TRIE) {
-		if (tommy_trie_count(&trie) != 0)
-			abort();
-		tommy_allocator_done(&trie_allocator);
-		free(TRIE);
-	}
+/**
+ * Gets a field of /proc/self/status, like VmRSS or VmHWM, in byte.
+ * \return 0 if not available.
+ */
+tommy_size_t rss_get(const char* field)
+{
+#if defined(__linux)
+	char line[128];
+	size_t len = strlen(field);
+	tommy_size_t v = 0;
+	FILE* f;
 
-	COND(DATA_TRIE_INPLACE) {
-		if (tommy_trie_inplace_count(&trie_inplace) != 0)
-			abort();
-		free(TRIE_INPLACE);
-	}
+	f = fopen("/proc/self/status", "r");
+	if (!f)
+		return 0;
 
-	COND(DATA_KHASH) {
-		kh_destroy(word, khash);
-		free(KHASH);
+	while (fgets(line, sizeof(line), f)) {
+		if (strncmp(line, field, len) == 0 && line[len] == ':') {
+			v = (tommy_size_t)strtoull(line + len + 1, 0, 10) * 1024;
+			break;
+		}
 	}
 
-#ifdef USE_GOOGLELIBCHASH
-	COND(DATA_GOOGLELIBCHASH) {
-		FreeHashTable(googlelibhash);
-		free(GOOGLELIBCHASH);
-	}
+	fclose(f);
+	return v;
+#else
+	(void)field;
+	return 0;
 #endif
+}
 
-#ifdef USE_GOOGLEDENSEHASH
-	COND(DATA_GOOGLEDENSEHASH) {
-		free(GOOGLEDENSEHASH);
-		delete googledensehash;
-	}
-#endif
+/**
+ * Resets the peak RSS to the current RSS.
+ * \return 0 if not supported.
+ */
+tommy_bool_t rss_reset(void)
+{
+#if defined(__linux)
+	FILE* f;
 
-#ifdef USE_GOOGLEBTREE
-	COND(DATA_GOOGLEBTREE) {
-		free(GOOGLEBTREE);
-		delete googlebtree;
-	}
-#endif
+	/* supported since Linux 4.0 */
+	f = fopen("/proc/self/clear_refs", "w");
+	if (!f)
+		return 0;
 
-#ifdef USE_STXBTREE
-	COND(DATA_STXBTREE) {
-		free(STX);
-		delete stxbtree;
+	if (fputs("5", f) < 0) {
+		fclose(f);
+		return 0;
 	}
-#endif
 
-#ifdef USE_CPPMAP
-	COND(DATA_CPPMAP) {
-		free(CPP);
-		delete cppmap;
-	}
+	return fclose(f) == 0;
+#else
+	return 0;
 #endif
+}
 
-#ifdef USE_CPPUNORDEREDMAP
-	COND(DATA_CPPUNORDEREDMAP) {
-		free(CPP);
-		delete cppunorderedmap;
-	}
+/**
+ * Starts to track the memory allocated by Tommy.
+ */
+void alloc_reset(void)
+{
+	the_alloc_base = the_alloc_size;
+	the_alloc_peak = the_alloc_size;
+}
+
+/**
+ * Starts to track the peak RSS.
+ */
+void peak_reset(void)
+{
+#if defined(__GLIBC__)
+	/* return to the system the memory freed by the previous tests */
+	malloc_trim(0);
 #endif
 
-	COND(DATA_UTHASH) {
-		free(UTHASH);
-	}
+	if (rss_reset())
+		the_rss_base = rss_get("VmRSS");
+	else
+		the_rss_base = 0;
+}
 
-	COND(DATA_NEDTRIE) {
-		free(NEDTRIE);
-	}
+/******************************************************************************/
+/* measure */
 
-#ifdef USE_JUDY
-	COND(DATA_JUDY) {
-		free(JUDY);
-	}
-#endif
+tommy_bool_t start(unsigned data)
+{
+	the_start_data = data;
 
-#ifdef USE_JUDYARRAY
-	COND(DATA_JUDYARRAY) {
-		free(JUDYARRAY);
-		judy_close(judyarray);
-	}
-#endif
+	if (!is_select(the_start_data))
+		return 0;
 
-#ifdef USE_CUBE
-	COND(DATA_CUBE) {
-		free(CUBE);
-		destroy_cube(cube);
-	}
-#endif
+	if (!the_log)
+		printf("%10s, %10s, %12s, ", ORDER_NAME[the_order], OPERATION_NAME[the_operation], DATA_NAME[data]);
 
-#ifdef USE_LIBDYNAMIC
-	COND(DATA_LIBDYNAMIC) {
-		free(LIBDYNAMIC);
-		map_destruct(&libdynamic, &libdynamic_equal, 0);
-	}
-#endif
+	if (the_period)
+		hist_reset();
 
-#ifdef USE_CK
-	COND(DATA_CK) {
-		free(CK);
-		ck_hs_destroy(&ck);
-	}
-#endif
+	/* start with a sampled operation */
+	the_end = 0;
+	the_sample_next = 1;
+
+	if (the_counter)
+		counter_start();
+
+	the_time = nano();
+	return 1;
 }
 
-void test_insert(unsigned* INSERT)
+void stop(void)
 {
-	unsigned i;
+	tommy_uint64_t elapsed = nano() - the_time;
+	unsigned p;
 
-	START(DATA_TREE) {
-		unsigned key = INSERT[i];
-		RBTREE[i].value = key;
-		rbt_insert(&tree, &RBTREE[i]);
-	} STOP();
+	if (!is_select(the_start_data))
+		return;
 
-	START(DATA_HASHTABLE) {
-		unsigned key = INSERT[i];
-		unsigned hash_key = hash(key);
-		HASHTABLE[i].value = key;
-		tommy_hashtable_insert(&hashtable, &HASHTABLE[i].node, &HASHTABLE[i], hash_key);
-	} STOP();
+	if (the_counter) {
+		double* v = CNT[the_retry][the_data][the_order][the_operation];
 
-	START(DATA_HASHDYN) {
-		unsigned key = INSERT[i];
-		unsigned hash_key = hash(key);
-		HASHDYN[i].value = key;
-		tommy_hashdyn_insert(&hashdyn, &HASHDYN[i].node, &HASHDYN[i], hash_key);
-	} STOP();
+		counter_stop(v);
 
-	START(DATA_HASHLIN) {
-		unsigned key = INSERT[i];
-		unsigned hash_key = hash(key);
-		HASHLIN[i].value = key;
-		tommy_hashlin_insert(&hashlin, &HASHLIN[i].node, &HASHLIN[i], hash_key);
-	} STOP();
+		for(p=0;p<COUNTER_MAX;++p) {
+			if (v[p] >= 0)
+				v[p] /= the_max;
+		}
+	}
 
-	START(DATA_TRIE) {
-		unsigned key = INSERT[i];
-		TRIE[i].value = key;
-		tommy_trie_insert(&trie, &TRIE[i].node, &TRIE[i], key);
-	} STOP();
+	if (!the_log) {
+		printf("%4u [ns]", (unsigned)(elapsed / the_max));
+	} 
 
-	START(DATA_TRIE_INPLACE) {
-		unsigned key = INSERT[i];
-		TRIE_INPLACE[i].value = key;
-		tommy_trie_inplace_insert(&trie_inplace, &TRIE_INPLACE[i].node, &TRIE_INPLACE[i], key);
-	} STOP();
+	LOG[the_retry][the_data][the_order][the_operation] = (unsigned)(elapsed / the_max);
 
-	/* for khash we hash the key because internally khash doesn't use any hash for integer keys */
-	START(DATA_KHASH) {
-		unsigned key = INSERT[i];
-		unsigned hash_key = hash(key);
-		khiter_t k;
-		int r;
-		KHASH[i].value = key;
-		k = kh_put(word, khash, hash_key, &r);
-		if (!r)
-			abort();
-		kh_value(khash, k) = &KHASH[i];
-	} STOP();
+	if (the_period) {
+		for(p=0;p<PERCENTILE_MAX;++p) {
+			tommy_uint64_t v = (tommy_uint64_t)(hist_percentile(PERCENTILE_FRACTION[p]) / the_tick_per_ns);
 
-#ifdef USE_GOOGLELIBCHASH
-	START(DATA_GOOGLELIBCHASH) {
-		unsigned key = INSERT[i];
-		HTItem* r;
-		u_long ptr_value = (u_long)&GOOGLELIBCHASH[i];
-		GOOGLELIBCHASH[i].value = key;
-		r = HashInsert(googlelibhash, key, ptr_value);
-		if (!r)
-			abort();
-	} STOP();
-#endif
+			if (!the_log)
+				printf(", %s %4u", PERCENTILE_NAME[p], (unsigned)v);
 
-#ifdef USE_GOOGLEDENSEHASH
-	START(DATA_GOOGLEDENSEHASH) {
-		unsigned key = INSERT[i];
-		struct google_object* obj = &GOOGLEDENSEHASH[i];
-		GOOGLEDENSEHASH[i].value = key;
-		(*googledensehash)[key] = obj;
-	} STOP();
-#endif
+			LAT[the_retry][the_data][the_order][the_operation][p] = (unsigned)v;
+		}
 
-#ifdef USE_GOOGLEBTREE
-	START(DATA_GOOGLEBTREE) {
-		unsigned key = INSERT[i];
-		struct google_object* obj = &GOOGLEBTREE[i];
-		GOOGLEBTREE[i].value = key;
-		(*googlebtree)[key] = obj;
-	} STOP();
-#endif
+		if (!the_log)
+			printf(" [ns]");
+	}
 
-#ifdef USE_STXBTREE
-	START(DATA_STXBTREE) {
-		unsigned key = INSERT[i];
-		struct stx_object* obj = &STX[i];
-		STX[i].value = key;
-		(*stxbtree)[key] = obj;
-	} STOP();
-#endif
+	if (the_counter && !the_log) {
+		double* v = CNT[the_retry][the_data][the_order][the_operation];
 
-#ifdef USE_CPPMAP
-	START(DATA_CPPMAP) {
-		unsigned key = INSERT[i];
-		struct cpp_object* obj = &CPP[i];
-		CPP[i].value = key;
-		(*cppmap)[key] = obj;
-	} STOP();
-#endif
+		if (v[COUNTER_CYCLE] > 0 && v[COUNTER_INSTRUCTION] >= 0)
+			printf(", ipc %4.2f", v[COUNTER_INSTRUCTION] / v[COUNTER_CYCLE]);
+		else
+			printf(", ipc  n/a");
 
-#ifdef USE_CPPUNORDEREDMAP
-	START(DATA_CPPUNORDEREDMAP) {
-		unsigned key = INSERT[i];
-		struct cpp_object* obj = &CPP[i];
-		CPP[i].value = key;
-		(*cppunorderedmap)[key] = obj;
-	} STOP();
-#endif
+		for(p=COUNTER_L1D;p<COUNTER_MAX;++p) {
+			if (v[p] >= 0)
+				printf(", %s %6.3f", COUNTER_NAME[p], v[p]);
+			else
+				printf(", %s    n/a", COUNTER_NAME[p]);
+		}
 
-	START(DATA_UTHASH) {
-		unsigned key = INSERT[i];
-		struct uthash_object* obj = &UTHASH[i];
-		obj->value = key;
-		HASH_ADD_INT(uthash, value, obj);
-	} STOP();
+		printf(" [miss/op]");
+	}
 
-	START(DATA_NEDTRIE) {
-		unsigned key = INSERT[i];
-		NEDTRIE[i].value = key;
-		NEDTRIE_INSERT(nedtrie_t, &nedtrie, &NEDTRIE[i]);
-	} STOP();
+	if (!the_log)
+		printf("\n");
+}
 
-#ifdef USE_JUDY
-	START(DATA_JUDY) {
-		unsigned key = INSERT[i];
-		Pvoid_t PValue;
-		JUDY[i].value = key;
-		JLI(PValue, judy, key);
-		*(struct judy_object**)PValue = &JUDY[i];
-	} STOP();
-#endif
+void mem(unsigned data, tommy_size_t v)
+{
+	if (!the_log) {
+		printf("%10s, %10s, %12s, ", ORDER_NAME[the_order], OPERATION_NAME[the_operation], DATA_NAME[data]);
+		printf("%4u [byte]\n", (unsigned)(v / the_max));
+	} 
 
-#ifdef USE_JUDYARRAY
-	START(DATA_JUDYARRAY) {
-		judyvalue key = INSERT[i];
-		JudySlot* pvalue;
-		JUDYARRAY[i].value = key;
-		pvalue = judy_cell(judyarray, (uchar*)&key, 0);
-		*(struct judyarray_object**)pvalue = &JUDYARRAY[i];
-	} STOP();
-#endif
+	LOG[the_retry][the_data][the_order][the_operation] = (unsigned)(v / the_max);
+}
 
-#ifdef USE_CUBE
-	START(DATA_CUBE) {
-		unsigned key = INSERT[i];
-		CUBE[i].value = key;
-		set_key(cube, key, &CUBE[i]);
-	} STOP();
-#endif
+#define COND(s) if (is_select(s))
+#define START(s) if (start(s)) while (segment()) for(i=the_begin;i<the_end;++i)
+#define STOP() stop()
+#define MEM(s, v) if (is_select(s)) mem(s, v)
+#define OPERATION(operation) the_operation = operation
+#define ORDER(order) the_order = order
+#define DATA(data) the_data = data
 
-#ifdef USE_LIBDYNAMIC
-	START(DATA_LIBDYNAMIC) {
-		unsigned key = INSERT[i];
-		struct libdynamic_object* obj = &LIBDYNAMIC[i];
-		obj->value = key;
-		map_insert(&libdynamic, &obj, libdynamic_hash, libdynamic_equal, libdynamic_set, 0);
-	} STOP();
-#endif
+FILE* open(const char* mode)
+{
+	char buf[128];
+	sprintf(buf, "dat_%s%s_%s.lst", the_string ? "string_" : "", ORDER_NAME[the_order], OPERATION_NAME[the_operation]);
+	return fopen(buf, mode);
+}
 
-#ifdef USE_CK
-	START(DATA_CK) {
-		unsigned key = INSERT[i];
-		unsigned hash_key;
-		CK[i].value = key;
-		hash_key = CK_HS_HASH(&ck, hs_hash, &CK[i]);
-		ck_hs_put(&ck, hash_key, &CK[i]);
-	} STOP();
-#endif
+FILE* open_percentile(const char* mode, unsigned percentile)
+{
+	char buf[128];
+	sprintf(buf, "dat_%s%s_%s_%s.lst", the_string ? "string_" : "", ORDER_NAME[the_order], OPERATION_NAME[the_operation], PERCENTILE_NAME[percentile]);
+	return fopen(buf, mode);
 }
 
-void test_hit(unsigned* SEARCH)
+FILE* open_counter(const char* mode, unsigned counter)
 {
-	unsigned i;
+	char buf[128];
+	sprintf(buf, "dat_%s%s_%s_%s.lst", the_string ? "string_" : "", ORDER_NAME[the_order], OPERATION_NAME[the_operation], COUNTER_NAME[counter]);
+	return fopen(buf, mode);
+}
 
-	/* always dereference the object found. It has cache effect. */
-	/* considering we are dealing with objects, it makes sense to simulate an access to it */
-	/* this favorites data structures that store part of the information in the object itself */
-	const int dereference = 1;
+/******************************************************************************/
+/* test */
 
-	const unsigned DELTA = 1;
+/**
+ * Cache clearing buffer.
+ */
+unsigned char CACHE[8*1024*1024];
 
-	START(DATA_TREE) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct rbt_object key_obj;
-		struct rbt_object* obj;
-		key_obj.value = key;
-		obj = rbt_search(&tree, &key_obj); 
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+void cache_clear(void)
+{
+	unsigned i;
 
-	START(DATA_HASHTABLE) {
-		unsigned key = SEARCH[i] + DELTA;
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
+	/* read & write */
+	for(i=0;i<sizeof(CACHE);i += 32)
+		CACHE[i] += 1;
+
+#ifdef WIN32
+	Sleep(0);
+#endif
+}
+
+/**
+ * Different orders used.
+ */ 
+unsigned* FORWARD;
+unsigned* RAND0;
+unsigned* RAND1;
+
+/**
+ * Keys used for the searches, with the selected distribution.
+ */
+unsigned* LOOKUP;
+
+/**
+ * Selected distribution of the searches, ORDER_MAX if none.
+ */
+unsigned the_dist = ORDER_MAX;
+
+/**
+ * Parameter of the Zipf distribution.
+ */
+double the_theta = 0.99;
+
+/**
+ * Trace of keys to replay.
+ * Each key is stored as its index in the set of different keys.
+ */
+unsigned* TRACE;
+unsigned TRACE_MAX;
+
+/**
+ * If the order is tested.
+ */
+tommy_bool_t is_order(unsigned order)
+{
+	return order == ORDER_FORWARD || order == ORDER_RANDOM || order == the_dist;
+}
+
+/**
+ * Uniform random number in [0, 1).
+ */
+double rnd_uniform(void)
+{
+	return rnd(0x80000000) / 2147483648.0;
+}
+
+/**
+ * Generator of Zipf distributed numbers in [0, max), with 0 the most frequent.
+ * The method is valid only for 0 < theta < 1.
+ * From "Quickly Generating Billion-Record Synthetic Databases", Jim Gray et al, SIGMOD 1994.
+ */
+struct zipf {
+	double n;
+	double theta;
+	double alpha;
+	double zetan;
+	double eta;
+};
+
+void zipf_init(struct zipf* z, unsigned max, double theta)
+{
+	double zeta2;
+	unsigned i;
+
+	z->n = max;
+	z->theta = theta;
+	z->alpha = 1 / (1 - theta);
+
+	z->zetan = 0;
+	for(i=1;i<=max;++i)
+		z->zetan += 1 / pow(i, theta);
+
+	zeta2 = 1 + 1 / pow(2, theta);
+
+	z->eta = (1 - pow(2 / z->n, 1 - theta)) / (1 - zeta2 / z->zetan);
+}
+
+unsigned zipf_next(struct zipf* z)
+{
+	double u = rnd_uniform();
+	double uz = u * z->zetan;
+	unsigned r;
+
+	if (uz < 1)
+		return 0;
+	if (uz < 1 + pow(0.5, z->theta))
+		return 1;
+
+	r = (unsigned)(z->n * pow(z->eta * u - z->eta + 1, z->alpha));
+	if (r >= z->n)
+		r = (unsigned)z->n - 1;
+
+	return r;
+}
+
+int trace_compare(const void* void_a, const void* void_b)
+{
+	unsigned a = *(const unsigned*)void_a;
+	unsigned b = *(const unsigned*)void_b;
+
+	if (a < b)
+		return -1;
+	if (a > b)
+		return 1;
+	return 0;
+}
+
+/**
+ * Loads a trace file.
+ * The file is a text file with a key for each line, in decimal, or in
+ * hexadecimal with the 0x prefix. Empty lines and lines starting with # are ignored.
+ * Keys are replaced with their index in the set of different keys, to be mapped
+ * to the keys of the test, keeping the frequencies and the locality of the trace.
+ */
+void trace_load(const char* path)
+{
+	unsigned* sorted;
+	unsigned distinct;
+	unsigned trace_alloc;
+	char buf[256];
+	FILE* f;
+	unsigned i;
+
+	f = fopen(path, "rt");
+	if (!f) {
+		printf("Error opening trace file '%s'\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	trace_alloc = 1024;
+	TRACE = (unsigned*)malloc(trace_alloc * sizeof(unsigned));
+	TRACE_MAX = 0;
+	while (fgets(buf, sizeof(buf), f)) {
+		char* s = buf;
+		char* e;
+		unsigned long v;
+
+		while (*s == ' ' || *s == '\t')
+			++s;
+		if (*s == '#' || *s == '\n' || *s == '\r' || *s == 0)
+			continue;
+
+		v = strtoul(s, &e, 0);
+		if (e == s) {
+			printf("Invalid key '%s' in trace file '%s'\n", s, path);
+			exit(EXIT_FAILURE);
+		}
+
+		if (TRACE_MAX == trace_alloc) {
+			trace_alloc *= 2;
+			TRACE = (unsigned*)realloc(TRACE, trace_alloc * sizeof(unsigned));
+		}
+		TRACE[TRACE_MAX++] = (unsigned)v;
+	}
+
+	fclose(f);
+
+	if (TRACE_MAX == 0) {
+		printf("Empty trace file '%s'\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	/* get the set of different keys */
+	sorted = (unsigned*)malloc(TRACE_MAX * sizeof(unsigned));
+	memcpy(sorted, TRACE, TRACE_MAX * sizeof(unsigned));
+	qsort(sorted, TRACE_MAX, sizeof(unsigned), trace_compare);
+	distinct = 0;
+	for(i=0;i<TRACE_MAX;++i) {
+		if (distinct == 0 || sorted[distinct - 1] != sorted[i])
+			sorted[distinct++] = sorted[i];
+	}
+
+	/* replace the keys with their index */
+	for(i=0;i<TRACE_MAX;++i) {
+		unsigned* ptr = (unsigned*)bsearch(&TRACE[i], sorted, distinct, sizeof(unsigned), trace_compare);
+		TRACE[i] = (unsigned)(ptr - sorted);
+	}
+
+	free(sorted);
+
+	printf("Trace with %u keys, %u different\n", TRACE_MAX, distinct);
+}
+
+/**
+ * Generates the keys used for the searches with the selected distribution.
+ * The keys are the ones of FORWARD, and RAND0 is the insertion order.
+ */
+void lookup_init(unsigned max)
+{
+	struct zipf z;
+	unsigned hot;
+	unsigned i;
+
+	LOOKUP = (unsigned*)malloc(max * sizeof(unsigned));
+
+	switch (the_dist) {
+	case ORDER_ZIPF :
+		/* the most frequent keys are spread using the random RAND1 order */
+		zipf_init(&z, max, the_theta);
+		for(i=0;i<max;++i)
+			LOOKUP[i] = RAND1[zipf_next(&z)];
+		break;
+	case ORDER_HOTSPOT :
+		/* the hot keys are the first 20% of the random RAND1 order */
+		hot = max / 5;
+		if (hot == 0)
+			hot = 1;
+		for(i=0;i<max;++i) {
+			if (rnd(100) < 80 || hot == max)
+				LOOKUP[i] = RAND1[rnd(hot)];
+			else
+				LOOKUP[i] = RAND1[hot + rnd(max - hot)];
+		}
+		break;
+	case ORDER_LATEST :
+		/* the most frequent keys are the last inserted */
+		/* test_change() removes the keys in the RAND1 order and reinserts them in the RAND0 order */
+		zipf_init(&z, max, the_theta);
+		for(i=0;i<max;++i)
+			LOOKUP[i] = RAND0[max - 1 - zipf_next(&z)];
+		break;
+	case ORDER_TRACE :
+		/* if the trace is shorter, it's replayed more times */
+		for(i=0;i<max;++i)
+			LOOKUP[i] = FORWARD[TRACE[i % TRACE_MAX] % max];
+		break;
+	}
+}
+
+/**
+ * Hash functions used for string keys.
+ */
+#define STRING_HASH_U64 1 /**< tommy_hash_u64() with the string length. */
+#define STRING_STRHASH_U32 2 /**< tommy_strhash_u32() with the zero terminated string. */
+
+/**
+ * Max number of objects with string keys.
+ * It's lower because each key takes on average 90 bytes.
+ */
+#define STRING_MAX 1000000
+
+/**
+ * String keys, two for each object, one for the key K and one for K+1.
+ * They are indexed with K - 0x80000000, as the keys are not sparse.
+ */
+std::string* STRING;
+
+struct string_object* STRING_OBJ;
+struct stringc_object* STRINGC_OBJ;
+
+/**
+ * Generates the string keys, with a length from 16 to 128 bytes.
+ * The keys K and K+1 differ only in the last char, but they have different hashes.
+ * So a hit compares the full key, but a miss is rejected by the hash in the hashtables
+ * storing it, and compares the key only on the rare hash collisions.
+ */
+void string_init(unsigned max)
+{
+	static const char ALPHABET[] = "abcdefghijklmnopqrstuvwxyz0123456789";
+	unsigned i;
+
+	STRING = new std::string[2 * max];
+
+	for(i=0;i<2*max;++i) {
+		std::string* s = &STRING[i];
+		unsigned seed = hash(i / 2);
+		unsigned len = 16 + seed % 113;
+		unsigned j;
+
+		s->resize(len);
+		for(j=0;j<len;++j) {
+			seed = seed * 1103515245 + 12345;
+			(*s)[j] = ALPHABET[(seed >> 16) % 36];
+		}
+
+		if (i % 2 != 0)
+			(*s)[len - 1] = '_';
+	}
+}
+
+void string_done(void)
+{
+	delete [] STRING;
+	STRING = 0;
+}
+
+const std::string* string_key(unsigned key)
+{
+	return &STRING[key - 0x80000000];
+}
+
+tommy_hash_t string_hash(const std::string* key)
+{
+	if (the_string == STRING_STRHASH_U32)
+		return tommy_strhash_u32(0, key->c_str());
+
+	return tommy_hash_u64(0, key->data(), key->size());
+}
+
+void order_init(int max, int sparse)
+{
+	int i;
+
+	FORWARD = (unsigned*)malloc(max * sizeof(unsigned));
+	RAND0 = (unsigned*)malloc(max * sizeof(unsigned));
+	RAND1 = (unsigned*)malloc(max * sizeof(unsigned));
+
+	/* generated forward orders */
+	if (sparse) {
+		for(i=0;i<max;++i) {
+			FORWARD[i] = 0xffffffff / max * i;
+			RAND0[i] = FORWARD[i];
+			RAND1[i] = FORWARD[i];
+		}
+	} else {
+		for(i=0;i<max;++i) {
+			FORWARD[i] = 0x80000000 + i * 2;
+			RAND0[i] = FORWARD[i];
+			RAND1[i] = FORWARD[i];
+		}
+	}
+
+	/* randomize using the Fisher-Yates shuffle, http://en.wikipedia.org/wiki/Fisher-Yates_shuffle */
+	for(i=max-1;i>=0;--i) {
+		unsigned j, t;
+		j = rnd(i+1);
+		t = RAND0[i];
+		RAND0[i] = RAND0[j];
+		RAND0[j] = t;
+
+		j = rnd(i+1);
+		t = RAND1[i];
+		RAND1[i] = RAND1[j];
+		RAND1[j] = t;
+	}
+
+	if (the_dist != ORDER_MAX)
+		lookup_init(max);
+
+	if (the_string)
+		string_init(max);
+}
+
+void order_done(void)
+{
+	free(FORWARD);
+	free(RAND0);
+	free(RAND1); 
+	free(LOOKUP);
+	LOOKUP = 0;
+	string_done();
+}
+
+void test_alloc(void)
+{
+	COND(DATA_TREE) {
+		rbt_new(&tree);
+		RBTREE = (struct rbt_object*)malloc(sizeof(struct rbt_object) * the_max);
+	}
+
+	COND(DATA_HASHTABLE) {
+		tommy_hashtable_init(&hashtable, 2 * the_max);
+		HASHTABLE = (struct hashtable_object*)malloc(sizeof(struct hashtable_object) * the_max);
+	}
+
+	COND(DATA_HASHDYN) {
+		tommy_hashdyn_init(&hashdyn);
+		HASHDYN = (struct hashtable_object*)malloc(sizeof(struct hashtable_object) * the_max);
+	}
+
+	COND(DATA_HASHDYNC) {
+		tommy_hashdync_init(&hashdync, offsetof(struct hashtablec_object, node));
+		HASHDYNC = (struct hashtablec_object*)malloc(sizeof(struct hashtablec_object) * the_max);
+	}
+
+	COND(DATA_HASHLIN) {
+		tommy_hashlin_init(&hashlin);
+		HASHLIN = (struct hashtable_object*)malloc(sizeof(struct hashtable_object) * the_max);
+	}
+
+	COND(DATA_HASHLINC) {
+		tommy_hashlinc_init(&hashlinc, offsetof(struct hashtablec_object, node));
+		HASHLINC = (struct hashtablec_object*)malloc(sizeof(struct hashtablec_object) * the_max);
+	}
+
+	COND(DATA_MPHF) {
+		MPHF = (struct mphf_object*)malloc(sizeof(struct mphf_object) * the_max);
+		MPHF_KEY = (tommy_uint64_t*)malloc(sizeof(tommy_uint64_t) * the_max);
+	}
+
+	COND(DATA_TRIE) {
+		tommy_allocator_init(&trie_allocator, TOMMY_TRIE_BLOCK_SIZE, TOMMY_TRIE_BLOCK_SIZE);
+		tommy_trie_init(&trie, &trie_allocator);
+		TRIE = (struct trie_object*)malloc(sizeof(struct trie_object) * the_max);
+	}
+
+	COND(DATA_TRIE_INPLACE) {
+		tommy_trie_inplace_init(&trie_inplace);
+		TRIE_INPLACE = (struct trie_inplace_object*)malloc(sizeof(struct trie_inplace_object) * the_max);
+	}
+
+	COND(DATA_KHASH) {
+		KHASH = (struct khash_object*)malloc(sizeof(struct khash_object) * the_max);
+		khash = kh_init(word);
+	}
+
+#ifdef USE_GOOGLELIBCHASH
+	COND(DATA_GOOGLELIBCHASH) {
+		GOOGLELIBCHASH = (struct google_object*)malloc(sizeof(struct google_object) * the_max);
+		googlelibhash = AllocateHashTable(sizeof(void*), 0);
+	}
+#endif
+
+#ifdef USE_GOOGLEDENSEHASH
+	COND(DATA_GOOGLEDENSEHASH) {
+		GOOGLEDENSEHASH = (struct google_object*)malloc(sizeof(struct google_object) * the_max);
+		googledensehash = new googledensehash_t;
+		googledensehash->set_empty_key(-1);
+		googledensehash->set_deleted_key(-2);
+	}
+#endif
+
+#ifdef USE_GOOGLEBTREE
+	COND(DATA_GOOGLEBTREE) {
+		GOOGLEBTREE = (struct google_object*)malloc(sizeof(struct google_object) * the_max);
+		googlebtree = new googlebtree_t;
+	}
+#endif
+
+#ifdef USE_STXBTREE
+	COND(DATA_STXBTREE) {
+		STX = (struct stx_object*)malloc(sizeof(struct stx_object) * the_max);
+		stxbtree = new stxbtree_t;
+	}
+#endif
+
+#ifdef USE_CPPMAP
+	COND(DATA_CPPMAP) {
+		CPP = (struct cpp_object*)malloc(sizeof(struct cpp_object) * the_max);
+		cppmap = new cppmap_t;
+	}
+#endif
+
+#ifdef USE_CPPUNORDEREDMAP
+	COND(DATA_CPPUNORDEREDMAP) {
+		CPP = (struct cpp_object*)malloc(sizeof(struct cpp_object) * the_max);
+		cppunorderedmap = new cppunorderedmap_t;
+	}
+#endif
+
+	COND(DATA_UTHASH) {
+		UTHASH = (struct uthash_object*)malloc(sizeof(struct uthash_object) * the_max);
+	}
+
+	COND(DATA_NEDTRIE) {
+		NEDTRIE_INIT(&nedtrie);
+		NEDTRIE = (struct nedtrie_object*)malloc(sizeof(struct nedtrie_object) * the_max);
+	}
+
+#ifdef USE_JUDY
+	COND(DATA_JUDY) {
+		JUDY = (struct judy_object*)malloc(sizeof(struct judy_object) * the_max);
+	}
+#endif
+
+#ifdef USE_JUDYARRAY
+	COND(DATA_JUDYARRAY) {
+		JUDYARRAY = (struct judyarray_object*)malloc(sizeof(struct judyarray_object) * the_max);
+		judyarray = (Judy*)judy_open(1024, 1);
+	}
+#endif
+
+#ifdef USE_CUBE
+	COND(DATA_CUBE) {
+		CUBE = (struct cube_object*)malloc(sizeof(struct cube_object) * the_max);
+		cube = create_cube();
+	}
+#endif
+
+#ifdef USE_LIBDYNAMIC
+	COND(DATA_LIBDYNAMIC) {
+		LIBDYNAMIC = (struct libdynamic_object*)malloc(sizeof(struct libdynamic_object) * the_max);
+		map_construct(&libdynamic, sizeof(struct libdynamic_object*), &libdynamic_empty_ptr, libdynamic_set);
+	}
+#endif
+
+#ifdef USE_CK
+	COND(DATA_CK) {
+		CK = (struct ck_object*)malloc(sizeof(struct ck_object) * the_max);
+		/* Adding CK_HS_MODE_DELETE makes the performance worse */
+		/* when the number of elements is near and just a little lower than a */
+		/* power of 2. For example, with 63095 elements: */
+/*
+63095 ck forward
+   forward,     insert,           ck,  200 [ns]
+   forward,     change,           ck, 23977 [ns] <<<<<
+   forward,        hit,           ck,  338 [ns]
+   forward,       miss,           ck,  209 [ns]
+   forward,     remove,           ck,  325 [ns]
+63095 ck random
+    random,     insert,           ck,  197 [ns]
+    random,     change,           ck, 24025 [ns] <<<<<
+    random,        hit,           ck,  342 [ns]
+    random,       miss,           ck,  206 [ns]
+    random,     remove,           ck,  337 [ns]
+*/
+		/* Without CK_HS_MODE_DELETE performance are better, but still */
+		/* very slow: */
+/*
+63095 ck forward
+   forward,     insert,           ck,  193 [ns]
+   forward,     change,           ck, 3102 [ns] <<<<<
+   forward,        hit,           ck,  344 [ns]
+   forward,       miss,           ck, 3330 [ns] <<<<<
+   forward,     remove,           ck,  327 [ns]
+63095 ck random
+    random,     insert,           ck,  193 [ns]
+    random,     change,           ck, 2984 [ns] <<<<<
+    random,        hit,           ck,  340 [ns]
+    random,       miss,           ck, 3261 [ns] <<<<<
+    random,     remove,           ck,  341 [ns]
+*/
+		ck_hs_init(&ck, CK_HS_MODE_OBJECT, hs_hash, hs_compare, &my_allocator, 32, 0);
+	}
+#endif
+}
+
+void test_free(void)
+{
+	COND(DATA_TREE) {
+		free(RBTREE);
+	}
+
+	COND(DATA_HASHTABLE) {
+		if (tommy_hashtable_count(&hashtable) != 0)
+			abort();
+		tommy_hashtable_done(&hashtable);
+		free(HASHTABLE);
+	}
+
+	COND(DATA_HASHDYN) {
+		if (tommy_hashdyn_count(&hashdyn) != 0)
+			abort();
+		tommy_hashdyn_done(&hashdyn);
+		free(HASHDYN);
+	}
+
+	COND(DATA_HASHDYNC) {
+		if (tommy_hashdync_count(&hashdync) != 0)
+			abort();
+		tommy_hashdync_done(&hashdync);
+		free(HASHDYNC);
+	}
+
+	COND(DATA_HASHLIN) {
+		if (tommy_hashlin_count(&hashlin) != 0)
+			abort();
+		tommy_hashlin_done(&hashlin);
+		free(HASHLIN);
+	}
+
+	COND(DATA_HASHLINC) {
+		if (tommy_hashlinc_count(&hashlinc) != 0)
+			abort();
+		tommy_hashlinc_done(&hashlinc);
+		free(HASHLINC);
+	}
+
+	COND(DATA_MPHF) {
+		tommy_mphf_done(&mphf);
+		free(MPHF);
+		free(MPHF_KEY);
+	}
+
+	COND(DATA_TRIE) {
+		if (tommy_trie_count(&trie) != 0)
+			abort();
+		tommy_allocator_done(&trie_allocator);
+		free(TRIE);
+	}
+
+	COND(DATA_TRIE_INPLACE) {
+		if (tommy_trie_inplace_count(&trie_inplace) != 0)
+			abort();
+		free(TRIE_INPLACE);
+	}
+
+	COND(DATA_KHASH) {
+		kh_destroy(word, khash);
+		free(KHASH);
+	}
+
+#ifdef USE_GOOGLELIBCHASH
+	COND(DATA_GOOGLELIBCHASH) {
+		FreeHashTable(googlelibhash);
+		free(GOOGLELIBCHASH);
+	}
+#endif
+
+#ifdef USE_GOOGLEDENSEHASH
+	COND(DATA_GOOGLEDENSEHASH) {
+		free(GOOGLEDENSEHASH);
+		delete googledensehash;
+	}
+#endif
+
+#ifdef USE_GOOGLEBTREE
+	COND(DATA_GOOGLEBTREE) {
+		free(GOOGLEBTREE);
+		delete googlebtree;
+	}
+#endif
+
+#ifdef USE_STXBTREE
+	COND(DATA_STXBTREE) {
+		free(STX);
+		delete stxbtree;
+	}
+#endif
+
+#ifdef USE_CPPMAP
+	COND(DATA_CPPMAP) {
+		free(CPP);
+		delete cppmap;
+	}
+#endif
+
+#ifdef USE_CPPUNORDEREDMAP
+	COND(DATA_CPPUNORDEREDMAP) {
+		free(CPP);
+		delete cppunorderedmap;
+	}
+#endif
+
+	COND(DATA_UTHASH) {
+		free(UTHASH);
+	}
+
+	COND(DATA_NEDTRIE) {
+		free(NEDTRIE);
+	}
+
+#ifdef USE_JUDY
+	COND(DATA_JUDY) {
+		free(JUDY);
+	}
+#endif
+
+#ifdef USE_JUDYARRAY
+	COND(DATA_JUDYARRAY) {
+		free(JUDYARRAY);
+		judy_close(judyarray);
+	}
+#endif
+
+#ifdef USE_CUBE
+	COND(DATA_CUBE) {
+		free(CUBE);
+		destroy_cube(cube);
+	}
+#endif
+
+#ifdef USE_LIBDYNAMIC
+	COND(DATA_LIBDYNAMIC) {
+		free(LIBDYNAMIC);
+		map_destruct(&libdynamic, &libdynamic_equal, 0);
+	}
+#endif
+
+#ifdef USE_CK
+	COND(DATA_CK) {
+		free(CK);
+		ck_hs_destroy(&ck);
+	}
+#endif
+}
+
+void test_insert(unsigned* INSERT)
+{
+	unsigned i;
+
+	START(DATA_TREE) {
+		unsigned key = INSERT[i];
+		RBTREE[i].value = key;
+		rbt_insert(&tree, &RBTREE[i]);
+	} STOP();
+
+	START(DATA_HASHTABLE) {
+		unsigned key = INSERT[i];
+		unsigned hash_key = hash(key);
+		HASHTABLE[i].value = key;
+		tommy_hashtable_insert(&hashtable, &HASHTABLE[i].node, &HASHTABLE[i], hash_key);
+	} STOP();
+
+	START(DATA_HASHDYN) {
+		unsigned key = INSERT[i];
+		unsigned hash_key = hash(key);
+		HASHDYN[i].value = key;
+		tommy_hashdyn_insert(&hashdyn, &HASHDYN[i].node, &HASHDYN[i], hash_key);
+	} STOP();
+
+	START(DATA_HASHDYNC) {
+		unsigned key = INSERT[i];
+		unsigned hash_key = hash(key);
+		HASHDYNC[i].value = key;
+		tommy_hashdync_insert(&hashdync, &HASHDYNC[i].node, hash_key);
+	} STOP();
+
+	START(DATA_HASHLIN) {
+		unsigned key = INSERT[i];
+		unsigned hash_key = hash(key);
+		HASHLIN[i].value = key;
+		tommy_hashlin_insert(&hashlin, &HASHLIN[i].node, &HASHLIN[i], hash_key);
+	} STOP();
+
+	START(DATA_HASHLINC) {
+		unsigned key = INSERT[i];
+		unsigned hash_key = hash(key);
+		HASHLINC[i].value = key;
+		tommy_hashlinc_insert(&hashlinc, &HASHLINC[i].node, hash_key);
+	} STOP();
+
+	/* the mphf is static, so it's built directly with the keys that the other */
+	/* data structures have after the change, to search the same keys */
+	START(DATA_MPHF) {
+		unsigned key = INSERT[i] + 1;
+		MPHF_KEY[i] = tommy_hash_u64(0, &key, sizeof(key));
+	}
+	COND(DATA_MPHF) {
+		tommy_mphf_init(&mphf, MPHF_KEY, the_max, 0, 0);
+		for(i=0;i<the_max;++i) {
+			tommy_size_t pos = tommy_mphf_search(&mphf, MPHF_KEY[i]);
+			MPHF[pos].value = INSERT[i] + 1;
+		}
+	} STOP();
+
+	START(DATA_TRIE) {
+		unsigned key = INSERT[i];
+		TRIE[i].value = key;
+		tommy_trie_insert(&trie, &TRIE[i].node, &TRIE[i], key);
+	} STOP();
+
+	START(DATA_TRIE_INPLACE) {
+		unsigned key = INSERT[i];
+		TRIE_INPLACE[i].value = key;
+		tommy_trie_inplace_insert(&trie_inplace, &TRIE_INPLACE[i].node, &TRIE_INPLACE[i], key);
+	} STOP();
+
+	/* for khash we hash the key because internally khash doesn't use any hash for integer keys */
+	START(DATA_KHASH) {
+		unsigned key = INSERT[i];
+		unsigned hash_key = hash(key);
+		khiter_t k;
+		int r;
+		KHASH[i].value = key;
+		k = kh_put(word, khash, hash_key, &r);
+		if (!r)
+			abort();
+		kh_value(khash, k) = &KHASH[i];
+	} STOP();
+
+#ifdef USE_GOOGLELIBCHASH
+	START(DATA_GOOGLELIBCHASH) {
+		unsigned key = INSERT[i];
+		HTItem* r;
+		u_long ptr_value = (u_long)&GOOGLELIBCHASH[i];
+		GOOGLELIBCHASH[i].value = key;
+		r = HashInsert(googlelibhash, key, ptr_value);
+		if (!r)
+			abort();
+	} STOP();
+#endif
+
+#ifdef USE_GOOGLEDENSEHASH
+	START(DATA_GOOGLEDENSEHASH) {
+		unsigned key = INSERT[i];
+		struct google_object* obj = &GOOGLEDENSEHASH[i];
+		GOOGLEDENSEHASH[i].value = key;
+		(*googledensehash)[key] = obj;
+	} STOP();
+#endif
+
+#ifdef USE_GOOGLEBTREE
+	START(DATA_GOOGLEBTREE) {
+		unsigned key = INSERT[i];
+		struct google_object* obj = &GOOGLEBTREE[i];
+		GOOGLEBTREE[i].value = key;
+		(*googlebtree)[key] = obj;
+	} STOP();
+#endif
+
+#ifdef USE_STXBTREE
+	START(DATA_STXBTREE) {
+		unsigned key = INSERT[i];
+		struct stx_object* obj = &STX[i];
+		STX[i].value = key;
+		(*stxbtree)[key] = obj;
+	} STOP();
+#endif
+
+#ifdef USE_CPPMAP
+	START(DATA_CPPMAP) {
+		unsigned key = INSERT[i];
+		struct cpp_object* obj = &CPP[i];
+		CPP[i].value = key;
+		(*cppmap)[key] = obj;
+	} STOP();
+#endif
+
+#ifdef USE_CPPUNORDEREDMAP
+	START(DATA_CPPUNORDEREDMAP) {
+		unsigned key = INSERT[i];
+		struct cpp_object* obj = &CPP[i];
+		CPP[i].value = key;
+		(*cppunorderedmap)[key] = obj;
+	} STOP();
+#endif
+
+	START(DATA_UTHASH) {
+		unsigned key = INSERT[i];
+		struct uthash_object* obj = &UTHASH[i];
+		obj->value = key;
+		HASH_ADD_INT(uthash, value, obj);
+	} STOP();
+
+	START(DATA_NEDTRIE) {
+		unsigned key = INSERT[i];
+		NEDTRIE[i].value = key;
+		NEDTRIE_INSERT(nedtrie_t, &nedtrie, &NEDTRIE[i]);
+	} STOP();
+
+#ifdef USE_JUDY
+	START(DATA_JUDY) {
+		unsigned key = INSERT[i];
+		Pvoid_t PValue;
+		JUDY[i].value = key;
+		JLI(PValue, judy, key);
+		*(struct judy_object**)PValue = &JUDY[i];
+	} STOP();
+#endif
+
+#ifdef USE_JUDYARRAY
+	START(DATA_JUDYARRAY) {
+		judyvalue key = INSERT[i];
+		JudySlot* pvalue;
+		JUDYARRAY[i].value = key;
+		pvalue = judy_cell(judyarray, (uchar*)&key, 0);
+		*(struct judyarray_object**)pvalue = &JUDYARRAY[i];
+	} STOP();
+#endif
+
+#ifdef USE_CUBE
+	START(DATA_CUBE) {
+		unsigned key = INSERT[i];
+		CUBE[i].value = key;
+		set_key(cube, key, &CUBE[i]);
+	} STOP();
+#endif
+
+#ifdef USE_LIBDYNAMIC
+	START(DATA_LIBDYNAMIC) {
+		unsigned key = INSERT[i];
+		struct libdynamic_object* obj = &LIBDYNAMIC[i];
+		obj->value = key;
+		map_insert(&libdynamic, &obj, libdynamic_hash, libdynamic_equal, libdynamic_set, 0);
+	} STOP();
+#endif
+
+#ifdef USE_CK
+	START(DATA_CK) {
+		unsigned key = INSERT[i];
+		unsigned hash_key;
+		CK[i].value = key;
+		hash_key = CK_HS_HASH(&ck, hs_hash, &CK[i]);
+		ck_hs_put(&ck, hash_key, &CK[i]);
+	} STOP();
+#endif
+}
+
+void test_hit(unsigned* SEARCH)
+{
+	unsigned i;
+
+	/* always dereference the object found. It has cache effect. */
+	/* considering we are dealing with objects, it makes sense to simulate an access to it */
+	/* this favorites data structures that store part of the information in the object itself */
+	const int dereference = 1;
+
+	const unsigned DELTA = 1;
+
+	START(DATA_TREE) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct rbt_object key_obj;
+		struct rbt_object* obj;
+		key_obj.value = key;
+		obj = rbt_search(&tree, &key_obj); 
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_HASHTABLE) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashtable_search(&hashtable, tommy_hashtable_compare, &key, hash_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_HASHDYN) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashdyn_search(&hashdyn, tommy_hashtable_compare, &key, hash_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_HASHDYNC) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtablec_object* obj;
+		obj = (struct hashtablec_object*)tommy_hashdync_search(&hashdync, tommy_hashtablec_compare, &key, hash_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_HASHLIN) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashlin_search(&hashlin, tommy_hashtable_compare, &key, hash_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_HASHLINC) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtablec_object* obj;
+		obj = (struct hashtablec_object*)tommy_hashlinc_search(&hashlinc, tommy_hashtablec_compare, &key, hash_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_MPHF) {
+		unsigned key = SEARCH[i] + DELTA;
+		tommy_size_t pos = tommy_mphf_search(&mphf, tommy_hash_u64(0, &key, sizeof(key)));
+		struct mphf_object* obj;
+		if (pos >= the_max)
+			abort();
+		/* always dereference, as the mphf doesn't store the keys */
+		obj = &MPHF[pos];
+		if (obj->value != key)
+			abort();
+	} STOP();
+
+	START(DATA_TRIE) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct trie_object* obj;
+		obj = (struct trie_object*)tommy_trie_search(&trie, key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_TRIE_INPLACE) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct trie_inplace_object* obj;
+		obj = (struct trie_inplace_object*)tommy_trie_inplace_search(&trie_inplace, key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_KHASH) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		khiter_t k;
+		k = kh_get(word, khash, hash_key);
+		if (k == kh_end(khash))
+			abort();
+		if (dereference) {
+			struct khash_object* obj = kh_value(khash, k);
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+#ifdef USE_GOOGLELIBCHASH
+	START(DATA_GOOGLELIBCHASH) {
+		unsigned key = SEARCH[i] + DELTA;
+		HTItem* ptr;
+		ptr = HashFind(googlelibhash, key);
+		if (!ptr)
+			abort();
+		if (dereference) {
+			struct google_object* obj = (void*)ptr->data;
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_GOOGLEDENSEHASH
+	START(DATA_GOOGLEDENSEHASH) {
+		unsigned key = SEARCH[i] + DELTA;
+		googledensehash_t::const_iterator ptr = googledensehash->find(key);
+		if (ptr == googledensehash->end())
+			abort();
+		if (dereference) {
+			struct google_object* obj = ptr->second;
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_GOOGLEBTREE
+	START(DATA_GOOGLEBTREE) {
+		unsigned key = SEARCH[i] + DELTA;
+		googlebtree_t::const_iterator ptr = googlebtree->find(key);
+		if (ptr == googlebtree->end())
+			abort();
+		if (dereference) {
+			struct google_object* obj = ptr->second;
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_STXBTREE
+	START(DATA_STXBTREE) {
+		unsigned key = SEARCH[i] + DELTA;
+		stxbtree_t::const_iterator ptr = stxbtree->find(key);
+		if (ptr == stxbtree->end())
+			abort();
+		if (dereference) {
+			struct stx_object* obj = ptr->second;
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_CPPMAP
+	START(DATA_CPPMAP) {
+		unsigned key = SEARCH[i] + DELTA;
+		cppmap_t::const_iterator ptr = cppmap->find(key);
+		if (ptr == cppmap->end())
+			abort();
+		if (dereference) {
+			struct cpp_object* obj = ptr->second;
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_CPPUNORDEREDMAP
+	START(DATA_CPPUNORDEREDMAP) {
+		unsigned key = SEARCH[i] + DELTA;
+		cppunorderedmap_t::const_iterator ptr = cppunorderedmap->find(key);
+		if (ptr == cppunorderedmap->end())
+			abort();
+		if (dereference) {
+			struct cpp_object* obj = ptr->second;
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+	START(DATA_UTHASH) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct uthash_object* obj;
+		HASH_FIND_INT(uthash, &key, obj);  
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_NEDTRIE) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct nedtrie_object key_obj;
+		struct nedtrie_object* obj;
+		key_obj.value = key;
+		obj = NEDTRIE_FIND(nedtrie_t, &nedtrie, &key_obj);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+#ifdef USE_JUDY
+	START(DATA_JUDY) {
+		Word_t key = SEARCH[i] + DELTA;
+		Pvoid_t PValue;
+		JLG(PValue, judy, key);
+		if (!PValue)
+			abort();
+		if (dereference) {
+			struct judy_object* obj = *(struct judy_object**)PValue;
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_JUDYARRAY
+	START(DATA_JUDYARRAY) {
+		judyvalue key = SEARCH[i] + DELTA;
+		JudySlot* pvalue;
+		pvalue = judy_slot(judyarray, (uchar*)&key, 0);
+		if (!pvalue)
+			abort();
+		if (dereference) {
+			struct judyarray_object* obj = *(struct judyarray_object**)pvalue;
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_CUBE
+	START(DATA_CUBE) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct cube_object* obj;
+		obj = (struct cube_object*)get_key(cube, key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_LIBDYNAMIC
+	START(DATA_LIBDYNAMIC) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct libdynamic_object key_obj;
+		struct libdynamic_object* key_ptr = &key_obj;
+		struct libdynamic_object* obj;
+		key_obj.value = key;
+		obj = *(struct libdynamic_object**)map_at(&libdynamic, &key_ptr, libdynamic_hash, libdynamic_equal);
+		if (obj == &libdynamic_empty)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_CK
+	START(DATA_CK) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key;
+		struct ck_object obj_key;
+		struct ck_object* obj;
+		obj_key.value = key;
+		hash_key = CK_HS_HASH(&ck, hs_hash, &obj_key);
+		obj = (struct ck_object*)ck_hs_get(&ck, hash_key, &obj_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+}
+
+void test_miss(unsigned* SEARCH)
+{
+	unsigned i;
+
+	const unsigned DELTA = 0;
+
+	START(DATA_TREE) {
+		struct rbt_object key;
+		key.value = SEARCH[i] + DELTA;
+		if (rbt_search(&tree, &key))
+			abort();
+	} STOP();
+
+	START(DATA_HASHTABLE) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
 		obj = (struct hashtable_object*)tommy_hashtable_search(&hashtable, tommy_hashtable_compare, &key, hash_key);
+		if (obj)
+			abort();
+	} STOP();
+
+	START(DATA_HASHDYN) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashdyn_search(&hashdyn, tommy_hashtable_compare, &key, hash_key);
+		if (obj)
+			abort();
+	} STOP();
+
+	START(DATA_HASHDYNC) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtablec_object* obj;
+		obj = (struct hashtablec_object*)tommy_hashdync_search(&hashdync, tommy_hashtablec_compare, &key, hash_key);
+		if (obj)
+			abort();
+	} STOP();
+
+	START(DATA_HASHLIN) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashlin_search(&hashlin, tommy_hashtable_compare, &key, hash_key);
+		if (obj)
+			abort();
+	} STOP();
+
+	START(DATA_HASHLINC) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtablec_object* obj;
+		obj = (struct hashtablec_object*)tommy_hashlinc_search(&hashlinc, tommy_hashtablec_compare, &key, hash_key);
+		if (obj)
+			abort();
+	} STOP();
+
+	START(DATA_MPHF) {
+		unsigned key = SEARCH[i] + DELTA;
+		tommy_size_t pos = tommy_mphf_search(&mphf, tommy_hash_u64(0, &key, sizeof(key)));
+		if (pos < the_max && MPHF[pos].value == key)
+			abort();
+	} STOP();
+
+	START(DATA_TRIE) {
+		struct trie_object* obj;
+		obj = (struct trie_object*)tommy_trie_search(&trie, SEARCH[i] + DELTA);
+		if (obj)
+			abort();
+	} STOP();
+
+	START(DATA_TRIE_INPLACE) {
+		struct trie_inplace_object* obj;
+		obj = (struct trie_inplace_object*)tommy_trie_inplace_search(&trie_inplace, SEARCH[i] + DELTA);
+		if (obj)
+			abort();
+	} STOP();
+
+	START(DATA_KHASH) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key = hash(key);
+		khiter_t k;
+		k = kh_get(word, khash, hash_key);
+		if (k != kh_end(khash))
+			abort();
+	} STOP();
+
+#ifdef USE_GOOGLELIBCHASH
+	START(DATA_GOOGLELIBCHASH) {
+		unsigned key = SEARCH[i] + DELTA;
+		HTItem* ptr;
+		ptr = HashFind(googlelibhash, key);
+		if (ptr)
+			abort();
+	} STOP();
+#endif
+
+#ifdef USE_GOOGLEDENSEHASH
+	START(DATA_GOOGLEDENSEHASH) {
+		unsigned key = SEARCH[i] + DELTA;
+		googledensehash_t::const_iterator ptr = googledensehash->find(key);
+		if (ptr != googledensehash->end())
+			abort();
+	} STOP();
+#endif
+
+#ifdef USE_GOOGLEBTREE
+	START(DATA_GOOGLEBTREE) {
+		unsigned key = SEARCH[i] + DELTA;
+		googlebtree_t::const_iterator ptr = googlebtree->find(key);
+		if (ptr != googlebtree->end())
+			abort();
+	} STOP();
+#endif
+
+#ifdef USE_STXBTREE
+	START(DATA_STXBTREE) {
+		unsigned key = SEARCH[i] + DELTA;
+		stxbtree_t::const_iterator ptr = stxbtree->find(key);
+		if (ptr != stxbtree->end())
+			abort();
+	} STOP();
+#endif
+
+
+#ifdef USE_CPPMAP
+	START(DATA_CPPMAP) {
+		unsigned key = SEARCH[i] + DELTA;
+		cppmap_t::const_iterator ptr = cppmap->find(key);
+		if (ptr != cppmap->end())
+			abort();
+	} STOP();
+#endif
+
+#ifdef USE_CPPUNORDEREDMAP
+	START(DATA_CPPUNORDEREDMAP) {
+		unsigned key = SEARCH[i] + DELTA;
+		cppunorderedmap_t::const_iterator ptr = cppunorderedmap->find(key);
+		if (ptr != cppunorderedmap->end())
+			abort();
+	} STOP();
+#endif
+
+	START(DATA_UTHASH) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct uthash_object* obj;
+		HASH_FIND_INT(uthash, &key, obj);  
+		if (obj)
+			abort();
+	} STOP();
+
+	START(DATA_NEDTRIE) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct nedtrie_object key_obj;
+		struct nedtrie_object* obj;
+		key_obj.value = key;
+		obj = NEDTRIE_FIND(nedtrie_t, &nedtrie, &key_obj);
+		if (obj)
+			abort();
+	} STOP();
+
+#ifdef USE_JUDY
+	START(DATA_JUDY) {
+		Word_t key = SEARCH[i] + DELTA;
+		Pvoid_t PValue;
+		JLG(PValue, judy, key);
+		if (PValue)
+			abort();
+	} STOP();
+#endif
+
+#ifdef USE_JUDYARRAY
+	START(DATA_JUDYARRAY) {
+		judyvalue key = SEARCH[i] + DELTA;
+		JudySlot* pvalue;
+		pvalue = judy_slot(judyarray, (uchar*)&key, 0);
+		if (pvalue) {
+			/* workaround for a judyarray bug. Sometimes it returns a pvalue pointing to NULL */
+			void* obj = *(void**)pvalue;
+			if (obj)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_CUBE
+	START(DATA_CUBE) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct cube_obj* obj;
+		obj = (struct cube_obj*)get_key(cube, key);
+		if (obj)
+			abort();
+	} STOP();
+#endif
+
+#ifdef USE_LIBDYNAMIC
+	START(DATA_LIBDYNAMIC) {
+		unsigned key = SEARCH[i] + DELTA;
+		struct libdynamic_object key_obj;
+		struct libdynamic_object* key_ptr = &key_obj;
+		struct libdynamic_object* obj;
+		key_obj.value = key;
+		obj = *(struct libdynamic_object**)map_at(&libdynamic, &key_ptr, libdynamic_hash, libdynamic_equal);
+		if (obj != &libdynamic_empty)
+			abort();
+	} STOP();
+#endif
+
+#ifdef USE_CK
+	START(DATA_CK) {
+		unsigned key = SEARCH[i] + DELTA;
+		unsigned hash_key;
+		struct ck_object obj_key;
+		struct ck_object* obj;
+		obj_key.value = key;
+		hash_key = CK_HS_HASH(&ck, hs_hash, &obj_key);
+		obj = (struct ck_object*)ck_hs_get(&ck, hash_key, &obj_key);
+		if (obj)
+			abort();
+	} STOP();
+#endif
+}
+
+void test_change(unsigned* REMOVE, unsigned* INSERT)
+{
+	unsigned i;
+
+	const unsigned DELTA = 1;
+
+	START(DATA_TREE) {
+		unsigned key = REMOVE[i];
+		struct rbt_object key_obj;
+		struct rbt_object* obj;
+		key_obj.value = REMOVE[i];
+		obj = rbt_search(&tree, &key_obj); 
+		if (!obj)
+			abort();
+		rbt_remove(&tree, obj);
+
+		key = INSERT[i] + DELTA;  
+		obj->value = key;
+		rbt_insert(&tree, obj);
+	} STOP();
+
+	START(DATA_HASHTABLE) {
+		unsigned key = REMOVE[i];
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashtable_remove(&hashtable, tommy_hashtable_compare, &key, hash_key);
+		if (!obj)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		hash_key = hash(key);
+		obj->value = key;
+		tommy_hashtable_insert(&hashtable, &obj->node, obj, hash_key);
+	} STOP();
+
+	START(DATA_HASHDYN) {
+		unsigned key = REMOVE[i];
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashdyn_remove(&hashdyn, tommy_hashtable_compare, &key, hash_key);
+		if (!obj)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		hash_key = hash(key);
+		obj->value = key;
+		tommy_hashdyn_insert(&hashdyn, &obj->node, obj, hash_key);
+	} STOP();
+
+	START(DATA_HASHDYNC) {
+		unsigned key = REMOVE[i];
+		unsigned hash_key = hash(key);
+		struct hashtablec_object* obj;
+		obj = (struct hashtablec_object*)tommy_hashdync_remove(&hashdync, tommy_hashtablec_compare, &key, hash_key);
+		if (!obj)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		hash_key = hash(key);
+		obj->value = key;
+		tommy_hashdync_insert(&hashdync, &obj->node, hash_key);
+	} STOP();
+
+	START(DATA_HASHLIN) {
+		unsigned key = REMOVE[i];
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashlin_remove(&hashlin, tommy_hashtable_compare, &key, hash_key);
+		if (!obj)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		hash_key = hash(key);
+		obj->value = key;
+		tommy_hashlin_insert(&hashlin, &obj->node, obj, hash_key);
+	} STOP();
+
+	START(DATA_HASHLINC) {
+		unsigned key = REMOVE[i];
+		unsigned hash_key = hash(key);
+		struct hashtablec_object* obj;
+		obj = (struct hashtablec_object*)tommy_hashlinc_remove(&hashlinc, tommy_hashtablec_compare, &key, hash_key);
+		if (!obj)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		hash_key = hash(key);
+		obj->value = key;
+		tommy_hashlinc_insert(&hashlinc, &obj->node, hash_key);
+	} STOP();
+
+	START(DATA_TRIE) {
+		unsigned key = REMOVE[i];
+		struct trie_object* obj;
+		obj = (struct trie_object*)tommy_trie_remove(&trie, key);
+		if (!obj)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		tommy_trie_insert(&trie, &obj->node, obj, key);
+	} STOP();
+
+	START(DATA_TRIE_INPLACE) {
+		unsigned key = REMOVE[i];
+		struct trie_inplace_object* obj;
+		obj = (struct trie_inplace_object*)tommy_trie_inplace_remove(&trie_inplace, key);
+		if (!obj)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		tommy_trie_inplace_insert(&trie_inplace, &obj->node, obj, key);
+	} STOP();
+
+	START(DATA_KHASH) {
+		unsigned key = REMOVE[i];
+		unsigned hash_key = hash(key);
+		khiter_t k;
+		int r;
+		struct khash_object* obj;
+		k = kh_get(word, khash, hash_key);
+		if (k == kh_end(khash))
+			abort();
+		obj = kh_value(khash, k);
+		kh_del(word, khash, k);
+
+		key = INSERT[i] + DELTA;
+		hash_key = hash(key);
+		obj->value = key;
+		k = kh_put(word, khash, hash_key, &r);
+		if (!r)
+			abort();
+		kh_value(khash, k) = obj;
+	} STOP();
+
+#ifdef USE_GOOGLELIBCHASH
+	START(DATA_GOOGLELIBCHASH) {
+		unsigned key = REMOVE[i];
+		HTItem* ptr;
+		struct google_object* obj;
+		u_long ptr_value;
+		ptr = HashFind(googlelibhash, key);
+		if (!ptr)
+			abort();
+		obj = (void*)ptr->data;
+		HashDeleteLast(googlelibhash);
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		ptr_value = (u_long)obj;
+		ptr = HashInsert(googlelibhash, key, ptr_value);
+		if (!ptr)
+			abort();
+	} STOP();
+#endif
+
+#ifdef USE_GOOGLEDENSEHASH
+	START(DATA_GOOGLEDENSEHASH) {
+		unsigned key = REMOVE[i];
+		googledensehash_t::iterator ptr = googledensehash->find(key);
+		struct google_object* obj;
+		if (ptr == googledensehash->end())
+			abort();
+		obj = ptr->second;
+		googledensehash->erase(ptr);
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		(*googledensehash)[key] = obj;
+	} STOP();
+#endif
+
+#ifdef USE_GOOGLEBTREE
+	START(DATA_GOOGLEBTREE) {
+		unsigned key = REMOVE[i];
+		googlebtree_t::iterator ptr = googlebtree->find(key);
+		struct google_object* obj;
+		if (ptr == googlebtree->end())
+			abort();
+		obj = ptr->second;
+		googlebtree->erase(ptr);
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		(*googlebtree)[key] = obj;
+	} STOP();
+#endif
+
+#ifdef USE_STXBTREE
+	START(DATA_STXBTREE) {
+		unsigned key = REMOVE[i];
+		stxbtree_t::iterator ptr = stxbtree->find(key);
+		struct stx_object* obj;
+		if (ptr == stxbtree->end())
+			abort();
+		obj = ptr->second;
+		stxbtree->erase(ptr);
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		(*stxbtree)[key] = obj;
+	} STOP();
+#endif
+
+#ifdef USE_CPPMAP
+	START(DATA_CPPMAP) {
+		unsigned key = REMOVE[i];
+		cppmap_t::iterator ptr = cppmap->find(key);
+		struct cpp_object* obj;
+		if (ptr == cppmap->end())
+			abort();
+		obj = ptr->second;
+		cppmap->erase(ptr);
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		(*cppmap)[key] = obj;
+	} STOP();
+#endif
+
+#ifdef USE_CPPUNORDEREDMAP
+	START(DATA_CPPUNORDEREDMAP) {
+		unsigned key = REMOVE[i];
+		cppunorderedmap_t::iterator ptr = cppunorderedmap->find(key);
+		struct cpp_object* obj;
+		if (ptr == cppunorderedmap->end())
+			abort();
+		obj = ptr->second;
+		cppunorderedmap->erase(ptr);
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		(*cppunorderedmap)[key] = obj;
+	} STOP();
+#endif
+
+	START(DATA_UTHASH) {
+		unsigned key = REMOVE[i];
+		struct uthash_object* obj;
+		HASH_FIND_INT(uthash, &key, obj);
+		if (!obj)
+			abort();
+		HASH_DEL(uthash, obj);
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		HASH_ADD_INT(uthash, value, obj);
+	} STOP();
+
+	START(DATA_NEDTRIE) {
+		unsigned key = REMOVE[i];
+		struct nedtrie_object key_obj;
+		struct nedtrie_object* obj;
+		key_obj.value = key;
+		obj = NEDTRIE_FIND(nedtrie_t, &nedtrie, &key_obj);
+		if (!obj)
+			abort();
+		NEDTRIE_REMOVE(nedtrie_t, &nedtrie, obj);
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		NEDTRIE_INSERT(nedtrie_t, &nedtrie, obj);
+	} STOP();
+
+#ifdef USE_JUDY
+	START(DATA_JUDY) {
+		Word_t key = REMOVE[i];
+		struct judy_object* obj;
+		int r;
+		Pvoid_t PValue;
+		JLG(PValue, judy, key);
+		if (!PValue)
+			abort();
+		obj = *(struct judy_object**)PValue;
+		JLD(r, judy, key);
+		if (r != 1)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		JLI(PValue, judy, key);
+		*(struct judy_object**)PValue = obj;
+	} STOP();
+#endif
+
+#ifdef USE_JUDYARRAY
+	START(DATA_JUDYARRAY) {
+		judyvalue key = REMOVE[i];
+		struct judyarray_object* obj;
+		JudySlot* pvalue;
+		pvalue = judy_slot(judyarray, (uchar*)&key, 0);
+		if (!pvalue)
+			abort();
+		obj = *(struct judyarray_object**)pvalue;
+		judy_del(judyarray);
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		pvalue = judy_cell(judyarray, (uchar*)&key, 0);
+		*(struct judyarray_object**)pvalue = obj;
+	} STOP();
+#endif
+
+#ifdef USE_CUBE
+	START(DATA_CUBE) {
+		unsigned key = REMOVE[i];
+		struct cube_object* obj;
+		obj = (struct cube_object*)del_key(cube, key);
+		if (!obj)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		set_key(cube, key, obj);
+	} STOP();
+#endif
+
+#ifdef USE_LIBDYNAMIC
+	START(DATA_LIBDYNAMIC) {
+		unsigned key = REMOVE[i];
+		struct libdynamic_object key_obj;
+		struct libdynamic_object* key_ptr = &key_obj;
+		struct libdynamic_object* obj;
+		key_obj.value = key;
+		LIBDYNAMIC_RELEASE = 0;
+		map_erase(&libdynamic, &key_ptr, libdynamic_hash, libdynamic_equal, libdynamic_set, libdynamic_release);
+		obj = LIBDYNAMIC_RELEASE;
+		if (!obj)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		map_insert(&libdynamic, &obj, libdynamic_hash, libdynamic_equal, libdynamic_set, 0);
+	} STOP();
+#endif
+
+#ifdef USE_CK
+	START(DATA_CK) {
+		unsigned key = REMOVE[i];
+		unsigned hash_key;
+		struct ck_object obj_key;
+		struct ck_object* obj;
+		obj_key.value = key;
+		hash_key = CK_HS_HASH(&ck, hs_hash, &obj_key);
+		obj = (struct ck_object*)ck_hs_remove(&ck, hash_key, &obj_key);
+		if (!obj)
+			abort();
+
+		key = INSERT[i] + DELTA;
+		obj->value = key;
+		hash_key = CK_HS_HASH(&ck, hs_hash, obj);
+		ck_hs_put(&ck, hash_key, obj);
+	} STOP();
+#endif
+}
+
+void test_remove(unsigned* REMOVE)
+{
+	unsigned i;
+
+	/* always dereference the object deleted. It has cache effect. */
+	/* considering we are dealing with objects, it makes sense to simulate an access to it */
+	/* even on deletion, because you have at least to do a free() call. */
+	/* this favorites data structures that store part of the information in the object itself */
+	const int dereference = 1;
+
+	const unsigned DELTA = 1;
+
+	START(DATA_TREE) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct rbt_object key_obj;
+		struct rbt_object* obj;
+		key_obj.value = key;
+		obj = rbt_search(&tree, &key_obj); 
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+		rbt_remove(&tree, obj);
+	} STOP();
+
+	START(DATA_HASHTABLE) {
+		unsigned key = REMOVE[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashtable_remove(&hashtable, tommy_hashtable_compare, &key, hash_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_HASHDYN) {
+		unsigned key = REMOVE[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashdyn_remove(&hashdyn, tommy_hashtable_compare, &key, hash_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_HASHDYNC) {
+		unsigned key = REMOVE[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtablec_object* obj;
+		obj = (struct hashtablec_object*)tommy_hashdync_remove(&hashdync, tommy_hashtablec_compare, &key, hash_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_HASHLIN) {
+		unsigned key = REMOVE[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtable_object* obj;
+		obj = (struct hashtable_object*)tommy_hashlin_remove(&hashlin, tommy_hashtable_compare, &key, hash_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_HASHLINC) {
+		unsigned key = REMOVE[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct hashtablec_object* obj;
+		obj = (struct hashtablec_object*)tommy_hashlinc_remove(&hashlinc, tommy_hashtablec_compare, &key, hash_key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_TRIE) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct trie_object* obj;
+		obj = (struct trie_object*)tommy_trie_remove(&trie, key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_TRIE_INPLACE) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct trie_inplace_object* obj;
+		obj = (struct trie_inplace_object*)tommy_trie_inplace_remove(&trie_inplace, key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_KHASH) {
+		unsigned key = REMOVE[i] + DELTA;
+		unsigned hash_key = hash(key);
+		struct khash_object* obj;
+		khiter_t k;
+		k = kh_get(word, khash, hash_key);
+		if (k == kh_end(khash))
+			abort();
+		if (dereference) {
+			obj = kh_value(khash, k);
+		}
+		kh_del(word, khash, k);
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+#ifdef USE_GOOGLELIBCHASH
+	START(DATA_GOOGLELIBCHASH) {
+		unsigned key = REMOVE[i] + DELTA;
+		HTItem* ptr;
+		struct google_object* obj;
+		ptr = HashFind(googlelibhash, key);
+		if (!ptr)
+			abort();
+		obj = (struct google_object*)ptr->data;
+		HashDeleteLast(googlelibhash);
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_GOOGLEDENSEHASH
+	START(DATA_GOOGLEDENSEHASH) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct google_object* obj;
+		googledensehash_t::iterator ptr = googledensehash->find(key);
+		if (ptr == googledensehash->end())
+			abort();
+		obj = ptr->second;
+		googledensehash->erase(ptr);
+
+		/* force a resize when we reach 20% load factor */
+		googledensehash->resize(0);
+
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_GOOGLEBTREE
+	START(DATA_GOOGLEBTREE) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct google_object* obj;
+		googlebtree_t::iterator ptr = googlebtree->find(key);
+		if (ptr == googlebtree->end())
+			abort();
+		obj = ptr->second;
+		googlebtree->erase(ptr);
+
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_STXBTREE
+	START(DATA_STXBTREE) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct stx_object* obj;
+		stxbtree_t::iterator ptr = stxbtree->find(key);
+		if (ptr == stxbtree->end())
+			abort();
+		obj = ptr->second;
+		stxbtree->erase(ptr);
+
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_CPPMAP
+	START(DATA_CPPMAP) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct cpp_object* obj;
+		cppmap_t::iterator ptr = cppmap->find(key);
+		if (ptr == cppmap->end())
+			abort();
+		obj = ptr->second;
+		cppmap->erase(ptr);
+
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_CPPUNORDEREDMAP
+	START(DATA_CPPUNORDEREDMAP) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct cpp_object* obj;
+		cppunorderedmap_t::iterator ptr = cppunorderedmap->find(key);
+		if (ptr == cppunorderedmap->end())
+			abort();
+		obj = ptr->second;
+		cppunorderedmap->erase(ptr);
+
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+	START(DATA_UTHASH) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct uthash_object* obj;
+		HASH_FIND_INT(uthash, &key, obj);  
+		if (!obj)
+			abort();
+		HASH_DEL(uthash, obj);  
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+	START(DATA_NEDTRIE) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct nedtrie_object key_obj;
+		struct nedtrie_object* obj;
+		key_obj.value = key;
+		obj = NEDTRIE_FIND(nedtrie_t, &nedtrie, &key_obj);
+		if (!obj)
+			abort();
+		NEDTRIE_REMOVE(nedtrie_t, &nedtrie, obj);
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+
+#ifdef USE_JUDY
+	START(DATA_JUDY) {
+		Word_t key = REMOVE[i] + DELTA;
+		struct judy_object* obj;
+		int r;
+		if (dereference) {
+			Pvoid_t PValue;
+			JLG(PValue, judy, key);
+			if (!PValue)
+				abort();
+			obj = *(struct judy_object**)PValue;
+		}
+		JLD(r, judy, key);
+		if (r != 1)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_JUDYARRAY
+	START(DATA_JUDYARRAY) {
+		judyvalue key = REMOVE[i] + DELTA;
+		struct judyarray_object* obj;
+		JudySlot* pvalue;
+		pvalue = judy_slot(judyarray, (uchar*)&key, 0);
+		if (!pvalue)
+			abort();
+		obj = *(struct judyarray_object**)pvalue;
+		judy_del(judyarray);
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_CUBE
+	START(DATA_CUBE) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct cube_object* obj;
+		obj = (struct cube_object*)del_key(cube, key);
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_LIBDYNAMIC
+	START(DATA_LIBDYNAMIC) {
+		unsigned key = REMOVE[i] + DELTA;
+		struct libdynamic_object key_obj;
+		struct libdynamic_object* key_ptr = &key_obj;
+		struct libdynamic_object* obj;
+		key_obj.value = key;
+		LIBDYNAMIC_RELEASE = 0;
+		map_erase(&libdynamic, &key_ptr, libdynamic_hash, libdynamic_equal, libdynamic_set, libdynamic_release);
+		obj = LIBDYNAMIC_RELEASE;
+		if (!obj)
+			abort();
+		if (dereference) {
+			if (obj->value != key)
+				abort();
+		}
+	} STOP();
+#endif
+
+#ifdef USE_CK
+	START(DATA_CK) {
+		unsigned key = REMOVE[i] + DELTA;
+		unsigned hash_key;
+		struct ck_object obj_key;
+		struct ck_object* obj;
+		obj_key.value = key;
+		hash_key = CK_HS_HASH(&ck, hs_hash, &obj_key);
+		obj = (struct ck_object*)ck_hs_remove(&ck, hash_key, &obj_key);
 		if (!obj)
 			abort();
 		if (dereference) {
@@ -1413,1385 +3778,2103 @@ void test_hit(unsigned* SEARCH)
 				abort();
 		}
 	} STOP();
+#endif
+}
+
+tommy_size_t uthash_size(struct uthash_object* obj)
+{
+	UT_hash_table* table;
+	if (!obj)
+		return 0;
+	table = obj->hh.tbl;
+	if (!table)
+		return 0;
+	return table->num_buckets * (tommy_size_t)sizeof(table->buckets[0])
+		+ table->num_items * (tommy_size_t)sizeof(UT_hash_handle);
+}
+
+tommy_size_t nedtrie_size(struct nedtrie_t* col)
+{
+	struct nedtrie_object element;
+	(void)element;
+	return col->count * sizeof(element.link);
+}
+
+tommy_size_t khash_size(khash_t(word)* col)
+{
+	return col->n_buckets * sizeof(void*) /* val */
+		+ col->n_buckets * sizeof(uint32_t) /* key */
+		+ (col->n_buckets >> 4) * sizeof(uint32_t); /* flags */
+}
+
+#ifdef USE_GOOGLEDENSEHASH
+tommy_size_t googledensehash_size(googledensehash_t* col)
+{
+	googledensehash_t::value_type element;
+	(void)element;
+	return col->bucket_count() * sizeof(element);
+}
+#endif
+
+#ifdef USE_GOOGLEBTREE
+tommy_size_t googlebtree_size(googlebtree_t* col)
+{
+	return col->bytes_used();
+}
+#endif
+
+#ifdef USE_STXBTREE
+tommy_size_t stxbtree_size(stxbtree_t* col)
+{
+	return col->get_stats().leaves * sizeof(struct stxbtree_t::btree_impl::leaf_node)
+		+ col->get_stats().innernodes * sizeof(struct stxbtree_t::btree_impl::inner_node);
+	return 0;
+}
+#endif
+
+tommy_size_t rbt_size(rbtree_t* col, unsigned count)
+{
+	struct rbt_object element;
+	(void)col;
+	(void)element;
+	return count * sizeof(element.link);
+}
+
+tommy_size_t libdynamic_size(map* ld)
+{
+	return sizeof(map) + ld->element_size * ld->elements_capacity;
+}
+
+void test_size(void)
+{
+#ifdef USE_JUDY
+	Word_t w;
+#endif
+
+	MEM(DATA_TREE, rbt_size(&tree, the_max));
+	MEM(DATA_HASHTABLE, tommy_hashtable_memory_usage(&hashtable));
+	MEM(DATA_HASHDYN, tommy_hashdyn_memory_usage(&hashdyn));
+	MEM(DATA_HASHLIN, tommy_hashlin_memory_usage(&hashlin));
+	MEM(DATA_HASHDYNC, tommy_hashdync_memory_usage(&hashdync));
+	MEM(DATA_HASHLINC, tommy_hashlinc_memory_usage(&hashlinc));
+	MEM(DATA_MPHF, tommy_mphf_memory_usage(&mphf));
+	MEM(DATA_TRIE, tommy_trie_memory_usage(&trie));
+	MEM(DATA_TRIE_INPLACE, tommy_trie_inplace_memory_usage(&trie_inplace));
+	MEM(DATA_KHASH, khash_size(khash));
+#ifdef USE_GOOGLEDENSEHASH
+	MEM(DATA_GOOGLEDENSEHASH, googledensehash_size(googledensehash));
+#endif
+#ifdef USE_GOOGLEBTREE
+	MEM(DATA_GOOGLEBTREE, googlebtree_size(googlebtree));
+#endif
+#ifdef USE_STXBTREE
+	MEM(DATA_STXBTREE, stxbtree_size(stxbtree));
+#endif
+	MEM(DATA_UTHASH, uthash_size(uthash));
+	MEM(DATA_NEDTRIE, nedtrie_size(&nedtrie));
+#ifdef USE_JUDY
+	JLMU(w, judy);
+	MEM(DATA_JUDY, w);
+#endif
+#ifdef USE_JUDYARRAY
+	MEM(DATA_JUDYARRAY,judy_size(judyarray));
+#endif
+#ifdef USE_CUBE
+	MEM(DATA_CUBE, size_cube(cube));
+#endif
+#ifdef USE_LIBDYNAMIC
+	MEM(DATA_LIBDYNAMIC, libdynamic_size(&libdynamic));
+#endif
+}
 
-	START(DATA_HASHDYN) {
-		unsigned key = SEARCH[i] + DELTA;
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashdyn_search(&hashdyn, tommy_hashtable_compare, &key, hash_key);
-		if (!obj)
+/******************************************************************************/
+/* string */
+
+/**
+ * If the data structure is tested with string keys.
+ */
+tommy_bool_t is_string(unsigned data)
+{
+	switch (data) {
+	case DATA_HASHDYN :
+	case DATA_HASHLIN :
+	case DATA_HASHDYNC :
+	case DATA_HASHLINC :
+	case DATA_KHASH :
+#ifdef USE_CPPUNORDEREDMAP
+	case DATA_CPPUNORDEREDMAP :
+#endif
+		return 1;
+	}
+
+	return 0;
+}
+
+void test_string_alloc(void)
+{
+	COND(DATA_HASHDYN) {
+		tommy_hashdyn_init(&hashdyn);
+		STRING_OBJ = (struct string_object*)malloc(sizeof(struct string_object) * the_max);
+	}
+
+	COND(DATA_HASHLIN) {
+		tommy_hashlin_init(&hashlin);
+		STRING_OBJ = (struct string_object*)malloc(sizeof(struct string_object) * the_max);
+	}
+
+	COND(DATA_HASHDYNC) {
+		tommy_hashdync_init(&hashdync, offsetof(struct stringc_object, node));
+		STRINGC_OBJ = (struct stringc_object*)malloc(sizeof(struct stringc_object) * the_max);
+	}
+
+	COND(DATA_HASHLINC) {
+		tommy_hashlinc_init(&hashlinc, offsetof(struct stringc_object, node));
+		STRINGC_OBJ = (struct stringc_object*)malloc(sizeof(struct stringc_object) * the_max);
+	}
+
+	COND(DATA_KHASH) {
+		khstring = kh_init(str);
+		STRING_OBJ = (struct string_object*)malloc(sizeof(struct string_object) * the_max);
+	}
+
+#ifdef USE_CPPUNORDEREDMAP
+	COND(DATA_CPPUNORDEREDMAP) {
+		cppstringmap = new cppstringmap_t;
+		STRING_OBJ = (struct string_object*)malloc(sizeof(struct string_object) * the_max);
+	}
+#endif
+}
+
+void test_string_free(void)
+{
+	COND(DATA_HASHDYN) {
+		if (tommy_hashdyn_count(&hashdyn) != 0)
 			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+		tommy_hashdyn_done(&hashdyn);
+		free(STRING_OBJ);
+	}
 
-	START(DATA_HASHLIN) {
-		unsigned key = SEARCH[i] + DELTA;
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashlin_search(&hashlin, tommy_hashtable_compare, &key, hash_key);
-		if (!obj)
+	COND(DATA_HASHLIN) {
+		if (tommy_hashlin_count(&hashlin) != 0)
 			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+		tommy_hashlin_done(&hashlin);
+		free(STRING_OBJ);
+	}
 
-	START(DATA_TRIE) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct trie_object* obj;
-		obj = (struct trie_object*)tommy_trie_search(&trie, key);
-		if (!obj)
+	COND(DATA_HASHDYNC) {
+		if (tommy_hashdync_count(&hashdync) != 0)
 			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+		tommy_hashdync_done(&hashdync);
+		free(STRINGC_OBJ);
+	}
 
-	START(DATA_TRIE_INPLACE) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct trie_inplace_object* obj;
-		obj = (struct trie_inplace_object*)tommy_trie_inplace_search(&trie_inplace, key);
-		if (!obj)
+	COND(DATA_HASHLINC) {
+		if (tommy_hashlinc_count(&hashlinc) != 0)
 			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+		tommy_hashlinc_done(&hashlinc);
+		free(STRINGC_OBJ);
+	}
 
-	START(DATA_KHASH) {
-		unsigned key = SEARCH[i] + DELTA;
-		unsigned hash_key = hash(key);
-		khiter_t k;
-		k = kh_get(word, khash, hash_key);
-		if (k == kh_end(khash))
+	COND(DATA_KHASH) {
+		if (kh_size(khstring) != 0)
 			abort();
-		if (dereference) {
-			struct khash_object* obj = kh_value(khash, k);
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+		kh_destroy(str, khstring);
+		free(STRING_OBJ);
+	}
 
-#ifdef USE_GOOGLELIBCHASH
-	START(DATA_GOOGLELIBCHASH) {
-		unsigned key = SEARCH[i] + DELTA;
-		HTItem* ptr;
-		ptr = HashFind(googlelibhash, key);
-		if (!ptr)
+#ifdef USE_CPPUNORDEREDMAP
+	COND(DATA_CPPUNORDEREDMAP) {
+		if (cppstringmap->size() != 0)
 			abort();
-		if (dereference) {
-			struct google_object* obj = (void*)ptr->data;
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+		delete cppstringmap;
+		free(STRING_OBJ);
+	}
 #endif
+}
 
-#ifdef USE_GOOGLEDENSEHASH
-	START(DATA_GOOGLEDENSEHASH) {
-		unsigned key = SEARCH[i] + DELTA;
-		googledensehash_t::const_iterator ptr = googledensehash->find(key);
-		if (ptr == googledensehash->end())
-			abort();
-		if (dereference) {
-			struct google_object* obj = ptr->second;
-			if (obj->value != key)
-				abort();
-		}
+void test_string_insert(unsigned* INSERT)
+{
+	unsigned i;
+
+	START(DATA_HASHDYN) {
+		const std::string* key = string_key(INSERT[i]);
+		struct string_object* obj = &STRING_OBJ[i];
+		obj->str = key->c_str();
+		obj->len = key->size();
+		tommy_hashdyn_insert(&hashdyn, &obj->node, obj, string_hash(key));
 	} STOP();
-#endif
 
-#ifdef USE_GOOGLEBTREE
-	START(DATA_GOOGLEBTREE) {
-		unsigned key = SEARCH[i] + DELTA;
-		googlebtree_t::const_iterator ptr = googlebtree->find(key);
-		if (ptr == googlebtree->end())
-			abort();
-		if (dereference) {
-			struct google_object* obj = ptr->second;
-			if (obj->value != key)
-				abort();
-		}
+	START(DATA_HASHLIN) {
+		const std::string* key = string_key(INSERT[i]);
+		struct string_object* obj = &STRING_OBJ[i];
+		obj->str = key->c_str();
+		obj->len = key->size();
+		tommy_hashlin_insert(&hashlin, &obj->node, obj, string_hash(key));
 	} STOP();
-#endif
 
-#ifdef USE_STXBTREE
-	START(DATA_STXBTREE) {
-		unsigned key = SEARCH[i] + DELTA;
-		stxbtree_t::const_iterator ptr = stxbtree->find(key);
-		if (ptr == stxbtree->end())
-			abort();
-		if (dereference) {
-			struct stx_object* obj = ptr->second;
-			if (obj->value != key)
-				abort();
-		}
+	START(DATA_HASHDYNC) {
+		const std::string* key = string_key(INSERT[i]);
+		struct stringc_object* obj = &STRINGC_OBJ[i];
+		obj->str = key->c_str();
+		obj->len = key->size();
+		tommy_hashdync_insert(&hashdync, &obj->node, string_hash(key));
 	} STOP();
-#endif
 
-#ifdef USE_CPPMAP
-	START(DATA_CPPMAP) {
-		unsigned key = SEARCH[i] + DELTA;
-		cppmap_t::const_iterator ptr = cppmap->find(key);
-		if (ptr == cppmap->end())
+	START(DATA_HASHLINC) {
+		const std::string* key = string_key(INSERT[i]);
+		struct stringc_object* obj = &STRINGC_OBJ[i];
+		obj->str = key->c_str();
+		obj->len = key->size();
+		tommy_hashlinc_insert(&hashlinc, &obj->node, string_hash(key));
+	} STOP();
+
+	START(DATA_KHASH) {
+		const std::string* key = string_key(INSERT[i]);
+		struct string_object* obj = &STRING_OBJ[i];
+		khiter_t k;
+		int r;
+		obj->str = key->c_str();
+		obj->len = key->size();
+		k = kh_put(str, khstring, obj->str, &r);
+		if (!r)
 			abort();
-		if (dereference) {
-			struct cpp_object* obj = ptr->second;
-			if (obj->value != key)
-				abort();
-		}
+		kh_value(khstring, k) = obj;
 	} STOP();
-#endif
 
 #ifdef USE_CPPUNORDEREDMAP
 	START(DATA_CPPUNORDEREDMAP) {
-		unsigned key = SEARCH[i] + DELTA;
-		cppunorderedmap_t::const_iterator ptr = cppunorderedmap->find(key);
-		if (ptr == cppunorderedmap->end())
-			abort();
-		if (dereference) {
-			struct cpp_object* obj = ptr->second;
-			if (obj->value != key)
-				abort();
-		}
+		const std::string* key = string_key(INSERT[i]);
+		struct string_object* obj = &STRING_OBJ[i];
+		obj->str = key->c_str();
+		obj->len = key->size();
+		(*cppstringmap)[*key] = obj;
 	} STOP();
 #endif
+}
 
-	START(DATA_UTHASH) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct uthash_object* obj;
-		HASH_FIND_INT(uthash, &key, obj);  
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+void test_string_hit(unsigned* SEARCH)
+{
+	unsigned i;
 
-	START(DATA_NEDTRIE) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct nedtrie_object key_obj;
-		struct nedtrie_object* obj;
-		key_obj.value = key;
-		obj = NEDTRIE_FIND(nedtrie_t, &nedtrie, &key_obj);
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+	const unsigned DELTA = 1;
 
-#ifdef USE_JUDY
-	START(DATA_JUDY) {
-		Word_t key = SEARCH[i] + DELTA;
-		Pvoid_t PValue;
-		JLG(PValue, judy, key);
-		if (!PValue)
+	START(DATA_HASHDYN) {
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		struct string_object* obj;
+		obj = (struct string_object*)tommy_hashdyn_search(&hashdyn, tommy_string_compare, key, string_hash(key));
+		if (!obj)
 			abort();
-		if (dereference) {
-			struct judy_object* obj = *(struct judy_object**)PValue;
-			if (obj->value != key)
-				abort();
-		}
 	} STOP();
-#endif
 
-#ifdef USE_JUDYARRAY
-	START(DATA_JUDYARRAY) {
-		judyvalue key = SEARCH[i] + DELTA;
-		JudySlot* pvalue;
-		pvalue = judy_slot(judyarray, (uchar*)&key, 0);
-		if (!pvalue)
+	START(DATA_HASHLIN) {
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		struct string_object* obj;
+		obj = (struct string_object*)tommy_hashlin_search(&hashlin, tommy_string_compare, key, string_hash(key));
+		if (!obj)
 			abort();
-		if (dereference) {
-			struct judyarray_object* obj = *(struct judyarray_object**)pvalue;
-			if (obj->value != key)
-				abort();
-		}
 	} STOP();
-#endif
 
-#ifdef USE_CUBE
-	START(DATA_CUBE) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct cube_object* obj;
-		obj = (struct cube_object*)get_key(cube, key);
+	START(DATA_HASHDYNC) {
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		struct stringc_object* obj;
+		obj = (struct stringc_object*)tommy_hashdync_search(&hashdync, tommy_stringc_compare, key, string_hash(key));
 		if (!obj)
 			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
 	} STOP();
-#endif
 
-#ifdef USE_LIBDYNAMIC
-	START(DATA_LIBDYNAMIC) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct libdynamic_object key_obj;
-		struct libdynamic_object* key_ptr = &key_obj;
-		struct libdynamic_object* obj;
-		key_obj.value = key;
-		obj = *(struct libdynamic_object**)map_at(&libdynamic, &key_ptr, libdynamic_hash, libdynamic_equal);
-		if (obj == &libdynamic_empty)
+	START(DATA_HASHLINC) {
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		struct stringc_object* obj;
+		obj = (struct stringc_object*)tommy_hashlinc_search(&hashlinc, tommy_stringc_compare, key, string_hash(key));
+		if (!obj)
 			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
 	} STOP();
-#endif
 
-#ifdef USE_CK
-	START(DATA_CK) {
-		unsigned key = SEARCH[i] + DELTA;
-		unsigned hash_key;
-		struct ck_object obj_key;
-		struct ck_object* obj;
-		obj_key.value = key;
-		hash_key = CK_HS_HASH(&ck, hs_hash, &obj_key);
-		obj = (struct ck_object*)ck_hs_get(&ck, hash_key, &obj_key);
-		if (!obj)
+	START(DATA_KHASH) {
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		khiter_t k;
+		k = kh_get(str, khstring, key->c_str());
+		if (k == kh_end(khstring))
+			abort();
+	} STOP();
+
+#ifdef USE_CPPUNORDEREDMAP
+	START(DATA_CPPUNORDEREDMAP) {
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		cppstringmap_t::const_iterator ptr = cppstringmap->find(*key);
+		if (ptr == cppstringmap->end())
 			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
 	} STOP();
 #endif
 }
 
-void test_miss(unsigned* SEARCH)
+void test_string_miss(unsigned* SEARCH)
 {
 	unsigned i;
 
 	const unsigned DELTA = 0;
 
-	START(DATA_TREE) {
-		struct rbt_object key;
-		key.value = SEARCH[i] + DELTA;
-		if (rbt_search(&tree, &key))
-			abort();
-	} STOP();
-
-	START(DATA_HASHTABLE) {
-		unsigned key = SEARCH[i] + DELTA;
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashtable_search(&hashtable, tommy_hashtable_compare, &key, hash_key);
-		if (obj)
-			abort();
-	} STOP();
-
 	START(DATA_HASHDYN) {
-		unsigned key = SEARCH[i] + DELTA;
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashdyn_search(&hashdyn, tommy_hashtable_compare, &key, hash_key);
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		struct string_object* obj;
+		obj = (struct string_object*)tommy_hashdyn_search(&hashdyn, tommy_string_compare, key, string_hash(key));
 		if (obj)
 			abort();
 	} STOP();
 
 	START(DATA_HASHLIN) {
-		unsigned key = SEARCH[i] + DELTA;
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashlin_search(&hashlin, tommy_hashtable_compare, &key, hash_key);
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		struct string_object* obj;
+		obj = (struct string_object*)tommy_hashlin_search(&hashlin, tommy_string_compare, key, string_hash(key));
 		if (obj)
 			abort();
 	} STOP();
 
-	START(DATA_TRIE) {
-		struct trie_object* obj;
-		obj = (struct trie_object*)tommy_trie_search(&trie, SEARCH[i] + DELTA);
+	START(DATA_HASHDYNC) {
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		struct stringc_object* obj;
+		obj = (struct stringc_object*)tommy_hashdync_search(&hashdync, tommy_stringc_compare, key, string_hash(key));
 		if (obj)
 			abort();
 	} STOP();
 
-	START(DATA_TRIE_INPLACE) {
-		struct trie_inplace_object* obj;
-		obj = (struct trie_inplace_object*)tommy_trie_inplace_search(&trie_inplace, SEARCH[i] + DELTA);
+	START(DATA_HASHLINC) {
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		struct stringc_object* obj;
+		obj = (struct stringc_object*)tommy_hashlinc_search(&hashlinc, tommy_stringc_compare, key, string_hash(key));
 		if (obj)
 			abort();
 	} STOP();
 
 	START(DATA_KHASH) {
-		unsigned key = SEARCH[i] + DELTA;
-		unsigned hash_key = hash(key);
+		const std::string* key = string_key(SEARCH[i] + DELTA);
 		khiter_t k;
-		k = kh_get(word, khash, hash_key);
-		if (k != kh_end(khash))
+		k = kh_get(str, khstring, key->c_str());
+		if (k != kh_end(khstring))
 			abort();
 	} STOP();
 
-#ifdef USE_GOOGLELIBCHASH
-	START(DATA_GOOGLELIBCHASH) {
-		unsigned key = SEARCH[i] + DELTA;
-		HTItem* ptr;
-		ptr = HashFind(googlelibhash, key);
-		if (ptr)
+#ifdef USE_CPPUNORDEREDMAP
+	START(DATA_CPPUNORDEREDMAP) {
+		const std::string* key = string_key(SEARCH[i] + DELTA);
+		cppstringmap_t::const_iterator ptr = cppstringmap->find(*key);
+		if (ptr != cppstringmap->end())
 			abort();
 	} STOP();
 #endif
+}
 
-#ifdef USE_GOOGLEDENSEHASH
-	START(DATA_GOOGLEDENSEHASH) {
-		unsigned key = SEARCH[i] + DELTA;
-		googledensehash_t::const_iterator ptr = googledensehash->find(key);
-		if (ptr != googledensehash->end())
+void test_string_change(unsigned* REMOVE, unsigned* INSERT)
+{
+	unsigned i;
+
+	const unsigned DELTA = 1;
+
+	START(DATA_HASHDYN) {
+		const std::string* key = string_key(REMOVE[i]);
+		struct string_object* obj;
+		obj = (struct string_object*)tommy_hashdyn_remove(&hashdyn, tommy_string_compare, key, string_hash(key));
+		if (!obj)
 			abort();
+
+		key = string_key(INSERT[i] + DELTA);
+		obj->str = key->c_str();
+		obj->len = key->size();
+		tommy_hashdyn_insert(&hashdyn, &obj->node, obj, string_hash(key));
 	} STOP();
-#endif
 
-#ifdef USE_GOOGLEBTREE
-	START(DATA_GOOGLEBTREE) {
-		unsigned key = SEARCH[i] + DELTA;
-		googlebtree_t::const_iterator ptr = googlebtree->find(key);
-		if (ptr != googlebtree->end())
+	START(DATA_HASHLIN) {
+		const std::string* key = string_key(REMOVE[i]);
+		struct string_object* obj;
+		obj = (struct string_object*)tommy_hashlin_remove(&hashlin, tommy_string_compare, key, string_hash(key));
+		if (!obj)
 			abort();
+
+		key = string_key(INSERT[i] + DELTA);
+		obj->str = key->c_str();
+		obj->len = key->size();
+		tommy_hashlin_insert(&hashlin, &obj->node, obj, string_hash(key));
 	} STOP();
-#endif
 
-#ifdef USE_STXBTREE
-	START(DATA_STXBTREE) {
-		unsigned key = SEARCH[i] + DELTA;
-		stxbtree_t::const_iterator ptr = stxbtree->find(key);
-		if (ptr != stxbtree->end())
+	START(DATA_HASHDYNC) {
+		const std::string* key = string_key(REMOVE[i]);
+		struct stringc_object* obj;
+		obj = (struct stringc_object*)tommy_hashdync_remove(&hashdync, tommy_stringc_compare, key, string_hash(key));
+		if (!obj)
 			abort();
+
+		key = string_key(INSERT[i] + DELTA);
+		obj->str = key->c_str();
+		obj->len = key->size();
+		tommy_hashdync_insert(&hashdync, &obj->node, string_hash(key));
 	} STOP();
-#endif
 
+	START(DATA_HASHLINC) {
+		const std::string* key = string_key(REMOVE[i]);
+		struct stringc_object* obj;
+		obj = (struct stringc_object*)tommy_hashlinc_remove(&hashlinc, tommy_stringc_compare, key, string_hash(key));
+		if (!obj)
+			abort();
 
-#ifdef USE_CPPMAP
-	START(DATA_CPPMAP) {
-		unsigned key = SEARCH[i] + DELTA;
-		cppmap_t::const_iterator ptr = cppmap->find(key);
-		if (ptr != cppmap->end())
+		key = string_key(INSERT[i] + DELTA);
+		obj->str = key->c_str();
+		obj->len = key->size();
+		tommy_hashlinc_insert(&hashlinc, &obj->node, string_hash(key));
+	} STOP();
+
+	START(DATA_KHASH) {
+		const std::string* key = string_key(REMOVE[i]);
+		struct string_object* obj;
+		khiter_t k;
+		int r;
+		k = kh_get(str, khstring, key->c_str());
+		if (k == kh_end(khstring))
+			abort();
+		obj = kh_value(khstring, k);
+		kh_del(str, khstring, k);
+
+		key = string_key(INSERT[i] + DELTA);
+		obj->str = key->c_str();
+		obj->len = key->size();
+		k = kh_put(str, khstring, obj->str, &r);
+		if (!r)
 			abort();
+		kh_value(khstring, k) = obj;
 	} STOP();
-#endif
 
 #ifdef USE_CPPUNORDEREDMAP
 	START(DATA_CPPUNORDEREDMAP) {
-		unsigned key = SEARCH[i] + DELTA;
-		cppunorderedmap_t::const_iterator ptr = cppunorderedmap->find(key);
-		if (ptr != cppunorderedmap->end())
+		const std::string* key = string_key(REMOVE[i]);
+		struct string_object* obj;
+		cppstringmap_t::iterator ptr = cppstringmap->find(*key);
+		if (ptr == cppstringmap->end())
 			abort();
+		obj = ptr->second;
+		cppstringmap->erase(ptr);
+
+		key = string_key(INSERT[i] + DELTA);
+		obj->str = key->c_str();
+		obj->len = key->size();
+		(*cppstringmap)[*key] = obj;
 	} STOP();
 #endif
+}
 
-	START(DATA_UTHASH) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct uthash_object* obj;
-		HASH_FIND_INT(uthash, &key, obj);  
-		if (obj)
+void test_string_remove(unsigned* REMOVE)
+{
+	unsigned i;
+
+	const unsigned DELTA = 1;
+
+	START(DATA_HASHDYN) {
+		const std::string* key = string_key(REMOVE[i] + DELTA);
+		struct string_object* obj;
+		obj = (struct string_object*)tommy_hashdyn_remove(&hashdyn, tommy_string_compare, key, string_hash(key));
+		if (!obj)
 			abort();
 	} STOP();
 
-	START(DATA_NEDTRIE) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct nedtrie_object key_obj;
-		struct nedtrie_object* obj;
-		key_obj.value = key;
-		obj = NEDTRIE_FIND(nedtrie_t, &nedtrie, &key_obj);
-		if (obj)
+	START(DATA_HASHLIN) {
+		const std::string* key = string_key(REMOVE[i] + DELTA);
+		struct string_object* obj;
+		obj = (struct string_object*)tommy_hashlin_remove(&hashlin, tommy_string_compare, key, string_hash(key));
+		if (!obj)
 			abort();
 	} STOP();
 
-#ifdef USE_JUDY
-	START(DATA_JUDY) {
-		Word_t key = SEARCH[i] + DELTA;
-		Pvoid_t PValue;
-		JLG(PValue, judy, key);
-		if (PValue)
+	START(DATA_HASHDYNC) {
+		const std::string* key = string_key(REMOVE[i] + DELTA);
+		struct stringc_object* obj;
+		obj = (struct stringc_object*)tommy_hashdync_remove(&hashdync, tommy_stringc_compare, key, string_hash(key));
+		if (!obj)
+			abort();
+	} STOP();
+
+	START(DATA_HASHLINC) {
+		const std::string* key = string_key(REMOVE[i] + DELTA);
+		struct stringc_object* obj;
+		obj = (struct stringc_object*)tommy_hashlinc_remove(&hashlinc, tommy_stringc_compare, key, string_hash(key));
+		if (!obj)
 			abort();
 	} STOP();
+
+	START(DATA_KHASH) {
+		const std::string* key = string_key(REMOVE[i] + DELTA);
+		struct string_object* obj;
+		khiter_t k;
+		k = kh_get(str, khstring, key->c_str());
+		if (k == kh_end(khstring))
+			abort();
+		obj = kh_value(khstring, k);
+		kh_del(str, khstring, k);
+		if (obj->len != key->size())
+			abort();
+	} STOP();
+
+#ifdef USE_CPPUNORDEREDMAP
+	START(DATA_CPPUNORDEREDMAP) {
+		const std::string* key = string_key(REMOVE[i] + DELTA);
+		struct string_object* obj;
+		cppstringmap_t::iterator ptr = cppstringmap->find(*key);
+		if (ptr == cppstringmap->end())
+			abort();
+		obj = ptr->second;
+		cppstringmap->erase(ptr);
+		if (obj->len != key->size())
+			abort();
+	} STOP();
+#endif
+}
+
+/**
+ * Memory used, excluding the string keys, that are stored only once outside.
+ */
+void test_string_size(void)
+{
+	MEM(DATA_HASHDYN, tommy_hashdyn_memory_usage(&hashdyn));
+	MEM(DATA_HASHLIN, tommy_hashlin_memory_usage(&hashlin));
+	MEM(DATA_HASHDYNC, tommy_hashdync_memory_usage(&hashdync));
+	MEM(DATA_HASHLINC, tommy_hashlinc_memory_usage(&hashlinc));
+	MEM(DATA_KHASH, khstring->n_buckets * sizeof(void*) /* val */
+		+ khstring->n_buckets * sizeof(const char*) /* key */
+		+ (khstring->n_buckets >> 4) * sizeof(uint32_t)); /* flags */
+}
+
+/**
+ * Max size reached, adding to the size the transient peaks of the memory
+ * allocated by Tommy, like when resizing, and the allocator slack.
+ * Available only with -P, and not for the other data structures.
+ */
+void test_peak(void)
+{
+	tommy_size_t size;
+
+	if (the_alloc_peak <= the_alloc_base)
+		return;
+
+	size = (tommy_size_t)LOG[the_retry][the_data][the_order][OPERATION_SIZE] * the_max;
+
+	mem(the_data, size + the_alloc_peak - the_alloc_steady);
+}
+
+/**
+ * Peak RSS of the process, including the objects and the allocator overhead.
+ * It's available for all the data structures, but only in Linux.
+ */
+void test_rss(void)
+{
+	tommy_size_t peak;
+
+	if (!the_rss_base)
+		return;
+
+	peak = rss_get("VmHWM");
+	if (peak < the_rss_base)
+		peak = the_rss_base;
+
+	mem(the_data, peak - the_rss_base);
+}
+
+void test_operation(unsigned* INSERT, unsigned* SEARCH, unsigned* HIT)
+{
+	cache_clear();
+
+	peak_reset();
+
+	if (the_string) {
+		OPERATION(OPERATION_INSERT);
+		test_string_insert(INSERT);
+
+		OPERATION(OPERATION_CHANGE);
+		test_string_change(SEARCH, INSERT);
+
+		OPERATION(OPERATION_HIT);
+		test_string_hit(HIT);
+
+		OPERATION(OPERATION_MISS);
+		test_string_miss(HIT);
+
+		OPERATION(OPERATION_SIZE);
+		test_string_size();
+		the_alloc_steady = the_alloc_size;
+
+		OPERATION(OPERATION_REMOVE);
+		test_string_remove(SEARCH);
+
+		OPERATION(OPERATION_PEAK);
+		test_peak();
+
+		OPERATION(OPERATION_RSS);
+		test_rss();
+		return;
+	}
+
+	OPERATION(OPERATION_INSERT);
+	test_insert(INSERT);
+
+	OPERATION(OPERATION_CHANGE);
+	test_change(SEARCH, INSERT);
+
+	OPERATION(OPERATION_HIT);
+	test_hit(HIT);
+
+	OPERATION(OPERATION_MISS);
+	test_miss(HIT);
+
+	OPERATION(OPERATION_SIZE);
+	test_size();
+	the_alloc_steady = the_alloc_size;
+
+	OPERATION(OPERATION_REMOVE);
+	test_remove(SEARCH);
+
+	OPERATION(OPERATION_PEAK);
+	test_peak();
+
+	OPERATION(OPERATION_RSS);
+	test_rss();
+}
+
+/******************************************************************************/
+/* output */
+
+/**
+ * Compiler flags, defined by the Makefile.
+ */
+#ifndef BENCHMARK_FLAGS
+#define BENCHMARK_FLAGS "unknown"
 #endif
 
-#ifdef USE_JUDYARRAY
-	START(DATA_JUDYARRAY) {
-		judyvalue key = SEARCH[i] + DELTA;
-		JudySlot* pvalue;
-		pvalue = judy_slot(judyarray, (uchar*)&key, 0);
-		if (pvalue) {
-			/* workaround for a judyarray bug. Sometimes it returns a pvalue pointing to NULL */
-			void* obj = *(void**)pvalue;
-			if (obj)
-				abort();
+FILE* the_output; /**< Output file with all the results, 0 if disabled. */
+tommy_bool_t the_output_json; /**< If the output is JSON, otherwise CSV. */
+tommy_bool_t the_output_first; /**< If no result was yet written in the output. */
+
+/**
+ * Gets the name of the machine, with the operating system and the CPU.
+ */
+void output_machine(char* buf, size_t size)
+{
+	char cpu[128];
+
+	strcpy(cpu, "unknown");
+
+#if defined(__linux)
+	{
+		FILE* f = fopen("/proc/cpuinfo", "r");
+		if (f) {
+			char line[256];
+			while (fgets(line, sizeof(line), f)) {
+				if (strncmp(line, "model name", 10) == 0) {
+					char* s = strchr(line, ':');
+					char* e;
+					if (!s)
+						continue;
+					++s;
+					while (*s == ' ' || *s == '\t')
+						++s;
+					e = s + strlen(s);
+					while (e > s && (e[-1] == '\n' || e[-1] == ' '))
+						--e;
+					*e = 0;
+					snprintf(cpu, sizeof(cpu), "%s", s);
+					break;
+				}
+			}
+			fclose(f);
 		}
-	} STOP();
+	}
 #endif
 
-#ifdef USE_CUBE
-	START(DATA_CUBE) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct cube_obj* obj;
-		obj = (struct cube_obj*)get_key(cube, key);
-		if (obj)
-			abort();
-	} STOP();
+#if defined(__linux) || defined(__MACH__)
+	{
+		struct utsname name;
+		if (uname(&name) == 0) {
+			snprintf(buf, size, "%s %s %s, %s", name.sysname, name.release, name.machine, cpu);
+			return;
+		}
+	}
 #endif
 
-#ifdef USE_LIBDYNAMIC
-	START(DATA_LIBDYNAMIC) {
-		unsigned key = SEARCH[i] + DELTA;
-		struct libdynamic_object key_obj;
-		struct libdynamic_object* key_ptr = &key_obj;
-		struct libdynamic_object* obj;
-		key_obj.value = key;
-		obj = *(struct libdynamic_object**)map_at(&libdynamic, &key_ptr, libdynamic_hash, libdynamic_equal);
-		if (obj != &libdynamic_empty)
-			abort();
-	} STOP();
+#if defined(_WIN32)
+	snprintf(buf, size, "Windows, %s", cpu);
+#else
+	snprintf(buf, size, "unknown, %s", cpu);
 #endif
+}
 
-#ifdef USE_CK
-	START(DATA_CK) {
-		unsigned key = SEARCH[i] + DELTA;
-		unsigned hash_key;
-		struct ck_object obj_key;
-		struct ck_object* obj;
-		obj_key.value = key;
-		hash_key = CK_HS_HASH(&ck, hs_hash, &obj_key);
-		obj = (struct ck_object*)ck_hs_get(&ck, hash_key, &obj_key);
-		if (obj)
-			abort();
-	} STOP();
+const char* output_compiler(void)
+{
+#if defined(__clang__)
+	return "clang " __clang_version__;
+#elif defined(__GNUC__)
+	return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+	return "msvc";
+#else
+	return "unknown";
 #endif
 }
 
-void test_change(unsigned* REMOVE, unsigned* INSERT)
+/**
+ * Writes a JSON string, escaping the special chars.
+ */
+void output_json_string(const char* s)
 {
-	unsigned i;
+	fputc('"', the_output);
+	while (*s) {
+		if (*s == '"' || *s == '\\')
+			fputc('\\', the_output);
+		if ((unsigned char)*s >= 0x20)
+			fputc(*s, the_output);
+		++s;
+	}
+	fputc('"', the_output);
+}
 
-	const unsigned DELTA = 1;
+/**
+ * Opens the output file, using JSON if the name ends with .json, or CSV otherwise.
+ */
+void output_open(const char* file)
+{
+	char machine[256];
+	size_t len = strlen(file);
 
-	START(DATA_TREE) {
-		unsigned key = REMOVE[i];
-		struct rbt_object key_obj;
-		struct rbt_object* obj;
-		key_obj.value = REMOVE[i];
-		obj = rbt_search(&tree, &key_obj); 
-		if (!obj)
-			abort();
-		rbt_remove(&tree, obj);
+	the_output = fopen(file, "wt");
+	if (!the_output) {
+		printf("Error opening output file '%s'\n", file);
+		exit(EXIT_FAILURE);
+	}
 
-		key = INSERT[i] + DELTA;  
-		obj->value = key;
-		rbt_insert(&tree, obj);
-	} STOP();
+	the_output_json = len >= 5 && strcmp(file + len - 5, ".json") == 0;
+	the_output_first = 1;
 
-	START(DATA_HASHTABLE) {
-		unsigned key = REMOVE[i];
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashtable_remove(&hashtable, tommy_hashtable_compare, &key, hash_key);
-		if (!obj)
-			abort();
+	output_machine(machine, sizeof(machine));
 
-		key = INSERT[i] + DELTA;
-		hash_key = hash(key);
-		obj->value = key;
-		tommy_hashtable_insert(&hashtable, &obj->node, obj, hash_key);
-	} STOP();
+	if (the_output_json) {
+		fprintf(the_output, "{\n");
+		fprintf(the_output, "\t\"machine\": ");
+		output_json_string(machine);
+		fprintf(the_output, ",\n\t\"compiler\": ");
+		output_json_string(output_compiler());
+		fprintf(the_output, ",\n\t\"flags\": ");
+		output_json_string(BENCHMARK_FLAGS);
+		fprintf(the_output, ",\n\t\"results\": [");
+	} else {
+		fprintf(the_output, "# machine: %s\n", machine);
+		fprintf(the_output, "# compiler: %s\n", output_compiler());
+		fprintf(the_output, "# flags: %s\n", BENCHMARK_FLAGS);
+		fprintf(the_output, "size,data,key,order,operation,unit,retry,min,mean,stddev\n");
+	}
+}
 
-	START(DATA_HASHDYN) {
-		unsigned key = REMOVE[i];
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashdyn_remove(&hashdyn, tommy_hashtable_compare, &key, hash_key);
-		if (!obj)
-			abort();
+void output_close(void)
+{
+	if (!the_output)
+		return;
 
-		key = INSERT[i] + DELTA;
-		hash_key = hash(key);
-		obj->value = key;
-		tommy_hashdyn_insert(&hashdyn, &obj->node, obj, hash_key);
-	} STOP();
+	if (the_output_json)
+		fprintf(the_output, "\n\t]\n}\n");
 
-	START(DATA_HASHLIN) {
-		unsigned key = REMOVE[i];
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashlin_remove(&hashlin, tommy_hashtable_compare, &key, hash_key);
-		if (!obj)
-			abort();
+	fclose(the_output);
+	the_output = 0;
+}
 
-		key = INSERT[i] + DELTA;
-		hash_key = hash(key);
-		obj->value = key;
-		tommy_hashlin_insert(&hashlin, &obj->node, obj, hash_key);
-	} STOP();
+/**
+ * Gets the name of the keys used, as in the -S option.
+ */
+const char* output_key(void)
+{
+	switch (the_string) {
+	case STRING_HASH_U64 : return "hash_u64";
+	case STRING_STRHASH_U32 : return "strhash_u32";
+	default : return "int";
+	}
+}
 
-	START(DATA_TRIE) {
-		unsigned key = REMOVE[i];
-		struct trie_object* obj;
-		obj = (struct trie_object*)tommy_trie_remove(&trie, key);
-		if (!obj)
-			abort();
+/**
+ * Writes a single result.
+ * The order and the operation identify the test, together with the size, the data and the key.
+ * The unit tells if lower is better, like "ns" and "byte", or higher, like "Mops/s".
+ */
+void output_result(const char* data, const char* order, const char* operation, const char* unit, unsigned retry, double min, double mean, double stddev)
+{
+	if (!the_output)
+		return;
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		tommy_trie_insert(&trie, &obj->node, obj, key);
-	} STOP();
+	if (the_output_json) {
+		fprintf(the_output, "%s\n\t\t{ \"size\": %u, \"data\": \"%s\", \"key\": \"%s\", \"order\": \"%s\", \"operation\": \"%s\", \"unit\": \"%s\", \"retry\": %u, \"min\": %.10g, \"mean\": %.2f, \"stddev\": %.2f }",
+			the_output_first ? "" : ",", the_max, data, output_key(), order, operation, unit, retry, min, mean, stddev);
+	} else {
+		fprintf(the_output, "%u,%s,%s,%s,%s,%s,%u,%.10g,%.2f,%.2f\n",
+			the_max, data, output_key(), order, operation, unit, retry, min, mean, stddev);
+	}
 
-	START(DATA_TRIE_INPLACE) {
-		unsigned key = REMOVE[i];
-		struct trie_inplace_object* obj;
-		obj = (struct trie_inplace_object*)tommy_trie_inplace_remove(&trie_inplace, key);
-		if (!obj)
-			abort();
+	the_output_first = 0;
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		tommy_trie_inplace_insert(&trie_inplace, &obj->node, obj, key);
-	} STOP();
+	fflush(the_output);
+}
 
-	START(DATA_KHASH) {
-		unsigned key = REMOVE[i];
-		unsigned hash_key = hash(key);
-		khiter_t k;
-		int r;
-		struct khash_object* obj;
-		k = kh_get(word, khash, hash_key);
-		if (k == kh_end(khash))
-			abort();
-		obj = kh_value(khash, k);
-		kh_del(word, khash, k);
+/**
+ * Writes the results of the current number of elements.
+ * For each operation it writes the minimum, the mean and the standard deviation over the retries.
+ */
+void output_write(unsigned retry)
+{
+	if (!the_output)
+		return;
 
-		key = INSERT[i] + DELTA;
-		hash_key = hash(key);
-		obj->value = key;
-		k = kh_put(word, khash, hash_key, &r);
-		if (!r)
-			abort();
-		kh_value(khash, k) = obj;
-	} STOP();
+	for(the_data=0;the_data<DATA_MAX;++the_data) {
+		if (!is_listed(the_data))
+			continue;
 
-#ifdef USE_GOOGLELIBCHASH
-	START(DATA_GOOGLELIBCHASH) {
-		unsigned key = REMOVE[i];
-		HTItem* ptr;
-		struct google_object* obj;
-		u_long ptr_value;
-		ptr = HashFind(googlelibhash, key);
-		if (!ptr)
-			abort();
-		obj = (void*)ptr->data;
-		HashDeleteLast(googlelibhash);
+		for(the_order=0;the_order<ORDER_MAX;++the_order) {
+			if (!is_order(the_order))
+				continue;
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		ptr_value = (u_long)obj;
-		ptr = HashInsert(googlelibhash, key, ptr_value);
-		if (!ptr)
-			abort();
-	} STOP();
-#endif
+			for(the_operation=0;the_operation<OPERATION_MAX;++the_operation) {
+				const char* unit = is_memory(the_operation) ? "byte" : "ns";
+				unsigned i, v;
+				double mean, var;
+
+				/* get the minimum */
+				v = LOG[0][the_data][the_order][the_operation];
+				for(i=1;i<retry;++i) {
+					if (LOG[i][the_data][the_order][the_operation] < v)
+						v = LOG[i][the_data][the_order][the_operation];
+				}
 
-#ifdef USE_GOOGLEDENSEHASH
-	START(DATA_GOOGLEDENSEHASH) {
-		unsigned key = REMOVE[i];
-		googledensehash_t::iterator ptr = googledensehash->find(key);
-		struct google_object* obj;
-		if (ptr == googledensehash->end())
-			abort();
-		obj = ptr->second;
-		googledensehash->erase(ptr);
+				/* skip not measured */
+				if (v == 0)
+					continue;
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		(*googledensehash)[key] = obj;
-	} STOP();
-#endif
+				mean = 0;
+				for(i=0;i<retry;++i)
+					mean += LOG[i][the_data][the_order][the_operation];
+				mean /= retry;
+
+				var = 0;
+				for(i=0;i<retry;++i) {
+					double d = LOG[i][the_data][the_order][the_operation] - mean;
+					var += d * d;
+				}
+				if (retry > 1)
+					var /= retry - 1;
+
+				output_result(DATA_NAME[the_data], ORDER_NAME[the_order], OPERATION_NAME[the_operation], unit, retry, v, mean, sqrt(var));
+			}
+		}
+	}
+}
+
+void test(unsigned size, unsigned data, int log, int sparse)
+{
+	double base;
+	double fact;
+
+	base = 1000;
+	fact = pow(10, 0.1);
+
+	/* log if batch test or requested */
+	the_log = (size == 0 && data == DATA_MAX) || log;
+
+	/* write the header */
+	if (the_log)
+	for(the_order=0;the_order<ORDER_MAX;++the_order) {
+		if (!is_order(the_order))
+			continue;
+		for(the_operation=0;the_operation<OPERATION_MAX;++the_operation) {
+			unsigned p;
+			FILE* f = open("wt");
+			fprintf(f, "0\t");
+			for(the_data=0;the_data<DATA_MAX;++the_data) {
+				if (is_listed(the_data))
+					fprintf(f, "%s\t", DATA_NAME[the_data]);
+			}
+			fprintf(f, "\n");
+			fclose(f);
+
+			if (is_memory(the_operation))
+				continue;
+
+			for(p=0;the_period && p<PERCENTILE_MAX;++p) {
+				f = open_percentile("wt", p);
+				fprintf(f, "0\t");
+				for(the_data=0;the_data<DATA_MAX;++the_data) {
+					if (is_listed(the_data))
+						fprintf(f, "%s\t", DATA_NAME[the_data]);
+				}
+				fprintf(f, "\n");
+				fclose(f);
+			}
+
+			for(p=0;the_counter && p<COUNTER_MAX;++p) {
+				f = open_counter("wt", p);
+				fprintf(f, "0\t");
+				for(the_data=0;the_data<DATA_MAX;++the_data) {
+					if (is_listed(the_data))
+						fprintf(f, "%s\t", DATA_NAME[the_data]);
+				}
+				fprintf(f, "\n");
+				fclose(f);
+			}
+		}
+	}
 
-#ifdef USE_GOOGLEBTREE
-	START(DATA_GOOGLEBTREE) {
-		unsigned key = REMOVE[i];
-		googlebtree_t::iterator ptr = googlebtree->find(key);
-		struct google_object* obj;
-		if (ptr == googlebtree->end())
-			abort();
-		obj = ptr->second;
-		googlebtree->erase(ptr);
+	if (size != 0)
+		the_max = size;
+	else
+		the_max = (unsigned)base;
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		(*googlebtree)[key] = obj;
-	} STOP();
-#endif
+	while (the_max <= (the_string ? STRING_MAX : MAX)) {
+		unsigned retry;
+	
+		/* number of retries to avoid spikes */
+		retry = MIN_TRY / the_max;
+		if (retry < 1)
+			retry = 1;
+		if (retry > RETRY_MAX)
+			retry = RETRY_MAX;
+		if (size != 0)
+			retry = 1;
 
-#ifdef USE_STXBTREE
-	START(DATA_STXBTREE) {
-		unsigned key = REMOVE[i];
-		stxbtree_t::iterator ptr = stxbtree->find(key);
-		struct stx_object* obj;
-		if (ptr == stxbtree->end())
-			abort();
-		obj = ptr->second;
-		stxbtree->erase(ptr);
+		/* clear the log */
+		memset(LOG, 0, sizeof(LOG));
+		memset(LAT, 0, sizeof(LAT));
+		memset(CNT, 0, sizeof(CNT));
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		(*stxbtree)[key] = obj;
-	} STOP();
-#endif
+		order_init(the_max, sparse);
 
-#ifdef USE_CPPMAP
-	START(DATA_CPPMAP) {
-		unsigned key = REMOVE[i];
-		cppmap_t::iterator ptr = cppmap->find(key);
-		struct cpp_object* obj;
-		if (ptr == cppmap->end())
-			abort();
-		obj = ptr->second;
-		cppmap->erase(ptr);
+		/* run the test */
+		for(the_retry=0;the_retry<retry;++the_retry) {
+			/* data */
+			for(the_data=0;the_data<DATA_MAX;++the_data) {
+				if (!is_listed(the_data))
+					continue;
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		(*cppmap)[key] = obj;
-	} STOP();
-#endif
+				if (data != DATA_MAX && data != the_data)
+					continue;
 
-#ifdef USE_CPPUNORDEREDMAP
-	START(DATA_CPPUNORDEREDMAP) {
-		unsigned key = REMOVE[i];
-		cppunorderedmap_t::iterator ptr = cppunorderedmap->find(key);
-		struct cpp_object* obj;
-		if (ptr == cppunorderedmap->end())
-			abort();
-		obj = ptr->second;
-		cppunorderedmap->erase(ptr);
+				if (the_string && !is_string(the_data))
+					continue;
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		(*cppunorderedmap)[key] = obj;
-	} STOP();
-#endif
+				for(the_order=0;the_order<ORDER_MAX;++the_order) {
+					unsigned i;
 
-	START(DATA_UTHASH) {
-		unsigned key = REMOVE[i];
-		struct uthash_object* obj;
-		HASH_FIND_INT(uthash, &key, obj);
-		if (!obj)
-			abort();
-		HASH_DEL(uthash, obj);
+					if (!is_order(the_order))
+						continue;
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		HASH_ADD_INT(uthash, value, obj);
-	} STOP();
+					printf("%12u", the_max);
 
-	START(DATA_NEDTRIE) {
-		unsigned key = REMOVE[i];
-		struct nedtrie_object key_obj;
-		struct nedtrie_object* obj;
-		key_obj.value = key;
-		obj = NEDTRIE_FIND(nedtrie_t, &nedtrie, &key_obj);
-		if (!obj)
-			abort();
-		NEDTRIE_REMOVE(nedtrie_t, &nedtrie, obj);
+					printf(" %18s %10s", DATA_NAME[the_data], ORDER_NAME[the_order]);
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		NEDTRIE_INSERT(nedtrie_t, &nedtrie, obj);
-	} STOP();
+					/* skip degenerated cases */
+					if (LAST[the_data][the_order] > TIME_MAX_NS) {
+						printf(" (skipped, too slow)\n");
+						continue;
+					}
 
-#ifdef USE_JUDY
-	START(DATA_JUDY) {
-		Word_t key = REMOVE[i];
-		struct judy_object* obj;
-		int r;
-		Pvoid_t PValue;
-		JLG(PValue, judy, key);
-		if (!PValue)
-			abort();
-		obj = *(struct judy_object**)PValue;
-		JLD(r, judy, key);
-		if (r != 1)
-			abort();
+					if (!the_log)
+						printf("\n");
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		JLI(PValue, judy, key);
-		*(struct judy_object**)PValue = obj;
-	} STOP();
-#endif
+					alloc_reset();
+					if (the_string)
+						test_string_alloc();
+					else
+						test_alloc();
+					if (the_order == ORDER_FORWARD)
+						test_operation(FORWARD, FORWARD, FORWARD);
+					else if (the_order == ORDER_RANDOM)
+						test_operation(RAND0, RAND1, RAND1);
+					else
+						test_operation(RAND0, RAND1, LOOKUP);
+					if (the_string)
+						test_string_free();
+					else
+						test_free();
 
-#ifdef USE_JUDYARRAY
-	START(DATA_JUDYARRAY) {
-		judyvalue key = REMOVE[i];
-		struct judyarray_object* obj;
-		JudySlot* pvalue;
-		pvalue = judy_slot(judyarray, (uchar*)&key, 0);
-		if (!pvalue)
-			abort();
-		obj = *(struct judyarray_object**)pvalue;
-		judy_del(judyarray);
+					if (the_log) {
+						for(i=0;i<OPERATION_MAX;++i)
+							printf(" %4u", LOG[the_retry][the_data][the_order][i]);
+						printf(" [ns]\n");
+					}
+				}
+			}
+		}
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		pvalue = judy_cell(judyarray, (uchar*)&key, 0);
-		*(struct judyarray_object**)pvalue = obj;
-	} STOP();
-#endif
+		order_done();
 
-#ifdef USE_CUBE
-	START(DATA_CUBE) {
-		unsigned key = REMOVE[i];
-		struct cube_object* obj;
-		obj = (struct cube_object*)del_key(cube, key);
-		if (!obj)
-			abort();
+		/* write the data */
+		if (the_log)
+		for(the_order=0;the_order<ORDER_MAX;++the_order) {
+			if (!is_order(the_order))
+				continue;
+			for(the_operation=0;the_operation<OPERATION_MAX;++the_operation) {
+				unsigned p;
+				FILE* f = open("at");
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		set_key(cube, key, obj);
-	} STOP();
-#endif
+				fprintf(f, "%u\t", the_max);
+				
+				/* data */
+				for(the_data=0;the_data<DATA_MAX;++the_data) {
+					unsigned i, v;
 
-#ifdef USE_LIBDYNAMIC
-	START(DATA_LIBDYNAMIC) {
-		unsigned key = REMOVE[i];
-		struct libdynamic_object key_obj;
-		struct libdynamic_object* key_ptr = &key_obj;
-		struct libdynamic_object* obj;
-		key_obj.value = key;
-		LIBDYNAMIC_RELEASE = 0;
-		map_erase(&libdynamic, &key_ptr, libdynamic_hash, libdynamic_equal, libdynamic_set, libdynamic_release);
-		obj = LIBDYNAMIC_RELEASE;
-		if (!obj)
-			abort();
+					if (!is_listed(the_data))
+						continue;
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		map_insert(&libdynamic, &obj, libdynamic_hash, libdynamic_equal, libdynamic_set, 0);
-	} STOP();
-#endif
+					/* get the minimum */
+					v = LOG[0][the_data][the_order][the_operation];
+					for(i=1;i<retry;++i) {
+						if (LOG[i][the_data][the_order][the_operation] < v)
+							v = LOG[i][the_data][the_order][the_operation];
+					}
 
-#ifdef USE_CK
-	START(DATA_CK) {
-		unsigned key = REMOVE[i];
-		unsigned hash_key;
-		struct ck_object obj_key;
-		struct ck_object* obj;
-		obj_key.value = key;
-		hash_key = CK_HS_HASH(&ck, hs_hash, &obj_key);
-		obj = (struct ck_object*)ck_hs_remove(&ck, hash_key, &obj_key);
-		if (!obj)
-			abort();
+					if (!is_memory(the_operation) && v != 0) {
+						/* keep the longest operation measure */
+						if (v > LAST[the_data][the_order]) {
+							LAST[the_data][the_order] = v;
+						}
+					}
 
-		key = INSERT[i] + DELTA;
-		obj->value = key;
-		hash_key = CK_HS_HASH(&ck, hs_hash, obj);
-		ck_hs_put(&ck, hash_key, obj);
-	} STOP();
-#endif
-}
+					fprintf(f, "%u\t", v);
+				}
 
-void test_remove(unsigned* REMOVE)
-{
-	unsigned i;
+				fprintf(f, "\n");
+				fclose(f);
 
-	/* always dereference the object deleted. It has cache effect. */
-	/* considering we are dealing with objects, it makes sense to simulate an access to it */
-	/* even on deletion, because you have at least to do a free() call. */
-	/* this favorites data structures that store part of the information in the object itself */
-	const int dereference = 1;
+				if (is_memory(the_operation))
+					continue;
 
-	const unsigned DELTA = 1;
+				for(p=0;the_period && p<PERCENTILE_MAX;++p) {
+					f = open_percentile("at", p);
 
-	START(DATA_TREE) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct rbt_object key_obj;
-		struct rbt_object* obj;
-		key_obj.value = key;
-		obj = rbt_search(&tree, &key_obj); 
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-		rbt_remove(&tree, obj);
-	} STOP();
+					fprintf(f, "%u\t", the_max);
 
-	START(DATA_HASHTABLE) {
-		unsigned key = REMOVE[i] + DELTA;
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashtable_remove(&hashtable, tommy_hashtable_compare, &key, hash_key);
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+					/* data */
+					for(the_data=0;the_data<DATA_MAX;++the_data) {
+						unsigned i, v;
 
-	START(DATA_HASHDYN) {
-		unsigned key = REMOVE[i] + DELTA;
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashdyn_remove(&hashdyn, tommy_hashtable_compare, &key, hash_key);
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+						if (!is_listed(the_data))
+							continue;
 
-	START(DATA_HASHLIN) {
-		unsigned key = REMOVE[i] + DELTA;
-		unsigned hash_key = hash(key);
-		struct hashtable_object* obj;
-		obj = (struct hashtable_object*)tommy_hashlin_remove(&hashlin, tommy_hashtable_compare, &key, hash_key);
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+						/* get the minimum, as for the mean */
+						v = LAT[0][the_data][the_order][the_operation][p];
+						for(i=1;i<retry;++i) {
+							if (LAT[i][the_data][the_order][the_operation][p] < v)
+								v = LAT[i][the_data][the_order][the_operation][p];
+						}
 
-	START(DATA_TRIE) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct trie_object* obj;
-		obj = (struct trie_object*)tommy_trie_remove(&trie, key);
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+						fprintf(f, "%u\t", v);
+					}
 
-	START(DATA_TRIE_INPLACE) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct trie_inplace_object* obj;
-		obj = (struct trie_inplace_object*)tommy_trie_inplace_remove(&trie_inplace, key);
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+					fprintf(f, "\n");
+					fclose(f);
+				}
 
-	START(DATA_KHASH) {
-		unsigned key = REMOVE[i] + DELTA;
-		unsigned hash_key = hash(key);
-		struct khash_object* obj;
-		khiter_t k;
-		k = kh_get(word, khash, hash_key);
-		if (k == kh_end(khash))
-			abort();
-		if (dereference) {
-			obj = kh_value(khash, k);
-		}
-		kh_del(word, khash, k);
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+				for(p=0;the_counter && p<COUNTER_MAX;++p) {
+					f = open_counter("at", p);
 
-#ifdef USE_GOOGLELIBCHASH
-	START(DATA_GOOGLELIBCHASH) {
-		unsigned key = REMOVE[i] + DELTA;
-		HTItem* ptr;
-		struct google_object* obj;
-		ptr = HashFind(googlelibhash, key);
-		if (!ptr)
-			abort();
-		obj = (struct google_object*)ptr->data;
-		HashDeleteLast(googlelibhash);
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
-#endif
+					fprintf(f, "%u\t", the_max);
 
-#ifdef USE_GOOGLEDENSEHASH
-	START(DATA_GOOGLEDENSEHASH) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct google_object* obj;
-		googledensehash_t::iterator ptr = googledensehash->find(key);
-		if (ptr == googledensehash->end())
-			abort();
-		obj = ptr->second;
-		googledensehash->erase(ptr);
+					/* data */
+					for(the_data=0;the_data<DATA_MAX;++the_data) {
+						unsigned i;
+						double v;
 
-		/* force a resize when we reach 20% load factor */
-		googledensehash->resize(0);
+						if (!is_listed(the_data))
+							continue;
 
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
-#endif
+						/* get the minimum, as for the mean */
+						v = CNT[0][the_data][the_order][the_operation][p];
+						for(i=1;i<retry;++i) {
+							if (CNT[i][the_data][the_order][the_operation][p] < v)
+								v = CNT[i][the_data][the_order][the_operation][p];
+						}
 
-#ifdef USE_GOOGLEBTREE
-	START(DATA_GOOGLEBTREE) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct google_object* obj;
-		googlebtree_t::iterator ptr = googlebtree->find(key);
-		if (ptr == googlebtree->end())
-			abort();
-		obj = ptr->second;
-		googlebtree->erase(ptr);
+						/* not available counters are stored as 0 */
+						if (v < 0)
+							v = 0;
 
-		if (dereference) {
-			if (obj->value != key)
-				abort();
+						fprintf(f, "%.3f\t", v);
+					}
+
+					fprintf(f, "\n");
+					fclose(f);
+				}
+			}
 		}
-	} STOP();
-#endif
 
-#ifdef USE_STXBTREE
-	START(DATA_STXBTREE) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct stx_object* obj;
-		stxbtree_t::iterator ptr = stxbtree->find(key);
-		if (ptr == stxbtree->end())
-			abort();
-		obj = ptr->second;
-		stxbtree->erase(ptr);
+		output_write(retry);
 
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
-#endif
+		if (size != 0)
+			break;
 
-#ifdef USE_CPPMAP
-	START(DATA_CPPMAP) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct cpp_object* obj;
-		cppmap_t::iterator ptr = cppmap->find(key);
-		if (ptr == cppmap->end())
-			abort();
-		obj = ptr->second;
-		cppmap->erase(ptr);
+		/* new max */
+		base *= fact;
+		the_max = (unsigned)base;
+	}
+}
 
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
-#endif
+/******************************************************************************/
+/* compare */
 
-#ifdef USE_CPPUNORDEREDMAP
-	START(DATA_CPPUNORDEREDMAP) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct cpp_object* obj;
-		cppunorderedmap_t::iterator ptr = cppunorderedmap->find(key);
-		if (ptr == cppunorderedmap->end())
-			abort();
-		obj = ptr->second;
-		cppunorderedmap->erase(ptr);
+/**
+ * Minimal relative change reported, in percentage.
+ */
+#define COMPARE_THRESHOLD 5
 
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
-#endif
+/**
+ * Result read from a CSV output.
+ */
+struct compare_result {
+	unsigned size;
+	char data[32];
+	char key[16];
+	char order[16];
+	char operation[32];
+	char unit[8];
+	unsigned retry;
+	double min;
+	double mean;
+	double stddev;
+};
 
-	START(DATA_UTHASH) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct uthash_object* obj;
-		HASH_FIND_INT(uthash, &key, obj);  
-		if (!obj)
-			abort();
-		HASH_DEL(uthash, obj);  
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+/**
+ * Loads a CSV output, as written by -o with a file name not ending with .json.
+ * The JSON output is not supported.
+ * The files written before the key column are read as with integer keys.
+ * \return The number of results.
+ */
+unsigned compare_load(const char* file, struct compare_result** result)
+{
+	char line[256];
+	unsigned count = 0;
+	unsigned max = 0;
+	FILE* f;
 
-	START(DATA_NEDTRIE) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct nedtrie_object key_obj;
-		struct nedtrie_object* obj;
-		key_obj.value = key;
-		obj = NEDTRIE_FIND(nedtrie_t, &nedtrie, &key_obj);
-		if (!obj)
-			abort();
-		NEDTRIE_REMOVE(nedtrie_t, &nedtrie, obj);
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+	*result = 0;
 
-#ifdef USE_JUDY
-	START(DATA_JUDY) {
-		Word_t key = REMOVE[i] + DELTA;
-		struct judy_object* obj;
-		int r;
-		if (dereference) {
-			Pvoid_t PValue;
-			JLG(PValue, judy, key);
-			if (!PValue)
-				abort();
-			obj = *(struct judy_object**)PValue;
-		}
-		JLD(r, judy, key);
-		if (r != 1)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
-#endif
+	f = fopen(file, "rt");
+	if (!f) {
+		printf("Error opening '%s'\n", file);
+		exit(EXIT_FAILURE);
+	}
+
+	while (fgets(line, sizeof(line), f)) {
+		struct compare_result r;
+
+		if (sscanf(line, "%u,%31[^,],%15[^,],%15[^,],%31[^,],%7[^,],%u,%lf,%lf,%lf",
+			&r.size, r.data, r.key, r.order, r.operation, r.unit, &r.retry, &r.min, &r.mean, &r.stddev) != 10) {
+			/* format without the key column */
+			if (sscanf(line, "%u,%31[^,],%15[^,],%31[^,],%7[^,],%u,%lf,%lf,%lf",
+				&r.size, r.data, r.order, r.operation, r.unit, &r.retry, &r.min, &r.mean, &r.stddev) != 9)
+				continue;
+			strcpy(r.key, "int");
+		}
 
-#ifdef USE_JUDYARRAY
-	START(DATA_JUDYARRAY) {
-		judyvalue key = REMOVE[i] + DELTA;
-		struct judyarray_object* obj;
-		JudySlot* pvalue;
-		pvalue = judy_slot(judyarray, (uchar*)&key, 0);
-		if (!pvalue)
-			abort();
-		obj = *(struct judyarray_object**)pvalue;
-		judy_del(judyarray);
-		if (dereference) {
-			if (obj->value != key)
-				abort();
+		if (count == max) {
+			max = max ? max * 2 : 256;
+			*result = (struct compare_result*)realloc(*result, max * sizeof(struct compare_result));
 		}
-	} STOP();
-#endif
 
-#ifdef USE_CUBE
-	START(DATA_CUBE) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct cube_object* obj;
-		obj = (struct cube_object*)del_key(cube, key);
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
+		(*result)[count++] = r;
+	}
+
+	fclose(f);
+
+	return count;
+}
+
+/**
+ * Compares two CSV outputs.
+ *
+ * The results are matched by size, data, key, order and operation.
+ * A change is significant if the minimum changes more than COMPARE_THRESHOLD,
+ * and if the means differ more than two times their standard error,
+ * like in the Welch's t-test at about 95% of confidence.
+ * With a single retry there is no variance, and only the threshold is used.
+ * \return The number of regressions.
+ */
+unsigned compare(const char* old_file, const char* new_file)
+{
+	struct compare_result* old_result;
+	struct compare_result* new_result;
+	unsigned old_count;
+	unsigned new_count;
+	unsigned regression = 0;
+	unsigned improvement = 0;
+	unsigned matched = 0;
+	unsigned i, j;
+
+	old_count = compare_load(old_file, &old_result);
+	new_count = compare_load(new_file, &new_result);
+
+	printf("%10s %18s %11s %11s %16s %9s %9s %-6s %8s\n", "size", "data", "key", "order", "operation", "old", "new", "unit", "change");
+
+	for(i=0;i<new_count;++i) {
+		struct compare_result* n = &new_result[i];
+		struct compare_result* o = 0;
+		double change;
+		double error;
+		const char* tag;
+
+		for(j=0;j<old_count;++j) {
+			if (old_result[j].size == n->size
+				&& strcmp(old_result[j].data, n->data) == 0
+				&& strcmp(old_result[j].key, n->key) == 0
+				&& strcmp(old_result[j].order, n->order) == 0
+				&& strcmp(old_result[j].operation, n->operation) == 0
+			) {
+				o = &old_result[j];
+				break;
+			}
 		}
-	} STOP();
-#endif
 
-#ifdef USE_LIBDYNAMIC
-	START(DATA_LIBDYNAMIC) {
-		unsigned key = REMOVE[i] + DELTA;
-		struct libdynamic_object key_obj;
-		struct libdynamic_object* key_ptr = &key_obj;
-		struct libdynamic_object* obj;
-		key_obj.value = key;
-		LIBDYNAMIC_RELEASE = 0;
-		map_erase(&libdynamic, &key_ptr, libdynamic_hash, libdynamic_equal, libdynamic_set, libdynamic_release);
-		obj = LIBDYNAMIC_RELEASE;
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
+		if (!o || o->min == 0)
+			continue;
+
+		++matched;
+
+		change = (n->min - o->min) * 100 / o->min;
+
+		/* standard error of the difference of the means */
+		error = 0;
+		if (o->retry > 1 && n->retry > 1)
+			error = 2 * sqrt(o->stddev * o->stddev / o->retry + n->stddev * n->stddev / n->retry);
+
+		if (fabs(change) < COMPARE_THRESHOLD || fabs(n->mean - o->mean) <= error)
+			continue;
+
+		/* for the throughput higher is better */
+		if ((change > 0) != (strcmp(n->unit, "Mops/s") == 0)) {
+			tag = "REGRESSION";
+			++regression;
+		} else {
+			tag = "improvement";
+			++improvement;
 		}
-	} STOP();
+
+		printf("%10u %18s %11s %11s %16s %9.2f %9.2f %-6s %+7.1f%% %s\n", n->size, n->data, n->key, n->order, n->operation, o->min, n->min, n->unit, change, tag);
+	}
+
+	printf("Compared %u results, %u regressions, %u improvements\n", matched, regression, improvement);
+
+	free(old_result);
+	free(new_result);
+
+	return regression;
+}
+
+/******************************************************************************/
+/* throughput */
+
+#ifdef USE_THROUGHPUT
+
+/**
+ * Throughput modes.
+ */
+#define MODE_PARTITIONED 0 /**< Each thread uses its own container, with its own part of the keys. */
+#define MODE_SHARED 1 /**< All the threads use the same container, protected by a lock. */
+#define MODE_MAX 2
+
+const char* MODE_NAME[MODE_MAX] = {
+	"partitioned",
+	"shared",
+};
+
+/**
+ * Max number of threads.
+ */
+#define THREAD_MAX 256
+
+/**
+ * Number of operations done by each thread.
+ */
+#define THREAD_OPS 1000000
+
+/**
+ * Container used in the throughput test.
+ */
+struct mt_container {
+	std::mutex lock; /**< Lock used when the container is shared. */
+	unsigned begin; /**< First key. */
+	unsigned count; /**< Number of keys. */
+	void* obj; /**< Vector of objects. */
+	size_t size; /**< Size of the objects. */
+	tommy_hashdyn hashdyn;
+	tommy_hashlin hashlin;
+	tommy_hashdync hashdync;
+	tommy_hashlinc hashlinc;
+	tommy_trie_inplace trie_inplace;
+#ifdef USE_CPPUNORDEREDMAP
+	cppunorderedmap_t* cppunorderedmap;
 #endif
+};
 
-#ifdef USE_CK
-	START(DATA_CK) {
-		unsigned key = REMOVE[i] + DELTA;
-		unsigned hash_key;
-		struct ck_object obj_key;
-		struct ck_object* obj;
-		obj_key.value = key;
-		hash_key = CK_HS_HASH(&ck, hs_hash, &obj_key);
-		obj = (struct ck_object*)ck_hs_remove(&ck, hash_key, &obj_key);
-		if (!obj)
-			abort();
-		if (dereference) {
-			if (obj->value != key)
-				abort();
-		}
-	} STOP();
+/**
+ * Thread in the throughput test.
+ */
+struct mt_thread {
+	std::thread thread;
+	struct mt_container* container; /**< Container used. */
+	tommy_bool_t shared; /**< If the container is shared and has to be locked. */
+	unsigned seed; /**< Random seed. */
+};
+
+unsigned the_write = 10; /**< Percentage of write operations. */
+std::atomic<unsigned> the_ready; /**< Number of threads ready to run. */
+std::atomic<unsigned> the_go; /**< Set when the threads can run. */
+
+/**
+ * If the data structure is supported in the throughput test.
+ */
+tommy_bool_t mt_is_supported(unsigned data)
+{
+	switch (data) {
+	case DATA_HASHDYN :
+	case DATA_HASHLIN :
+	case DATA_HASHDYNC :
+	case DATA_HASHLINC :
+	case DATA_TRIE_INPLACE :
+#ifdef USE_CPPUNORDEREDMAP
+	case DATA_CPPUNORDEREDMAP :
 #endif
+		return 1;
+	}
+
+	return 0;
 }
 
-tommy_size_t uthash_size(struct uthash_object* obj)
+void mt_insert(struct mt_container* c, unsigned data, void* void_obj, unsigned key)
 {
-	UT_hash_table* table;
-	if (!obj)
-		return 0;
-	table = obj->hh.tbl;
-	if (!table)
-		return 0;
-	return table->num_buckets * (tommy_size_t)sizeof(table->buckets[0])
-		+ table->num_items * (tommy_size_t)sizeof(UT_hash_handle);
+	switch (data) {
+	case DATA_HASHDYN : {
+		struct hashtable_object* obj = (struct hashtable_object*)void_obj;
+		obj->value = key;
+		tommy_hashdyn_insert(&c->hashdyn, &obj->node, obj, hash(key));
+		} break;
+	case DATA_HASHLIN : {
+		struct hashtable_object* obj = (struct hashtable_object*)void_obj;
+		obj->value = key;
+		tommy_hashlin_insert(&c->hashlin, &obj->node, obj, hash(key));
+		} break;
+	case DATA_HASHDYNC : {
+		struct hashtablec_object* obj = (struct hashtablec_object*)void_obj;
+		obj->value = key;
+		tommy_hashdync_insert(&c->hashdync, &obj->node, hash(key));
+		} break;
+	case DATA_HASHLINC : {
+		struct hashtablec_object* obj = (struct hashtablec_object*)void_obj;
+		obj->value = key;
+		tommy_hashlinc_insert(&c->hashlinc, &obj->node, hash(key));
+		} break;
+	case DATA_TRIE_INPLACE : {
+		struct trie_inplace_object* obj = (struct trie_inplace_object*)void_obj;
+		obj->value = key;
+		tommy_trie_inplace_insert(&c->trie_inplace, &obj->node, obj, key);
+		} break;
+#ifdef USE_CPPUNORDEREDMAP
+	case DATA_CPPUNORDEREDMAP : {
+		struct cpp_object* obj = (struct cpp_object*)void_obj;
+		obj->value = key;
+		(*c->cppunorderedmap)[key] = obj;
+		} break;
+#endif
+	}
 }
 
-tommy_size_t nedtrie_size(struct nedtrie_t* col)
+/**
+ * Searches a key, returning 0 if missing.
+ */
+void* mt_find(struct mt_container* c, unsigned data, unsigned key)
 {
-	struct nedtrie_object element;
-	(void)element;
-	return col->count * sizeof(element.link);
+	void* obj = 0;
+
+	switch (data) {
+	case DATA_HASHDYN :
+		obj = tommy_hashdyn_search(&c->hashdyn, tommy_hashtable_compare, &key, hash(key));
+		break;
+	case DATA_HASHLIN :
+		obj = tommy_hashlin_search(&c->hashlin, tommy_hashtable_compare, &key, hash(key));
+		break;
+	case DATA_HASHDYNC :
+		obj = tommy_hashdync_search(&c->hashdync, tommy_hashtablec_compare, &key, hash(key));
+		break;
+	case DATA_HASHLINC :
+		obj = tommy_hashlinc_search(&c->hashlinc, tommy_hashtablec_compare, &key, hash(key));
+		break;
+	case DATA_TRIE_INPLACE :
+		obj = tommy_trie_inplace_search(&c->trie_inplace, key);
+		break;
+#ifdef USE_CPPUNORDEREDMAP
+	case DATA_CPPUNORDEREDMAP : {
+		cppunorderedmap_t::const_iterator ptr = c->cppunorderedmap->find(key);
+		if (ptr != c->cppunorderedmap->end())
+			obj = ptr->second;
+		} break;
+#endif
+	}
+
+	return obj;
 }
 
-tommy_size_t khash_size(khash_t(word)* col)
+/**
+ * Searches a key that must be present.
+ */
+void* mt_search(struct mt_container* c, unsigned data, unsigned key)
 {
-	return col->n_buckets * sizeof(void*) /* val */
-		+ col->n_buckets * sizeof(uint32_t) /* key */
-		+ (col->n_buckets >> 4) * sizeof(uint32_t); /* flags */
+	void* obj = mt_find(c, data, key);
+
+	if (!obj)
+		abort();
+
+	return obj;
 }
 
-#ifdef USE_GOOGLEDENSEHASH
-tommy_size_t googledensehash_size(googledensehash_t* col)
+void* mt_remove(struct mt_container* c, unsigned data, unsigned key)
 {
-	googledensehash_t::value_type element;
-	(void)element;
-	return col->bucket_count() * sizeof(element);
-}
+	void* obj = 0;
+
+	switch (data) {
+	case DATA_HASHDYN :
+		obj = tommy_hashdyn_remove(&c->hashdyn, tommy_hashtable_compare, &key, hash(key));
+		break;
+	case DATA_HASHLIN :
+		obj = tommy_hashlin_remove(&c->hashlin, tommy_hashtable_compare, &key, hash(key));
+		break;
+	case DATA_HASHDYNC :
+		obj = tommy_hashdync_remove(&c->hashdync, tommy_hashtablec_compare, &key, hash(key));
+		break;
+	case DATA_HASHLINC :
+		obj = tommy_hashlinc_remove(&c->hashlinc, tommy_hashtablec_compare, &key, hash(key));
+		break;
+	case DATA_TRIE_INPLACE :
+		obj = tommy_trie_inplace_remove(&c->trie_inplace, key);
+		break;
+#ifdef USE_CPPUNORDEREDMAP
+	case DATA_CPPUNORDEREDMAP : {
+		cppunorderedmap_t::iterator ptr = c->cppunorderedmap->find(key);
+		if (ptr != c->cppunorderedmap->end()) {
+			obj = ptr->second;
+			c->cppunorderedmap->erase(ptr);
+		}
+		} break;
 #endif
+	}
 
-#ifdef USE_GOOGLEBTREE
-tommy_size_t googlebtree_size(googlebtree_t* col)
-{
-	return col->bytes_used();
+	if (!obj)
+		abort();
+
+	return obj;
 }
+
+/**
+ * Allocates the container, with objects for count keys starting from begin.
+ * Only the first insert keys are inserted.
+ */
+void mt_alloc(struct mt_container* c, unsigned data, unsigned begin, unsigned count, unsigned insert)
+{
+	size_t size = 0;
+	unsigned i;
+
+	switch (data) {
+	case DATA_HASHDYN :
+		tommy_hashdyn_init(&c->hashdyn);
+		size = sizeof(struct hashtable_object);
+		break;
+	case DATA_HASHLIN :
+		tommy_hashlin_init(&c->hashlin);
+		size = sizeof(struct hashtable_object);
+		break;
+	case DATA_HASHDYNC :
+		tommy_hashdync_init(&c->hashdync, offsetof(struct hashtablec_object, node));
+		size = sizeof(struct hashtablec_object);
+		break;
+	case DATA_HASHLINC :
+		tommy_hashlinc_init(&c->hashlinc, offsetof(struct hashtablec_object, node));
+		size = sizeof(struct hashtablec_object);
+		break;
+	case DATA_TRIE_INPLACE :
+		tommy_trie_inplace_init(&c->trie_inplace);
+		size = sizeof(struct trie_inplace_object);
+		break;
+#ifdef USE_CPPUNORDEREDMAP
+	case DATA_CPPUNORDEREDMAP :
+		c->cppunorderedmap = new cppunorderedmap_t;
+		size = sizeof(struct cpp_object);
+		break;
 #endif
+	}
 
-#ifdef USE_STXBTREE
-tommy_size_t stxbtree_size(stxbtree_t* col)
+	c->begin = begin;
+	c->count = count;
+	c->size = size;
+	c->obj = malloc(size * count);
+
+	for(i=0;i<insert;++i)
+		mt_insert(c, data, (unsigned char*)c->obj + i * size, begin + i);
+}
+
+/**
+ * Number of buckets of the container, used to detect the resizes.
+ * It's 0 for the containers without buckets.
+ */
+size_t mt_bucket(struct mt_container* c, unsigned data)
 {
-	return col->get_stats().leaves * sizeof(struct stxbtree_t::btree_impl::leaf_node)
-		+ col->get_stats().innernodes * sizeof(struct stxbtree_t::btree_impl::inner_node);
+	switch (data) {
+	case DATA_HASHDYN :
+		return c->hashdyn.bucket_max;
+	case DATA_HASHLIN :
+		return c->hashlin.bucket_max;
+	case DATA_HASHDYNC :
+		return c->hashdync.bucket_max;
+	case DATA_HASHLINC :
+		return c->hashlinc.bucket_max;
+#ifdef USE_CPPUNORDEREDMAP
+	case DATA_CPPUNORDEREDMAP :
+		return c->cppunorderedmap->bucket_count();
+#endif
+	}
+
 	return 0;
 }
-#endif
 
-tommy_size_t rbt_size(rbtree_t* col, unsigned count)
+void mt_free(struct mt_container* c, unsigned data)
 {
-	struct rbt_object element;
-	(void)col;
-	(void)element;
-	return count * sizeof(element.link);
+	switch (data) {
+	case DATA_HASHDYN :
+		tommy_hashdyn_done(&c->hashdyn);
+		break;
+	case DATA_HASHLIN :
+		tommy_hashlin_done(&c->hashlin);
+		break;
+	case DATA_HASHDYNC :
+		tommy_hashdync_done(&c->hashdync);
+		break;
+	case DATA_HASHLINC :
+		tommy_hashlinc_done(&c->hashlinc);
+		break;
+	case DATA_TRIE_INPLACE :
+		break;
+#ifdef USE_CPPUNORDEREDMAP
+	case DATA_CPPUNORDEREDMAP :
+		delete c->cppunorderedmap;
+		break;
+#endif
+	}
+
+	free(c->obj);
 }
 
-tommy_size_t libdynamic_size(map* ld)
+/**
+ * Runs the operations of a thread.
+ * A write is a remove followed by the insert of the same object,
+ * to keep the keys in the container always the same.
+ */
+void mt_run(struct mt_thread* t, unsigned data)
 {
-	return sizeof(map) + ld->element_size * ld->elements_capacity;
+	struct mt_container* c = t->container;
+	unsigned seed = t->seed;
+	unsigned i;
+
+	/* wait for all the other threads */
+	++the_ready;
+	while (!the_go)
+		std::this_thread::yield();
+
+	for(i=0;i<THREAD_OPS;++i) {
+		unsigned key;
+		unsigned r;
+
+		/* xorshift random generator */
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		key = c->begin + seed % c->count;
+		r = (seed >> 16) % 100;
+
+		if (t->shared)
+			c->lock.lock();
+
+		if (r < the_write) {
+			void* obj = mt_remove(c, data, key);
+			mt_insert(c, data, obj, key);
+		} else {
+			mt_search(c, data, key);
+		}
+
+		if (t->shared)
+			c->lock.unlock();
+	}
 }
 
-void test_size(void)
+/**
+ * Measures the throughput in Mops/s with the specified number of threads.
+ */
+double mt_measure(unsigned mode, unsigned data, unsigned thread_max)
 {
-#ifdef USE_JUDY
-	Word_t w;
-#endif
+	struct mt_container* container;
+	struct mt_thread* thread;
+	unsigned container_max;
+	tommy_uint64_t elapsed;
+	unsigned i;
 
-	MEM(DATA_TREE, rbt_size(&tree, the_max));
-	MEM(DATA_HASHTABLE, tommy_hashtable_memory_usage(&hashtable));
-	MEM(DATA_HASHDYN, tommy_hashdyn_memory_usage(&hashdyn));
-	MEM(DATA_HASHLIN, tommy_hashlin_memory_usage(&hashlin));
-	MEM(DATA_TRIE, tommy_trie_memory_usage(&trie));
-	MEM(DATA_TRIE_INPLACE, tommy_trie_inplace_memory_usage(&trie_inplace));
-	MEM(DATA_KHASH, khash_size(khash));
-#ifdef USE_GOOGLEDENSEHASH
-	MEM(DATA_GOOGLEDENSEHASH, googledensehash_size(googledensehash));
-#endif
-#ifdef USE_GOOGLEBTREE
-	MEM(DATA_GOOGLEBTREE, googlebtree_size(googlebtree));
-#endif
-#ifdef USE_STXBTREE
-	MEM(DATA_STXBTREE, stxbtree_size(stxbtree));
-#endif
-	MEM(DATA_UTHASH, uthash_size(uthash));
-	MEM(DATA_NEDTRIE, nedtrie_size(&nedtrie));
-#ifdef USE_JUDY
-	JLMU(w, judy);
-	MEM(DATA_JUDY, w);
-#endif
-#ifdef USE_JUDYARRAY
-	MEM(DATA_JUDYARRAY,judy_size(judyarray));
-#endif
-#ifdef USE_CUBE
-	MEM(DATA_CUBE, size_cube(cube));
-#endif
-#ifdef USE_LIBDYNAMIC
-	MEM(DATA_LIBDYNAMIC, libdynamic_size(&libdynamic));
-#endif
+	if (mode == MODE_SHARED)
+		container_max = 1;
+	else
+		container_max = thread_max;
+
+	/* split the keys among the containers */
+	container = new mt_container[container_max];
+	for(i=0;i<container_max;++i) {
+		unsigned begin = (unsigned)((tommy_uint64_t)the_max * i / container_max);
+		unsigned end = (unsigned)((tommy_uint64_t)the_max * (i + 1) / container_max);
+		mt_alloc(&container[i], data, begin, end - begin, end - begin);
+	}
+
+	the_ready = 0;
+	the_go = 0;
+
+	thread = new mt_thread[thread_max];
+	for(i=0;i<thread_max;++i) {
+		thread[i].container = &container[i % container_max];
+		thread[i].shared = mode == MODE_SHARED;
+		thread[i].seed = 0x9E3779B9 * (i + 1);
+		thread[i].thread = std::thread(mt_run, &thread[i], data);
+	}
+
+	/* start all the threads at the same time */
+	while (the_ready != thread_max)
+		std::this_thread::yield();
+	the_time = nano();
+	the_go = 1;
+
+	for(i=0;i<thread_max;++i)
+		thread[i].thread.join();
+	elapsed = nano() - the_time;
+
+	delete [] thread;
+
+	for(i=0;i<container_max;++i)
+		mt_free(&container[i], data);
+	delete [] container;
+
+	return (double)thread_max * THREAD_OPS * 1000 / elapsed;
 }
 
-void test_operation(unsigned* INSERT, unsigned* SEARCH)
+/**
+ * Throughput test.
+ * Runs with a number of threads doubling from 1 to the specified max.
+ */
+void test_throughput(unsigned size, unsigned data, int log, unsigned thread_max)
 {
-	cache_clear();
+	unsigned thread_count[THREAD_MAX];
+	unsigned count_max;
+	unsigned mode;
+	unsigned t;
 
-	OPERATION(OPERATION_INSERT);
-	test_insert(INSERT);
+	if (size != 0)
+		the_max = size;
+	else
+		the_max = 1000000;
 
-	OPERATION(OPERATION_CHANGE);
-	test_change(SEARCH, INSERT);
+	/* the partitioned mode needs at least one key for each thread */
+	if (thread_max > the_max) {
+		printf("Invalid number of threads %u, more than the %u objects\n", thread_max, the_max);
+		exit(EXIT_FAILURE);
+	}
 
-	OPERATION(OPERATION_HIT);
-	test_hit(SEARCH);
+	/* number of threads to test */
+	count_max = 0;
+	for(t=1;t<thread_max;t*=2)
+		thread_count[count_max++] = t;
+	thread_count[count_max++] = thread_max;
 
-	OPERATION(OPERATION_MISS);
-	test_miss(SEARCH);
+	printf("Throughput with %u objects and %u%% writes\n", the_max, the_write);
 
-	OPERATION(OPERATION_SIZE);
-	test_size();
+	for(mode=0;mode<MODE_MAX;++mode) {
+		double MOPS[THREAD_MAX][DATA_MAX];
+		FILE* f = 0;
 
-	OPERATION(OPERATION_REMOVE);
-	test_remove(SEARCH);
-}
+		memset(MOPS, 0, sizeof(MOPS));
 
-void test(unsigned size, unsigned data, int log, int sparse)
-{
-	double base;
-	double fact;
+		for(the_data=0;the_data<DATA_MAX;++the_data) {
+			if (data != DATA_MAX && data != the_data)
+				continue;
 
-	base = 1000;
-	fact = pow(10, 0.1);
+			if (!mt_is_supported(the_data)) {
+				if (data != DATA_MAX && mode == 0)
+					printf("%18s (skipped, not supported)\n", DATA_NAME[the_data]);
+				continue;
+			}
 
-	/* log if batch test or requested */
-	the_log = (size == 0 && data == DATA_MAX) || log;
+			for(t=0;t<count_max;++t) {
+				double efficiency;
 
-	/* write the header */
-	if (the_log)
-	for(the_order=0;the_order<ORDER_MAX;++the_order) {
-		for(the_operation=0;the_operation<OPERATION_MAX;++the_operation) {
-			FILE* f = open("wt");
-			fprintf(f, "0\t");
+				MOPS[t][the_data] = mt_measure(mode, the_data, thread_count[t]);
+
+				/* efficiency compared to the single thread scaled linearly */
+				efficiency = MOPS[t][the_data] / (MOPS[0][the_data] * thread_count[t]);
+
+				printf("%4u %12s %18s, %8.2f [Mops/s], %4u [%%]\n", thread_count[t], MODE_NAME[mode], DATA_NAME[the_data], MOPS[t][the_data], (unsigned)(efficiency * 100 + 0.5));
+
+				/* the operation is the number of threads and the percentage of writes */
+				{
+					char buf[32];
+					snprintf(buf, sizeof(buf), "t%u_w%u", thread_count[t], the_write);
+					output_result(DATA_NAME[the_data], MODE_NAME[mode], buf, "Mops/s", 1, MOPS[t][the_data], MOPS[t][the_data], 0);
+				}
+			}
+		}
+
+		if (!log)
+			continue;
+
+		/* write the data, with a row for each number of threads */
+		{
+			char buf[128];
+			sprintf(buf, "dat_%s_throughput.lst", MODE_NAME[mode]);
+			f = fopen(buf, "wt");
+		}
+		fprintf(f, "0\t");
+		for(the_data=0;the_data<DATA_MAX;++the_data) {
+			if (is_listed(the_data))
+				fprintf(f, "%s\t", DATA_NAME[the_data]);
+		}
+		fprintf(f, "\n");
+		for(t=0;t<count_max;++t) {
+			fprintf(f, "%u\t", thread_count[t]);
 			for(the_data=0;the_data<DATA_MAX;++the_data) {
 				if (is_listed(the_data))
-					fprintf(f, "%s\t", DATA_NAME[the_data]);
+					fprintf(f, "%.2f\t", MOPS[t][the_data]);
 			}
 			fprintf(f, "\n");
-			fclose(f);
 		}
+		fclose(f);
 	}
+}
 
-	if (size != 0)
-		the_max = size;
-	else
-		the_max = (unsigned)base;
-
-	while (the_max <= MAX) {
-		unsigned retry;
-	
-		/* number of retries to avoid spikes */
-		retry = MIN_TRY / the_max;
-		if (retry < 1)
-			retry = 1;
-		if (retry > RETRY_MAX)
-			retry = RETRY_MAX;
-		if (size != 0)
-			retry = 1;
+/******************************************************************************/
+/* steady */
 
-		/* clear the log */
-		memset(LOG, 0, sizeof(LOG));
+/**
+ * Number of operations measured at least in the steady state test.
+ */
+#define STEADY_OPS 4000000
 
-		order_init(the_max, sparse);
+/**
+ * Number of sawtooth cycles measured at least in the steady state test.
+ */
+#define STEADY_CYCLE 2
 
-		/* run the test */
-		for(the_retry=0;the_retry<retry;++the_retry) {
-			/* data */
-			for(the_data=0;the_data<DATA_MAX;++the_data) {
-				if (!is_listed(the_data))
-					continue;
+/**
+ * Default period of the operations sampled for the latency.
+ */
+#define STEADY_PERIOD 64
 
-				if (data != DATA_MAX && data != the_data)
-					continue;
+/**
+ * Default percentage of the lookups of absent keys.
+ */
+#define STEADY_MISS 50
 
-				for(the_order=0;the_order<ORDER_MAX;++the_order) {
-					unsigned i;
+unsigned the_mix_lookup; /**< Percentage of lookups, 0 if the steady state test is disabled. */
+unsigned the_mix_insert; /**< Percentage of inserts. */
+unsigned the_mix_remove; /**< Percentage of removes. */
+unsigned the_mix_miss = STEADY_MISS; /**< Percentage of the lookups of absent keys. */
+tommy_bool_t the_sawtooth; /**< If the size moves in a sawtooth across the resize thresholds. */
 
-					printf("%12u", the_max);
+/**
+ * Result of the steady state test.
+ */
+struct steady_result {
+	double mops; /**< Throughput in Mops/s. */
+	unsigned low; /**< Min size. */
+	unsigned high; /**< Max size. */
+	unsigned grow; /**< Number of times the buckets increased. */
+	unsigned shrink; /**< Number of times the buckets decreased. */
+};
 
-					printf(" %18s %10s", DATA_NAME[the_data], ORDER_NAME[the_order]);
+/**
+ * Runs a steady state test, with a random mix of lookups, inserts and removes.
+ *
+ * Keys come from a pool of double the max size, kept partitioned as present
+ * and absent keys. Inserts take a random absent key, and removes a random present one.
+ * Lookups search a random absent key, with the miss probability, or a present one.
+ *
+ * The container starts at the target size, and with equal inserts and removes
+ * it stays around it, with the writes interleaved at random.
+ * With different inserts and removes, the size drifts up to the half or one and a half
+ * of the target, where the writes that go beyond are changed in the opposite ones.
+ *
+ * With the_sawtooth, the writes are instead all inserts going up, and all removes
+ * going down, in a sawtooth from 1/16 to the power of two of the target.
+ * A random walk around the target size never reaches the resize thresholds.
+ * The hashtables start to double the buckets when 50% full, and to halve them when 12.5% full,
+ * but tommy_hashlin completes a grow only at 100% and a shrink only at 6.25%,
+ * after the buckets are split or merged progressively by the following writes.
+ * The 16x range completes two grows and two shrinks of all of them at each cycle.
+ */
+void steady_measure(unsigned data, struct steady_result* result)
+{
+	struct mt_container c;
+	unsigned* pool;
+	unsigned pool_max;
+	unsigned count;
+	unsigned low;
+	unsigned high;
+	unsigned period;
+	unsigned seed;
+	unsigned warmup;
+	unsigned ops;
+	tommy_bool_t up;
+	size_t bucket;
+	unsigned i;
+	tommy_uint64_t elapsed;
 
-					/* skip degenerated cases */
-					if (LAST[the_data][the_order] > TIME_MAX_NS) {
-						printf(" (skipped, too slow)\n");
-						continue;
-					}
+	period = the_period ? the_period : STEADY_PERIOD;
 
-					if (!the_log)
-						printf("\n");
+	if (the_sawtooth) {
+		/* the power of two where the hashtables complete the grow */
+		high = tommy_roundup_pow2_u32(the_max);
+		low = high / 16;
+		count = low;
 
-					test_alloc();
-					if (the_order == ORDER_FORWARD)
-						test_operation(FORWARD, FORWARD);
-					else
-						test_operation(RAND0, RAND1);
-					test_free();
+		/* the writes to complete the cycles */
+		ops = (unsigned)((double)STEADY_CYCLE * 2 * (high - low) * 100 / (the_mix_insert + the_mix_remove));
+		if (ops < STEADY_OPS)
+			ops = STEADY_OPS;
+	} else {
+		high = the_max + the_max / 2;
+		low = the_max / 2;
+		count = the_max;
+		ops = STEADY_OPS;
+	}
+	up = 1;
+
+	result->low = count;
+	result->high = count;
+	result->grow = 0;
+	result->shrink = 0;
+
+	/* the first count keys of the pool are present */
+	pool_max = 2 * high;
+	pool = (unsigned*)malloc(pool_max * sizeof(unsigned));
+	for(i=0;i<pool_max;++i)
+		pool[i] = i;
+
+	mt_alloc(&c, data, 0, pool_max, count);
+	bucket = mt_bucket(&c, data);
+
+	hist_reset();
+	seed = 0x9E3779B9;
+	warmup = STEADY_OPS / 4;
+	the_time = 0;
+
+	for(i=0;i<warmup+ops;++i) {
+		tommy_uint64_t begin = 0;
+		tommy_bool_t sample;
+		tommy_bool_t insert;
+		unsigned key;
+		unsigned r;
+		unsigned j;
+
+		if (i == warmup)
+			the_time = nano();
+
+		/* xorshift random generator */
+		seed ^= seed << 13;
+		seed ^= seed >> 17;
+		seed ^= seed << 5;
+
+		r = (seed >> 16) % 100;
+
+		if (the_sawtooth)
+			insert = up;
+		else
+			insert = r < the_mix_lookup + the_mix_insert;
+
+		/* don't go beyond the size limits */
+		if (insert && count == high)
+			insert = 0;
+		else if (!insert && count == low)
+			insert = 1;
+
+		sample = i >= warmup && i % period == 0;
+		if (sample)
+			begin = tick();
+
+		if (r < the_mix_lookup) {
+			if ((seed >> 8) % 100 < the_mix_miss) {
+				if (mt_find(&c, data, pool[count + seed % (pool_max - count)]) != 0)
+					abort();
+			} else {
+				mt_search(&c, data, pool[seed % count]);
+			}
+		} else if (insert) {
+			/* move a random absent key at the end of the present ones */
+			j = count + seed % (pool_max - count);
+			key = pool[j];
+			pool[j] = pool[count];
+			pool[count] = key;
+			++count;
+			mt_insert(&c, data, (unsigned char*)c.obj + key * c.size, key);
+		} else {
+			/* move a random present key at the begin of the absent ones */
+			j = seed % count;
+			key = pool[j];
+			--count;
+			pool[j] = pool[count];
+			pool[count] = key;
+			mt_remove(&c, data, key);
+		}
 
-					if (the_log) {
-						for(i=0;i<OPERATION_MAX;++i)
-							printf(" %4u", LOG[the_retry][the_data][the_order][i]);
-						printf(" [ns]\n");
-					}
-				}
+		if (sample)
+			sample_store(tick() - begin);
+
+		if (r >= the_mix_lookup) {
+			size_t b;
+
+			/* invert the direction at the ends of the sawtooth */
+			if (count == high)
+				up = 0;
+			else if (count == low)
+				up = 1;
+
+			if (count < result->low)
+				result->low = count;
+			if (count > result->high)
+				result->high = count;
+
+			/* count the resizes in the measured operations */
+			b = mt_bucket(&c, data);
+			if (i >= warmup) {
+				if (b > bucket)
+					++result->grow;
+				else if (b < bucket)
+					++result->shrink;
 			}
+			bucket = b;
 		}
+	}
 
-		order_done();
+	elapsed = nano() - the_time;
 
-		/* write the data */
-		if (the_log)
-		for(the_order=0;the_order<ORDER_MAX;++the_order) {
-			for(the_operation=0;the_operation<OPERATION_MAX;++the_operation) {
-				FILE* f = open("at");
+	mt_free(&c, data);
+	free(pool);
 
-				fprintf(f, "%u\t", the_max);
-				
-				/* data */
-				for(the_data=0;the_data<DATA_MAX;++the_data) {
-					unsigned i, v;
+	result->mops = (double)ops * 1000 / elapsed;
+}
 
-					if (!is_listed(the_data))
-						continue;
+/**
+ * Steady state test with a mix of lookups, inserts and removes.
+ */
+void test_steady(unsigned size, unsigned data, int log)
+{
+	double MOPS[DATA_MAX];
+	unsigned GROW[DATA_MAX];
+	unsigned SHRINK[DATA_MAX];
+	unsigned LATENCY[DATA_MAX][PERCENTILE_MAX];
+	unsigned p;
 
-					/* get the minimum */
-					v = LOG[0][the_data][the_order][the_operation];
-					for(i=1;i<retry;++i) {
-						if (LOG[i][the_data][the_order][the_operation] < v)
-							v = LOG[i][the_data][the_order][the_operation];
-					}
+	if (size != 0)
+		the_max = size;
+	else
+		the_max = 1000000;
 
-					if (the_operation != OPERATION_SIZE && v != 0) {
-						/* keep the longest operation measure */
-						if (v > LAST[the_data][the_order]) {
-							LAST[the_data][the_order] = v;
-						}
-					}
+	memset(MOPS, 0, sizeof(MOPS));
+	memset(GROW, 0, sizeof(GROW));
+	memset(SHRINK, 0, sizeof(SHRINK));
+	memset(LATENCY, 0, sizeof(LATENCY));
 
-					fprintf(f, "%u\t", v);
-				}
+	if (the_sawtooth)
+		printf("Sawtooth from %u to %u objects with %u/%u lookup/write and %u%% of lookup misses\n", tommy_roundup_pow2_u32(the_max) / 16, tommy_roundup_pow2_u32(the_max), the_mix_lookup, the_mix_insert + the_mix_remove, the_mix_miss);
+	else
+		printf("Steady state with %u objects and %u/%u/%u lookup/insert/remove and %u%% of lookup misses\n", the_max, the_mix_lookup, the_mix_insert, the_mix_remove, the_mix_miss);
 
-				fprintf(f, "\n");
-				fclose(f);
+	for(the_data=0;the_data<DATA_MAX;++the_data) {
+		struct steady_result result;
+
+		if (data != DATA_MAX && data != the_data)
+			continue;
+
+		if (!mt_is_supported(the_data)) {
+			if (data != DATA_MAX)
+				printf("%18s (skipped, not supported)\n", DATA_NAME[the_data]);
+			continue;
+		}
+
+		steady_measure(the_data, &result);
+		MOPS[the_data] = result.mops;
+		GROW[the_data] = result.grow;
+		SHRINK[the_data] = result.shrink;
+
+		printf("%18s, %8.2f [Mops/s]", DATA_NAME[the_data], MOPS[the_data]);
+		for(p=0;p<PERCENTILE_MAX;++p) {
+			LATENCY[the_data][p] = (unsigned)(hist_percentile(PERCENTILE_FRACTION[p]) / the_tick_per_ns);
+			printf(", %s %4u", PERCENTILE_NAME[p], LATENCY[the_data][p]);
+		}
+		printf(" [ns], size %u-%u, grow %u, shrink %u\n", result.low, result.high, result.grow, result.shrink);
+
+		/* the operation is the mix of lookup/insert/remove/miss */
+		{
+			char buf[32];
+			snprintf(buf, sizeof(buf), "%u/%u/%u/%u", the_mix_lookup, the_mix_insert, the_mix_remove, the_mix_miss);
+			output_result(DATA_NAME[the_data], the_sawtooth ? "sawtooth" : "steady", buf, "Mops/s", 1, MOPS[the_data], MOPS[the_data], 0);
+			for(p=0;p<PERCENTILE_MAX;++p) {
+				snprintf(buf, sizeof(buf), "%u/%u/%u/%u_%s", the_mix_lookup, the_mix_insert, the_mix_remove, the_mix_miss, PERCENTILE_NAME[p]);
+				output_result(DATA_NAME[the_data], the_sawtooth ? "sawtooth" : "steady", buf, "ns", 1, LATENCY[the_data][p], LATENCY[the_data][p], 0);
 			}
 		}
+	}
 
-		if (size != 0)
-			break;
+	if (!log)
+		return;
 
-		/* new max */
-		base *= fact;
-		the_max = (unsigned)base;
+	/* write the data, with a row for the throughput and a row for each percentile */
+	{
+		FILE* f = fopen(the_sawtooth ? "dat_sawtooth.lst" : "dat_steady.lst", "wt");
+
+		fprintf(f, "0\t");
+		for(the_data=0;the_data<DATA_MAX;++the_data) {
+			if (is_listed(the_data))
+				fprintf(f, "%s\t", DATA_NAME[the_data]);
+		}
+		fprintf(f, "\n");
+
+		fprintf(f, "mops\t");
+		for(the_data=0;the_data<DATA_MAX;++the_data) {
+			if (is_listed(the_data))
+				fprintf(f, "%.2f\t", MOPS[the_data]);
+		}
+		fprintf(f, "\n");
+
+		fprintf(f, "grow\t");
+		for(the_data=0;the_data<DATA_MAX;++the_data) {
+			if (is_listed(the_data))
+				fprintf(f, "%u\t", GROW[the_data]);
+		}
+		fprintf(f, "\n");
+
+		fprintf(f, "shrink\t");
+		for(the_data=0;the_data<DATA_MAX;++the_data) {
+			if (is_listed(the_data))
+				fprintf(f, "%u\t", SHRINK[the_data]);
+		}
+		fprintf(f, "\n");
+
+		for(p=0;p<PERCENTILE_MAX;++p) {
+			fprintf(f, "%s\t", PERCENTILE_NAME[p]);
+			for(the_data=0;the_data<DATA_MAX;++the_data) {
+				if (is_listed(the_data))
+					fprintf(f, "%u\t", LATENCY[the_data][p]);
+			}
+			fprintf(f, "\n");
+		}
+
+		fclose(f);
 	}
 }
+#endif
 
 void help(void)
 {
@@ -2800,7 +5883,24 @@ void help(void)
 	printf("-m        Run the test for the maximum number of objects.\n");
 	printf("-d DATA   Run the test for the specified data structure.\n");
 	printf("-s        Use a sparse dataset intead of a compact one.\n");
+	printf("-S HASH   Use string keys of 16-128 bytes, hashed with hash_u64 or strhash_u32.\n");
+	printf("-k DIST   Adds a test with searches in the zipf, hotspot or latest distribution.\n");
+	printf("-z THETA  Parameter of the zipf and latest distributions, in (0,1). Default 0.99.\n");
+	printf("-r FILE   Adds a test with searches replayed from a trace file, with a key for each line.\n");
 	printf("-l        Logs results into file for graphs creation.\n");
+	printf("-o FILE   Writes all the results in FILE, as JSON if ending with .json, or as CSV.\n");
+	printf("-D OLD NEW Compares two CSV results, and reports the significant changes. JSON is not supported.\n");
+	printf("-p PERIOD Measures the latency percentiles sampling one operation every PERIOD.\n");
+	printf("-c        Reads the hardware counters of cache, TLB and branch misses for operation.\n");
+	printf("-P        Counts the Tommy allocations to measure the peak memory. It slows down Tommy.\n");
+	printf("          Not supported with -t.\n");
+#ifdef USE_THROUGHPUT
+	printf("-t THREAD Measures the throughput with up to THREAD threads.\n");
+	printf("-w WRITE  Percentage of writes in the throughput test. Default 10.\n");
+	printf("-M MIX    Measures the steady state with a mix of lookup/insert/remove[/miss], like 90/5/5/50.\n");
+	printf("          Miss is the percentage of lookups of absent keys. Default 50.\n");
+	printf("-R        With -M, moves the size in a sawtooth across the resize thresholds.\n");
+#endif
 }
 
 int main(int argc, char * argv[])
@@ -2810,8 +5910,12 @@ int main(int argc, char * argv[])
 	int flag_size = 0;
 	int flag_log = 0;
 	int flag_sparse = 0;
+	int flag_thread = 0;
+	int flag_steady = 0;
+	const char* flag_output = 0;
 
 	nano_init();
+	sample_init();
 
 	printf("Tommy benchmark program.\n");
 
@@ -2822,6 +5926,84 @@ int main(int argc, char * argv[])
 			flag_sparse = 1;
 		} else if (strcmp(argv[i], "-m") == 0) {
 			flag_size = MAX;
+		} else if (strcmp(argv[i], "-S") == 0) {
+			if (i+1 >= argc) {
+				printf("Missing hash function in %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			if (strcmp(argv[i+1], "hash_u64") == 0) {
+				the_string = STRING_HASH_U64;
+			} else if (strcmp(argv[i+1], "strhash_u32") == 0) {
+				the_string = STRING_STRHASH_U32;
+			} else {
+				printf("Unknown hash function '%s'\n", argv[i+1]);
+				exit(EXIT_FAILURE);
+			}
+			++i;
+		} else if (strcmp(argv[i], "-k") == 0) {
+			if (i+1 >= argc) {
+				printf("Missing distribution in %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			if (strcmp(argv[i+1], "zipf") == 0) {
+				the_dist = ORDER_ZIPF;
+			} else if (strcmp(argv[i+1], "hotspot") == 0) {
+				the_dist = ORDER_HOTSPOT;
+			} else if (strcmp(argv[i+1], "latest") == 0) {
+				the_dist = ORDER_LATEST;
+			} else {
+				printf("Unknown distribution '%s'\n", argv[i+1]);
+				exit(EXIT_FAILURE);
+			}
+			++i;
+		} else if (strcmp(argv[i], "-z") == 0) {
+			if (i+1 >= argc) {
+				printf("Missing parameter in %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			the_theta = atof(argv[i+1]);
+			if (!(the_theta > 0 && the_theta < 1)) {
+				printf("Invalid zipf parameter '%s'\n", argv[i+1]);
+				exit(EXIT_FAILURE);
+			}
+			++i;
+		} else if (strcmp(argv[i], "-r") == 0) {
+			if (i+1 >= argc) {
+				printf("Missing trace file in %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			trace_load(argv[i+1]);
+			the_dist = ORDER_TRACE;
+			++i;
+		} else if (strcmp(argv[i], "-o") == 0) {
+			if (i+1 >= argc) {
+				printf("Missing output file in %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			flag_output = argv[i+1];
+			++i;
+		} else if (strcmp(argv[i], "-D") == 0) {
+			if (i+2 >= argc) {
+				printf("Missing files to compare in %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			/* exit with failure if there are regressions */
+			return compare(argv[i+1], argv[i+2]) == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+		} else if (strcmp(argv[i], "-c") == 0) {
+			the_counter = 1;
+		} else if (strcmp(argv[i], "-P") == 0) {
+			the_alloc_count = 1;
+		} else if (strcmp(argv[i], "-p") == 0) {
+			if (i+1 >= argc) {
+				printf("Missing sampling period in %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			the_period = atoi(argv[i+1]);
+			if (the_period == 0) {
+				printf("Invalid sampling period '%s'\n", argv[i+1]);
+				exit(EXIT_FAILURE);
+			}
+			++i;
 		} else if (strcmp(argv[i], "-n") == 0) {
 			if (i+1 >= argc) {
 				printf("Missing number of objects in %s\n", argv[i]);
@@ -2829,6 +6011,47 @@ int main(int argc, char * argv[])
 			}
 			flag_size = atoi(argv[i+1]);
 			++i;
+#ifdef USE_THROUGHPUT
+		} else if (strcmp(argv[i], "-t") == 0) {
+			if (i+1 >= argc) {
+				printf("Missing number of threads in %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			flag_thread = atoi(argv[i+1]);
+			if (flag_thread <= 0 || flag_thread > THREAD_MAX) {
+				printf("Invalid number of threads '%s'\n", argv[i+1]);
+				exit(EXIT_FAILURE);
+			}
+			++i;
+		} else if (strcmp(argv[i], "-w") == 0) {
+			if (i+1 >= argc) {
+				printf("Missing percentage of writes in %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			the_write = atoi(argv[i+1]);
+			if (the_write > 100) {
+				printf("Invalid percentage of writes '%s'\n", argv[i+1]);
+				exit(EXIT_FAILURE);
+			}
+			++i;
+		} else if (strcmp(argv[i], "-R") == 0) {
+			the_sawtooth = 1;
+		} else if (strcmp(argv[i], "-M") == 0) {
+			if (i+1 >= argc) {
+				printf("Missing operation mix in %s\n", argv[i]);
+				exit(EXIT_FAILURE);
+			}
+			int n = sscanf(argv[i+1], "%u/%u/%u/%u", &the_mix_lookup, &the_mix_insert, &the_mix_remove, &the_mix_miss);
+			if ((n != 3 && n != 4)
+				|| the_mix_lookup + the_mix_insert + the_mix_remove != 100
+				|| the_mix_miss > 100
+			) {
+				printf("Invalid operation mix '%s', it must be like 90/5/5 or 90/5/5/50\n", argv[i+1]);
+				exit(EXIT_FAILURE);
+			}
+			flag_steady = 1;
+			++i;
+#endif
 		} else if (strcmp(argv[i], "-d") == 0) {
 			int j;
 			if (i+1 >= argc) {
@@ -2858,7 +6081,45 @@ int main(int argc, char * argv[])
 		} 
 	}
 
-	test(flag_size, flag_data, flag_log, flag_sparse);
+	if (the_counter)
+		the_counter = counter_init();
+
+	if (the_string && flag_sparse) {
+		printf("String keys are not supported with a sparse dataset\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (the_string && flag_size > STRING_MAX) {
+		printf("String keys are supported up to %u objects\n", STRING_MAX);
+		exit(EXIT_FAILURE);
+	}
+
+#ifdef USE_THROUGHPUT
+	/* the counters of the allocations are not thread safe */
+	if (the_alloc_count && flag_thread != 0) {
+		printf("Counting the allocations is not supported with threads\n");
+		exit(EXIT_FAILURE);
+	}
+
+	if (the_sawtooth && (!flag_steady || the_mix_insert + the_mix_remove == 0)) {
+		printf("The sawtooth needs -M with some inserts or removes\n");
+		exit(EXIT_FAILURE);
+	}
+#endif
+
+	if (flag_output)
+		output_open(flag_output);
+
+#ifdef USE_THROUGHPUT
+	if (flag_steady)
+		test_steady(flag_size, flag_data, flag_log);
+	else if (flag_thread != 0)
+		test_throughput(flag_size, flag_data, flag_log, flag_thread);
+	else
+#endif
+		test(flag_size, flag_data, flag_log, flag_sparse);
+
+	output_close();
 
 	printf("OK\n");
 
@@ -21,6 +21,16 @@ DIR=data\core_i5_650_3G2_linux
 %GNUPLOT% %DIR%\gr_def.gnu gr_random_change.gnu
 %GNUPLOT% %DIR%\gr_def.gnu gr_random_remove.gnu
 %GNUPLOT% %DIR%\gr_def.gnu gr_random_size.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_zipf_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_zipf_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_hotspot_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_hotspot_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_latest_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_latest_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_trace_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_trace_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_random_peak.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_random_rss.gnu
 
 DIR=data\core_i7_3740_2G7_win
 %GNUPLOT% %DIR%\gr_def.gnu gr_forward_insert.gnu
@@ -36,6 +46,16 @@ DIR=data\core_i7_3740_2G7_win
 %GNUPLOT% %DIR%\gr_def.gnu gr_random_change.gnu
 %GNUPLOT% %DIR%\gr_def.gnu gr_random_remove.gnu
 %GNUPLOT% %DIR%\gr_def.gnu gr_random_size.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_zipf_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_zipf_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_hotspot_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_hotspot_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_latest_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_latest_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_trace_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_trace_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_random_peak.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_random_rss.gnu
 
 DIR=data\test
 %GNUPLOT% %DIR%\gr_def.gnu gr_forward_insert.gnu
@@ -51,4 +71,14 @@ DIR=data\test
 %GNUPLOT% %DIR%\gr_def.gnu gr_random_change.gnu
 %GNUPLOT% %DIR%\gr_def.gnu gr_random_remove.gnu
 %GNUPLOT% %DIR%\gr_def.gnu gr_random_size.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_zipf_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_zipf_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_hotspot_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_hotspot_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_latest_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_latest_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_trace_hit.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_trace_miss.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_random_peak.gnu
+%GNUPLOT% %DIR%\gr_def.gnu gr_random_rss.gnu
 
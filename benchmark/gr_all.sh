@@ -22,6 +22,16 @@ gnuplot $DIR/gr_def.gnu gr_random_miss.gnu
 gnuplot $DIR/gr_def.gnu gr_random_change.gnu
 gnuplot $DIR/gr_def.gnu gr_random_remove.gnu
 gnuplot $DIR/gr_def.gnu gr_random_size.gnu
+gnuplot $DIR/gr_def.gnu gr_zipf_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_zipf_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_hotspot_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_hotspot_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_latest_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_latest_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_trace_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_trace_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_random_peak.gnu
+gnuplot $DIR/gr_def.gnu gr_random_rss.gnu
 
 DIR=data/core_i7_3740_2G7_win
 gnuplot $DIR/gr_def.gnu gr_forward_insert.gnu
@@ -37,6 +47,16 @@ gnuplot $DIR/gr_def.gnu gr_random_miss.gnu
 gnuplot $DIR/gr_def.gnu gr_random_change.gnu
 gnuplot $DIR/gr_def.gnu gr_random_remove.gnu
 gnuplot $DIR/gr_def.gnu gr_random_size.gnu
+gnuplot $DIR/gr_def.gnu gr_zipf_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_zipf_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_hotspot_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_hotspot_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_latest_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_latest_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_trace_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_trace_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_random_peak.gnu
+gnuplot $DIR/gr_def.gnu gr_random_rss.gnu
 
 DIR=data/core_i7_10700_2G9_linux
 gnuplot $DIR/gr_def.gnu gr_forward_insert.gnu
@@ -52,6 +72,16 @@ gnuplot $DIR/gr_def.gnu gr_random_miss.gnu
 gnuplot $DIR/gr_def.gnu gr_random_change.gnu
 gnuplot $DIR/gr_def.gnu gr_random_remove.gnu
 gnuplot $DIR/gr_def.gnu gr_random_size.gnu
+gnuplot $DIR/gr_def.gnu gr_zipf_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_zipf_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_hotspot_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_hotspot_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_latest_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_latest_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_trace_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_trace_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_random_peak.gnu
+gnuplot $DIR/gr_def.gnu gr_random_rss.gnu
 
 DIR=data/test
 gnuplot $DIR/gr_def.gnu gr_forward_insert.gnu
@@ -67,4 +97,14 @@ gnuplot $DIR/gr_def.gnu gr_random_miss.gnu
 gnuplot $DIR/gr_def.gnu gr_random_change.gnu
 gnuplot $DIR/gr_def.gnu gr_random_remove.gnu
 gnuplot $DIR/gr_def.gnu gr_random_size.gnu
+gnuplot $DIR/gr_def.gnu gr_zipf_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_zipf_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_hotspot_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_hotspot_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_latest_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_latest_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_trace_hit.gnu
+gnuplot $DIR/gr_def.gnu gr_trace_miss.gnu
+gnuplot $DIR/gr_def.gnu gr_random_peak.gnu
+gnuplot $DIR/gr_def.gnu gr_random_rss.gnu
 
@@ -76,4 +76,7 @@ set style line 17 lc 17 lt 8 # tesseract
 set style line 18 lc 4 lt 7 # libdynamic
 set style line 19 lc rgb "#FF69B4" lt 7 # googlelibchash
 set style line 20 lc rgb "#1E90FF" lt 7 # concurrencykit
+set style line 21 lc rgb "#228B22" lt 8 # mphf
+set style line 22 lc 2 lt 8 # hashdync
+set style line 23 lc 3 lt 8 # hashlinc
 
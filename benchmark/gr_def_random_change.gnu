@@ -8,5 +8,5 @@ set title "Random Change (Remove + Insert)".tsub
 data = bdir.tdir.'dat_random_change.lst'
 
 plot data using 1:2 title columnheader(2), \
-	for [i=3:21] '' using 1:i title columnheader(i) ls i-1
+	for [i=3:24] '' using 1:i title columnheader(i) ls i-1
 
@@ -0,0 +1,9 @@
+load "gr_common.gnu"
+
+set output bdir.tdir."img_hotspot_miss".bext
+set title "Hotspot Miss".tsub
+data = bdir.tdir.'dat_hotspot_miss.lst'
+
+plot data using 1:2 title columnheader(2), \
+	for [i=3:24] '' using 1:i title columnheader(i) ls i-1
+
@@ -10,5 +10,5 @@ set title "Random Change (Remove + Insert)".tsub
 data = bdir.tdir.'ck_problem.lst'
 
 plot data using 1:2 title columnheader(2), \
-	for [i=3:21] '' using 1:i title columnheader(i) ls i-1
+	for [i=3:24] '' using 1:i title columnheader(i) ls i-1
 
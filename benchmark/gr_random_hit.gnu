@@ -5,5 +5,5 @@ set title "Random Hit".tsub
 data = bdir.tdir.'dat_random_hit.lst'
 
 plot data using 1:2 title columnheader(2), \
-	for [i=3:21] '' using 1:i title columnheader(i) ls i-1
+	for [i=3:24] '' using 1:i title columnheader(i) ls i-1
 
@@ -0,0 +1,13 @@
+load "gr_common.gnu"
+
+set output bdir.tdir."img_random_peak".bext
+set title "Peak size".tsub
+set format y "%.0f"
+set ylabel "Peak size for element in byte\nLower is better"
+unset logscale y
+set yrange [0:120]
+data = bdir.tdir.'dat_random_peak.lst'
+
+plot data using 1:2 title columnheader(2), \
+	for [i=3:24] '' using 1:i title columnheader(i) ls i-1
+
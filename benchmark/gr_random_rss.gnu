@@ -0,0 +1,13 @@
+load "gr_common.gnu"
+
+set output bdir.tdir."img_random_rss".bext
+set title "Peak RSS".tsub
+set format y "%.0f"
+set ylabel "Peak RSS for element in byte\nLower is better"
+unset logscale y
+set yrange [0:200]
+data = bdir.tdir.'dat_random_rss.lst'
+
+plot data using 1:2 title columnheader(2), \
+	for [i=3:24] '' using 1:i title columnheader(i) ls i-1
+
@@ -0,0 +1,9 @@
+load "gr_common.gnu"
+
+set output bdir.tdir."img_zipf_hit".bext
+set title "Zipf Hit".tsub
+data = bdir.tdir.'dat_zipf_hit.lst'
+
+plot data using 1:2 title columnheader(2), \
+	for [i=3:24] '' using 1:i title columnheader(i) ls i-1
+
@@ -27,6 +27,13 @@
 #include <mach/mach_time.h>
 #endif
 
+/* Use threads to check the lock-free containers */
+#if defined(__linux) || defined(__MACH__)
+#include <pthread.h>
+#include <sched.h>
+#define USE_PTHREAD
+#endif
+
 #include "tommyds/tommy.h"
 
 #define TOMMY_SIZE 1000000
@@ -80,6 +87,12 @@ struct object_hash {
 	char payload[PAYLOAD];
 };
 
+struct object_hashc {
+	int value;
+	tommy_cnode node;
+	char payload[PAYLOAD];
+};
+
 struct object_tree {
 	int value;
 	tommy_tree_node node;
@@ -294,6 +307,23 @@ static int search_callback(const void* arg, const void* obj)
 	return arg != obj;
 }
 
+static tommy_uint64_t save_callback(void* arg, void* obj)
+{
+	struct object_hash* base = arg;
+	struct object_hash* hash = obj;
+
+	return hash - base;
+}
+
+static void* load_callback(void* arg, tommy_uint64_t offset, tommy_node** node)
+{
+	struct object_hash* hash = (struct object_hash*)arg + offset;
+
+	*node = &hash->node;
+
+	return hash;
+}
+
 struct hash32_test {
 	char* data;
 	tommy_uint32_t len;
@@ -692,6 +722,18 @@ void test_alloc(void)
 	free(PTR);
 }
 
+/* parallel function running all the jobs in the calling thread */
+void parallel_sequential(void* arg, tommy_job_func* job, void* context, tommy_size_t count)
+{
+	tommy_size_t i;
+
+	(void)arg;
+
+	/* run backward to not depend on the jobs order */
+	for(i=count;i>0;--i)
+		job(context, i - 1);
+}
+
 void test_list_order(tommy_node* list)
 {
 	tommy_node* node;
@@ -829,6 +871,42 @@ void test_list(void)
 
 	test_list_order(list);
 
+	/* forward order with some (1%) random values appended */
+	list = 0;
+	for(i=0;i<size;++i) {
+		VECTOR[i].value = LIST[i].value = i;
+		if (i >= size - size / 100)
+			VECTOR[i].value = LIST[i].value = rnd(size);
+		tommy_list_insert_tail(&list, &LIST[i].node, &LIST[i]);
+	}
+
+	START("sort appended");
+	tommy_list_sort(&list, compare);
+	STOP();
+
+	START("C qsort appended");
+	qsort(VECTOR, size, sizeof(VECTOR[0]), compare_vector);
+	STOP();
+
+	test_list_order(list);
+
+	/* backward order with duplicates */
+	list = 0;
+	for(i=0;i<size;++i) {
+		VECTOR[i].value = LIST[i].value = (size - 1 - i) / 4;
+		tommy_list_insert_tail(&list, &LIST[i].node, &LIST[i]);
+	}
+
+	START("sort backward duplicate");
+	tommy_list_sort(&list, compare);
+	STOP();
+
+	START("C qsort backward duplicate");
+	qsort(VECTOR, size, sizeof(VECTOR[0]), compare_vector);
+	STOP();
+
+	test_list_order(list);
+
 	/* use a small range of random value to insert a lot of duplicates */
 	list = 0;
 	for(i=0;i<size;++i) {
@@ -846,417 +924,2150 @@ void test_list(void)
 
 	test_list_order(list);
 
-	free(LIST);
-	free(VECTOR);
-}
-
-void test_tree(void)
-{
-	tommy_tree tree;
-	struct object_tree* OBJ;
-	unsigned i;
-	const unsigned size = TOMMY_SIZE / 4;
-
-	OBJ = malloc(size * sizeof(struct object_tree));
-
-	START("tree");
-	tommy_tree_init(&tree, &compare);
+	/* radix sort of random values */
+	list = 0;
+	for(i=0;i<size;++i) {
+		LIST[i].value = rnd(size);
+		tommy_list_insert_tail(&list, &LIST[i].node, &LIST[i]);
+		LIST[i].node.index = LIST[i].value;
+	}
 
-	/* forward order */
-	for(i=0;i<size;++i)
-		OBJ[i].value = i;
+	START("sort index random");
+	tommy_list_sort_index(&list);
+	STOP();
 
-	/* insert */
-	for(i=0;i<size;++i)
-		if (tommy_tree_insert(&tree, &OBJ[i].node, &OBJ[i]) != &OBJ[i])
-			/* LCOV_EXCL_START */
-			abort();
-			/* LCOV_EXCL_STOP */
+	test_list_order(list);
 
-	if (tommy_tree_memory_usage(&tree) < size * sizeof(tommy_tree_node))
+	if (tommy_list_count(&list) != size || tommy_list_tail(&list)->next != 0)
 		/* LCOV_EXCL_START */
 		abort();
 		/* LCOV_EXCL_STOP */
 
-	if (tommy_tree_count(&tree) != size)
+	/* radix sort of random values with duplicates */
+	list = 0;
+	for(i=0;i<size;++i) {
+		LIST[i].value = rnd(size / 1000 + 2);
+		tommy_list_insert_tail(&list, &LIST[i].node, &LIST[i]);
+		LIST[i].node.index = LIST[i].value;
+	}
+
+	START("sort index duplicate");
+	tommy_list_sort_index(&list);
+	STOP();
+
+	test_list_order(list);
+
+	/* radix sort of backward values with a constant high part */
+	list = 0;
+	for(i=0;i<size;++i) {
+		LIST[i].value = size - 1 - i;
+		tommy_list_insert_tail(&list, &LIST[i].node, &LIST[i]);
+		LIST[i].node.index = LIST[i].value + 0x40000000;
+	}
+
+	START("sort index backward");
+	tommy_list_sort_index(&list);
+	STOP();
+
+	test_list_order(list);
+
+	if (tommy_list_head(&list)->data != &LIST[size - 1] || tommy_list_tail(&list)->data != &LIST[0])
 		/* LCOV_EXCL_START */
 		abort();
 		/* LCOV_EXCL_STOP */
 
-	the_count = 0;
-	tommy_tree_foreach(&tree, count_callback);
-	if (the_count != size)
+	/* parallel sort of random values with duplicates */
+	list = 0;
+	for(i=0;i<size;++i) {
+		LIST[i].value = rnd(size / 16 + 2);
+		tommy_list_insert_tail(&list, &LIST[i].node, &LIST[i]);
+	}
+
+	START("sort parallel");
+	tommy_list_sort_parallel(&list, compare, 8, parallel_sequential, 0);
+	STOP();
+
+	test_list_order(list);
+
+	if (tommy_list_count(&list) != size)
 		/* LCOV_EXCL_START */
 		abort();
 		/* LCOV_EXCL_STOP */
 
-	the_count = 0;
-	tommy_tree_foreach_arg(&tree, count_arg_callback, &the_count);
-	if (the_count != size)
+	/* parallel sort with an uneven number of runs and without a parallel function */
+	list = 0;
+	for(i=0;i<size;++i) {
+		LIST[i].value = rnd(size);
+		tommy_list_insert_tail(&list, &LIST[i].node, &LIST[i]);
+	}
+
+	tommy_list_sort_parallel(&list, compare, 7, 0, 0);
+
+	test_list_order(list);
+
+	if (tommy_list_count(&list) != size)
 		/* LCOV_EXCL_START */
 		abort();
 		/* LCOV_EXCL_STOP */
 
-	/* search present */
-	for(i=0;i<size/2;++i) {
-		if (tommy_tree_search(&tree, &OBJ[i]) == 0)
-				/* LCOV_EXCL_START */
-			abort();
-			/* LCOV_EXCL_STOP */
-		if (tommy_tree_search_compare(&tree, &compare, &OBJ[i]) == 0)
-			/* LCOV_EXCL_START */
-			abort();
-			/* LCOV_EXCL_STOP */
+	/* parallel sort with more runs than elements */
+	list = 0;
+	for(i=0;i<5;++i) {
+		LIST[i].value = 5 - i;
+		tommy_list_insert_tail(&list, &LIST[i].node, &LIST[i]);
 	}
 
-	/* insert existing */
-	for(i=0;i<size;++i) {
-		struct object_tree EXTRA;
-		EXTRA.value = i;
-		if (tommy_tree_insert(&tree, &EXTRA.node, &EXTRA) == &EXTRA)
-			/* LCOV_EXCL_START */
-			abort();
-			/* LCOV_EXCL_STOP */
-	}
+	tommy_list_sort_parallel(&list, compare, 64, parallel_sequential, 0);
 
-	/* remove existing */
-	for(i=0;i<size/2;++i)
-		tommy_tree_remove_existing(&tree, &OBJ[i].node);
+	test_list_order(list);
 
-	/* remove missing */
-	for(i=0;i<size/2;++i)
-		if (tommy_tree_remove(&tree, &OBJ[i]) != 0)
-			/* LCOV_EXCL_START */
-			abort();
-			/* LCOV_EXCL_STOP */
+	if (tommy_list_count(&list) != 5 || tommy_list_tail(&list)->next != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
 
-	/* search missing */
-	for(i=0;i<size/2;++i) {
-		if (tommy_tree_search(&tree, &OBJ[i]) != 0)
-			/* LCOV_EXCL_START */
-			abort();
-			/* LCOV_EXCL_STOP */
-		if (tommy_tree_search_compare(&tree, &compare, &OBJ[i]) != 0)
-			/* LCOV_EXCL_START */
-			abort();
-			/* LCOV_EXCL_STOP */
-	}
+	free(LIST);
+	free(VECTOR);
+}
 
-	/* remove present */
-	for(i=0;i<size/2;++i)
-		if (tommy_tree_remove(&tree, &OBJ[size/2+i]) == 0)
-			/* LCOV_EXCL_START */
-			abort();
-			/* LCOV_EXCL_STOP */
+void test_ulist(void)
+{
+	struct object* OBJ;
+	tommy_ulist_iterator* ITER;
+	tommy_allocator alloc;
+	tommy_ulist ulist;
+	tommy_ulist_iterator it;
+	tommy_node* list;
+	struct object* obj;
+	unsigned i;
+	unsigned count;
+	const unsigned size = TOMMY_SIZE;
 
-	/* reverse order */
-	for(i=0;i<size;++i)
-		OBJ[i].value = size - i;
+	OBJ = malloc(size * sizeof(struct object));
+	ITER = malloc(size * sizeof(tommy_ulist_iterator));
 
-	/* insert */
-	for(i=0;i<size;++i)
-		if (tommy_tree_insert(&tree, &OBJ[i].node, &OBJ[i]) != &OBJ[i])
-			/* LCOV_EXCL_START */
-			abort();
-			/* LCOV_EXCL_STOP */
+	tommy_allocator_init(&alloc, TOMMY_ULIST_BLOCK_SIZE, TOMMY_ULIST_BLOCK_SIZE);
+	tommy_ulist_init(&ulist, &alloc);
 
-	/* remove all */
-	for(i=0;i<size;++i)
-		tommy_tree_remove_existing(&tree, &OBJ[i].node);
+	if (tommy_ulist_begin(&ulist, &it) != 0 || tommy_ulist_remove_head(&ulist) != 0 || tommy_ulist_remove_tail(&ulist) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
 
-	/* random order */
-	for(i=0;i<size;++i)
-		OBJ[i].value = tommy_inthash_u32(i);
+	list = 0;
+	for(i=0;i<size;++i) {
+		OBJ[i].value = i;
+		tommy_ulist_insert_tail(&ulist, &OBJ[i], &ITER[i]);
+		tommy_list_insert_tail(&list, &OBJ[i].node, &OBJ[i]);
+	}
 
-	/* insert */
-	for(i=0;i<size;++i)
-		if (tommy_tree_insert(&tree, &OBJ[i].node, &OBJ[i]) != &OBJ[i])
+	if (tommy_ulist_count(&ulist) != size || tommy_ulist_get(&ITER[size / 2]) != &OBJ[size / 2])
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	START("ulist iterate");
+	count = 0;
+	obj = tommy_ulist_begin(&ulist, &it);
+	while (obj) {
+		if (obj->value != (int)count)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
-
-	/* remove all */
-	for(i=0;i<size;++i)
-		tommy_tree_remove_existing(&tree, &OBJ[i].node);
-
+		++count;
+		obj = tommy_ulist_next(&it);
+	}
 	STOP();
-}
-
-void test_array(void)
-{
-	tommy_array array;
-	tommy_uintptr_t i;
-	const unsigned size = 50 * TOMMY_SIZE;
-
-	tommy_array_init(&array);
 
-	/* no op */
-	tommy_array_grow(&array, 0);
+	if (count != size)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
 
-	START("array init");
-	for(i=0;i<size;++i) {
-		tommy_array_grow(&array, i + 1);
-		if (tommy_array_get(&array, i) != 0)
+	START("list iterate");
+	count = 0;
+	list = tommy_list_head(&list);
+	while (list) {
+		obj = list->data;
+		if (obj->value != (int)count)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
+		++count;
+		list = list->next;
 	}
 	STOP();
 
-	START("array set");
+	/* remove two elements every three, and all of the first chunks */
+	START("ulist remove existing");
 	for(i=0;i<size;++i) {
-		tommy_array_set(&array, i, (void*)i);
+		if (i % 3 != 0 || i < 4 * TOMMY_ULIST_SLOT_MAX) {
+			if (tommy_ulist_remove_existing(&ulist, &ITER[i]) != &OBJ[i])
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
 	}
 	STOP();
 
-	START("array get");
-	for(i=0;i<size;++i) {
-		if (tommy_array_get(&array, i) != (void*)i)
+	the_count = 0;
+	tommy_ulist_foreach(&ulist, count_callback);
+	if (the_count != tommy_ulist_count(&ulist))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	count = 0;
+	tommy_ulist_foreach_arg(&ulist, count_arg_callback, &count);
+	if (count != tommy_ulist_count(&ulist))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* the remaining elements are still in order */
+	count = 0;
+	i = 4 * TOMMY_ULIST_SLOT_MAX;
+	obj = tommy_ulist_begin(&ulist, &it);
+	while (obj) {
+		while (i % 3 != 0)
+			++i;
+		if (obj != &OBJ[i])
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
+		++count;
+		++i;
+		obj = tommy_ulist_next(&it);
 	}
-	STOP();
 
-	if (tommy_array_memory_usage(&array) < size * sizeof(void*))
+	if (count != tommy_ulist_count(&ulist))
 		/* LCOV_EXCL_START */
 		abort();
 		/* LCOV_EXCL_STOP */
 
-	tommy_array_done(&array);
-}
-
-void test_arrayof(void)
+	/* remove alternating the head and the tail */
+	i = 0;
+	while (!tommy_ulist_empty(&ulist)) {
+		if (i % 2 == 0)
+			obj = tommy_ulist_remove_head(&ulist);
+		else
+			obj = tommy_ulist_remove_tail(&ulist);
+		if (!obj || obj->value % 3 != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		++i;
+	}
+
+	if (i != count || tommy_ulist_memory_usage(&ulist) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* use it as a queue, inserting at the head and removing from the tail */
+	START("ulist queue");
+	for(i=0;i<size;++i) {
+		tommy_ulist_insert_head(&ulist, &OBJ[i], 0);
+		if (i % 2 == 1) {
+			obj = tommy_ulist_remove_tail(&ulist);
+			if (obj != &OBJ[i / 2])
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+	}
+	STOP();
+
+	if (tommy_ulist_count(&ulist) != size / 2 || tommy_ulist_memory_usage(&ulist) == 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	tommy_ulist_done(&ulist);
+
+	if (tommy_ulist_count(&ulist) != 0 || alloc.count != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	tommy_allocator_done(&alloc);
+
+	free(OBJ);
+	free(ITER);
+}
+
+#ifdef USE_PTHREAD
+/**
+ * Number of producer and consumer threads.
+ */
+#define THREAD_MAX 4
+
+struct thread_context {
+	tommy_queue* queue;
+	tommy_ring* ring;
+	struct object* obj; /**< Objects to insert. */
+	unsigned count; /**< Number of objects to insert. */
+	unsigned* seen; /**< Number of times each object is removed. */
+	tommy_size_t volatile* removed; /**< Number of objects removed by all the consumers. */
+	tommy_size_t total; /**< Number of objects inserted by all the producers. */
+};
+
+static void* queue_producer(void* arg)
 {
-	tommy_arrayof arrayof;
+	struct thread_context* context = arg;
 	unsigned i;
-	const unsigned size = 50 * TOMMY_SIZE;
 
-	tommy_arrayof_init(&arrayof, sizeof(unsigned));
+	for(i=0;i<context->count;++i)
+		tommy_queue_insert(context->queue, &context->obj[i].node, &context->obj[i]);
 
-	/* no op */
-	tommy_arrayof_grow(&arrayof, 0);
+	return 0;
+}
 
-	START("arrayof init");
-	for(i=0;i<size;++i) {
-		tommy_arrayof_grow(&arrayof, i + 1);
-		unsigned* ref = tommy_arrayof_ref(&arrayof, i);
-		if (*ref != 0)
+static void* ring_producer(void* arg)
+{
+	struct thread_context* context = arg;
+	unsigned i;
+
+	for(i=0;i<context->count;++i) {
+		/* retry while full, leaving the cpu to the consumers */
+		while (tommy_ring_insert(context->ring, &context->obj[i].node, &context->obj[i]) != 0)
+			sched_yield();
+	}
+
+	return 0;
+}
+
+static void* ring_consumer(void* arg)
+{
+	struct thread_context* context = arg;
+
+	while (tommy_atomic_load(context->removed) < context->total) {
+		tommy_list list;
+		tommy_node* node;
+		tommy_size_t count;
+
+		tommy_list_init(&list);
+		if (tommy_ring_remove_list(context->ring, &list) != 0) {
+			sched_yield();
+			continue;
+		}
+
+		count = 0;
+		node = tommy_list_head(&list);
+		while (node) {
+			struct object* obj = node->data;
+			++context->seen[obj->value];
+			++count;
+			node = node->next;
+		}
+
+		tommy_atomic_add(context->removed, count);
+	}
+
+	return 0;
+}
+
+/**
+ * Checks the queue with concurrent producers, and the main thread as consumer.
+ */
+static void test_queue_thread(struct object* OBJ, unsigned size)
+{
+	pthread_t producer[THREAD_MAX];
+	struct thread_context context[THREAD_MAX];
+	int last[THREAD_MAX];
+	tommy_queue queue;
+	const unsigned count = size / THREAD_MAX;
+	unsigned removed;
+	unsigned i;
+
+	tommy_queue_init(&queue);
+
+	for(i=0;i<THREAD_MAX;++i) {
+		context[i].queue = &queue;
+		context[i].obj = OBJ + i * count;
+		context[i].count = count;
+		last[i] = (int)(i * count) - 1;
+		if (pthread_create(&producer[i], 0, queue_producer, &context[i]) != 0)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 	}
-	STOP();
 
-	START("arrayof set");
-	for(i=0;i<size;++i) {
-		unsigned* ref = tommy_arrayof_ref(&arrayof, i);
-		*ref = i;
-	}
-	STOP();
+	removed = 0;
+	while (removed < THREAD_MAX * count) {
+		struct object* obj = tommy_queue_remove(&queue);
+		unsigned p;
 
-	START("arrayof get");
-	for(i=0;i<size;++i) {
-		unsigned* ref = tommy_arrayof_ref(&arrayof, i);
-		if (*ref != i)
+		if (!obj) {
+			sched_yield();
+			continue;
+		}
+
+		/* the elements of each producer must come in order */
+		p = obj->value / count;
+		if (obj->value != last[p] + 1)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
+		last[p] = obj->value;
+
+		++removed;
 	}
-	STOP();
 
-	if (tommy_arrayof_memory_usage(&arrayof) < size * sizeof(unsigned))
+	for(i=0;i<THREAD_MAX;++i)
+		pthread_join(producer[i], 0);
+
+	if (tommy_queue_remove(&queue) != 0)
 		/* LCOV_EXCL_START */
 		abort();
 		/* LCOV_EXCL_STOP */
+}
 
-	tommy_arrayof_done(&arrayof);
+/**
+ * Checks the ring with concurrent producers and consumers.
+ */
+static void test_ring_thread(struct object* OBJ, unsigned size)
+{
+	pthread_t producer[THREAD_MAX];
+	pthread_t consumer[THREAD_MAX];
+	struct thread_context context[THREAD_MAX];
+	tommy_ring ring;
+	tommy_size_t removed;
+	unsigned* seen;
+	const unsigned count = size / THREAD_MAX;
+	unsigned i;
+
+	/* a small ring, to have it often full */
+	tommy_ring_init(&ring, 16);
+
+	seen = calloc(size, sizeof(unsigned));
+	removed = 0;
+
+	for(i=0;i<THREAD_MAX;++i) {
+		context[i].ring = &ring;
+		context[i].obj = OBJ + i * count;
+		context[i].count = count;
+		context[i].seen = seen;
+		context[i].removed = &removed;
+		context[i].total = THREAD_MAX * count;
+		if (pthread_create(&consumer[i], 0, ring_consumer, &context[i]) != 0
+			|| pthread_create(&producer[i], 0, ring_producer, &context[i]) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+
+	for(i=0;i<THREAD_MAX;++i) {
+		pthread_join(producer[i], 0);
+		pthread_join(consumer[i], 0);
+	}
+
+	/* each element must be removed exactly once */
+	for(i=0;i<THREAD_MAX * count;++i)
+		if (seen[i] != 1)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+	free(seen);
+	tommy_ring_done(&ring);
 }
+#endif
 
-void test_arrayblk(void)
+void test_queue(void)
 {
-	tommy_arrayblk arrayblk;
-	tommy_uintptr_t i;
-	const unsigned size = 50 * TOMMY_SIZE;
+	struct object* OBJ;
+	tommy_queue queue;
+	tommy_ring ring;
+	tommy_list list;
+	struct object* obj;
+	tommy_node* node;
+	unsigned i;
+	const unsigned size = TOMMY_SIZE;
 
-	tommy_arrayblk_init(&arrayblk);
+	OBJ = malloc(size * sizeof(struct object));
 
-	/* no op */
-	tommy_arrayblk_grow(&arrayblk, 0);
+	for(i=0;i<size;++i)
+		OBJ[i].value = i;
 
-	START("arrayblk init");
+	tommy_queue_init(&queue);
+
+	if (tommy_queue_remove(&queue) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	START("queue insert");
+	for(i=0;i<size;++i)
+		tommy_queue_insert(&queue, &OBJ[i].node, &OBJ[i]);
+	STOP();
+
+	START("queue remove");
 	for(i=0;i<size;++i) {
-		tommy_arrayblk_grow(&arrayblk, i + 1);
-		if (tommy_arrayblk_get(&arrayblk, i) != 0)
+		obj = tommy_queue_remove(&queue);
+		if (obj != &OBJ[i])
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 	}
 	STOP();
 
-	START("arrayblk set");
+	if (tommy_queue_remove(&queue) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* insert lists and single elements, and get them back as a list */
+	tommy_list_init(&list);
 	for(i=0;i<size;++i) {
-		tommy_arrayblk_set(&arrayblk, i, (void*)i);
+		if (i % 3 == 2) {
+			tommy_queue_insert_list(&queue, &list);
+			tommy_queue_insert(&queue, &OBJ[i].node, &OBJ[i]);
+		} else {
+			tommy_list_insert_tail(&list, &OBJ[i].node, &OBJ[i]);
+		}
 	}
-	STOP();
+	tommy_queue_insert_list(&queue, &list);
 
-	START("arrayblk get");
-	for(i=0;i<size;++i) {
-		if (tommy_arrayblk_get(&arrayblk, i) != (void*)i)
+	if (!tommy_list_empty(&list))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	if (tommy_queue_remove_list(&queue, &list) != size)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	i = 0;
+	node = tommy_list_head(&list);
+	while (node) {
+		if (node->data != &OBJ[i])
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
+		++i;
+		node = node->next;
 	}
-	STOP();
 
-	if (tommy_arrayblk_memory_usage(&arrayblk) < size * sizeof(void*))
+	if (i != size || tommy_queue_remove_list(&queue, &list) != 0)
 		/* LCOV_EXCL_START */
 		abort();
 		/* LCOV_EXCL_STOP */
 
-	tommy_arrayblk_done(&arrayblk);
-}
+	/* ring */
+	tommy_ring_init(&ring, 0);
 
-void test_arrayblkof(void)
-{
-	tommy_arrayblkof arrayblkof;
-	unsigned i;
-	const unsigned size = 50 * TOMMY_SIZE;
+	if (tommy_ring_memory_usage(&ring) != 2 * sizeof(tommy_ring_cell))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
 
-	tommy_arrayblkof_init(&arrayblkof, sizeof(unsigned));
+	tommy_ring_done(&ring);
 
-	/* no op */
-	tommy_arrayblkof_grow(&arrayblkof, 0);
+	tommy_ring_init(&ring, 1000);
 
-	START("arrayblkof init");
-	for(i=0;i<size;++i) {
-		tommy_arrayblkof_grow(&arrayblkof, i + 1);
-		unsigned* ref = tommy_arrayblkof_ref(&arrayblkof, i);
-		if (*ref != 0)
+	tommy_list_init(&list);
+	if (tommy_ring_remove_list(&ring, &list) != -1 || tommy_ring_insert_list(&ring, &list) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* fill it */
+	for(i=0;i<1024;++i) {
+		if (tommy_ring_insert(&ring, &OBJ[i].node, &OBJ[i]) != 0)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 	}
-	STOP();
 
-	START("arrayblkof set");
-	for(i=0;i<size;++i) {
-		unsigned* ref = tommy_arrayblkof_ref(&arrayblkof, i);
-		*ref = i;
-	}
-	STOP();
+	if (tommy_ring_insert(&ring, &OBJ[i].node, &OBJ[i]) != -1)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
 
-	START("arrayblkof get");
-	for(i=0;i<size;++i) {
-		unsigned* ref = tommy_arrayblkof_ref(&arrayblkof, i);
-		if (*ref != i)
+	START("ring");
+	for(i=1024;i<size;++i) {
+		tommy_list_init(&list);
+		if (tommy_ring_remove_list(&ring, &list) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		if (tommy_list_head(&list)->data != &OBJ[i - 1024])
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		if (tommy_ring_insert(&ring, &OBJ[i].node, &OBJ[i]) != 0)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 	}
 	STOP();
 
-	if (tommy_arrayblkof_memory_usage(&arrayblkof) < size * sizeof(unsigned))
+	/* empty it, collecting all the elements in a single list */
+	tommy_list_init(&list);
+	while (tommy_ring_remove_list(&ring, &list) == 0)
+		;
+
+	if (tommy_list_count(&list) != 1024 || tommy_list_head(&list)->data != &OBJ[size - 1024])
 		/* LCOV_EXCL_START */
 		abort();
 		/* LCOV_EXCL_STOP */
 
-	tommy_arrayblkof_done(&arrayblkof);
+	/* insert a whole list in a single cell */
+	if (tommy_ring_insert_list(&ring, &list) != 0 || !tommy_list_empty(&list))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	if (tommy_ring_remove_list(&ring, &list) != 0 || tommy_list_count(&list) != 1024)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	tommy_ring_done(&ring);
+
+#ifdef USE_PTHREAD
+	START("queue threads");
+	test_queue_thread(OBJ, size);
+	STOP();
+
+	START("ring threads");
+	test_ring_thread(OBJ, size);
+	STOP();
+#endif
+
+	free(OBJ);
 }
 
-void test_hashtable(void)
+void test_tree(void)
 {
-	tommy_hashtable hashtable;
-	struct object_hash* HASH;
-	unsigned i, j, n;
-	unsigned limit;
-	const unsigned size = TOMMY_SIZE;
-	const unsigned module = TOMMY_SIZE / 4;
+	tommy_tree tree;
+	struct object_tree* OBJ;
+	unsigned i;
+	const unsigned size = TOMMY_SIZE / 4;
 
-	HASH = malloc(size * sizeof(struct object_hash));
+	OBJ = malloc(size * sizeof(struct object_tree));
 
+	START("tree");
+	tommy_tree_init(&tree, &compare);
+
+	/* forward order */
 	for(i=0;i<size;++i)
-		HASH[i].value = i % module;
+		OBJ[i].value = i;
 
-	/* initialize a very small hashtable */
-	tommy_hashtable_init(&hashtable, 1);
+	/* insert */
+	for(i=0;i<size;++i)
+		if (tommy_tree_insert(&tree, &OBJ[i].node, &OBJ[i]) != &OBJ[i])
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
 
-	/* check that we allocated space for more elements */
-	if (hashtable.bucket_max == 1)
+	if (tommy_tree_memory_usage(&tree) < size * sizeof(tommy_tree_node))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	if (tommy_tree_count(&tree) != size)
 		/* LCOV_EXCL_START */
 		abort();
 		/* LCOV_EXCL_STOP */
 
-	/* destroy it as empty */
-	tommy_hashtable_done(&hashtable);
+	the_count = 0;
+	tommy_tree_foreach(&tree, count_callback);
+	if (the_count != size)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	the_count = 0;
+	tommy_tree_foreach_arg(&tree, count_arg_callback, &the_count);
+	if (the_count != size)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* search present */
+	for(i=0;i<size/2;++i) {
+		if (tommy_tree_search(&tree, &OBJ[i]) == 0)
+				/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		if (tommy_tree_search_compare(&tree, &compare, &OBJ[i]) == 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+
+	/* insert existing */
+	for(i=0;i<size;++i) {
+		struct object_tree EXTRA;
+		EXTRA.value = i;
+		if (tommy_tree_insert(&tree, &EXTRA.node, &EXTRA) == &EXTRA)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+
+	/* remove existing */
+	for(i=0;i<size/2;++i)
+		tommy_tree_remove_existing(&tree, &OBJ[i].node);
+
+	/* remove missing */
+	for(i=0;i<size/2;++i)
+		if (tommy_tree_remove(&tree, &OBJ[i]) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+	/* search missing */
+	for(i=0;i<size/2;++i) {
+		if (tommy_tree_search(&tree, &OBJ[i]) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		if (tommy_tree_search_compare(&tree, &compare, &OBJ[i]) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+
+	/* remove present */
+	for(i=0;i<size/2;++i)
+		if (tommy_tree_remove(&tree, &OBJ[size/2+i]) == 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+	/* reverse order */
+	for(i=0;i<size;++i)
+		OBJ[i].value = size - i;
+
+	/* insert */
+	for(i=0;i<size;++i)
+		if (tommy_tree_insert(&tree, &OBJ[i].node, &OBJ[i]) != &OBJ[i])
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+	/* remove all */
+	for(i=0;i<size;++i)
+		tommy_tree_remove_existing(&tree, &OBJ[i].node);
+
+	/* random order */
+	for(i=0;i<size;++i)
+		OBJ[i].value = tommy_inthash_u32(i);
+
+	/* insert */
+	for(i=0;i<size;++i)
+		if (tommy_tree_insert(&tree, &OBJ[i].node, &OBJ[i]) != &OBJ[i])
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+	/* remove all */
+	for(i=0;i<size;++i)
+		tommy_tree_remove_existing(&tree, &OBJ[i].node);
+
+	STOP();
+}
+
+void test_array(void)
+{
+	tommy_array array;
+	tommy_uintptr_t i;
+	const unsigned size = 50 * TOMMY_SIZE;
+
+	tommy_array_init(&array);
+
+	/* no op */
+	tommy_array_grow(&array, 0);
+
+	START("array init");
+	for(i=0;i<size;++i) {
+		tommy_array_grow(&array, i + 1);
+		if (tommy_array_get(&array, i) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("array set");
+	for(i=0;i<size;++i) {
+		tommy_array_set(&array, i, (void*)i);
+	}
+	STOP();
+
+	START("array get");
+	for(i=0;i<size;++i) {
+		if (tommy_array_get(&array, i) != (void*)i)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	if (tommy_array_memory_usage(&array) < size * sizeof(void*))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	START("array pop");
+	for(i=0;i<size/2;++i) {
+		if (tommy_array_pop(&array) != (void*)(size - 1 - i))
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("array shrink");
+	{
+		tommy_size_t usage = tommy_array_memory_usage(&array);
+		tommy_array_truncate(&array, size / 8);
+		tommy_array_shrink(&array);
+		if (tommy_array_size(&array) != size / 8 || tommy_array_memory_usage(&array) >= usage)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		tommy_array_grow(&array, size);
+		for(i=size/8;i<size;++i) {
+			if (tommy_array_get(&array, i) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+		tommy_array_truncate(&array, 0);
+		tommy_array_shrink(&array);
+		tommy_array_grow(&array, size);
+		for(i=0;i<size;++i) {
+			if (tommy_array_get(&array, i) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+	}
+	STOP();
+
+	tommy_array_done(&array);
+}
+
+struct span_sum {
+	tommy_size_t count;
+	tommy_uint64_t sum;
+};
+
+void span_sum(void* arg, tommy_size_t pos, void* span, tommy_size_t size)
+{
+	struct span_sum* result = arg;
+	unsigned* element = span;
+	tommy_size_t i;
+
+	for(i=0;i<size;++i) {
+		if (element[i] != pos + i)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		result->sum += element[i];
+	}
+	result->count += size;
+}
+
+void test_span(struct span_sum* result, unsigned size)
+{
+	if (result->count != size || result->sum != (tommy_uint64_t)size * (size - 1) / 2)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+}
+
+void test_arrayof(void)
+{
+	tommy_arrayof arrayof;
+	unsigned i;
+	const unsigned size = 50 * TOMMY_SIZE;
+
+	tommy_arrayof_init(&arrayof, sizeof(unsigned));
+
+	/* no op */
+	tommy_arrayof_grow(&arrayof, 0);
+
+	START("arrayof init");
+	for(i=0;i<size;++i) {
+		tommy_arrayof_grow(&arrayof, i + 1);
+		unsigned* ref = tommy_arrayof_ref(&arrayof, i);
+		if (*ref != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayof set");
+	for(i=0;i<size;++i) {
+		unsigned* ref = tommy_arrayof_ref(&arrayof, i);
+		*ref = i;
+	}
+	STOP();
+
+	START("arrayof get");
+	for(i=0;i<size;++i) {
+		unsigned* ref = tommy_arrayof_ref(&arrayof, i);
+		if (*ref != i)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayof span");
+	{
+		struct span_sum result;
+		tommy_size_t pos, span_size;
+
+		result.count = 0;
+		result.sum = 0;
+		for(pos=0;pos<tommy_arrayof_size(&arrayof);pos+=span_size) {
+			void* span = tommy_arrayof_span(&arrayof, pos, &span_size);
+			span_sum(&result, pos, span, span_size);
+		}
+		test_span(&result, size);
+
+		result.count = 0;
+		result.sum = 0;
+		tommy_arrayof_foreach_parallel(&arrayof, span_sum, &result, parallel_sequential, 0);
+		test_span(&result, size);
+
+		result.count = 0;
+		result.sum = 0;
+		tommy_arrayof_foreach_parallel(&arrayof, span_sum, &result, 0, 0);
+		test_span(&result, size);
+	}
+	STOP();
+
+	if (tommy_arrayof_memory_usage(&arrayof) < size * sizeof(unsigned))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	START("arrayof map");
+	{
+		tommy_arrayof mapped;
+		const char* path = "tommycheck.tmp";
+
+		if (tommy_arrayof_save(&arrayof, path) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* wrong element size */
+		if (tommy_arrayof_map(&mapped, sizeof(tommy_uint64_t), path, TOMMY_MAP_READONLY) == 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		if (tommy_arrayof_map(&mapped, sizeof(unsigned), path, TOMMY_MAP_READONLY) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		if (tommy_arrayof_size(&mapped) != size)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		for(i=0;i<size;++i) {
+			unsigned* ref = tommy_arrayof_ref(&mapped, i);
+			if (*ref != i)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+		tommy_arrayof_done(&mapped);
+
+		/* change and grow a private mapping */
+		if (tommy_arrayof_map(&mapped, sizeof(unsigned), path, TOMMY_MAP_PRIVATE) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		tommy_arrayof_grow(&mapped, 2 * size);
+		for(i=0;i<2*size;++i) {
+			unsigned* ref = tommy_arrayof_ref(&mapped, i);
+			if (*ref != (i < size ? i : 0))
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+			*ref = i + 1;
+		}
+		tommy_arrayof_truncate(&mapped, size / 2);
+		tommy_arrayof_shrink(&mapped);
+		tommy_arrayof_done(&mapped);
+
+		/* the file is not changed */
+		if (tommy_arrayof_map(&mapped, sizeof(unsigned), path, TOMMY_MAP_READONLY) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		for(i=0;i<size;++i) {
+			unsigned* ref = tommy_arrayof_ref(&mapped, i);
+			if (*ref != i)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+		tommy_arrayof_done(&mapped);
+
+		remove(path);
+
+		if (tommy_arrayof_map(&mapped, sizeof(unsigned), path, TOMMY_MAP_READONLY) == 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayof pop");
+	for(i=0;i<size/2;++i) {
+		unsigned value;
+		tommy_arrayof_pop(&arrayof, &value);
+		if (value != size - 1 - i)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	tommy_arrayof_pop(&arrayof, 0);
+	STOP();
+
+	START("arrayof shrink");
+	{
+		tommy_size_t usage = tommy_arrayof_memory_usage(&arrayof);
+		tommy_arrayof_truncate(&arrayof, size / 8);
+		tommy_arrayof_shrink(&arrayof);
+		if (tommy_arrayof_size(&arrayof) != size / 8 || tommy_arrayof_memory_usage(&arrayof) >= usage)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		tommy_arrayof_grow(&arrayof, size);
+		for(i=size/8;i<size;++i) {
+			unsigned* ref = tommy_arrayof_ref(&arrayof, i);
+			if (*ref != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+		tommy_arrayof_truncate(&arrayof, 0);
+		tommy_arrayof_shrink(&arrayof);
+		tommy_arrayof_grow(&arrayof, size);
+		for(i=0;i<size;++i) {
+			unsigned* ref = tommy_arrayof_ref(&arrayof, i);
+			if (*ref != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+	}
+	STOP();
+
+	tommy_arrayof_done(&arrayof);
+}
+
+void test_arrayblk(void)
+{
+	tommy_arrayblk arrayblk;
+	tommy_uintptr_t i;
+	const unsigned size = 50 * TOMMY_SIZE;
+
+	tommy_arrayblk_init(&arrayblk);
+
+	/* no op */
+	tommy_arrayblk_grow(&arrayblk, 0);
+
+	START("arrayblk init");
+	for(i=0;i<size;++i) {
+		tommy_arrayblk_grow(&arrayblk, i + 1);
+		if (tommy_arrayblk_get(&arrayblk, i) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayblk set");
+	for(i=0;i<size;++i) {
+		tommy_arrayblk_set(&arrayblk, i, (void*)i);
+	}
+	STOP();
+
+	START("arrayblk get");
+	for(i=0;i<size;++i) {
+		if (tommy_arrayblk_get(&arrayblk, i) != (void*)i)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	if (tommy_arrayblk_memory_usage(&arrayblk) < size * sizeof(void*))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	START("arrayblk snapshot");
+	{
+		tommy_arrayblk_snapshot snapshot;
+		tommy_arrayblk_snapshot other;
+
+		tommy_arrayblk_snapshot_init(&snapshot, &arrayblk);
+
+		/* change only the first half */
+		for(i=0;i<size/2;++i) {
+			tommy_arrayblk_set(&arrayblk, i, (void*)(i + 1));
+		}
+
+		tommy_arrayblk_snapshot_init(&other, &arrayblk);
+
+		/* change all */
+		for(i=0;i<size;++i) {
+			tommy_arrayblk_set(&arrayblk, i, (void*)(i + 2));
+		}
+
+		if (tommy_arrayblk_snapshot_size(&snapshot) != size || tommy_arrayblk_snapshot_memory_usage(&snapshot) == 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		for(i=0;i<size;++i) {
+			if (tommy_arrayblk_snapshot_get(&snapshot, i) != (void*)i)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+			if (tommy_arrayblk_snapshot_get(&other, i) != (void*)(i < size / 2 ? i + 1 : i))
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+
+		tommy_arrayblk_snapshot_done(&snapshot);
+
+		/* the snapshot survives the changes of size */
+		tommy_arrayblk_truncate(&arrayblk, size / 2);
+		tommy_arrayblk_shrink(&arrayblk);
+		tommy_arrayblk_grow(&arrayblk, size);
+
+		for(i=0;i<size;++i) {
+			if (tommy_arrayblk_snapshot_get(&other, i) != (void*)(i < size / 2 ? i + 1 : i))
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+			if (tommy_arrayblk_get(&arrayblk, i) != (void*)(i < size / 2 ? i + 2 : 0))
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+
+		tommy_arrayblk_snapshot_done(&other);
+
+		for(i=0;i<size;++i) {
+			tommy_arrayblk_set(&arrayblk, i, (void*)i);
+		}
+
+		/* with all the snapshots released, the blocks are no longer checked */
+		if (arrayblk.live != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayblk pop");
+	for(i=0;i<size/2;++i) {
+		if (tommy_arrayblk_pop(&arrayblk) != (void*)(size - 1 - i))
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayblk shrink");
+	{
+		tommy_size_t usage = tommy_arrayblk_memory_usage(&arrayblk);
+		tommy_arrayblk_truncate(&arrayblk, size / 8 + 1);
+		tommy_arrayblk_shrink(&arrayblk);
+		if (tommy_arrayblk_size(&arrayblk) != size / 8 + 1 || tommy_arrayblk_memory_usage(&arrayblk) >= usage)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		tommy_arrayblk_grow(&arrayblk, size);
+		for(i=size/8+1;i<size;++i) {
+			if (tommy_arrayblk_get(&arrayblk, i) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+		tommy_arrayblk_truncate(&arrayblk, 0);
+		tommy_arrayblk_shrink(&arrayblk);
+		tommy_arrayblk_grow(&arrayblk, size);
+		for(i=0;i<size;++i) {
+			if (tommy_arrayblk_get(&arrayblk, i) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+	}
+	STOP();
+
+	tommy_arrayblk_done(&arrayblk);
+}
+
+void test_arrayblkof(void)
+{
+	tommy_arrayblkof arrayblkof;
+	unsigned i;
+	const unsigned size = 50 * TOMMY_SIZE;
+
+	tommy_arrayblkof_init(&arrayblkof, sizeof(unsigned));
+
+	/* no op */
+	tommy_arrayblkof_grow(&arrayblkof, 0);
+
+	START("arrayblkof init");
+	for(i=0;i<size;++i) {
+		tommy_arrayblkof_grow(&arrayblkof, i + 1);
+		unsigned* ref = tommy_arrayblkof_ref(&arrayblkof, i);
+		if (*ref != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayblkof set");
+	for(i=0;i<size;++i) {
+		unsigned* ref = tommy_arrayblkof_ref(&arrayblkof, i);
+		*ref = i;
+	}
+	STOP();
+
+	START("arrayblkof get");
+	for(i=0;i<size;++i) {
+		unsigned* ref = tommy_arrayblkof_ref(&arrayblkof, i);
+		if (*ref != i)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayblkof span");
+	{
+		struct span_sum result;
+		tommy_size_t pos, span_size;
+
+		result.count = 0;
+		result.sum = 0;
+		for(pos=0;pos<tommy_arrayblkof_size(&arrayblkof);pos+=span_size) {
+			void* span = tommy_arrayblkof_span(&arrayblkof, pos, &span_size);
+			span_sum(&result, pos, span, span_size);
+		}
+		test_span(&result, size);
+
+		result.count = 0;
+		result.sum = 0;
+		tommy_arrayblkof_foreach_parallel(&arrayblkof, span_sum, &result, parallel_sequential, 0);
+		test_span(&result, size);
+
+		result.count = 0;
+		result.sum = 0;
+		tommy_arrayblkof_foreach_parallel(&arrayblkof, span_sum, &result, 0, 0);
+		test_span(&result, size);
+	}
+	STOP();
+
+	if (tommy_arrayblkof_memory_usage(&arrayblkof) < size * sizeof(unsigned))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	START("arrayblkof map");
+	{
+		tommy_arrayblkof mapped;
+		const char* path = "tommycheck.tmp";
+
+		if (tommy_arrayblkof_save(&arrayblkof, path) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* wrong element size */
+		if (tommy_arrayblkof_map(&mapped, sizeof(tommy_uint64_t), path, TOMMY_MAP_READONLY) == 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		if (tommy_arrayblkof_map(&mapped, sizeof(unsigned), path, TOMMY_MAP_READONLY) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		if (tommy_arrayblkof_size(&mapped) != size)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		for(i=0;i<size;++i) {
+			unsigned* ref = tommy_arrayblkof_ref(&mapped, i);
+			if (*ref != i)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+		tommy_arrayblkof_done(&mapped);
+
+		/* change and grow a private mapping */
+		if (tommy_arrayblkof_map(&mapped, sizeof(unsigned), path, TOMMY_MAP_PRIVATE) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		tommy_arrayblkof_grow(&mapped, 2 * size);
+		for(i=0;i<2*size;++i) {
+			unsigned* ref = tommy_arrayblkof_ref(&mapped, i);
+			if (*ref != (i < size ? i : 0))
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+			*ref = i + 1;
+		}
+		tommy_arrayblkof_truncate(&mapped, size / 2);
+		tommy_arrayblkof_shrink(&mapped);
+		tommy_arrayblkof_done(&mapped);
+
+		/* the file is not changed */
+		if (tommy_arrayblkof_map(&mapped, sizeof(unsigned), path, TOMMY_MAP_READONLY) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		for(i=0;i<size;++i) {
+			unsigned* ref = tommy_arrayblkof_ref(&mapped, i);
+			if (*ref != i)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+		tommy_arrayblkof_done(&mapped);
+
+		remove(path);
+
+		if (tommy_arrayblkof_map(&mapped, sizeof(unsigned), path, TOMMY_MAP_READONLY) == 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayblkof pop");
+	for(i=0;i<size/2;++i) {
+		unsigned value;
+		tommy_arrayblkof_pop(&arrayblkof, &value);
+		if (value != size - 1 - i)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	tommy_arrayblkof_pop(&arrayblkof, 0);
+	STOP();
+
+	START("arrayblkof shrink");
+	{
+		tommy_size_t usage = tommy_arrayblkof_memory_usage(&arrayblkof);
+		tommy_arrayblkof_truncate(&arrayblkof, size / 8 + 1);
+		tommy_arrayblkof_shrink(&arrayblkof);
+		if (tommy_arrayblkof_size(&arrayblkof) != size / 8 + 1 || tommy_arrayblkof_memory_usage(&arrayblkof) >= usage)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		tommy_arrayblkof_grow(&arrayblkof, size);
+		for(i=size/8+1;i<size;++i) {
+			unsigned* ref = tommy_arrayblkof_ref(&arrayblkof, i);
+			if (*ref != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+		tommy_arrayblkof_truncate(&arrayblkof, 0);
+		tommy_arrayblkof_shrink(&arrayblkof);
+		tommy_arrayblkof_grow(&arrayblkof, size);
+		for(i=0;i<size;++i) {
+			unsigned* ref = tommy_arrayblkof_ref(&arrayblkof, i);
+			if (*ref != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+	}
+	STOP();
+
+	tommy_arrayblkof_done(&arrayblkof);
+}
+
+void test_arrayvm(void)
+{
+	tommy_arrayvm arrayvm;
+	tommy_uintptr_t i;
+	const unsigned size = 50 * TOMMY_SIZE;
+
+	if (tommy_arrayvm_init(&arrayvm, size) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* a size in bytes that overflows */
+	if (tommy_arrayvm_init(&arrayvm, (tommy_size_t)-1) == 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+	if (tommy_arrayvm_init(&arrayvm, (tommy_size_t)-1 / sizeof(void*) + 1) == 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* no op */
+	tommy_arrayvm_grow(&arrayvm, 0);
+
+	START("arrayvm init");
+	for(i=0;i<size;++i) {
+		tommy_arrayvm_grow(&arrayvm, i + 1);
+		if (tommy_arrayvm_get(&arrayvm, i) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayvm set");
+	for(i=0;i<size;++i) {
+		tommy_arrayvm_set(&arrayvm, i, (void*)i);
+	}
+	STOP();
+
+	START("arrayvm get");
+	for(i=0;i<size;++i) {
+		if (tommy_arrayvm_get(&arrayvm, i) != (void*)i)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	if (tommy_arrayvm_memory_usage(&arrayvm) < size * sizeof(void*))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	START("arrayvm pop");
+	for(i=0;i<size/2;++i) {
+		if (tommy_arrayvm_pop(&arrayvm) != (void*)(size - 1 - i))
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("arrayvm shrink");
+	{
+		tommy_size_t usage = tommy_arrayvm_memory_usage(&arrayvm);
+		tommy_arrayvm_truncate(&arrayvm, size / 8);
+		tommy_arrayvm_shrink(&arrayvm);
+		if (tommy_arrayvm_size(&arrayvm) != size / 8 || tommy_arrayvm_memory_usage(&arrayvm) >= usage)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+		tommy_arrayvm_grow(&arrayvm, size);
+		for(i=size/8;i<size;++i) {
+			if (tommy_arrayvm_get(&arrayvm, i) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+		for(i=0;i<size;++i) {
+			tommy_arrayvm_set(&arrayvm, i, (void*)i);
+		}
+		tommy_arrayvm_truncate(&arrayvm, 0);
+		tommy_arrayvm_shrink(&arrayvm);
+		tommy_arrayvm_grow(&arrayvm, size);
+		for(i=0;i<size;++i) {
+			if (tommy_arrayvm_get(&arrayvm, i) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+	}
+	STOP();
+
+	START("arrayvm truncate");
+	{
+		/* truncate at a position not aligned to the pages, without shrinking */
+		for(i=0;i<size;++i)
+			tommy_arrayvm_set(&arrayvm, i, (void*)(i + 1));
+		tommy_arrayvm_truncate(&arrayvm, size / 8 + 3);
+		tommy_arrayvm_grow(&arrayvm, size);
+		for(i=0;i<size;++i) {
+			if (tommy_arrayvm_get(&arrayvm, i) != (i < size / 8 + 3 ? (void*)(i + 1) : 0))
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+		}
+
+#if TOMMY_SIZE_BIT == 64 && (defined(__unix__) || defined(__APPLE__) || defined(_WIN32))
+		/* a large reservation, that is committed only in the pages touched */
+		{
+			tommy_arrayvm large;
+			const tommy_size_t large_size = (tommy_size_t)1 << 28;
+
+			if (tommy_arrayvm_init(&large, large_size) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+			tommy_arrayvm_grow(&large, large_size);
+			tommy_arrayvm_set(&large, large_size - 1, &large);
+			tommy_arrayvm_truncate(&large, 0);
+			tommy_arrayvm_grow(&large, large_size);
+			if (tommy_arrayvm_get(&large, large_size - 1) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+			tommy_arrayvm_done(&large);
+		}
+#endif
+	}
+	STOP();
+
+	tommy_arrayvm_done(&arrayvm);
+}
+
+void test_hashtable(void)
+{
+	tommy_hashtable hashtable;
+	struct object_hash* HASH;
+	unsigned i, j, n;
+	unsigned limit;
+	const unsigned size = TOMMY_SIZE;
+	const unsigned module = TOMMY_SIZE / 4;
+
+	HASH = malloc(size * sizeof(struct object_hash));
+
+	for(i=0;i<size;++i)
+		HASH[i].value = i % module;
+
+	/* initialize a very small hashtable */
+	tommy_hashtable_init(&hashtable, 1);
+
+	/* check that we allocated space for more elements */
+	if (hashtable.bucket_max == 1)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* destroy it as empty */
+	tommy_hashtable_done(&hashtable);
+
+	START("hashtable stack");
+	limit = 5 * isqrt(size);
+	for(n=0;n<=limit;++n) {
+		/* last iteration is full size */
+		if (n == limit)
+			n = limit = size;
+
+		tommy_hashtable_init(&hashtable, limit / 2);
+
+		/* insert */
+		for(i=0;i<n;++i)
+			tommy_hashtable_insert(&hashtable, &HASH[i].node, &HASH[i], HASH[i].value);
+
+		if (tommy_hashtable_memory_usage(&hashtable) < n * sizeof(void*))
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		if (tommy_hashtable_count(&hashtable) != n)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		the_count = 0;
+		tommy_hashtable_foreach(&hashtable, count_callback);
+		if (the_count != n)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* remove in backward order */
+		for(i=0;i<n/2;++i)
+			tommy_hashtable_remove_existing(&hashtable, &HASH[n-i-1].node);
+
+		/* remove missing */
+		for(i=0;i<n/2;++i)
+			if (tommy_hashtable_remove(&hashtable, search_callback, &HASH[n-i-1], HASH[n-i-1].value) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		/* remove search */
+		for(i=0;i<n/2;++i)
+			if (tommy_hashtable_remove(&hashtable, search_callback, &HASH[n/2-i-1], HASH[n/2-i-1].value) == 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		tommy_hashtable_done(&hashtable);
+	}
+	STOP();
+
+	START("hashtable queue");
+	limit = isqrt(size) / 16;
+	for(n=0;n<=limit;++n) {
+		/* last iteration is full size */
+		if (n == limit)
+			n = limit = size;
+
+		tommy_hashtable_init(&hashtable, limit / 2);
+
+		/* insert first run */
+		for(j=0,i=0;i<n;++i)
+			tommy_hashtable_insert(&hashtable, &HASH[i].node, &HASH[i], HASH[i].value);
+
+		the_count = 0;
+		tommy_hashtable_foreach_arg(&hashtable, count_arg_callback, &the_count);
+		if (the_count != n)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* insert all the others */
+		for(;i<size;++i,++j) {
+			/* insert one */
+			tommy_hashtable_insert(&hashtable, &HASH[i].node, &HASH[i], HASH[i].value);
+
+			/* remove one */
+			tommy_hashtable_remove_existing(&hashtable, &HASH[j].node);
+		}
+
+		for(;j<size;++j)
+			if (tommy_hashtable_remove(&hashtable, search_callback, &HASH[j], HASH[j].value) == 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		tommy_hashtable_done(&hashtable);
+	}
+	STOP();
+}
+
+void test_hashdyn(void)
+{
+	tommy_hashdyn hashdyn;
+	struct object_hash* HASH;
+	unsigned i, j, n;
+	unsigned limit;
+	const unsigned size = TOMMY_SIZE;
+	const unsigned module = TOMMY_SIZE / 4;
+
+	HASH = malloc(size * sizeof(struct object_hash));
+
+	for(i=0;i<size;++i)
+		HASH[i].value = i % module;
+
+	START("hashdyn stack");
+	limit = 5 * isqrt(size);
+	for(n=0;n<=limit;++n) {
+		/* last iteration is full size */
+		if (n == limit)
+			n = limit = size;
+
+		tommy_hashdyn_init(&hashdyn);
+
+		/* insert */
+		for(i=0;i<n;++i)
+			tommy_hashdyn_insert(&hashdyn, &HASH[i].node, &HASH[i], HASH[i].value);
+
+		if (tommy_hashdyn_memory_usage(&hashdyn) < n * sizeof(void*))
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		if (tommy_hashdyn_count(&hashdyn) != n)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		the_count = 0;
+		tommy_hashdyn_foreach(&hashdyn, count_callback);
+		if (the_count != n)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* remove in backward order */
+		for(i=0;i<n/2;++i)
+			tommy_hashdyn_remove_existing(&hashdyn, &HASH[n-i-1].node);
+
+		/* remove missing */
+		for(i=0;i<n/2;++i)
+			if (tommy_hashdyn_remove(&hashdyn, search_callback, &HASH[n-i-1], HASH[n-i-1].value) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		/* remove search */
+		for(i=0;i<n/2;++i)
+			if (tommy_hashdyn_remove(&hashdyn, search_callback, &HASH[n/2-i-1], HASH[n/2-i-1].value) == 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		tommy_hashdyn_done(&hashdyn);
+	}
+	STOP();
+
+	START("hashdyn queue");
+	limit = isqrt(size) / 16;
+	for(n=0;n<=limit;++n) {
+		/* last iteration is full size */
+		if (n == limit)
+			n = limit = size;
+
+		tommy_hashdyn_init(&hashdyn);
+
+		/* insert first run */
+		for(j=0,i=0;i<n;++i)
+			tommy_hashdyn_insert(&hashdyn, &HASH[i].node, &HASH[i], HASH[i].value);
+
+		the_count = 0;
+		tommy_hashdyn_foreach_arg(&hashdyn, count_arg_callback, &the_count);
+		if (the_count != n)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* insert all the others */
+		for(;i<size;++i,++j) {
+			/* insert one */
+			tommy_hashdyn_insert(&hashdyn, &HASH[i].node, &HASH[i], HASH[i].value);
+
+			/* remove one */
+			tommy_hashdyn_remove_existing(&hashdyn, &HASH[j].node);
+		}
+
+		for(;j<size;++j)
+			if (tommy_hashdyn_remove(&hashdyn, search_callback, &HASH[j], HASH[j].value) == 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		tommy_hashdyn_done(&hashdyn);
+	}
+	STOP();
+
+	START("hashdyn load");
+	{
+		const char* path = "tommycheck.tmp";
+
+		tommy_hashdyn_init(&hashdyn);
+		for(i=0;i<size;++i)
+			tommy_hashdyn_insert(&hashdyn, &HASH[i].node, &HASH[i], HASH[i].value);
+
+		if (tommy_hashdyn_save(&hashdyn, path, save_callback, HASH) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* deinitialize without removing elements, the nodes are reused */
+		tommy_hashdyn_done(&hashdyn);
+
+		if (tommy_hashdyn_load(&hashdyn, path, load_callback, HASH) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		remove(path);
+
+		if (tommy_hashdyn_count(&hashdyn) != size)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		for(i=0;i<size;++i)
+			if (tommy_hashdyn_search(&hashdyn, search_callback, &HASH[i], HASH[i].value) != &HASH[i])
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		/* it continues to work normally */
+		for(i=0;i<size;++i)
+			if (tommy_hashdyn_remove(&hashdyn, search_callback, &HASH[i], HASH[i].value) == 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		tommy_hashdyn_done(&hashdyn);
+
+		if (tommy_hashdyn_load(&hashdyn, path, load_callback, HASH) == 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+}
+
+void test_hashlin(void)
+{
+	tommy_hashlin hashlin;
+	struct object_hash* HASH;
+	unsigned i, j, n;
+	unsigned limit;
+	const unsigned size = TOMMY_SIZE;
+	const unsigned module = TOMMY_SIZE / 4;
+	tommy_hashlin_node* bucket;
+
+	HASH = malloc(size * sizeof(struct object_hash));
+
+	for(i=0;i<size;++i)
+		HASH[i].value = i % module;
+
+	tommy_hashlin_init(&hashlin);
+
+	/* insert */
+	for(i=0;i<size;++i)
+		tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+
+	/* get the bucket of the last element */
+	bucket = tommy_hashlin_bucket(&hashlin, module - 1);
+	if (bucket == 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* deinitialize without removing elements to force deallocation */
+	tommy_hashlin_done(&hashlin);
+
+	START("hashlin stack");
+	limit = 5 * isqrt(size);
+	for(n=0;n<=limit;++n) {
+		/* last iteration is full size */
+		if (n == limit)
+			n = limit = size;
+
+		tommy_hashlin_init(&hashlin);
+
+		/* insert */
+		for(i=0;i<n;++i)
+			tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+
+		if (tommy_hashlin_memory_usage(&hashlin) < n * sizeof(void*))
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		if (tommy_hashlin_count(&hashlin) != n)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		the_count = 0;
+		tommy_hashlin_foreach(&hashlin, count_callback);
+		if (the_count != n)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* remove in backward order */
+		for(i=0;i<n/2;++i)
+			tommy_hashlin_remove_existing(&hashlin, &HASH[n-i-1].node);
+
+		/* remove missing */
+		for(i=0;i<n/2;++i)
+			if (tommy_hashlin_remove(&hashlin, search_callback, &HASH[n-i-1], HASH[n-i-1].value) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		/* remove search */
+		for(i=0;i<n/2;++i)
+			if (tommy_hashlin_remove(&hashlin, search_callback, &HASH[n/2-i-1], HASH[n/2-i-1].value) == 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		tommy_hashlin_done(&hashlin);
+	}
+	STOP();
+
+	START("hashlin queue");
+	limit = isqrt(size) / 16;
+	for(n=0;n<=limit;++n) {
+		/* last iteration is full size */
+		if (n == limit)
+			n = limit = size;
+
+		tommy_hashlin_init(&hashlin);
+
+		/* insert first run */
+		for(j=0,i=0;i<n;++i)
+			tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+
+		the_count = 0;
+		tommy_hashlin_foreach_arg(&hashlin, count_arg_callback, &the_count);
+		if (the_count != n)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* insert all the others */
+		for(;i<size;++i,++j) {
+			/* insert one */
+			tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+
+			/* remove one */
+			tommy_hashlin_remove_existing(&hashlin, &HASH[j].node);
+		}
+
+		for(;j<size;++j)
+			if (tommy_hashlin_remove(&hashlin, search_callback, &HASH[j], HASH[j].value) == 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		tommy_hashlin_done(&hashlin);
+	}
+	STOP();
+
+	START("hashlin load");
+	{
+		const char* path = "tommycheck.tmp";
+
+		tommy_hashlin_init(&hashlin);
+		for(i=0;i<size;++i)
+			tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+
+		if (tommy_hashlin_save(&hashlin, path, save_callback, HASH) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* deinitialize without removing elements, the nodes are reused */
+		tommy_hashlin_done(&hashlin);
+
+		if (tommy_hashlin_load(&hashlin, path, load_callback, HASH) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		remove(path);
+
+		if (tommy_hashlin_count(&hashlin) != size)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		for(i=0;i<size;++i)
+			if (tommy_hashlin_search(&hashlin, search_callback, &HASH[i], HASH[i].value) != &HASH[i])
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		/* it continues to work normally */
+		for(i=0;i<size;++i)
+			if (tommy_hashlin_remove(&hashlin, search_callback, &HASH[i], HASH[i].value) == 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		tommy_hashlin_done(&hashlin);
+
+		if (tommy_hashlin_load(&hashlin, path, load_callback, HASH) == 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+	}
+	STOP();
+
+	START("hashlin stats");
+	{
+		tommy_stats stats;
+
+		tommy_hashlin_init(&hashlin);
+		for(i=0;i<size;++i)
+			tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+
+		/* search present */
+		for(i=0;i<size;++i)
+			if (tommy_hashlin_search(&hashlin, search_callback, &HASH[i], HASH[i].value) != &HASH[i])
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		/* search missing */
+		for(i=0;i<module;++i)
+			if (tommy_hashlin_search(&hashlin, search_callback, &hashlin, i) != 0)
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
+		for(i=0;i<size;++i)
+			tommy_hashlin_remove_existing(&hashlin, &HASH[i].node);
+
+		tommy_hashlin_stats(&hashlin, &stats);
+
+#ifdef TOMMY_STATS
+		if (stats.search != size + module || stats.hit != size || stats.miss != module)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		/* each missing search visits all the 4 elements with the same hash */
+		if (stats.visit < size + 4 * module || stats.chain_max < 4)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+		if (stats.grow == 0 || stats.shrink == 0 || stats.rehash == 0 || stats.segment < 2)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+#else
+		if (stats.search != 0 || stats.hit != 0 || stats.grow != 0 || stats.segment != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+#endif
+
+		tommy_hashlin_done(&hashlin);
+	}
+	STOP();
+
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+	START("hashlin fingerprint");
+	{
+		tommy_size_t filter;
+		tommy_size_t k;
+
+		/* hashes in the same bucket of a table of 2^26 buckets, with only the upper bits of 32 different */
+		filter = 0;
+		for (k = 0; k < 64; ++k)
+			filter |= tommy_hashlin_fingerprint((k << 26) | 0x1234567);
+		if (tommy_popcount(filter) < TOMMY_SIZE_BIT / 2)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+#if TOMMY_SIZE_BIT == 64
+		/* hashes in the same bucket of a table of 2^30 buckets, with only the bits over 30 different */
+		filter = 0;
+		for (k = 0; k < 256; ++k)
+			filter |= tommy_hashlin_fingerprint((k << 30) | 0x1234567);
+		if (tommy_popcount(filter) < TOMMY_SIZE_BIT / 2)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+#endif
+	}
+	STOP();
+#endif
+}
+
+int compare_hashc(const void* arg, const void* obj)
+{
+	return *(const int*)arg != ((const struct object_hashc*)obj)->value;
+}
+
+void test_hashdync(void)
+{
+	tommy_hashdync hashdync;
+	struct object_hashc* HASH;
+	unsigned i, j, n;
+	unsigned limit;
+	const unsigned size = TOMMY_SIZE;
+	const unsigned module = TOMMY_SIZE / 4;
+
+	HASH = malloc(size * sizeof(struct object_hashc));
 
-	START("hashtable stack");
+	for(i=0;i<size;++i)
+		HASH[i].value = i % module;
+
+	START("hashdync stack");
 	limit = 5 * isqrt(size);
 	for(n=0;n<=limit;++n) {
 		/* last iteration is full size */
 		if (n == limit)
 			n = limit = size;
 
-		tommy_hashtable_init(&hashtable, limit / 2);
+		tommy_hashdync_init(&hashdync, offsetof(struct object_hashc, node));
 
 		/* insert */
 		for(i=0;i<n;++i)
-			tommy_hashtable_insert(&hashtable, &HASH[i].node, &HASH[i], HASH[i].value);
+			tommy_hashdync_insert(&hashdync, &HASH[i].node, HASH[i].value);
 
-		if (tommy_hashtable_memory_usage(&hashtable) < n * sizeof(void*))
+		if (tommy_hashdync_memory_usage(&hashdync) < n * sizeof(tommy_cnode))
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 
-		if (tommy_hashtable_count(&hashtable) != n)
+		if (tommy_hashdync_count(&hashdync) != n)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 
 		the_count = 0;
-		tommy_hashtable_foreach(&hashtable, count_callback);
+		tommy_hashdync_foreach(&hashdync, count_callback);
 		if (the_count != n)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 
+		/* search */
+		for(i=0;i<n;++i)
+			if (tommy_hashdync_search(&hashdync, search_callback, &HASH[i], HASH[i].value) != &HASH[i])
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
 		/* remove in backward order */
 		for(i=0;i<n/2;++i)
-			tommy_hashtable_remove_existing(&hashtable, &HASH[n-i-1].node);
+			if (tommy_hashdync_remove_existing(&hashdync, &HASH[n-i-1].node) != &HASH[n-i-1])
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
 
 		/* remove missing */
 		for(i=0;i<n/2;++i)
-			if (tommy_hashtable_remove(&hashtable, search_callback, &HASH[n-i-1], HASH[n-i-1].value) != 0)
+			if (tommy_hashdync_remove(&hashdync, search_callback, &HASH[n-i-1], HASH[n-i-1].value) != 0)
 				/* LCOV_EXCL_START */
 				abort();
 				/* LCOV_EXCL_STOP */
 
 		/* remove search */
 		for(i=0;i<n/2;++i)
-			if (tommy_hashtable_remove(&hashtable, search_callback, &HASH[n/2-i-1], HASH[n/2-i-1].value) == 0)
+			if (tommy_hashdync_remove(&hashdync, search_callback, &HASH[n/2-i-1], HASH[n/2-i-1].value) != &HASH[n/2-i-1])
 				/* LCOV_EXCL_START */
 				abort();
 				/* LCOV_EXCL_STOP */
 
-		tommy_hashtable_done(&hashtable);
+		tommy_hashdync_done(&hashdync);
 	}
 	STOP();
 
-	START("hashtable queue");
+	START("hashdync queue");
 	limit = isqrt(size) / 16;
 	for(n=0;n<=limit;++n) {
 		/* last iteration is full size */
 		if (n == limit)
 			n = limit = size;
 
-		tommy_hashtable_init(&hashtable, limit / 2);
+		tommy_hashdync_init(&hashdync, offsetof(struct object_hashc, node));
 
 		/* insert first run */
 		for(j=0,i=0;i<n;++i)
-			tommy_hashtable_insert(&hashtable, &HASH[i].node, &HASH[i], HASH[i].value);
+			tommy_hashdync_insert(&hashdync, &HASH[i].node, HASH[i].value);
 
 		the_count = 0;
-		tommy_hashtable_foreach_arg(&hashtable, count_arg_callback, &the_count);
+		tommy_hashdync_foreach_arg(&hashdync, count_arg_callback, &the_count);
 		if (the_count != n)
 			/* LCOV_EXCL_START */
 			abort();
@@ -1265,104 +3076,132 @@ void test_hashtable(void)
 		/* insert all the others */
 		for(;i<size;++i,++j) {
 			/* insert one */
-			tommy_hashtable_insert(&hashtable, &HASH[i].node, &HASH[i], HASH[i].value);
+			tommy_hashdync_insert(&hashdync, &HASH[i].node, HASH[i].value);
 
 			/* remove one */
-			tommy_hashtable_remove_existing(&hashtable, &HASH[j].node);
+			tommy_hashdync_remove_existing(&hashdync, &HASH[j].node);
 		}
 
 		for(;j<size;++j)
-			if (tommy_hashtable_remove(&hashtable, search_callback, &HASH[j], HASH[j].value) == 0)
+			if (tommy_hashdync_remove(&hashdync, search_callback, &HASH[j], HASH[j].value) == 0)
 				/* LCOV_EXCL_START */
 				abort();
 				/* LCOV_EXCL_STOP */
 
-		tommy_hashtable_done(&hashtable);
+		tommy_hashdync_done(&hashdync);
 	}
 	STOP();
+
+	START("hashdync order");
+	tommy_hashdync_init(&hashdync, offsetof(struct object_hashc, node));
+
+	/* all equal values, the last inserted is found first */
+	for(i=0;i<size;i+=module)
+		tommy_hashdync_insert(&hashdync, &HASH[i].node, HASH[i].value);
+
+	for(i=0;i<size;i+=module)
+		if (tommy_hashdync_remove(&hashdync, compare_hashc, &HASH[i].value, HASH[i].value) != &HASH[size - module - i])
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+	tommy_hashdync_done(&hashdync);
+	STOP();
+
+	free(HASH);
 }
 
-void test_hashdyn(void)
+void test_hashlinc(void)
 {
-	tommy_hashdyn hashdyn;
-	struct object_hash* HASH;
+	tommy_hashlinc hashlinc;
+	struct object_hashc* HASH;
 	unsigned i, j, n;
 	unsigned limit;
 	const unsigned size = TOMMY_SIZE;
 	const unsigned module = TOMMY_SIZE / 4;
 
-	HASH = malloc(size * sizeof(struct object_hash));
+	HASH = malloc(size * sizeof(struct object_hashc));
 
 	for(i=0;i<size;++i)
 		HASH[i].value = i % module;
 
-	START("hashdyn stack");
+	START("hashlinc stack");
 	limit = 5 * isqrt(size);
 	for(n=0;n<=limit;++n) {
 		/* last iteration is full size */
 		if (n == limit)
 			n = limit = size;
 
-		tommy_hashdyn_init(&hashdyn);
+		tommy_hashlinc_init(&hashlinc, offsetof(struct object_hashc, node));
 
 		/* insert */
 		for(i=0;i<n;++i)
-			tommy_hashdyn_insert(&hashdyn, &HASH[i].node, &HASH[i], HASH[i].value);
+			tommy_hashlinc_insert(&hashlinc, &HASH[i].node, HASH[i].value);
 
-		if (tommy_hashdyn_memory_usage(&hashdyn) < n * sizeof(void*))
+		if (tommy_hashlinc_memory_usage(&hashlinc) < n * sizeof(tommy_cnode))
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 
-		if (tommy_hashdyn_count(&hashdyn) != n)
+		if (tommy_hashlinc_count(&hashlinc) != n)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 
 		the_count = 0;
-		tommy_hashdyn_foreach(&hashdyn, count_callback);
+		tommy_hashlinc_foreach(&hashlinc, count_callback);
 		if (the_count != n)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 
+		/* search */
+		for(i=0;i<n;++i)
+			if (tommy_hashlinc_search(&hashlinc, search_callback, &HASH[i], HASH[i].value) != &HASH[i])
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
+
 		/* remove in backward order */
 		for(i=0;i<n/2;++i)
-			tommy_hashdyn_remove_existing(&hashdyn, &HASH[n-i-1].node);
+			if (tommy_hashlinc_remove_existing(&hashlinc, &HASH[n-i-1].node) != &HASH[n-i-1])
+				/* LCOV_EXCL_START */
+				abort();
+				/* LCOV_EXCL_STOP */
 
 		/* remove missing */
 		for(i=0;i<n/2;++i)
-			if (tommy_hashdyn_remove(&hashdyn, search_callback, &HASH[n-i-1], HASH[n-i-1].value) != 0)
+			if (tommy_hashlinc_remove(&hashlinc, search_callback, &HASH[n-i-1], HASH[n-i-1].value) != 0)
 				/* LCOV_EXCL_START */
 				abort();
 				/* LCOV_EXCL_STOP */
 
 		/* remove search */
 		for(i=0;i<n/2;++i)
-			if (tommy_hashdyn_remove(&hashdyn, search_callback, &HASH[n/2-i-1], HASH[n/2-i-1].value) == 0)
+			if (tommy_hashlinc_remove(&hashlinc, search_callback, &HASH[n/2-i-1], HASH[n/2-i-1].value) != &HASH[n/2-i-1])
 				/* LCOV_EXCL_START */
 				abort();
 				/* LCOV_EXCL_STOP */
 
-		tommy_hashdyn_done(&hashdyn);
+		tommy_hashlinc_done(&hashlinc);
 	}
 	STOP();
 
-	START("hashdyn queue");
+	START("hashlinc queue");
 	limit = isqrt(size) / 16;
 	for(n=0;n<=limit;++n) {
 		/* last iteration is full size */
 		if (n == limit)
 			n = limit = size;
 
-		tommy_hashdyn_init(&hashdyn);
+		tommy_hashlinc_init(&hashlinc, offsetof(struct object_hashc, node));
 
 		/* insert first run */
 		for(j=0,i=0;i<n;++i)
-			tommy_hashdyn_insert(&hashdyn, &HASH[i].node, &HASH[i], HASH[i].value);
+			tommy_hashlinc_insert(&hashlinc, &HASH[i].node, HASH[i].value);
 
 		the_count = 0;
-		tommy_hashdyn_foreach_arg(&hashdyn, count_arg_callback, &the_count);
+		tommy_hashlinc_foreach_arg(&hashlinc, count_arg_callback, &the_count);
 		if (the_count != n)
 			/* LCOV_EXCL_START */
 			abort();
@@ -1371,144 +3210,293 @@ void test_hashdyn(void)
 		/* insert all the others */
 		for(;i<size;++i,++j) {
 			/* insert one */
-			tommy_hashdyn_insert(&hashdyn, &HASH[i].node, &HASH[i], HASH[i].value);
+			tommy_hashlinc_insert(&hashlinc, &HASH[i].node, HASH[i].value);
 
 			/* remove one */
-			tommy_hashdyn_remove_existing(&hashdyn, &HASH[j].node);
+			tommy_hashlinc_remove_existing(&hashlinc, &HASH[j].node);
 		}
 
 		for(;j<size;++j)
-			if (tommy_hashdyn_remove(&hashdyn, search_callback, &HASH[j], HASH[j].value) == 0)
+			if (tommy_hashlinc_remove(&hashlinc, search_callback, &HASH[j], HASH[j].value) == 0)
 				/* LCOV_EXCL_START */
 				abort();
 				/* LCOV_EXCL_STOP */
 
-		tommy_hashdyn_done(&hashdyn);
+		tommy_hashlinc_done(&hashlinc);
 	}
 	STOP();
+
+	START("hashlinc order");
+	tommy_hashlinc_init(&hashlinc, offsetof(struct object_hashc, node));
+
+	/* all equal values, the last inserted is found first */
+	for(i=0;i<size;i+=module)
+		tommy_hashlinc_insert(&hashlinc, &HASH[i].node, HASH[i].value);
+
+	for(i=0;i<size;i+=module)
+		if (tommy_hashlinc_remove(&hashlinc, compare_hashc, &HASH[i].value, HASH[i].value) != &HASH[size - module - i])
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+	tommy_hashlinc_done(&hashlinc);
+	STOP();
+
+	free(HASH);
 }
 
-void test_hashlin(void)
+/**
+ * Saves a frozen hashtable with a bucket after the next one, and checks that it's not mapped.
+ */
+void frozen_corrupt_test(tommy_hashlin* hashlin, struct object_hash* HASH, const char* path)
+{
+	tommy_hashfrozen frozen;
+	tommy_size_t value;
+	FILE* f;
+
+	tommy_hashfrozen_init_hashlin(&frozen, hashlin, HASH);
+	if (tommy_hashfrozen_save(&frozen, path) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+	tommy_hashfrozen_done(&frozen);
+
+	/* the second bucket, after the count and the bucket bit */
+	value = (tommy_size_t)-1;
+	f = fopen(path, "r+b");
+	if (!f
+		|| fseek(f, TOMMY_FILE_OFFSET + 3 * sizeof(tommy_size_t), SEEK_SET) != 0
+		|| fwrite(&value, sizeof(value), 1, f) != 1
+		|| fclose(f) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	if (tommy_hashfrozen_map(&frozen, path, HASH) == 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	remove(path);
+}
+
+void test_hashfrozen(void)
 {
+	tommy_hashdyn hashdyn;
 	tommy_hashlin hashlin;
+	tommy_hashfrozen frozen;
 	struct object_hash* HASH;
-	unsigned i, j, n;
-	unsigned limit;
+	unsigned i;
 	const unsigned size = TOMMY_SIZE;
 	const unsigned module = TOMMY_SIZE / 4;
-	tommy_hashlin_node* bucket;
+	const char* path = "tommycheck.tmp";
 
 	HASH = malloc(size * sizeof(struct object_hash));
 
 	for(i=0;i<size;++i)
 		HASH[i].value = i % module;
 
-	tommy_hashlin_init(&hashlin);
-
-	/* insert */
+	START("hashfrozen hashdyn");
+	tommy_hashdyn_init(&hashdyn);
 	for(i=0;i<size;++i)
-		tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+		tommy_hashdyn_insert(&hashdyn, &HASH[i].node, &HASH[i], HASH[i].value);
 
-	/* get the bucket of the last element */
-	bucket = tommy_hashlin_bucket(&hashlin, module - 1);
-	if (bucket == 0)
+	tommy_hashfrozen_init_hashdyn(&frozen, &hashdyn, 0);
+	tommy_hashdyn_done(&hashdyn);
+
+	if (tommy_hashfrozen_count(&frozen) != size)
 		/* LCOV_EXCL_START */
 		abort();
 		/* LCOV_EXCL_STOP */
 
-	/* deinitialize without removing elements to force deallocation */
+	if (tommy_hashfrozen_memory_usage(&frozen) < size * sizeof(tommy_hashfrozen_entry))
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	for(i=0;i<size;++i)
+		if (tommy_hashfrozen_search(&frozen, search_callback, &HASH[i], HASH[i].value) != &HASH[i])
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+	/* missing */
+	for(i=0;i<size;++i)
+		if (tommy_hashfrozen_search(&frozen, search_callback, &HASH[i], HASH[i].value + module) != 0)
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
+
+	tommy_hashfrozen_done(&frozen);
+	STOP();
+
+	START("hashfrozen hashlin");
+	tommy_hashlin_init(&hashlin);
+	for(i=0;i<size;++i)
+		tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+
+	/* use the vector as base to have a position independent index */
+	tommy_hashfrozen_init_hashlin(&frozen, &hashlin, HASH);
+
+	/* a file with the buckets not sorted is rejected */
+	frozen_corrupt_test(&hashlin, HASH, path);
+
 	tommy_hashlin_done(&hashlin);
 
-	START("hashlin stack");
-	limit = 5 * isqrt(size);
-	for(n=0;n<=limit;++n) {
-		/* last iteration is full size */
-		if (n == limit)
-			n = limit = size;
+	if (tommy_hashfrozen_save(&frozen, path) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
 
-		tommy_hashlin_init(&hashlin);
+	tommy_hashfrozen_done(&frozen);
 
-		/* insert */
-		for(i=0;i<n;++i)
-			tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+	if (tommy_hashfrozen_map(&frozen, path, HASH) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
 
-		if (tommy_hashlin_memory_usage(&hashlin) < n * sizeof(void*))
+	remove(path);
+
+	for(i=0;i<size;++i)
+		if (tommy_hashfrozen_search(&frozen, search_callback, &HASH[i], HASH[i].value) != &HASH[i])
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 
-		if (tommy_hashlin_count(&hashlin) != n)
+	tommy_hashfrozen_done(&frozen);
+
+	if (tommy_hashfrozen_map(&frozen, path, HASH) == 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* empty */
+	tommy_hashdyn_init(&hashdyn);
+	tommy_hashfrozen_init_hashdyn(&frozen, &hashdyn, 0);
+	if (tommy_hashfrozen_search(&frozen, search_callback, &HASH[0], HASH[0].value) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+	tommy_hashfrozen_done(&frozen);
+	tommy_hashdyn_done(&hashdyn);
+	STOP();
+
+	free(HASH);
+}
+
+void test_mphf(void)
+{
+	tommy_mphf mphf;
+	tommy_uint64_t* KEY;
+	tommy_size_t* POS;
+	unsigned char* USED;
+	tommy_uint64_t DUP[3];
+	unsigned i;
+	const unsigned size = TOMMY_SIZE;
+	const char* path = "tommycheck.tmp";
+
+	KEY = malloc(size * sizeof(tommy_uint64_t));
+	POS = malloc(size * sizeof(tommy_size_t));
+	USED = malloc(size);
+
+	for(i=0;i<size;++i)
+		KEY[i] = tommy_hash_u64(0, &i, sizeof(i));
+
+	START("mphf");
+	tommy_mphf_init(&mphf, KEY, size, 0, 0);
+
+	if (tommy_mphf_count(&mphf) != size)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* less than 8 bits for each key */
+	if (tommy_mphf_memory_usage(&mphf) > size)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+
+	/* every key has a different position */
+	memset(USED, 0, size);
+	for(i=0;i<size;++i) {
+		POS[i] = tommy_mphf_search(&mphf, KEY[i]);
+		if (POS[i] >= size || USED[POS[i]])
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
+		USED[POS[i]] = 1;
+	}
 
-		the_count = 0;
-		tommy_hashlin_foreach(&hashlin, count_callback);
-		if (the_count != n)
+	/* missing */
+	for(i=0;i<size;++i)
+		if (tommy_mphf_search(&mphf, KEY[i] + 1) > size)
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 
-		/* remove in backward order */
-		for(i=0;i<n/2;++i)
-			tommy_hashlin_remove_existing(&hashlin, &HASH[n-i-1].node);
+	tommy_mphf_done(&mphf);
+	STOP();
 
-		/* remove missing */
-		for(i=0;i<n/2;++i)
-			if (tommy_hashlin_remove(&hashlin, search_callback, &HASH[n-i-1], HASH[n-i-1].value) != 0)
-				/* LCOV_EXCL_START */
-				abort();
-				/* LCOV_EXCL_STOP */
+	START("mphf parallel");
+	tommy_mphf_init(&mphf, KEY, size, parallel_sequential, 0);
 
-		/* remove search */
-		for(i=0;i<n/2;++i)
-			if (tommy_hashlin_remove(&hashlin, search_callback, &HASH[n/2-i-1], HASH[n/2-i-1].value) == 0)
-				/* LCOV_EXCL_START */
-				abort();
-				/* LCOV_EXCL_STOP */
+	/* the jobs order doesn't change the result */
+	for(i=0;i<size;++i)
+		if (tommy_mphf_search(&mphf, KEY[i]) != POS[i])
+			/* LCOV_EXCL_START */
+			abort();
+			/* LCOV_EXCL_STOP */
 
-		tommy_hashlin_done(&hashlin);
-	}
-	STOP();
+	if (tommy_mphf_save(&mphf, path) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
 
-	START("hashlin queue");
-	limit = isqrt(size) / 16;
-	for(n=0;n<=limit;++n) {
-		/* last iteration is full size */
-		if (n == limit)
-			n = limit = size;
+	tommy_mphf_done(&mphf);
 
-		tommy_hashlin_init(&hashlin);
+	if (tommy_mphf_map(&mphf, path) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
 
-		/* insert first run */
-		for(j=0,i=0;i<n;++i)
-			tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+	remove(path);
 
-		the_count = 0;
-		tommy_hashlin_foreach_arg(&hashlin, count_arg_callback, &the_count);
-		if (the_count != n)
+	for(i=0;i<size;++i)
+		if (tommy_mphf_search(&mphf, KEY[i]) != POS[i])
 			/* LCOV_EXCL_START */
 			abort();
 			/* LCOV_EXCL_STOP */
 
-		/* insert all the others */
-		for(;i<size;++i,++j) {
-			/* insert one */
-			tommy_hashlin_insert(&hashlin, &HASH[i].node, &HASH[i], HASH[i].value);
+	tommy_mphf_done(&mphf);
 
-			/* remove one */
-			tommy_hashlin_remove_existing(&hashlin, &HASH[j].node);
-		}
+	if (tommy_mphf_map(&mphf, path) == 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
 
-		for(;j<size;++j)
-			if (tommy_hashlin_remove(&hashlin, search_callback, &HASH[j], HASH[j].value) == 0)
-				/* LCOV_EXCL_START */
-				abort();
-				/* LCOV_EXCL_STOP */
+	/* duplicate keys always collide, and they end in the fallback */
+	DUP[0] = 5;
+	DUP[1] = 7;
+	DUP[2] = 5;
+	tommy_mphf_init(&mphf, DUP, 3, 0, 0);
+	if (tommy_mphf_search(&mphf, 7) != 0 || tommy_mphf_search(&mphf, 5) != 1)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+	tommy_mphf_done(&mphf);
 
-		tommy_hashlin_done(&hashlin);
-	}
+	/* empty */
+	tommy_mphf_init(&mphf, KEY, 0, 0, 0);
+	if (tommy_mphf_search(&mphf, KEY[0]) != 0)
+		/* LCOV_EXCL_START */
+		abort();
+		/* LCOV_EXCL_STOP */
+	tommy_mphf_done(&mphf);
 	STOP();
+
+	free(KEY);
+	free(POS);
+	free(USED);
 }
 
 void test_trie(void)
@@ -1693,14 +3681,21 @@ int main() {
 	test_hash();
 	test_alloc();
 	test_list();
+	test_ulist();
+	test_queue();
 	test_tree();
 	test_array();
 	test_arrayof();
 	test_arrayblk();
 	test_arrayblkof();
+	test_arrayvm();
 	test_hashtable();
 	test_hashdyn();
 	test_hashlin();
+	test_hashdync();
+	test_hashlinc();
+	test_hashfrozen();
+	test_mphf();
 	test_trie();
 	test_trie_inplace();
 
@@ -0,0 +1,663 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+/**
+ * Tommy microbenchmark program.
+ *
+ * It measures the core primitives, like tommy_ilog2(), tommy_ctz(),
+ * tommy_roundup_pow2(), the hash functions and tommy_chain_mergesort(),
+ * and the inline fast path of some containers.
+ * The hashlin_search tests use a large table, to measure the effect of the
+ * TOMMY_HASHLIN_FINGERPRINT option, building with and without "make FINGERPRINT=1".
+ *
+ * Each measure repeats a loop over a vector of inputs, after some warmup runs.
+ * The runs slower than the third quartile plus 1.5 times the interquartile range
+ * are rejected as outliers, and the median, the minimum and the mean of the
+ * remaining runs are reported, as time for a single operation.
+ *
+ * Simply run it without any options, or with the name of the tests to run.
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#if defined(__linux)
+#include <stdint.h>
+#include <unistd.h>
+#include <sys/time.h>
+#endif
+
+#if defined(__MACH__)
+#include <mach/mach_time.h>
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+/* Use the time stamp counter for a precise measure */
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define USE_RDTSC
+#endif
+
+#include "tommyds/tommy.h"
+#include "tommyds/tommychain.h"
+
+/**
+ * Number of inputs for each run.
+ */
+#define MICRO_COUNT 4096
+
+/**
+ * Number of warmup runs, not measured.
+ */
+#define MICRO_WARMUP 5
+
+/**
+ * Number of measured runs.
+ */
+#define MICRO_RUN 31
+
+/**
+ * Number of elements in the containers.
+ */
+#define MICRO_CONTAINER 65536
+
+/**
+ * Number of elements in the large containers, that don't fit in the cache.
+ */
+#define MICRO_LARGE (2 * 1024 * 1024)
+
+/******************************************************************************/
+/* time */
+
+#if defined(_WIN32)
+static LARGE_INTEGER win_frequency;
+#endif
+
+static void nano_init(void)
+{
+#if defined(_WIN32)
+	if (!QueryPerformanceFrequency(&win_frequency)) {
+		win_frequency.QuadPart = 0;
+	}
+#endif
+}
+
+static tommy_uint64_t nano(void)
+{
+	tommy_uint64_t ret;
+#if defined(_WIN32)
+	LARGE_INTEGER t;
+
+	if (!QueryPerformanceCounter(&t))
+		return 0;
+
+	ret = (t.QuadPart / win_frequency.QuadPart) * 1000000000;
+
+	ret += (t.QuadPart % win_frequency.QuadPart) * 1000000000 / win_frequency.QuadPart;
+#elif defined(__MACH__)
+	mach_timebase_info_data_t info;
+	kern_return_t r;
+	tommy_uint64_t t;
+
+	t = mach_absolute_time();
+
+	r = mach_timebase_info(&info);
+	if (r != 0)
+		abort();
+
+	ret = (t / info.denom) * info.numer;
+
+	ret += (t % info.denom) * info.numer / info.denom;
+#elif defined(__linux)
+	struct timespec ts;
+	int r;
+
+	r = clock_gettime(CLOCK_MONOTONIC, &ts);
+	if (r != 0)
+		abort();
+
+	ret = ts.tv_sec * (tommy_uint64_t)1000000000 + ts.tv_nsec;
+#else
+	struct timeval tv;
+	int r;
+
+	r = gettimeofday(&tv, 0);
+	if (r != 0)
+		abort();
+
+	ret = tv.tv_sec * (tommy_uint64_t)1000000000 + tv.tv_usec * 1000;
+#endif
+	return ret;
+}
+
+/**
+ * Gets the current tick, from the time stamp counter if available.
+ */
+static tommy_uint64_t tick(void)
+{
+#ifdef USE_RDTSC
+	return __rdtsc();
+#else
+	return nano();
+#endif
+}
+
+/**
+ * Ticks for each nanosecond.
+ */
+static double the_tick_per_ns;
+
+/**
+ * Calibrates the ticks, counting them in 10 ms.
+ */
+static void tick_init(void)
+{
+	tommy_uint64_t begin_nano;
+	tommy_uint64_t begin_tick;
+	tommy_uint64_t elapsed_nano;
+
+	begin_nano = nano();
+	begin_tick = tick();
+	do {
+		elapsed_nano = nano() - begin_nano;
+	} while (elapsed_nano < 10000000);
+	the_tick_per_ns = (double)(tick() - begin_tick) / elapsed_nano;
+}
+
+/******************************************************************************/
+/* harness */
+
+/**
+ * Result of the operations, used to avoid that the compiler removes them.
+ */
+volatile tommy_size_t the_sink;
+
+/**
+ * Random inputs.
+ */
+static tommy_uint32_t U32[MICRO_COUNT];
+static tommy_uint64_t U64[MICRO_COUNT];
+
+/**
+ * Random generator.
+ */
+static tommy_uint64_t the_seed = 0x9E3779B97F4A7C15ULL;
+
+static tommy_uint64_t rnd(void)
+{
+	/* xorshift64 */
+	the_seed ^= the_seed << 13;
+	the_seed ^= the_seed >> 7;
+	the_seed ^= the_seed << 17;
+	return the_seed;
+}
+
+/**
+ * Microbenchmark.
+ */
+struct micro {
+	const char* name; /**< Name of the test. */
+	void (*prepare)(tommy_size_t arg); /**< Called before each run, not measured. It can be 0. */
+	void (*run)(tommy_size_t arg); /**< Run measured. */
+	tommy_size_t arg; /**< Argument of the test, like the size of the input. */
+	tommy_size_t count; /**< Number of operations in each run. */
+};
+
+static int compare_double(const void* void_a, const void* void_b)
+{
+	const double* a = void_a;
+	const double* b = void_b;
+
+	if (*a < *b)
+		return -1;
+	if (*a > *b)
+		return 1;
+	return 0;
+}
+
+static void measure(const struct micro* m)
+{
+	double v[MICRO_RUN];
+	double limit;
+	double mean;
+	unsigned kept;
+	unsigned i;
+
+	for (i = 0; i < MICRO_WARMUP + MICRO_RUN; ++i) {
+		tommy_uint64_t begin;
+		tommy_uint64_t elapsed;
+
+		if (m->prepare)
+			m->prepare(m->arg);
+
+		begin = tick();
+		m->run(m->arg);
+		elapsed = tick() - begin;
+
+		if (i >= MICRO_WARMUP)
+			v[i - MICRO_WARMUP] = (double)elapsed / m->count;
+	}
+
+	qsort(v, MICRO_RUN, sizeof(v[0]), compare_double);
+
+	/* reject the outliers with the Tukey's fences, only the slow ones */
+	limit = v[MICRO_RUN * 3 / 4] + 1.5 * (v[MICRO_RUN * 3 / 4] - v[MICRO_RUN / 4]);
+
+	mean = 0;
+	kept = 0;
+	for (i = 0; i < MICRO_RUN; ++i) {
+		if (v[i] <= limit) {
+			mean += v[i];
+			++kept;
+		}
+	}
+	mean /= kept;
+
+	printf("%-28s %8.2f %8.2f %8.2f %8u\n", m->name, v[MICRO_RUN / 2], v[0], mean, MICRO_RUN - kept);
+}
+
+/******************************************************************************/
+/* tests */
+
+static void run_baseline(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += U32[i];
+
+	the_sink = sum;
+}
+
+static void run_ilog2_u32(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += tommy_ilog2_u32(U32[i]);
+
+	the_sink = sum;
+}
+
+static void run_ilog2_u64(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += tommy_ilog2_u64(U64[i]);
+
+	the_sink = sum;
+}
+
+static void run_ctz_u32(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += tommy_ctz_u32(U32[i]);
+
+	the_sink = sum;
+}
+
+static void run_ctz_u64(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += tommy_ctz_u64(U64[i]);
+
+	the_sink = sum;
+}
+
+static void run_roundup_pow2_u32(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += tommy_roundup_pow2_u32(U32[i] >> 1);
+
+	the_sink = sum;
+}
+
+static void run_roundup_pow2_u64(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += (tommy_size_t)tommy_roundup_pow2_u64(U64[i] >> 1);
+
+	the_sink = sum;
+}
+
+static void run_inthash_u32(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += tommy_inthash_u32(U32[i]);
+
+	the_sink = sum;
+}
+
+static void run_inthash_u64(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += (tommy_size_t)tommy_inthash_u64(U64[i]);
+
+	the_sink = sum;
+}
+
+/**
+ * Buffer hashed, with zero terminated strings of increasing length at each offset.
+ */
+static char HASH_BUFFER[MICRO_COUNT + 1024 + 1];
+
+static void prepare_hash(tommy_size_t arg)
+{
+	unsigned i;
+
+	for (i = 0; i < sizeof(HASH_BUFFER); ++i)
+		HASH_BUFFER[i] = 'a' + rnd() % 26;
+
+	/* terminator for tommy_strhash_u32() */
+	HASH_BUFFER[arg] = 0;
+}
+
+static void run_hash_u32(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	for (i = 0; i < MICRO_COUNT / 16; ++i)
+		sum += tommy_hash_u32(i, HASH_BUFFER, arg);
+
+	the_sink = sum;
+}
+
+static void run_hash_u64(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	for (i = 0; i < MICRO_COUNT / 16; ++i)
+		sum += (tommy_size_t)tommy_hash_u64(i, HASH_BUFFER, arg);
+
+	the_sink = sum;
+}
+
+static void run_strhash_u32(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT / 16; ++i)
+		sum += tommy_strhash_u32(i, HASH_BUFFER);
+
+	the_sink = sum;
+}
+
+struct object {
+	tommy_node node;
+	tommy_uint32_t value;
+};
+
+static struct object SORT[MICRO_COUNT];
+static tommy_list the_list;
+
+static int compare_object(const void* void_a, const void* void_b)
+{
+	const struct object* a = void_a;
+	const struct object* b = void_b;
+
+	if (a->value < b->value)
+		return -1;
+	if (a->value > b->value)
+		return 1;
+	return 0;
+}
+
+static void prepare_mergesort(tommy_size_t arg)
+{
+	unsigned i;
+
+	tommy_list_init(&the_list);
+	for (i = 0; i < arg; ++i) {
+		SORT[i].value = (tommy_uint32_t)rnd();
+		tommy_list_insert_tail(&the_list, &SORT[i].node, &SORT[i]);
+	}
+}
+
+static void run_mergesort(tommy_size_t arg)
+{
+	tommy_chain chain;
+	tommy_node* head;
+
+	(void)arg;
+
+	/* create a chain from the list, like tommy_list_sort() */
+	head = tommy_list_head(&the_list);
+	chain.head = head;
+	chain.tail = head->prev;
+
+	tommy_chain_mergesort(&chain, compare_object);
+
+	the_sink = (tommy_size_t)chain.head;
+}
+
+static tommy_hashlin the_hashlin;
+
+static void run_hashlin_bucket_ref(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += (tommy_size_t)tommy_hashlin_bucket_ref(&the_hashlin, U32[i]);
+
+	the_sink = sum;
+}
+
+static tommy_hashlin the_hashlin_large;
+static struct object* the_hashlin_large_obj;
+
+static int search_object(const void* arg, const void* obj)
+{
+	return *(const tommy_uint32_t*)arg != ((const struct object*)obj)->value;
+}
+
+static void prepare_hashlin_large(tommy_size_t arg)
+{
+	tommy_uint32_t i;
+
+	(void)arg;
+
+	/* build the table only the first time */
+	if (the_hashlin_large_obj)
+		return;
+
+	the_hashlin_large_obj = malloc(MICRO_LARGE * sizeof(struct object));
+
+	/* use a 64 bits hash, to have all the hash bits significant */
+	tommy_hashlin_init(&the_hashlin_large);
+	for (i = 0; i < MICRO_LARGE; ++i) {
+		the_hashlin_large_obj[i].value = i;
+		tommy_hashlin_insert(&the_hashlin_large, &the_hashlin_large_obj[i].node, &the_hashlin_large_obj[i], tommy_inthash_u64(i));
+	}
+}
+
+static void run_hashlin_search(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	for (i = 0; i < MICRO_COUNT; ++i) {
+		/* with arg 0 search the present keys, with arg 1 the missing ones */
+		tommy_uint32_t key = (tommy_uint32_t)(U32[i] % MICRO_LARGE + arg * MICRO_LARGE);
+		sum += (tommy_size_t)tommy_hashlin_search(&the_hashlin_large, search_object, &key, tommy_inthash_u64(key));
+	}
+
+	the_sink = sum;
+}
+
+static tommy_arrayblkof the_arrayblkof;
+
+static void run_arrayblkof_ref(tommy_size_t arg)
+{
+	tommy_size_t sum = 0;
+	unsigned i;
+
+	(void)arg;
+
+	for (i = 0; i < MICRO_COUNT; ++i)
+		sum += (tommy_size_t)tommy_arrayblkof_ref(&the_arrayblkof, U32[i] % MICRO_CONTAINER);
+
+	the_sink = sum;
+}
+
+static const struct micro MICRO[] = {
+	{ "baseline", 0, run_baseline, 0, MICRO_COUNT },
+	{ "ilog2_u32", 0, run_ilog2_u32, 0, MICRO_COUNT },
+	{ "ilog2_u64", 0, run_ilog2_u64, 0, MICRO_COUNT },
+	{ "ctz_u32", 0, run_ctz_u32, 0, MICRO_COUNT },
+	{ "ctz_u64", 0, run_ctz_u64, 0, MICRO_COUNT },
+	{ "roundup_pow2_u32", 0, run_roundup_pow2_u32, 0, MICRO_COUNT },
+	{ "roundup_pow2_u64", 0, run_roundup_pow2_u64, 0, MICRO_COUNT },
+	{ "inthash_u32", 0, run_inthash_u32, 0, MICRO_COUNT },
+	{ "inthash_u64", 0, run_inthash_u64, 0, MICRO_COUNT },
+	{ "hash_u32/4", prepare_hash, run_hash_u32, 4, MICRO_COUNT / 16 },
+	{ "hash_u32/16", prepare_hash, run_hash_u32, 16, MICRO_COUNT / 16 },
+	{ "hash_u32/64", prepare_hash, run_hash_u32, 64, MICRO_COUNT / 16 },
+	{ "hash_u32/256", prepare_hash, run_hash_u32, 256, MICRO_COUNT / 16 },
+	{ "hash_u32/1024", prepare_hash, run_hash_u32, 1024, MICRO_COUNT / 16 },
+	{ "hash_u64/4", prepare_hash, run_hash_u64, 4, MICRO_COUNT / 16 },
+	{ "hash_u64/16", prepare_hash, run_hash_u64, 16, MICRO_COUNT / 16 },
+	{ "hash_u64/64", prepare_hash, run_hash_u64, 64, MICRO_COUNT / 16 },
+	{ "hash_u64/256", prepare_hash, run_hash_u64, 256, MICRO_COUNT / 16 },
+	{ "hash_u64/1024", prepare_hash, run_hash_u64, 1024, MICRO_COUNT / 16 },
+	{ "strhash_u32/4", prepare_hash, run_strhash_u32, 4, MICRO_COUNT / 16 },
+	{ "strhash_u32/16", prepare_hash, run_strhash_u32, 16, MICRO_COUNT / 16 },
+	{ "strhash_u32/64", prepare_hash, run_strhash_u32, 64, MICRO_COUNT / 16 },
+	{ "strhash_u32/256", prepare_hash, run_strhash_u32, 256, MICRO_COUNT / 16 },
+	{ "strhash_u32/1024", prepare_hash, run_strhash_u32, 1024, MICRO_COUNT / 16 },
+	{ "chain_mergesort/16", prepare_mergesort, run_mergesort, 16, 16 },
+	{ "chain_mergesort/256", prepare_mergesort, run_mergesort, 256, 256 },
+	{ "chain_mergesort/4096", prepare_mergesort, run_mergesort, 4096, 4096 },
+	{ "hashlin_bucket_ref", 0, run_hashlin_bucket_ref, 0, MICRO_COUNT },
+	{ "hashlin_search_hit", prepare_hashlin_large, run_hashlin_search, 0, MICRO_COUNT },
+	{ "hashlin_search_miss", prepare_hashlin_large, run_hashlin_search, 1, MICRO_COUNT },
+	{ "arrayblkof_ref", 0, run_arrayblkof_ref, 0, MICRO_COUNT },
+	{ 0, 0, 0, 0, 0 }
+};
+
+/******************************************************************************/
+/* main */
+
+static struct object HASHLIN[MICRO_CONTAINER];
+
+static void init(void)
+{
+	unsigned i;
+
+	for (i = 0; i < MICRO_COUNT; ++i) {
+		/* avoid zero, not supported by tommy_ilog2() and tommy_ctz() */
+		do {
+			U64[i] = rnd();
+		} while ((U64[i] & 0xFFFFFFFF) == 0);
+		U32[i] = (tommy_uint32_t)U64[i];
+	}
+
+	tommy_hashlin_init(&the_hashlin);
+	for (i = 0; i < MICRO_CONTAINER; ++i) {
+		HASHLIN[i].value = i;
+		tommy_hashlin_insert(&the_hashlin, &HASHLIN[i].node, &HASHLIN[i], tommy_inthash_u32(i));
+	}
+
+	tommy_arrayblkof_init(&the_arrayblkof, sizeof(tommy_uint32_t));
+	tommy_arrayblkof_grow(&the_arrayblkof, MICRO_CONTAINER);
+}
+
+static void done(void)
+{
+	tommy_hashlin_done(&the_hashlin);
+	if (the_hashlin_large_obj) {
+		tommy_hashlin_done(&the_hashlin_large);
+		free(the_hashlin_large_obj);
+	}
+	tommy_arrayblkof_done(&the_arrayblkof);
+}
+
+int main(int argc, char* argv[])
+{
+	const struct micro* m;
+	int i;
+
+	nano_init();
+	tick_init();
+	init();
+
+	printf("Tommy microbenchmark program.\n");
+#ifdef USE_RDTSC
+	printf("Time in ticks of the time stamp counter, %.2f ticks for ns.\n", the_tick_per_ns);
+#else
+	printf("Time in ns.\n");
+#endif
+	printf("%-28s %8s %8s %8s %8s\n", "test", "median", "min", "mean", "outliers");
+
+	for (m = MICRO; m->name; ++m) {
+		if (argc > 1) {
+			/* run only the selected tests, matching the name prefix */
+			for (i = 1; i < argc; ++i) {
+				if (strncmp(m->name, argv[i], strlen(argv[i])) == 0)
+					break;
+			}
+			if (i == argc)
+				continue;
+		}
+
+		measure(m);
+	}
+
+	done();
+
+	printf("OK\n");
+
+	return EXIT_SUCCESS;
+}
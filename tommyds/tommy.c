@@ -3,15 +3,24 @@
 
 #include "tommyhash.c"
 #include "tommyalloc.c"
+#include "tommyfile.c"
 #include "tommyarray.c"
 #include "tommyarrayof.c"
 #include "tommyarrayblk.c"
 #include "tommyarrayblkof.c"
+#include "tommyarrayvm.c"
 #include "tommylist.c"
+#include "tommyulist.c"
+#include "tommyqueue.c"
+#include "tommyring.c"
 #include "tommytree.c"
 #include "tommytrie.c"
 #include "tommytrieinp.c"
 #include "tommyhashtbl.c"
 #include "tommyhashdyn.c"
 #include "tommyhashlin.c"
+#include "tommyhashdync.c"
+#include "tommyhashlinc.c"
+#include "tommyhashfrz.c"
+#include "tommymphf.c"
 
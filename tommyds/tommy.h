@@ -23,15 +23,27 @@
  * The data structures provided are:
  *
  * - ::tommy_list - A double linked list.
+ * - ::tommy_ulist - An unrolled list of chunks of object pointers.
+ * It's faster to iterate, and it's a good choice for queues.
+ * - ::tommy_queue - A lock-free intrusive queue, with multiple producers and a single consumer.
+ * - ::tommy_ring - A lock-free bounded queue of lists, with multiple producers and consumers.
  * - ::tommy_array, ::tommy_arrayof - A linear array.
  * It doesn't fragment the heap.
  * - ::tommy_arrayblk, ::tommy_arrayblkof - A blocked linear array.
  * It doesn't fragment the heap and it minimizes space occupation.
+ * - ::tommy_arrayvm - A contiguous linear array in reserved virtual memory.
+ * It has the fastest access, and it zeroes the memory lazily.
  * - ::tommy_hashtable - A fixed-size chained hashtable.
  * - ::tommy_hashdyn - A dynamic chained hashtable.
  * - ::tommy_hashlin - A linear chained hashtable.
  * It doesn't have the problem of the delay when resizing and
  * it doesn't fragment the heap.
+ * - ::tommy_hashdync, ::tommy_hashlinc - Hashtables like ::tommy_hashdyn and ::tommy_hashlin
+ * using the compact ::tommy_cnode of half the size, without the object pointer.
+ * - ::tommy_hashfrozen - A read-only compact hashtable built from another one.
+ * It doesn't need any node in the objects, and it can be mapped from a file.
+ * - ::tommy_mphf - A minimal perfect hash function for a static set of keys.
+ * It maps the keys in a plain vector of objects, using less than 4 bits for each key.
  * - ::tommy_trie - A trie optimized for cache utilization.
  * - ::tommy_trie_inplace - A trie completely inplace.
  * - ::tommy_tree - A tree to keep elements in order.
@@ -761,6 +773,8 @@
  *
  * Tommy is not thread-safe. You have always to provide thread safety using
  * locks before calling any Tommy functions.
+ * The only exceptions are ::tommy_queue and ::tommy_ring that are lock-free,
+ * and designed to pass objects between threads.
  *
  * Tommy doesn't provide iterators for elements stored in a container.
  * To iterate on elements you must insert them also into a ::tommy_list,
@@ -857,17 +871,26 @@ extern "C" {
 #include "tommytypes.h"
 #include "tommyhash.h"
 #include "tommyalloc.h"
+#include "tommyfile.h"
 #include "tommyarray.h"
 #include "tommyarrayof.h"
 #include "tommyarrayblk.h"
 #include "tommyarrayblkof.h"
+#include "tommyarrayvm.h"
 #include "tommylist.h"
+#include "tommyulist.h"
+#include "tommyqueue.h"
+#include "tommyring.h"
 #include "tommytree.h"
 #include "tommytrie.h"
 #include "tommytrieinp.h"
 #include "tommyhashtbl.h"
 #include "tommyhashdyn.h"
 #include "tommyhashlin.h"
+#include "tommyhashdync.h"
+#include "tommyhashlinc.h"
+#include "tommyhashfrz.h"
+#include "tommymphf.h"
 
 #ifdef __cplusplus
 }
@@ -3,6 +3,8 @@
 
 #include "tommyarray.h"
 
+#include <string.h> /* for memset */
+
 /******************************************************************************/
 /* array */
 
@@ -52,6 +54,46 @@ TOMMY_API void tommy_array_grow(tommy_array* array, tommy_size_t count)
 	}
 }
 
+TOMMY_API void tommy_array_truncate(tommy_array* array, tommy_size_t count)
+{
+	tommy_size_t pos;
+
+	if (array->count <= count)
+		return;
+
+	/* clear the removed elements, as tommy_array_grow() expects them at 0 */
+	pos = count;
+	while (pos < array->count) {
+		tommy_uint_t bsr = tommy_ilog2(pos | 1);
+		tommy_size_t end;
+
+		/* end of the segment, the first one contains all the initial buckets */
+		if (bsr < TOMMY_ARRAY_BIT)
+			end = (tommy_size_t)1 << TOMMY_ARRAY_BIT;
+		else
+			end = (tommy_size_t)1 << (bsr + 1);
+		if (end > array->count)
+			end = array->count;
+
+		memset(&array->bucket[bsr][pos], 0, (end - pos) * sizeof(void*));
+
+		pos = end;
+	}
+
+	array->count = count;
+}
+
+TOMMY_API void tommy_array_shrink(tommy_array* array)
+{
+	/* free the last segment while it's not used */
+	while (array->bucket_bit > TOMMY_ARRAY_BIT && array->count <= array->bucket_max / 2) {
+		--array->bucket_bit;
+		array->bucket_max = (tommy_size_t)1 << array->bucket_bit;
+
+		tommy_free(&array->bucket[array->bucket_bit][(tommy_ptrdiff_t)1 << array->bucket_bit]);
+	}
+}
+
 TOMMY_API tommy_size_t tommy_array_memory_usage(tommy_array* array)
 {
 	return array->bucket_max * (tommy_size_t)sizeof(void*);
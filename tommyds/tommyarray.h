@@ -56,6 +56,20 @@ TOMMY_API void tommy_array_done(tommy_array* array);
  */
 TOMMY_API void tommy_array_grow(tommy_array* array, tommy_size_t size);
 
+/**
+ * Truncates the size down to the specified value.
+ * The removed elements are set to 0, but the memory is not freed.
+ * Call tommy_array_shrink() to free it.
+ * If the size is not smaller than the current one, nothing is done.
+ */
+TOMMY_API void tommy_array_truncate(tommy_array* array, tommy_size_t size);
+
+/**
+ * Frees the memory not required by the current size.
+ * The segments after the last element are freed, down to the initial size.
+ */
+TOMMY_API void tommy_array_shrink(tommy_array* array);
+
 /**
  * Gets a reference of the element at the specified position.
  * You must be sure that space for this position is already
@@ -105,6 +119,29 @@ tommy_inline void tommy_array_insert(tommy_array* array, void* element)
 	tommy_array_set(array, pos, element);
 }
 
+/**
+ * Removes the last element of the array.
+ * The memory is not freed. Call tommy_array_shrink() to free it.
+ * The array must not be empty.
+ * \return The removed element.
+ */
+tommy_inline void* tommy_array_pop(tommy_array* array)
+{
+	void** ref;
+	void* element;
+
+	assert(array->count > 0);
+
+	ref = tommy_array_ref(array, array->count - 1);
+	element = *ref;
+
+	/* keep the unused elements at 0, as expected by tommy_array_grow() */
+	*ref = 0;
+	--array->count;
+
+	return element;
+}
+
 /**
  * Gets the initialized size of the array.
  */
@@ -3,14 +3,74 @@
 
 #include "tommyarrayblk.h"
 
+#include <string.h> /* for memset and memcpy */
+#include <stddef.h> /* for offsetof */
+
+/******************************************************************************/
+/* block */
+
+/**
+ * Block of elements.
+ * The reference count is the number of the array and snapshots using it.
+ * The array stores only the pointer at the elements.
+ */
+struct tommy_arrayblk_block {
+	tommy_size_t refcount;
+	void* slot[TOMMY_ARRAYBLK_SIZE];
+};
+
+static struct tommy_arrayblk_block* arrayblk_block(void* slot)
+{
+	void* ptr = tommy_cast(unsigned char*, slot) - offsetof(struct tommy_arrayblk_block, slot);
+
+	return tommy_cast(struct tommy_arrayblk_block*, ptr);
+}
+
+static void** arrayblk_alloc(void)
+{
+	struct tommy_arrayblk_block* block = tommy_cast(struct tommy_arrayblk_block*, tommy_calloc(1, sizeof(struct tommy_arrayblk_block)));
+
+	block->refcount = 1;
+
+	return block->slot;
+}
+
+static void arrayblk_acquire(void* slot)
+{
+	struct tommy_arrayblk_block* block = arrayblk_block(slot);
+
+	tommy_atomic_add(&block->refcount, 1);
+}
+
+static void arrayblk_release(void* slot)
+{
+	struct tommy_arrayblk_block* block = arrayblk_block(slot);
+
+	/* if it's the last reference, nobody else can acquire it */
+	if (tommy_atomic_load(&block->refcount) == 1 || tommy_atomic_add(&block->refcount, (tommy_size_t)-1) == 0)
+		tommy_free(block);
+}
+
+/**
+ * Releases a reference to the counter of the live snapshots.
+ * The counter is shared by the array and by its snapshots, as both can be released first.
+ */
+static void arrayblk_live_release(tommy_size_t* live)
+{
+	/* if it's the last reference, nobody else can acquire it */
+	if (tommy_atomic_load(live) == 1 || tommy_atomic_add(live, (tommy_size_t)-1) == 0)
+		tommy_free(live);
+}
+
 /******************************************************************************/
 /* array */
 
-void tommy_arrayblk_init(tommy_arrayblk* array)
+TOMMY_API void tommy_arrayblk_init(tommy_arrayblk* array)
 {
 	tommy_array_init(&array->block);
 
 	array->count = 0;
+	array->live = 0;
 }
 
 TOMMY_API void tommy_arrayblk_done(tommy_arrayblk* array)
@@ -18,9 +78,12 @@ TOMMY_API void tommy_arrayblk_done(tommy_arrayblk* array)
 	tommy_size_t i;
 
 	for (i = 0; i < tommy_array_size(&array->block); ++i)
-		tommy_free(tommy_array_get(&array->block, i));
+		arrayblk_release(tommy_array_get(&array->block, i));
 
 	tommy_array_done(&array->block);
+
+	if (array->live)
+		arrayblk_live_release(array->live);
 }
 
 TOMMY_API void tommy_arrayblk_grow(tommy_arrayblk* array, tommy_size_t count)
@@ -41,7 +104,7 @@ TOMMY_API void tommy_arrayblk_grow(tommy_arrayblk* array, tommy_size_t count)
 
 		/* allocate new blocks */
 		while (block_mac < block_max) {
-			void** ptr = tommy_cast(void**, tommy_calloc(TOMMY_ARRAYBLK_SIZE, sizeof(void*)));
+			void** ptr = arrayblk_alloc();
 
 			/* set the new block */
 			tommy_array_set(&array->block, block_mac, ptr);
@@ -51,8 +114,137 @@ TOMMY_API void tommy_arrayblk_grow(tommy_arrayblk* array, tommy_size_t count)
 	}
 }
 
+TOMMY_API void tommy_arrayblk_truncate(tommy_arrayblk* array, tommy_size_t count)
+{
+	tommy_size_t pos;
+
+	if (array->count <= count)
+		return;
+
+	/* clear the removed elements, as tommy_arrayblk_grow() expects them at 0 */
+	pos = count;
+	while (pos < array->count) {
+		void** ptr;
+		tommy_size_t end = (pos / TOMMY_ARRAYBLK_SIZE + 1) * TOMMY_ARRAYBLK_SIZE;
+
+		if (array->live)
+			tommy_arrayblk_unshare(array, pos);
+
+		ptr = tommy_cast(void**, tommy_array_get(&array->block, pos / TOMMY_ARRAYBLK_SIZE));
+
+		if (end > array->count)
+			end = array->count;
+
+		memset(&ptr[pos % TOMMY_ARRAYBLK_SIZE], 0, (end - pos) * sizeof(void*));
+
+		pos = end;
+	}
+
+	array->count = count;
+}
+
+TOMMY_API void tommy_arrayblk_shrink(tommy_arrayblk* array)
+{
+	tommy_size_t block_max;
+	tommy_size_t block_mac;
+
+	block_max = (array->count + TOMMY_ARRAYBLK_SIZE - 1) / TOMMY_ARRAYBLK_SIZE;
+	block_mac = tommy_array_size(&array->block);
+
+	if (block_mac <= block_max)
+		return;
+
+	/* free the unused blocks */
+	while (block_mac > block_max) {
+		--block_mac;
+		arrayblk_release(tommy_array_get(&array->block, block_mac));
+	}
+
+	/* shrink the block array */
+	tommy_array_truncate(&array->block, block_max);
+	tommy_array_shrink(&array->block);
+}
+
+TOMMY_API void tommy_arrayblk_unshare(tommy_arrayblk* array, tommy_size_t pos)
+{
+	tommy_size_t i = pos / TOMMY_ARRAYBLK_SIZE;
+	void* slot = tommy_array_get(&array->block, i);
+	struct tommy_arrayblk_block* block = arrayblk_block(slot);
+	void** ptr;
+
+	/* if all the snapshots are released, stop sharing */
+	/* new snapshots cannot be taken concurrently, as they are taken by the writer */
+	if (tommy_atomic_load(array->live) == 1) {
+		tommy_free(array->live);
+		array->live = 0;
+		return;
+	}
+
+	/* only the array owns it */
+	if (tommy_atomic_load(&block->refcount) == 1)
+		return;
+
+	/* copy the block, and leave the old one to the snapshots */
+	ptr = arrayblk_alloc();
+	memcpy(ptr, block->slot, sizeof(block->slot));
+	tommy_array_set(&array->block, i, ptr);
+
+	arrayblk_release(slot);
+}
+
 TOMMY_API tommy_size_t tommy_arrayblk_memory_usage(tommy_arrayblk* array)
 {
-	return tommy_array_memory_usage(&array->block) + tommy_array_size(&array->block) * TOMMY_ARRAYBLK_SIZE * sizeof(void*);
+	return tommy_array_memory_usage(&array->block) + tommy_array_size(&array->block) * sizeof(struct tommy_arrayblk_block);
+}
+
+/******************************************************************************/
+/* snapshot */
+
+TOMMY_API void tommy_arrayblk_snapshot_init(tommy_arrayblk_snapshot* snapshot, tommy_arrayblk* array)
+{
+	tommy_size_t block_max;
+	tommy_size_t i;
+
+	/* the blocks after the last element are not shared */
+	block_max = (array->count + TOMMY_ARRAYBLK_SIZE - 1) / TOMMY_ARRAYBLK_SIZE;
+
+	tommy_array_init(&snapshot->block);
+	tommy_array_grow(&snapshot->block, block_max);
+
+	for (i = 0; i < block_max; ++i) {
+		void* slot = tommy_array_get(&array->block, i);
+
+		arrayblk_acquire(slot);
+
+		tommy_array_set(&snapshot->block, i, slot);
+	}
+
+	snapshot->count = array->count;
+
+	/* from now on the array has to check the blocks before changing them */
+	if (!array->live) {
+		array->live = tommy_cast(tommy_size_t*, tommy_malloc(sizeof(tommy_size_t)));
+		*array->live = 1;
+	}
+	tommy_atomic_add(array->live, 1);
+	snapshot->live = array->live;
+}
+
+TOMMY_API void tommy_arrayblk_snapshot_done(tommy_arrayblk_snapshot* snapshot)
+{
+	tommy_size_t i;
+
+	for (i = 0; i < tommy_array_size(&snapshot->block); ++i)
+		arrayblk_release(tommy_array_get(&snapshot->block, i));
+
+	tommy_array_done(&snapshot->block);
+
+	/* after releasing the blocks, as the array stops checking them when the count drops */
+	arrayblk_live_release(snapshot->live);
+}
+
+TOMMY_API tommy_size_t tommy_arrayblk_snapshot_memory_usage(tommy_arrayblk_snapshot* snapshot)
+{
+	return tommy_array_memory_usage(&snapshot->block);
 }
 
@@ -12,6 +12,24 @@
  * This also implies that the address of the stored elements never change.
  *
  * Allocated blocks are always of the same fixed size of 4 Ki pointers.
+ *
+ * The blocks are also the unit of copy-on-write for snapshots.
+ * A ::tommy_arrayblk_snapshot freezes the current content of the array sharing
+ * its blocks, and a block is copied only when the array modifies it.
+ * A snapshot can be read and released by other threads without any lock,
+ * while the array keeps being updated.
+ *
+ * \code
+ * tommy_arrayblk_snapshot snapshot;
+ *
+ * // in the writer thread
+ * tommy_arrayblk_snapshot_init(&snapshot, &array);
+ *
+ * // in any reader thread
+ * for (i = 0; i < tommy_arrayblk_snapshot_size(&snapshot); ++i)
+ *     process(tommy_arrayblk_snapshot_get(&snapshot, i));
+ * tommy_arrayblk_snapshot_done(&snapshot);
+ * \endcode
  */
 
 #ifndef __TOMMYARRAYBLK_H
@@ -37,8 +55,19 @@
 typedef struct tommy_arrayblk_struct {
 	tommy_array block; /**< Array of blocks. */
 	tommy_size_t count; /**< Number of initialized elements in the array. */
+	tommy_size_t* live; /**< Number of live snapshots plus one for the array, or 0 if the blocks are not shared. */
 } tommy_arrayblk;
 
+/**
+ * Snapshot of the array content.
+ * \note Don't use internal fields directly, but access the container only using functions.
+ */
+typedef struct tommy_arrayblk_snapshot_struct {
+	tommy_array block; /**< Array of shared blocks. */
+	tommy_size_t count; /**< Number of elements in the snapshot. */
+	tommy_size_t* live; /**< Number of live snapshots shared with the array. */
+} tommy_arrayblk_snapshot;
+
 /**
  * Initializes the array.
  */
@@ -55,10 +84,32 @@ TOMMY_API void tommy_arrayblk_done(tommy_arrayblk* array);
  */
 TOMMY_API void tommy_arrayblk_grow(tommy_arrayblk* array, tommy_size_t size);
 
+/**
+ * Truncates the size down to the specified value.
+ * The removed elements are set to 0, but the memory is not freed.
+ * Call tommy_arrayblk_shrink() to free it.
+ * If the size is not smaller than the current one, nothing is done.
+ */
+TOMMY_API void tommy_arrayblk_truncate(tommy_arrayblk* array, tommy_size_t size);
+
+/**
+ * Frees the memory not required by the current size.
+ * The blocks after the last element are freed.
+ */
+TOMMY_API void tommy_arrayblk_shrink(tommy_arrayblk* array);
+
+/** \internal
+ * Ensures that the block containing the specified position is not shared with snapshots.
+ * The block is copied if any snapshot still refers to it.
+ * When all the snapshots are released, the array stops checking the blocks.
+ */
+TOMMY_API void tommy_arrayblk_unshare(tommy_arrayblk* array, tommy_size_t pos);
+
 /**
  * Gets a reference of the element at the specified position.
  * You must be sure that space for this position is already
  * allocated calling tommy_arrayblk_grow().
+ * If you use snapshots, don't modify the element with the reference, but use tommy_arrayblk_set().
  */
 tommy_inline void** tommy_arrayblk_ref(tommy_arrayblk* array, tommy_size_t pos)
 {
@@ -78,6 +129,9 @@ tommy_inline void** tommy_arrayblk_ref(tommy_arrayblk* array, tommy_size_t pos)
  */
 tommy_inline void tommy_arrayblk_set(tommy_arrayblk* array, tommy_size_t pos, void* element)
 {
+	if (array->live)
+		tommy_arrayblk_unshare(array, pos);
+
 	*tommy_arrayblk_ref(array, pos) = element;
 }
 
@@ -103,6 +157,32 @@ tommy_inline void tommy_arrayblk_insert(tommy_arrayblk* array, void* element)
 	tommy_arrayblk_set(array, pos, element);
 }
 
+/**
+ * Removes the last element of the array.
+ * The memory is not freed. Call tommy_arrayblk_shrink() to free it.
+ * The array must not be empty.
+ * \return The removed element.
+ */
+tommy_inline void* tommy_arrayblk_pop(tommy_arrayblk* array)
+{
+	void** ref;
+	void* element;
+
+	assert(array->count > 0);
+
+	if (array->live)
+		tommy_arrayblk_unshare(array, array->count - 1);
+
+	ref = tommy_arrayblk_ref(array, array->count - 1);
+	element = *ref;
+
+	/* keep the unused elements at 0, as expected by tommy_arrayblk_grow() */
+	*ref = 0;
+	--array->count;
+
+	return element;
+}
+
 /**
  * Gets the initialized size of the array.
  */
@@ -113,7 +193,53 @@ tommy_inline tommy_size_t tommy_arrayblk_size(tommy_arrayblk* array)
 
 /**
  * Gets the size of allocated memory.
+ * The blocks shared with snapshots are included.
  */
 TOMMY_API tommy_size_t tommy_arrayblk_memory_usage(tommy_arrayblk* array);
 
+/******************************************************************************/
+/* snapshot */
+
+/**
+ * Initializes a snapshot with the current content of the array.
+ * The blocks are shared and not copied, and the cost is proportional to the number of blocks.
+ * It must be called by the thread that modifies the array.
+ * The snapshot is independent from the array, that can be also deinitialized before it.
+ */
+TOMMY_API void tommy_arrayblk_snapshot_init(tommy_arrayblk_snapshot* snapshot, tommy_arrayblk* array);
+
+/**
+ * Deinitializes the snapshot.
+ * It can be called by any thread, also concurrently with changes to the array.
+ */
+TOMMY_API void tommy_arrayblk_snapshot_done(tommy_arrayblk_snapshot* snapshot);
+
+/**
+ * Gets the element at the specified position in the snapshot.
+ */
+tommy_inline void* tommy_arrayblk_snapshot_get(tommy_arrayblk_snapshot* snapshot, tommy_size_t pos)
+{
+	void** ptr;
+
+	assert(pos < snapshot->count);
+
+	ptr = tommy_cast(void**, tommy_array_get(&snapshot->block, pos / TOMMY_ARRAYBLK_SIZE));
+
+	return ptr[pos % TOMMY_ARRAYBLK_SIZE];
+}
+
+/**
+ * Gets the number of elements in the snapshot.
+ */
+tommy_inline tommy_size_t tommy_arrayblk_snapshot_size(tommy_arrayblk_snapshot* snapshot)
+{
+	return snapshot->count;
+}
+
+/**
+ * Gets the size of the memory used by the snapshot.
+ * The blocks shared with the array are not included.
+ */
+TOMMY_API tommy_size_t tommy_arrayblk_snapshot_memory_usage(tommy_arrayblk_snapshot* snapshot);
+
 #endif
@@ -2,6 +2,9 @@
 // Copyright (C) 2013 Andrea Mazzoleni
 
 #include "tommyarrayblkof.h"
+#include "tommyfileint.h"
+
+#include <string.h> /* for memset and memcpy */
 
 /******************************************************************************/
 /* array */
@@ -12,16 +15,92 @@ TOMMY_API void tommy_arrayblkof_init(tommy_arrayblkof* array, tommy_size_t eleme
 
 	array->element_size = element_size;
 	array->count = 0;
+	array->map = 0;
+	array->map_size = 0;
+	array->map_block = 0;
 }
 
 TOMMY_API void tommy_arrayblkof_done(tommy_arrayblkof* array)
 {
 	tommy_size_t i;
 
-	for (i = 0; i < tommy_array_size(&array->block); ++i)
+	/* the mapped blocks are not allocated */
+	for (i = array->map_block; i < tommy_array_size(&array->block); ++i)
 		tommy_free(tommy_array_get(&array->block, i));
 
 	tommy_array_done(&array->block);
+
+	if (array->map)
+		tommy_file_unmap(array->map, array->map_size);
+}
+
+TOMMY_API int tommy_arrayblkof_save(tommy_arrayblkof* array, const char* path)
+{
+	FILE* f;
+	tommy_size_t capacity;
+	tommy_size_t pos;
+	tommy_size_t size;
+
+	/* reserve the space up to the end of the last block, to map it when loading */
+	capacity = (array->count + TOMMY_ARRAYBLKOF_SIZE - 1) / TOMMY_ARRAYBLKOF_SIZE * TOMMY_ARRAYBLKOF_SIZE;
+
+	f = tommy_file_create(path, array->element_size, array->count, capacity);
+	if (!f)
+		return -1;
+
+	for (pos = 0; pos < array->count; pos += size) {
+		void* span = tommy_arrayblkof_span(array, pos, &size);
+
+		if (fwrite(span, array->element_size, size, f) != size) {
+			fclose(f);
+			return -1;
+		}
+	}
+
+	return tommy_file_close(f, array->count * array->element_size, capacity * array->element_size);
+}
+
+TOMMY_API int tommy_arrayblkof_map(tommy_arrayblkof* array, tommy_size_t element_size, const char* path, tommy_uint_t mode)
+{
+	unsigned char* map;
+	unsigned char* data;
+	tommy_size_t count;
+	tommy_size_t capacity;
+	tommy_size_t size;
+	tommy_size_t pos;
+	tommy_size_t i;
+
+	map = tommy_cast(unsigned char*, tommy_file_map(path, mode, element_size, &count, &capacity, &size));
+	if (!map)
+		return -1;
+
+	data = map + TOMMY_FILE_OFFSET;
+
+	tommy_arrayblkof_init(array, element_size);
+
+	/* map all the blocks contained in the file */
+	array->map_block = capacity / TOMMY_ARRAYBLKOF_SIZE;
+	tommy_array_grow(&array->block, array->map_block);
+	for (i = 0; i < array->map_block; ++i)
+		tommy_array_set(&array->block, i, data + i * TOMMY_ARRAYBLKOF_SIZE * element_size);
+
+	array->map = map;
+	array->map_size = size;
+	array->count = count < array->map_block * TOMMY_ARRAYBLKOF_SIZE ? count : array->map_block * TOMMY_ARRAYBLKOF_SIZE;
+
+	/* copy the elements after the mapped blocks */
+	pos = array->count;
+	tommy_arrayblkof_grow(array, count);
+	while (pos < count) {
+		tommy_size_t span_size;
+		void* span = tommy_arrayblkof_span(array, pos, &span_size);
+
+		memcpy(span, data + pos * element_size, span_size * element_size);
+
+		pos += span_size;
+	}
+
+	return 0;
 }
 
 TOMMY_API void tommy_arrayblkof_grow(tommy_arrayblkof* array, tommy_size_t count)
@@ -52,6 +131,114 @@ TOMMY_API void tommy_arrayblkof_grow(tommy_arrayblkof* array, tommy_size_t count
 	}
 }
 
+TOMMY_API void tommy_arrayblkof_truncate(tommy_arrayblkof* array, tommy_size_t count)
+{
+	tommy_size_t pos;
+
+	if (array->count <= count)
+		return;
+
+	/* clear the removed elements, as tommy_arrayblkof_grow() expects them at 0 */
+	pos = count;
+	while (pos < array->count) {
+		unsigned char* base = tommy_cast(unsigned char*, tommy_array_get(&array->block, pos / TOMMY_ARRAYBLKOF_SIZE));
+		tommy_size_t end = (pos / TOMMY_ARRAYBLKOF_SIZE + 1) * TOMMY_ARRAYBLKOF_SIZE;
+
+		if (end > array->count)
+			end = array->count;
+
+		memset(base + (pos % TOMMY_ARRAYBLKOF_SIZE) * array->element_size, 0, (end - pos) * array->element_size);
+
+		pos = end;
+	}
+
+	array->count = count;
+}
+
+TOMMY_API void tommy_arrayblkof_shrink(tommy_arrayblkof* array)
+{
+	tommy_size_t block_max;
+	tommy_size_t block_mac;
+
+	block_max = (array->count + TOMMY_ARRAYBLKOF_SIZE - 1) / TOMMY_ARRAYBLKOF_SIZE;
+	block_mac = tommy_array_size(&array->block);
+
+	/* the mapped blocks are not freed */
+	if (block_max < array->map_block)
+		block_max = array->map_block;
+
+	if (block_mac <= block_max)
+		return;
+
+	/* free the unused blocks */
+	while (block_mac > block_max) {
+		--block_mac;
+		tommy_free(tommy_array_get(&array->block, block_mac));
+	}
+
+	/* shrink the block array */
+	tommy_array_truncate(&array->block, block_max);
+	tommy_array_shrink(&array->block);
+}
+
+TOMMY_API void tommy_arrayblkof_pop(tommy_arrayblkof* array, void* element)
+{
+	void* ref;
+
+	assert(array->count > 0);
+
+	ref = tommy_arrayblkof_ref(array, array->count - 1);
+
+	if (element)
+		memcpy(element, ref, array->element_size);
+
+	/* keep the unused elements at 0, as expected by tommy_arrayblkof_grow() */
+	memset(ref, 0, array->element_size);
+	--array->count;
+}
+
+/**
+ * Context of the foreach jobs.
+ */
+struct tommy_arrayblkof_foreach_context {
+	tommy_arrayblkof* array;
+	tommy_span_func* func;
+	void* arg;
+};
+
+static void tommy_arrayblkof_foreach_job(void* void_context, tommy_size_t index)
+{
+	struct tommy_arrayblkof_foreach_context* context = tommy_cast(struct tommy_arrayblkof_foreach_context*, void_context);
+	tommy_size_t pos;
+	tommy_size_t size;
+	void* span;
+
+	pos = index * TOMMY_ARRAYBLKOF_SIZE;
+	span = tommy_arrayblkof_span(context->array, pos, &size);
+
+	context->func(context->arg, pos, span, size);
+}
+
+TOMMY_API void tommy_arrayblkof_foreach_parallel(tommy_arrayblkof* array, tommy_span_func* func, void* arg, tommy_parallel_func* parallel, void* parallel_arg)
+{
+	struct tommy_arrayblkof_foreach_context context;
+	tommy_size_t count;
+	tommy_size_t i;
+
+	context.array = array;
+	context.func = func;
+	context.arg = arg;
+
+	count = (array->count + TOMMY_ARRAYBLKOF_SIZE - 1) / TOMMY_ARRAYBLKOF_SIZE;
+
+	if (parallel) {
+		parallel(parallel_arg, tommy_arrayblkof_foreach_job, &context, count);
+	} else {
+		for (i = 0; i < count; ++i)
+			tommy_arrayblkof_foreach_job(&context, i);
+	}
+}
+
 TOMMY_API tommy_size_t tommy_arrayblkof_memory_usage(tommy_arrayblkof* array)
 {
 	return tommy_array_memory_usage(&array->block) + tommy_array_size(&array->block) * TOMMY_ARRAYBLKOF_SIZE * array->element_size;
@@ -19,6 +19,7 @@
 
 #include "tommytypes.h"
 #include "tommyarray.h"
+#include "tommyfile.h"
 
 #include <assert.h> /* for assert */
 
@@ -38,6 +39,9 @@ typedef struct tommy_arrayblkof_struct {
 	tommy_array block; /**< Array of blocks. */
 	tommy_size_t element_size; /**< Size of the stored element in bytes. */
 	tommy_size_t count; /**< Number of initialized elements in the array. */
+	void* map; /**< Mapped file, or 0 if not mapped. */
+	tommy_size_t map_size; /**< Size of the mapped file. */
+	tommy_size_t map_block; /**< Number of blocks in the mapped file. */
 } tommy_arrayblkof;
 
 /**
@@ -51,12 +55,58 @@ TOMMY_API void tommy_arrayblkof_init(tommy_arrayblkof* array, tommy_size_t eleme
  */
 TOMMY_API void tommy_arrayblkof_done(tommy_arrayblkof* array);
 
+/**
+ * Saves the array in a file, that can be later mapped with tommy_arrayblkof_map().
+ * The file contains a header and all the elements in a contiguous vector,
+ * followed by a hole up to the end of the last block.
+ * \param path Path of the file to create.
+ * \return 0 on success, or -1 on error.
+ */
+TOMMY_API int tommy_arrayblkof_save(tommy_arrayblkof* array, const char* path);
+
+/**
+ * Initializes the array mapping a file saved with tommy_arrayblkof_save().
+ * The elements are used directly from the mapped file, without reading them,
+ * and the pages are loaded by the operating system on the first access.
+ * The header of the file is validated, including the element size.
+ * After mapping, the array can grow normally, allocating new blocks in memory.
+ * Call tommy_arrayblkof_done() to unmap the file.
+ * \param element_size Size in bytes of the element stored in the file.
+ * \param path Path of the file to map.
+ * \param mode One of ::TOMMY_MAP_READONLY or ::TOMMY_MAP_PRIVATE.
+ * With ::TOMMY_MAP_READONLY you must not change the mapped elements, nor truncate or pop them.
+ * \return 0 on success, or -1 on error. On error the array is not initialized.
+ */
+TOMMY_API int tommy_arrayblkof_map(tommy_arrayblkof* array, tommy_size_t element_size, const char* path, tommy_uint_t mode);
+
 /**
  * Grows the size up to the specified value.
  * All the new elements in the array are initialized with the 0 value.
  */
 TOMMY_API void tommy_arrayblkof_grow(tommy_arrayblkof* array, tommy_size_t size);
 
+/**
+ * Truncates the size down to the specified value.
+ * The removed elements are set to 0, but the memory is not freed.
+ * Call tommy_arrayblkof_shrink() to free it.
+ * If the size is not smaller than the current one, nothing is done.
+ */
+TOMMY_API void tommy_arrayblkof_truncate(tommy_arrayblkof* array, tommy_size_t size);
+
+/**
+ * Frees the memory not required by the current size.
+ * The blocks after the last element are freed.
+ */
+TOMMY_API void tommy_arrayblkof_shrink(tommy_arrayblkof* array);
+
+/**
+ * Removes the last element of the array.
+ * The memory is not freed. Call tommy_arrayblkof_shrink() to free it.
+ * The array must not be empty.
+ * \param element Where to copy the removed element. It can be 0 if not required.
+ */
+TOMMY_API void tommy_arrayblkof_pop(tommy_arrayblkof* array, void* element);
+
 /**
  * Gets a reference of the element at the specified position.
  * You must be sure that space for this position is already
@@ -73,6 +123,52 @@ tommy_inline void* tommy_arrayblkof_ref(tommy_arrayblkof* array, tommy_size_t po
 	return base + (pos % TOMMY_ARRAYBLKOF_SIZE) * array->element_size;
 }
 
+/**
+ * Gets the span of contiguous elements starting at the specified position.
+ * The span ends at the end of the block containing the position, or at
+ * the end of the array.
+ *
+ * To process all the elements with a tight loop, that the compiler is able to vectorize:
+ * \code
+ * tommy_size_t pos, size;
+ * for (pos = 0; pos < tommy_arrayblkof_size(&array); pos += size) {
+ *     struct object* obj = tommy_arrayblkof_span(&array, pos, &size);
+ *     for (i = 0; i < size; ++i)
+ *         sum += obj[i].value;
+ * }
+ * \endcode
+ * \param pos Position of the first element of the span.
+ * \param size Where the number of elements in the span is stored.
+ * \return Pointer to the element at the specified position.
+ */
+tommy_inline void* tommy_arrayblkof_span(tommy_arrayblkof* array, tommy_size_t pos, tommy_size_t* size)
+{
+	tommy_size_t end;
+
+	assert(pos < array->count);
+
+	end = (pos / TOMMY_ARRAYBLKOF_SIZE + 1) * TOMMY_ARRAYBLKOF_SIZE;
+	if (end > array->count)
+		end = array->count;
+
+	*size = end - pos;
+
+	return tommy_arrayblkof_ref(array, pos);
+}
+
+/**
+ * Calls the specified function for all the blocks, using multiple threads.
+ * Every block is processed by a different job, calling the function once
+ * with all the elements of the block. The jobs may run concurrently in any order.
+ *
+ * You cannot grow or shrink the array from the inside of the callback.
+ * \param func Function called for each span.
+ * \param arg Argument passed to the function.
+ * \param parallel Parallel function used to run the jobs. If 0, all the jobs are run in the calling thread.
+ * \param parallel_arg Argument passed to the parallel function.
+ */
+TOMMY_API void tommy_arrayblkof_foreach_parallel(tommy_arrayblkof* array, tommy_span_func* func, void* arg, tommy_parallel_func* parallel, void* parallel_arg);
+
 /**
  * Gets the initialized size of the array.
  */
@@ -2,6 +2,9 @@
 // Copyright (C) 2013 Andrea Mazzoleni
 
 #include "tommyarrayof.h"
+#include "tommyfileint.h"
+
+#include <string.h> /* for memset and memcpy */
 
 /******************************************************************************/
 /* array */
@@ -19,17 +22,106 @@ TOMMY_API void tommy_arrayof_init(tommy_arrayof* array, tommy_size_t element_siz
 		array->bucket[i] = array->bucket[0];
 
 	array->count = 0;
+	array->map = 0;
+	array->map_size = 0;
+	array->map_bit = 0;
 }
 
 TOMMY_API void tommy_arrayof_done(tommy_arrayof* array)
 {
 	tommy_uint_t i;
 
-	tommy_free(array->bucket[0]);
-	for (i = TOMMY_ARRAYOF_BIT; i < array->bucket_bit; ++i) {
+	/* the mapped segments are not allocated */
+	if (array->map_bit == 0) {
+		tommy_free(array->bucket[0]);
+		i = TOMMY_ARRAYOF_BIT;
+	} else {
+		i = array->map_bit;
+	}
+
+	for (; i < array->bucket_bit; ++i) {
 		unsigned char* segment = tommy_cast(unsigned char*, array->bucket[i]);
 		tommy_free(segment + ((tommy_ptrdiff_t)1 << i) * array->element_size);
 	}
+
+	if (array->map)
+		tommy_file_unmap(array->map, array->map_size);
+}
+
+TOMMY_API int tommy_arrayof_save(tommy_arrayof* array, const char* path)
+{
+	FILE* f;
+	tommy_size_t pos;
+	tommy_size_t size;
+
+	/* reserve the space of all the segments, to map them when loading */
+	f = tommy_file_create(path, array->element_size, array->count, array->bucket_max);
+	if (!f)
+		return -1;
+
+	for (pos = 0; pos < array->count; pos += size) {
+		void* span = tommy_arrayof_span(array, pos, &size);
+
+		if (fwrite(span, array->element_size, size, f) != size) {
+			fclose(f);
+			return -1;
+		}
+	}
+
+	return tommy_file_close(f, array->count * array->element_size, array->bucket_max * array->element_size);
+}
+
+TOMMY_API int tommy_arrayof_map(tommy_arrayof* array, tommy_size_t element_size, const char* path, tommy_uint_t mode)
+{
+	unsigned char* map;
+	unsigned char* data;
+	tommy_size_t count;
+	tommy_size_t capacity;
+	tommy_size_t size;
+	tommy_size_t pos;
+	tommy_uint_t i;
+
+	map = tommy_cast(unsigned char*, tommy_file_map(path, mode, element_size, &count, &capacity, &size));
+	if (!map)
+		return -1;
+
+	data = map + TOMMY_FILE_OFFSET;
+
+	/* if there isn't space for the first segment, copy it */
+	if (capacity < (tommy_size_t)1 << TOMMY_ARRAYOF_BIT) {
+		tommy_arrayof_init(array, element_size);
+		tommy_arrayof_grow(array, count);
+		memcpy(array->bucket[0], data, count * element_size);
+		tommy_file_unmap(map, size);
+		return 0;
+	}
+
+	/* map all the segments contained in the file */
+	/* as the elements are contiguous, all the segments point at the start */
+	array->element_size = element_size;
+	array->bucket_bit = tommy_ilog2(capacity);
+	array->bucket_max = (tommy_size_t)1 << array->bucket_bit;
+	for (i = 0; i < array->bucket_bit; ++i)
+		array->bucket[i] = data;
+
+	array->map = map;
+	array->map_size = size;
+	array->map_bit = array->bucket_bit;
+	array->count = count < array->bucket_max ? count : array->bucket_max;
+
+	/* copy the elements after the mapped segments */
+	pos = array->count;
+	tommy_arrayof_grow(array, count);
+	while (pos < count) {
+		tommy_size_t span_size;
+		void* span = tommy_arrayof_span(array, pos, &span_size);
+
+		memcpy(span, data + pos * element_size, span_size * element_size);
+
+		pos += span_size;
+	}
+
+	return 0;
 }
 
 TOMMY_API void tommy_arrayof_grow(tommy_arrayof* array, tommy_size_t count)
@@ -53,6 +145,121 @@ TOMMY_API void tommy_arrayof_grow(tommy_arrayof* array, tommy_size_t count)
 	}
 }
 
+TOMMY_API void tommy_arrayof_truncate(tommy_arrayof* array, tommy_size_t count)
+{
+	tommy_size_t pos;
+
+	if (array->count <= count)
+		return;
+
+	/* clear the removed elements, as tommy_arrayof_grow() expects them at 0 */
+	pos = count;
+	while (pos < array->count) {
+		tommy_uint_t bsr = tommy_ilog2(pos | 1);
+		unsigned char* ptr = tommy_cast(unsigned char*, array->bucket[bsr]);
+		tommy_size_t end;
+
+		/* end of the segment, the first one contains all the initial buckets */
+		if (bsr < TOMMY_ARRAYOF_BIT)
+			end = (tommy_size_t)1 << TOMMY_ARRAYOF_BIT;
+		else
+			end = (tommy_size_t)1 << (bsr + 1);
+		if (end > array->count)
+			end = array->count;
+
+		memset(ptr + pos * array->element_size, 0, (end - pos) * array->element_size);
+
+		pos = end;
+	}
+
+	array->count = count;
+}
+
+TOMMY_API void tommy_arrayof_shrink(tommy_arrayof* array)
+{
+	/* free the last segment while it's not used, but not the mapped ones */
+	while (array->bucket_bit > TOMMY_ARRAYOF_BIT && array->bucket_bit > array->map_bit && array->count <= array->bucket_max / 2) {
+		unsigned char* segment;
+
+		--array->bucket_bit;
+		array->bucket_max = (tommy_size_t)1 << array->bucket_bit;
+
+		segment = tommy_cast(unsigned char*, array->bucket[array->bucket_bit]);
+		tommy_free(segment + ((tommy_ptrdiff_t)1 << array->bucket_bit) * array->element_size);
+	}
+}
+
+TOMMY_API void tommy_arrayof_pop(tommy_arrayof* array, void* element)
+{
+	void* ref;
+
+	assert(array->count > 0);
+
+	ref = tommy_arrayof_ref(array, array->count - 1);
+
+	if (element)
+		memcpy(element, ref, array->element_size);
+
+	/* keep the unused elements at 0, as expected by tommy_arrayof_grow() */
+	memset(ref, 0, array->element_size);
+	--array->count;
+}
+
+/**
+ * Context of the foreach jobs.
+ */
+struct tommy_arrayof_foreach_context {
+	tommy_arrayof* array;
+	tommy_span_func* func;
+	void* arg;
+};
+
+static void tommy_arrayof_foreach_job(void* void_context, tommy_size_t index)
+{
+	struct tommy_arrayof_foreach_context* context = tommy_cast(struct tommy_arrayof_foreach_context*, void_context);
+	tommy_arrayof* array = context->array;
+	tommy_size_t pos;
+	tommy_size_t end;
+
+	pos = index * TOMMY_ARRAYOF_JOB;
+	end = pos + TOMMY_ARRAYOF_JOB;
+	if (end > array->count)
+		end = array->count;
+
+	while (pos < end) {
+		tommy_size_t size;
+		void* span = tommy_arrayof_span(array, pos, &size);
+
+		/* don't go over the range of the job */
+		if (size > end - pos)
+			size = end - pos;
+
+		context->func(context->arg, pos, span, size);
+
+		pos += size;
+	}
+}
+
+TOMMY_API void tommy_arrayof_foreach_parallel(tommy_arrayof* array, tommy_span_func* func, void* arg, tommy_parallel_func* parallel, void* parallel_arg)
+{
+	struct tommy_arrayof_foreach_context context;
+	tommy_size_t count;
+	tommy_size_t i;
+
+	context.array = array;
+	context.func = func;
+	context.arg = arg;
+
+	count = (array->count + TOMMY_ARRAYOF_JOB - 1) / TOMMY_ARRAYOF_JOB;
+
+	if (parallel) {
+		parallel(parallel_arg, tommy_arrayof_foreach_job, &context, count);
+	} else {
+		for (i = 0; i < count; ++i)
+			tommy_arrayof_foreach_job(&context, i);
+	}
+}
+
 TOMMY_API tommy_size_t tommy_arrayof_memory_usage(tommy_arrayof* array)
 {
 	return array->bucket_max * (tommy_size_t)array->element_size;
@@ -18,6 +18,7 @@
 #define __TOMMYARRAYOF_H
 
 #include "tommytypes.h"
+#include "tommyfile.h"
 
 #include <assert.h> /* for assert */
 
@@ -30,6 +31,11 @@
  */
 #define TOMMY_ARRAYOF_BIT 6
 
+/**
+ * Number of elements processed by each job of tommy_arrayof_foreach_parallel().
+ */
+#define TOMMY_ARRAYOF_JOB (4 * 1024)
+
 /**
  * Array container type.
  * \note Don't use internal fields directly, but access the container only using functions.
@@ -39,7 +45,10 @@ typedef struct tommy_arrayof_struct {
 	tommy_size_t element_size; /**< Size of the stored element in bytes. */
 	tommy_size_t bucket_max; /**< Number of buckets. */
 	tommy_size_t count; /**< Number of initialized elements in the array. */
+	void* map; /**< Mapped file, or 0 if not mapped. */
+	tommy_size_t map_size; /**< Size of the mapped file. */
 	tommy_uint_t bucket_bit; /**< Bits used in the bit mask. */
+	tommy_uint_t map_bit; /**< Bits of the segments in the mapped file, or 0 if not mapped. */
 } tommy_arrayof;
 
 /**
@@ -54,6 +63,32 @@ TOMMY_API void tommy_arrayof_init(tommy_arrayof* array, tommy_size_t element_siz
  */
 TOMMY_API void tommy_arrayof_done(tommy_arrayof* array);
 
+/**
+ * Saves the array in a file, that can be later mapped with tommy_arrayof_map().
+ * The file contains a header and all the elements in a contiguous vector,
+ * followed by a hole up to the allocated size of the array.
+ * \param array Array to save.
+ * \param path Path of the file to create.
+ * \return 0 on success, or -1 on error.
+ */
+TOMMY_API int tommy_arrayof_save(tommy_arrayof* array, const char* path);
+
+/**
+ * Initializes the array mapping a file saved with tommy_arrayof_save().
+ * The elements are used directly from the mapped file, without reading them,
+ * and the pages are loaded by the operating system on the first access.
+ * The header of the file is validated, including the element size.
+ * After mapping, the array can grow normally, allocating new segments in memory.
+ * Call tommy_arrayof_done() to unmap the file.
+ * \param array Array to initialize.
+ * \param element_size Size in bytes of the element stored in the file.
+ * \param path Path of the file to map.
+ * \param mode One of ::TOMMY_MAP_READONLY or ::TOMMY_MAP_PRIVATE.
+ * With ::TOMMY_MAP_READONLY you must not change the mapped elements, nor truncate or pop them.
+ * \return 0 on success, or -1 on error. On error the array is not initialized.
+ */
+TOMMY_API int tommy_arrayof_map(tommy_arrayof* array, tommy_size_t element_size, const char* path, tommy_uint_t mode);
+
 /**
  * Grows the size up to the specified value.
  * All the new elements in the array are initialized with the 0 value.
@@ -62,6 +97,28 @@ TOMMY_API void tommy_arrayof_done(tommy_arrayof* array);
  */
 TOMMY_API void tommy_arrayof_grow(tommy_arrayof* array, tommy_size_t size);
 
+/**
+ * Truncates the size down to the specified value.
+ * The removed elements are set to 0, but the memory is not freed.
+ * Call tommy_arrayof_shrink() to free it.
+ * If the size is not smaller than the current one, nothing is done.
+ */
+TOMMY_API void tommy_arrayof_truncate(tommy_arrayof* array, tommy_size_t size);
+
+/**
+ * Frees the memory not required by the current size.
+ * The segments after the last element are freed, down to the initial size.
+ */
+TOMMY_API void tommy_arrayof_shrink(tommy_arrayof* array);
+
+/**
+ * Removes the last element of the array.
+ * The memory is not freed. Call tommy_arrayof_shrink() to free it.
+ * The array must not be empty.
+ * \param element Where to copy the removed element. It can be 0 if not required.
+ */
+TOMMY_API void tommy_arrayof_pop(tommy_arrayof* array, void* element);
+
 /**
  * Gets a reference of the element at the specified position.
  * You must be sure that space for this position is already
@@ -84,6 +141,60 @@ tommy_inline void* tommy_arrayof_ref(tommy_arrayof* array, tommy_size_t pos)
 	return ptr + pos * array->element_size;
 }
 
+/**
+ * Gets the span of contiguous elements starting at the specified position.
+ * The span ends at the end of the segment containing the position, or at
+ * the end of the array.
+ *
+ * To process all the elements with a tight loop, that the compiler is able to vectorize:
+ * \code
+ * tommy_size_t pos, size;
+ * for (pos = 0; pos < tommy_arrayof_size(&array); pos += size) {
+ *     struct object* obj = tommy_arrayof_span(&array, pos, &size);
+ *     for (i = 0; i < size; ++i)
+ *         sum += obj[i].value;
+ * }
+ * \endcode
+ * \param pos Position of the first element of the span.
+ * \param size Where the number of elements in the span is stored.
+ * \return Pointer to the element at the specified position.
+ */
+tommy_inline void* tommy_arrayof_span(tommy_arrayof* array, tommy_size_t pos, tommy_size_t* size)
+{
+	tommy_uint_t bsr;
+	tommy_size_t end;
+
+	assert(pos < array->count);
+
+	bsr = tommy_ilog2(pos | 1);
+
+	/* end of the segment, the first one contains all the initial buckets */
+	if (bsr < TOMMY_ARRAYOF_BIT)
+		end = (tommy_size_t)1 << TOMMY_ARRAYOF_BIT;
+	else
+		end = (tommy_size_t)1 << (bsr + 1);
+	if (end > array->count)
+		end = array->count;
+
+	*size = end - pos;
+
+	return tommy_cast(unsigned char*, array->bucket[bsr]) + pos * array->element_size;
+}
+
+/**
+ * Calls the specified function for all the spans of contiguous elements, using multiple threads.
+ * The array is split in jobs of TOMMY_ARRAYOF_JOB elements, and every job calls
+ * the function for the spans in its range. The spans are passed in order
+ * inside a job, but the jobs may run concurrently in any order.
+ *
+ * You cannot grow or shrink the array from the inside of the callback.
+ * \param func Function called for each span.
+ * \param arg Argument passed to the function.
+ * \param parallel Parallel function used to run the jobs. If 0, all the jobs are run in the calling thread.
+ * \param parallel_arg Argument passed to the parallel function.
+ */
+TOMMY_API void tommy_arrayof_foreach_parallel(tommy_arrayof* array, tommy_span_func* func, void* arg, tommy_parallel_func* parallel, void* parallel_arg);
+
 /**
  * Gets the initialized size of the array.
  * \param array Array to query.
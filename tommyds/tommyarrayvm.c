@@ -0,0 +1,194 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+#include "tommyarrayvm.h"
+
+#include <string.h> /* for memset */
+#include <assert.h> /* for assert */
+
+#if defined(_WIN32)
+#include <windows.h> /* for VirtualAlloc */
+#define TOMMY_ARRAYVM_WINDOWS
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h> /* for mmap */
+#define TOMMY_ARRAYVM_MMAP
+#if !defined(MAP_ANONYMOUS) && defined(MAP_ANON)
+#define MAP_ANONYMOUS MAP_ANON
+#endif
+#endif
+
+/******************************************************************************/
+/* arrayvm */
+
+/**
+ * Rounds up the size in bytes to the commit granularity.
+ */
+static tommy_size_t arrayvm_page(tommy_size_t size)
+{
+	return (size + TOMMY_ARRAYVM_PAGE - 1) & ~(tommy_size_t)(TOMMY_ARRAYVM_PAGE - 1);
+}
+
+TOMMY_API int tommy_arrayvm_init(tommy_arrayvm* array, tommy_size_t size)
+{
+	void* base;
+
+	/* the size in bytes, and its rounding to pages, must not overflow */
+	if (size > ((tommy_size_t)-1 - TOMMY_ARRAYVM_PAGE) / sizeof(void*))
+		return -1;
+
+	/* at least one page to always have a valid base */
+	array->reserve = arrayvm_page(size * sizeof(void*));
+	if (array->reserve == 0)
+		array->reserve = TOMMY_ARRAYVM_PAGE;
+
+#if defined(TOMMY_ARRAYVM_WINDOWS)
+	base = VirtualAlloc(0, array->reserve, MEM_RESERVE, PAGE_NOACCESS);
+	if (base == 0)
+		return -1;
+	array->commit = 0;
+#elif defined(TOMMY_ARRAYVM_MMAP)
+#ifdef MAP_NORESERVE
+	base = mmap(0, array->reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+#else
+	base = mmap(0, array->reserve, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+#endif
+	if (base == MAP_FAILED)
+		return -1;
+	array->commit = 0;
+#else
+	base = tommy_calloc(array->reserve, 1);
+	if (base == 0)
+		return -1;
+	array->commit = array->reserve;
+#endif
+
+	array->base = tommy_cast(void**, base);
+	array->count = 0;
+
+	return 0;
+}
+
+TOMMY_API void tommy_arrayvm_done(tommy_arrayvm* array)
+{
+#if defined(TOMMY_ARRAYVM_WINDOWS)
+	VirtualFree(array->base, 0, MEM_RELEASE);
+#elif defined(TOMMY_ARRAYVM_MMAP)
+	munmap(array->base, array->reserve);
+#else
+	tommy_free(array->base);
+#endif
+}
+
+TOMMY_API void tommy_arrayvm_grow(tommy_arrayvm* array, tommy_size_t count)
+{
+	tommy_size_t commit;
+
+	if (array->count >= count)
+		return;
+
+	assert(count <= array->reserve / sizeof(void*));
+
+	array->count = count;
+
+	commit = arrayvm_page(count * sizeof(void*));
+	if (commit <= array->commit)
+		return;
+
+#if defined(TOMMY_ARRAYVM_WINDOWS)
+	{
+		void* base = array->base;
+		void* ptr;
+
+		/* committed pages are zeroed on the first access */
+		ptr = VirtualAlloc(tommy_cast(unsigned char*, base) + array->commit, commit - array->commit, MEM_COMMIT, PAGE_READWRITE);
+		assert(ptr != 0);
+		(void)ptr;
+	}
+#endif
+
+	/* with mmap the pages are committed by the kernel on the first touch */
+	array->commit = commit;
+}
+
+TOMMY_API void tommy_arrayvm_truncate(tommy_arrayvm* array, tommy_size_t count)
+{
+#if defined(TOMMY_ARRAYVM_WINDOWS) || defined(TOMMY_ARRAYVM_MMAP)
+	void* base = array->base;
+	tommy_size_t begin;
+	tommy_size_t page;
+	tommy_size_t end;
+	unsigned char* ptr;
+#endif
+
+	if (array->count <= count)
+		return;
+
+	/* the removed elements must be cleared, as tommy_arrayvm_grow() expects them at 0 */
+#if defined(TOMMY_ARRAYVM_WINDOWS) || defined(TOMMY_ARRAYVM_MMAP)
+	/* clear with memset() only the first partial page, and release the whole pages, */
+	/* that are read back as 0, to avoid to commit the pages never accessed */
+	begin = count * sizeof(void*);
+	page = arrayvm_page(begin);
+	end = array->count * sizeof(void*);
+
+	if (page > end)
+		page = end;
+	memset(&array->base[count], 0, page - begin);
+
+	end = arrayvm_page(end);
+	if (page < end) {
+		ptr = tommy_cast(unsigned char*, base) + page;
+#if defined(TOMMY_ARRAYVM_WINDOWS)
+		/* decommit and commit again, without accessing them the pages are not allocated */
+		VirtualFree(ptr, end - page, MEM_DECOMMIT);
+		ptr = tommy_cast(unsigned char*, VirtualAlloc(ptr, end - page, MEM_COMMIT, PAGE_READWRITE));
+		assert(ptr != 0);
+#elif defined(__linux) && defined(MADV_DONTNEED)
+		/* in Linux the private anonymous pages are read back as 0 */
+		madvise(ptr, end - page, MADV_DONTNEED);
+#else
+		/* other systems may keep the old content with MADV_DONTNEED, so map new pages */
+		ptr = tommy_cast(unsigned char*, mmap(ptr, end - page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0));
+		assert(ptr != MAP_FAILED);
+#endif
+		(void)ptr;
+	}
+#else
+	memset(&array->base[count], 0, (array->count - count) * sizeof(void*));
+#endif
+
+	array->count = count;
+}
+
+TOMMY_API void tommy_arrayvm_shrink(tommy_arrayvm* array)
+{
+#if defined(TOMMY_ARRAYVM_WINDOWS) || defined(TOMMY_ARRAYVM_MMAP)
+	void* base = array->base;
+	tommy_size_t commit;
+	unsigned char* ptr;
+
+	commit = arrayvm_page(array->count * sizeof(void*));
+	if (commit >= array->commit)
+		return;
+
+	ptr = tommy_cast(unsigned char*, base) + commit;
+
+	/* the released pages contain only 0, so it doesn't matter */
+	/* if the system reads them back as 0 or with the old content */
+#if defined(TOMMY_ARRAYVM_WINDOWS)
+	VirtualFree(ptr, array->commit - commit, MEM_DECOMMIT);
+#elif defined(MADV_DONTNEED)
+	madvise(ptr, array->commit - commit, MADV_DONTNEED);
+#endif
+
+	array->commit = commit;
+#else
+	/* nothing to release, as the whole range is allocated */
+	(void)array;
+#endif
+}
+
+TOMMY_API tommy_size_t tommy_arrayvm_memory_usage(tommy_arrayvm* array)
+{
+	return array->commit;
+}
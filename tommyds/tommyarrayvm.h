@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+/** \file
+ * Dynamic array based on a single reserved range of virtual memory.
+ *
+ * This array reserves at initialization a contiguous range of virtual memory
+ * large enough for the maximum number of elements, without using any
+ * physical memory. The pages are then committed lazily.
+ *
+ * Compared to ::tommy_array, the access is a plain index in a contiguous vector,
+ * without the segment lookup, and the grow operation doesn't zero the memory
+ * eagerly. The zero fill cost is moved to the first access of every page,
+ * where the operating system provides a zeroed page.
+ * The address of the stored elements never change.
+ *
+ * On POSIX systems the range is reserved with mmap() and the pages are committed
+ * by the kernel on the first touch. On Windows the range is reserved with VirtualAlloc()
+ * and committed by tommy_arrayvm_grow(). On other systems the whole range is
+ * allocated with tommy_calloc().
+ *
+ * The maximum number of elements is fixed at initialization, and it cannot be
+ * changed later.
+ */
+
+#ifndef __TOMMYARRAYVM_H
+#define __TOMMYARRAYVM_H
+
+#include "tommytypes.h"
+
+#include <assert.h> /* for assert */
+
+/******************************************************************************/
+/* arrayvm */
+
+/**
+ * Granularity in bytes of the memory committed and released.
+ * It's a multiple of the page size of all the supported systems.
+ */
+#define TOMMY_ARRAYVM_PAGE 65536
+
+/**
+ * Array container type.
+ * \note Don't use internal fields directly, but access the container only using functions.
+ */
+typedef struct tommy_arrayvm_struct {
+	void** base; /**< Reserved range of memory. */
+	tommy_size_t reserve; /**< Size in bytes of the reserved range. */
+	tommy_size_t commit; /**< Size in bytes of the committed range. */
+	tommy_size_t count; /**< Number of initialized elements in the array. */
+} tommy_arrayvm;
+
+/**
+ * Initializes the array.
+ * \param size Maximum number of elements. Only the virtual memory is reserved.
+ * \return 0 on success, or -1 on error. On error the array is not initialized.
+ */
+TOMMY_API int tommy_arrayvm_init(tommy_arrayvm* array, tommy_size_t size);
+
+/**
+ * Deinitializes the array.
+ */
+TOMMY_API void tommy_arrayvm_done(tommy_arrayvm* array);
+
+/**
+ * Grows the size up to the specified value.
+ * All the new elements in the array are initialized with the 0 value.
+ * The size cannot exceed the maximum specified at initialization.
+ */
+TOMMY_API void tommy_arrayvm_grow(tommy_arrayvm* array, tommy_size_t size);
+
+/**
+ * Truncates the size down to the specified value.
+ * The removed elements are set to 0, releasing the whole pages to the operating system,
+ * but the memory remains accounted by tommy_arrayvm_memory_usage().
+ * Call tommy_arrayvm_shrink() to also decommit it.
+ * If the size is not smaller than the current one, nothing is done.
+ */
+TOMMY_API void tommy_arrayvm_truncate(tommy_arrayvm* array, tommy_size_t size);
+
+/**
+ * Frees the memory not required by the current size.
+ * The pages after the last element are returned to the operating system,
+ * keeping the virtual memory reserved.
+ */
+TOMMY_API void tommy_arrayvm_shrink(tommy_arrayvm* array);
+
+/**
+ * Gets a reference of the element at the specified position.
+ * You must be sure that space for this position is already
+ * allocated calling tommy_arrayvm_grow().
+ */
+tommy_inline void** tommy_arrayvm_ref(tommy_arrayvm* array, tommy_size_t pos)
+{
+	assert(pos < array->count);
+
+	return &array->base[pos];
+}
+
+/**
+ * Sets the element at the specified position.
+ * You must be sure that space for this position is already
+ * allocated calling tommy_arrayvm_grow().
+ */
+tommy_inline void tommy_arrayvm_set(tommy_arrayvm* array, tommy_size_t pos, void* element)
+{
+	*tommy_arrayvm_ref(array, pos) = element;
+}
+
+/**
+ * Gets the element at the specified position.
+ * You must be sure that space for this position is already
+ * allocated calling tommy_arrayvm_grow().
+ */
+tommy_inline void* tommy_arrayvm_get(tommy_arrayvm* array, tommy_size_t pos)
+{
+	return *tommy_arrayvm_ref(array, pos);
+}
+
+/**
+ * Grows and inserts a new element at the end of the array.
+ */
+tommy_inline void tommy_arrayvm_insert(tommy_arrayvm* array, void* element)
+{
+	tommy_size_t pos = array->count;
+
+	tommy_arrayvm_grow(array, pos + 1);
+
+	tommy_arrayvm_set(array, pos, element);
+}
+
+/**
+ * Removes the last element of the array.
+ * The memory is not freed. Call tommy_arrayvm_shrink() to free it.
+ * The array must not be empty.
+ * \return The removed element.
+ */
+tommy_inline void* tommy_arrayvm_pop(tommy_arrayvm* array)
+{
+	void** ref;
+	void* element;
+
+	assert(array->count > 0);
+
+	ref = tommy_arrayvm_ref(array, array->count - 1);
+	element = *ref;
+
+	/* keep the unused elements at 0, as expected by tommy_arrayvm_grow() */
+	*ref = 0;
+	--array->count;
+
+	return element;
+}
+
+/**
+ * Gets the initialized size of the array.
+ */
+tommy_inline tommy_size_t tommy_arrayvm_size(tommy_arrayvm* array)
+{
+	return array->count;
+}
+
+/**
+ * Gets the size of committed memory.
+ * On POSIX systems it's an upper bound, as the pages never touched don't use any memory.
+ */
+TOMMY_API tommy_size_t tommy_arrayvm_memory_usage(tommy_arrayvm* array);
+
+#endif
@@ -62,8 +62,90 @@ tommy_inline void tommy_chain_concat(tommy_node* first_tail, tommy_node* second_
 	first_tail->next = second_head;
 }
 
+/**
+ * Number of consecutive nodes taken from the same chain before switching to galloping.
+ */
+#define TOMMY_CHAIN_GALLOP 7
+
+/** \internal
+ * Checks if a node of a chain has to be placed before the specified object.
+ * For the first chain equal nodes are placed before, for the second after,
+ * to keep the sort stable.
+ */
+tommy_inline int tommy_chain_before(tommy_node* node, void* data, int second, tommy_compare_func* cmp)
+{
+	if (second)
+		return cmp(data, node->data) > 0;
+	return cmp(node->data, data) <= 0;
+}
+
+/**
+ * Max distance of the probes in the galloping.
+ */
+#define TOMMY_CHAIN_GALLOP_MAX 64
+
+/**
+ * Gallops in a chain.
+ * Searches the last node of the chain that has to be placed before the specified object,
+ * probing nodes at exponentially growing distances, and then bisecting the last interval.
+ * It's the linked list adaptation of the TimSort galloping. The nodes are still visited
+ * one by one, but only O(log(N)) of them are compared.
+ * The nodes of the last interval are kept in a small vector, to bisect it without walking
+ * the chain again, and for this reason the distance of the probes is limited to TOMMY_CHAIN_GALLOP_MAX.
+ * \param node First node of the search. It must be placed before the object.
+ * \param tail Tail of the chain.
+ * \param data Object to compare.
+ * \param second If the node is in the second chain of the merge.
+ * \param cmp Comparison function.
+ * \return The last node to place before the object.
+ */
+tommy_inline tommy_node* tommy_chain_gallop(tommy_node* node, tommy_node* tail, void* data, int second, tommy_compare_func* cmp)
+{
+	tommy_node* interval[TOMMY_CHAIN_GALLOP_MAX];
+	tommy_size_t step = 1;
+
+	while (node != tail) {
+		tommy_node* probe = node;
+		tommy_size_t lower;
+		tommy_size_t upper;
+
+		/* advance of step nodes, stopping at the tail */
+		upper = 0;
+		while (upper < step && probe != tail) {
+			probe = probe->next;
+			interval[upper++] = probe;
+		}
+
+		if (tommy_chain_before(probe, data, second, cmp)) {
+			node = probe;
+			if (step < TOMMY_CHAIN_GALLOP_MAX)
+				step *= 2;
+			continue;
+		}
+
+		/* bisect, here node (at 0) is before and probe (at upper) is not */
+		lower = 0;
+		while (upper - lower > 1) {
+			tommy_size_t mid = (lower + upper) / 2;
+
+			if (tommy_chain_before(interval[mid - 1], data, second, cmp))
+				lower = mid;
+			else
+				upper = mid;
+		}
+
+		if (lower)
+			node = interval[lower - 1];
+		break;
+	}
+
+	return node;
+}
+
 /**
  * Merges two chains.
+ * After TOMMY_CHAIN_GALLOP consecutive nodes taken from the same chain, it switches
+ * to galloping with tommy_chain_gallop(), moving the following nodes as a single block.
  * \param first First chain (will contain the result).
  * \param second Second chain (will be empty after the merge).
  * \param cmp Comparison function.
@@ -72,21 +154,34 @@ tommy_inline void tommy_chain_merge(tommy_chain* first, tommy_chain* second, tom
 {
 	tommy_node* first_i = first->head;
 	tommy_node* second_i = second->head;
+	tommy_size_t first_run = 0;
+	tommy_size_t second_run = 0;
 
 	/* merge */
 	while (1) {
 		if (cmp(first_i->data, second_i->data) > 0) {
-			tommy_node* next = second_i->next;
+			tommy_node* second_last = second_i;
+			tommy_node* next;
+
+			first_run = 0;
+			if (++second_run >= TOMMY_CHAIN_GALLOP)
+				second_last = tommy_chain_gallop(second_i, second->tail, first_i->data, 1, cmp);
+
+			next = second_last->next;
 			if (first_i == first->head) {
-				tommy_chain_concat(second_i, first_i);
+				tommy_chain_concat(second_last, first_i);
 				first->head = second_i;
 			} else {
-				tommy_chain_splice(first_i->prev, first_i, second_i, second_i);
+				tommy_chain_splice(first_i->prev, first_i, second_i, second_last);
 			}
-			if (second_i == second->tail)
+			if (second_last == second->tail)
 				break;
 			second_i = next;
 		} else {
+			second_run = 0;
+			if (++first_run >= TOMMY_CHAIN_GALLOP)
+				first_i = tommy_chain_gallop(first_i, first->tail, second_i->data, 0, cmp);
+
 			if (first_i == first->tail) {
 				tommy_chain_concat(first_i, second_i);
 				first->tail = second->tail;
@@ -124,12 +219,144 @@ tommy_inline void tommy_chain_merge_degenerated(tommy_chain* first, tommy_chain*
 	tommy_chain_merge(first, second, cmp);
 }
 
+/** \internal
+ * Extracts the natural run at the head of a chain.
+ * A run is a sequence of non-descending nodes, or of strictly descending nodes
+ * that is reversed in place. Only strictly descending runs are reversed to keep the sort stable.
+ * \param run Where to store the run.
+ * \param node First node of the run.
+ * \param tail Tail of the chain.
+ * \param cmp Comparison function.
+ * \param count Where to store the number of nodes of the run.
+ * \return The node following the run, or 0 if the run reaches the tail.
+ */
+tommy_inline tommy_node* tommy_chain_natural(tommy_chain* run, tommy_node* node, tommy_node* tail, tommy_compare_func* cmp, tommy_size_t* count)
+{
+	tommy_node* last = node;
+	tommy_node* next;
+	tommy_node* prev;
+	tommy_size_t n = 1;
+
+	if (node == tail) {
+		run->head = node;
+		run->tail = node;
+		*count = 1;
+		return 0;
+	}
+
+	next = node->next;
+	if (cmp(node->data, next->data) <= 0) {
+		/* non-descending run */
+		while (1) {
+			last = next;
+			++n;
+			if (last == tail) {
+				next = 0;
+				break;
+			}
+			next = last->next;
+			if (cmp(last->data, next->data) > 0)
+				break;
+		}
+		run->head = node;
+		run->tail = last;
+		*count = n;
+		return next;
+	}
+
+	/* strictly descending run, reversed while scanning it */
+	prev = node->prev;
+	while (1) {
+		last->next = prev;
+		last->prev = next;
+		prev = last;
+		last = next;
+		++n;
+		if (last == tail) {
+			next = 0;
+			break;
+		}
+		next = last->next;
+		if (cmp(last->data, next->data) <= 0)
+			break;
+	}
+	last->next = prev;
+
+	run->head = last;
+	run->tail = node;
+	*count = n;
+	return next;
+}
+
+/**
+ * Min number of nodes of the runs.
+ * Shorter natural runs are extended with an insertion sort, that on so few nodes
+ * is faster than merging them, and it keeps the merges balanced with random data.
+ */
+#define TOMMY_CHAIN_MINRUN 8
+
+/** \internal
+ * Inserts a node in a sorted run, after all the nodes not greater than it.
+ */
+tommy_inline void tommy_chain_insert(tommy_chain* run, tommy_node* node, tommy_compare_func* cmp)
+{
+	tommy_node* pos = run->tail;
+
+	/* search backward the last node not greater */
+	while (cmp(pos->data, node->data) > 0) {
+		if (pos == run->head) {
+			tommy_chain_concat(node, run->head);
+			run->head = node;
+			return;
+		}
+		pos = pos->prev;
+	}
+
+	if (pos == run->tail) {
+		tommy_chain_concat(pos, node);
+		run->tail = node;
+	} else {
+		tommy_chain_splice(pos, pos->next, node, node);
+	}
+}
+
+/** \internal
+ * Extracts a run of at least TOMMY_CHAIN_MINRUN nodes at the head of a chain.
+ * \param run Where to store the run.
+ * \param node First node of the run.
+ * \param tail Tail of the chain.
+ * \param cmp Comparison function.
+ * \param count Where to store the number of nodes of the run.
+ * \return The node following the run, or 0 if the run reaches the tail.
+ */
+tommy_inline tommy_node* tommy_chain_run(tommy_chain* run, tommy_node* node, tommy_node* tail, tommy_compare_func* cmp, tommy_size_t* count)
+{
+	tommy_node* next = tommy_chain_natural(run, node, tail, cmp, count);
+
+	/* extend short runs */
+	while (next && *count < TOMMY_CHAIN_MINRUN) {
+		node = next;
+		next = node != tail ? node->next : 0;
+		tommy_chain_insert(run, node, cmp);
+		++*count;
+	}
+
+	return next;
+}
+
 /**
  * Sorts a chain.
  * It's a stable merge sort using power of 2 buckets, with O(N*log(N)) complexity,
  * similar to the one used in the SGI STL libraries and in the Linux Kernel,
  * but faster on degenerated cases like already ordered lists.
  *
+ * Like TimSort, it splits the chain in natural runs, ascending or descending,
+ * extending the short ones to TOMMY_CHAIN_MINRUN nodes with an insertion sort,
+ * and it merges runs instead of single nodes, using galloping when possible.
+ * The buckets are indexed by the size of the chain they contain, and not by the
+ * number of runs, to keep the merges balanced also with runs of very different length.
+ * This makes it O(N) for already ordered chains, and close to O(N) for nearly ordered ones.
+ *
  * SGI STL stl_list.h
  * http://www.sgi.com/tech/stl/stl_list.h
  *
@@ -143,67 +370,88 @@ tommy_inline void tommy_chain_mergesort(tommy_chain* chain, tommy_compare_func*
 {
 	/*
 	 * Bit buckets of chains.
-	 * Each bucket contains 2^i nodes or it's empty.
+	 * Each bucket i contains from 2^i to 2^(i+1)-1 nodes or it's empty.
+	 * Lower buckets contain the nodes that come later in the chain.
 	 * The chain at address TOMMY_BIT_MAX is an independent variable operating as "carry".
 	 * We keep it in the same "bit" vector to avoid reports from the valgrind tool sgcheck.
 	 */
 	tommy_chain bit[TOMMY_SIZE_BIT + 1];
 
 	/**
-	 * Value stored inside the bit bucket.
+	 * Number of nodes stored inside the bit bucket.
 	 * It's used to know which bucket is empty or full.
 	 */
-	tommy_size_t counter;
+	tommy_size_t size[TOMMY_SIZE_BIT];
 	tommy_node* node = chain->head;
 	tommy_node* tail = chain->tail;
-	tommy_size_t mask;
-	tommy_size_t i;
+	tommy_chain* last;
+	tommy_uint_t top;
+	tommy_uint_t i;
 
-	counter = 0;
+	top = 0;
 	while (1) {
+		tommy_chain* lower;
+		tommy_size_t last_size;
+		tommy_size_t lower_size;
+		tommy_uint_t level;
 		tommy_node* next;
-		tommy_chain* last;
 
-		/* carry bit to add */
+		/* carry run to add */
 		last = &bit[TOMMY_SIZE_BIT];
-		bit[TOMMY_SIZE_BIT].head = node;
-		bit[TOMMY_SIZE_BIT].tail = node;
-		next = node->next;
-
-		/* add the bit, propagating the carry */
-		i = 0;
-		mask = counter;
-		while ((mask & 1) != 0) {
+		next = tommy_chain_run(last, node, tail, cmp, &last_size);
+		level = tommy_ilog2(last_size);
+
+		/* collapse the buckets smaller than the run, from the smallest */
+		lower = 0;
+		lower_size = 0;
+		for (i = 0; i < level && i < top; ++i) {
+			if (!size[i])
+				continue;
+			if (lower)
+				tommy_chain_merge_degenerated(&bit[i], lower, cmp);
+			lower = &bit[i];
+			lower_size += size[i];
+			size[i] = 0;
+		}
+		if (lower) {
+			tommy_chain_merge_degenerated(lower, last, cmp);
+			last = lower;
+			last_size += lower_size;
+		}
+
+		/* add the run, propagating the carry */
+		for (i = level; i < top && i <= tommy_ilog2(last_size); ++i) {
+			if (!size[i])
+				continue;
 			tommy_chain_merge_degenerated(&bit[i], last, cmp);
-			mask >>= 1;
 			last = &bit[i];
-			++i;
+			last_size += size[i];
+			size[i] = 0;
 		}
 
-		/* copy the carry in the first empty bit */
-		bit[i] = *last;
+		/* copy the carry in its bucket, that is always empty */
+		level = tommy_ilog2(last_size);
+		for (; top <= level; ++top)
+			size[top] = 0;
+		bit[level] = *last;
+		size[level] = last_size;
 
-		/* add the carry in the counter */
-		++counter;
-
-		if (node == tail)
+		if (!next)
 			break;
 		node = next;
 	}
 
-	/* merge the buckets */
-	i = tommy_ctz(counter);
-	mask = counter >> i;
-	while (mask != 1) {
-		mask >>= 1;
-		if (mask & 1)
-			tommy_chain_merge_degenerated(&bit[i + 1], &bit[i], cmp);
-		else
-			bit[i + 1] = bit[i];
-		++i;
+	/* merge the buckets, from the smallest */
+	last = 0;
+	for (i = 0; i < top; ++i) {
+		if (!size[i])
+			continue;
+		if (last)
+			tommy_chain_merge_degenerated(&bit[i], last, cmp);
+		last = &bit[i];
 	}
 
-	*chain = bit[i];
+	*chain = *last;
 }
 
 #endif
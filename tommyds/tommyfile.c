@@ -0,0 +1,211 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+#include "tommyfileint.h"
+
+#include <string.h> /* for memset and memcmp */
+
+#if defined(_WIN32)
+#include <windows.h> /* for MapViewOfFile */
+#define TOMMY_FILE_WINDOWS
+#elif defined(__unix__) || defined(__APPLE__)
+#include <sys/mman.h> /* for mmap */
+#include <sys/stat.h> /* for fstat */
+#include <fcntl.h> /* for open */
+#include <unistd.h> /* for close */
+#define TOMMY_FILE_MMAP
+#endif
+
+/******************************************************************************/
+/* file */
+
+/**
+ * Magic string at the start of the file.
+ */
+static const char tommy_file_magic[8] = { 't', 'o', 'm', 'm', 'y', 'd', 's', 0 };
+
+/**
+ * Byte order marker, read differently with a different byte order.
+ */
+#define TOMMY_FILE_ORDER 0x01020304
+
+TOMMY_API FILE* tommy_file_create(const char* path, tommy_size_t element_size, tommy_size_t count, tommy_size_t capacity)
+{
+	unsigned char buffer[TOMMY_FILE_OFFSET];
+	tommy_file_header header;
+	FILE* f;
+
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, tommy_file_magic, sizeof(header.magic));
+	header.version = TOMMY_FILE_VERSION;
+	header.order = TOMMY_FILE_ORDER;
+	header.element_size = element_size;
+	header.count = count;
+	header.capacity = capacity;
+	header.offset = TOMMY_FILE_OFFSET;
+
+	/* the header is padded with 0 up to the first element */
+	memset(buffer, 0, sizeof(buffer));
+	memcpy(buffer, &header, sizeof(header));
+
+	f = fopen(path, "wb");
+	if (!f)
+		return 0;
+
+	if (fwrite(buffer, sizeof(buffer), 1, f) != 1) {
+		fclose(f);
+		return 0;
+	}
+
+	return f;
+}
+
+TOMMY_API int tommy_file_close(FILE* f, tommy_size_t size, tommy_size_t capacity)
+{
+	int ret = 0;
+
+	/* leave a hole up to the capacity, writing only the last byte */
+	if (capacity > size) {
+		tommy_size_t skip = capacity - size - 1;
+#if defined(_WIN32)
+		if (_fseeki64(f, (__int64)skip, SEEK_CUR) != 0)
+#elif defined(TOMMY_FILE_MMAP)
+		if (fseeko(f, (off_t)skip, SEEK_CUR) != 0)
+#else
+		if (fseek(f, (long)skip, SEEK_CUR) != 0)
+#endif
+			ret = -1;
+		else if (fputc(0, f) == EOF)
+			ret = -1;
+	}
+
+	if (fclose(f) != 0)
+		ret = -1;
+
+	return ret;
+}
+
+/**
+ * Validates the header of the mapped file.
+ */
+static int tommy_file_check(void* map, tommy_size_t size, tommy_size_t element_size, tommy_size_t* count, tommy_size_t* capacity)
+{
+	tommy_file_header header;
+
+	if (size < TOMMY_FILE_OFFSET)
+		return -1;
+
+	memcpy(&header, map, sizeof(header));
+
+	if (memcmp(header.magic, tommy_file_magic, sizeof(header.magic)) != 0
+		|| header.version != TOMMY_FILE_VERSION
+		|| header.order != TOMMY_FILE_ORDER
+		|| header.offset != TOMMY_FILE_OFFSET
+		|| header.element_size != element_size
+		|| element_size == 0
+		|| header.count > header.capacity
+		|| header.capacity > (size - TOMMY_FILE_OFFSET) / element_size)
+		return -1;
+
+	*count = (tommy_size_t)header.count;
+	*capacity = (tommy_size_t)header.capacity;
+
+	return 0;
+}
+
+TOMMY_API void* tommy_file_map(const char* path, tommy_uint_t mode, tommy_size_t element_size, tommy_size_t* count, tommy_size_t* capacity, tommy_size_t* size)
+{
+	void* map;
+
+#if defined(TOMMY_FILE_WINDOWS)
+	HANDLE file;
+	HANDLE mapping;
+	LARGE_INTEGER file_size;
+
+	file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, 0, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+	if (file == INVALID_HANDLE_VALUE)
+		return 0;
+
+	if (!GetFileSizeEx(file, &file_size) || file_size.QuadPart < TOMMY_FILE_OFFSET) {
+		CloseHandle(file);
+		return 0;
+	}
+
+	mapping = CreateFileMappingA(file, 0, mode == TOMMY_MAP_PRIVATE ? PAGE_WRITECOPY : PAGE_READONLY, 0, 0, 0);
+	CloseHandle(file);
+	if (!mapping)
+		return 0;
+
+	map = MapViewOfFile(mapping, mode == TOMMY_MAP_PRIVATE ? FILE_MAP_COPY : FILE_MAP_READ, 0, 0, 0);
+	CloseHandle(mapping);
+	if (!map)
+		return 0;
+
+	*size = (tommy_size_t)file_size.QuadPart;
+#elif defined(TOMMY_FILE_MMAP)
+	int fd;
+	struct stat st;
+
+	fd = open(path, O_RDONLY);
+	if (fd == -1)
+		return 0;
+
+	if (fstat(fd, &st) != 0 || st.st_size < TOMMY_FILE_OFFSET) {
+		close(fd);
+		return 0;
+	}
+
+	/* a private mapping is copy-on-write, also if the file is opened read-only */
+	map = mmap(0, (size_t)st.st_size, mode == TOMMY_MAP_PRIVATE ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return 0;
+
+	*size = (tommy_size_t)st.st_size;
+#else
+	FILE* f;
+	long file_size;
+
+	(void)mode;
+
+	/* without mapping support, read the whole file in memory */
+	f = fopen(path, "rb");
+	if (!f)
+		return 0;
+
+	if (fseek(f, 0, SEEK_END) != 0 || (file_size = ftell(f)) < TOMMY_FILE_OFFSET || fseek(f, 0, SEEK_SET) != 0) {
+		fclose(f);
+		return 0;
+	}
+
+	map = tommy_malloc((tommy_size_t)file_size);
+	if (fread(map, (size_t)file_size, 1, f) != 1) {
+		tommy_free(map);
+		fclose(f);
+		return 0;
+	}
+	fclose(f);
+
+	*size = (tommy_size_t)file_size;
+#endif
+
+	if (tommy_file_check(map, *size, element_size, count, capacity) != 0) {
+		tommy_file_unmap(map, *size);
+		return 0;
+	}
+
+	return map;
+}
+
+TOMMY_API void tommy_file_unmap(void* map, tommy_size_t size)
+{
+#if defined(TOMMY_FILE_WINDOWS)
+	(void)size;
+	UnmapViewOfFile(map);
+#elif defined(TOMMY_FILE_MMAP)
+	munmap(map, size);
+#else
+	(void)size;
+	tommy_free(map);
+#endif
+}
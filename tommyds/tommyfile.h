@@ -0,0 +1,99 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+/** \file
+ * File format used to save and map the arrays of fixed size elements.
+ *
+ * The file starts with a header of ::TOMMY_FILE_OFFSET bytes, followed by
+ * the elements stored contiguously in memory order.
+ * The header contains the version of the format, the byte order, the element size,
+ * the number of elements, and the capacity, that is the number of elements
+ * for which space is reserved in the file.
+ * The space after the last element is left as a hole, and it reads as 0.
+ *
+ * Data is stored with the byte order and the layout of the machine that saved it,
+ * and the file can be mapped only in a machine with the same byte order.
+ *
+ * The hashtables use the same format to save a vector of ::tommy_file_record,
+ * one for each element, with its hash and the position of the object
+ * provided by the user. As the records don't contain pointers, the file
+ * remains valid when the objects are loaded at a different address.
+ *
+ * Files are written and read with tommy_arrayof_save(), tommy_arrayof_map(),
+ * tommy_arrayblkof_save(), tommy_arrayblkof_map(), tommy_hashdyn_save(),
+ * tommy_hashdyn_load(), tommy_hashlin_save() and tommy_hashlin_load().
+ */
+
+#ifndef __TOMMYFILE_H
+#define __TOMMYFILE_H
+
+#include "tommytypes.h"
+
+/******************************************************************************/
+/* file */
+
+/**
+ * Version of the file format.
+ */
+#define TOMMY_FILE_VERSION 1
+
+/**
+ * Offset of the first element in the file.
+ * It's a multiple of the page size, to keep the mapped elements aligned.
+ */
+#define TOMMY_FILE_OFFSET 4096
+
+/**
+ * Maps the file in read-only mode.
+ * Any change to the mapped elements is an access violation.
+ */
+#define TOMMY_MAP_READONLY 0
+
+/**
+ * Maps the file in copy-on-write mode.
+ * The mapped elements can be changed, but the changes are not written to the file.
+ */
+#define TOMMY_MAP_PRIVATE 1
+
+/** \internal
+ * Header of the file.
+ */
+typedef struct tommy_file_header_struct {
+	char magic[8]; /**< Magic string. */
+	tommy_uint32_t version; /**< Version of the format. */
+	tommy_uint32_t order; /**< Byte order marker. */
+	tommy_uint64_t element_size; /**< Size of the element in bytes. */
+	tommy_uint64_t count; /**< Number of elements. */
+	tommy_uint64_t capacity; /**< Number of elements reserved in the file. */
+	tommy_uint64_t offset; /**< Offset of the first element. */
+} tommy_file_header;
+
+/**
+ * Record of an element of an hashtable saved in a file.
+ */
+typedef struct tommy_file_record_struct {
+	tommy_uint64_t hash; /**< Hash of the element. */
+	tommy_uint64_t offset; /**< Position of the object, as returned by the ::tommy_save_func. */
+} tommy_file_record;
+
+/**
+ * Save function.
+ * Gets the position of the object, independent from its address.
+ * For example, its index in the vector of objects, or its offset in a file.
+ * \param arg Pointer to a generic argument.
+ * \param obj Pointer to the object to save.
+ * \return The position of the object.
+ */
+typedef tommy_uint64_t tommy_save_func(void* arg, void* obj);
+
+/**
+ * Load function.
+ * Gets the object at the position returned by the ::tommy_save_func.
+ * \param arg Pointer to a generic argument.
+ * \param offset Position of the object.
+ * \param node Where to store the node of the object, to insert in the container.
+ * \return The pointer to the object, used to set the tommy_node::data field.
+ */
+typedef void* tommy_load_func(void* arg, tommy_uint64_t offset, tommy_node** node);
+
+#endif
@@ -0,0 +1,51 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+/** \file
+ * Internal functions used to write and map the files of tommyfile.h.
+ *
+ * This header is included only by the library sources, to keep FILE and
+ * stdio.h out of the public headers.
+ */
+
+#ifndef __TOMMYFILEINT_H
+#define __TOMMYFILEINT_H
+
+#include "tommyfile.h"
+
+#include <stdio.h> /* for FILE */
+
+/******************************************************************************/
+/* file */
+
+/** \internal
+ * Creates the file and writes the header.
+ * \return The file positioned at the first element, or 0 on error.
+ */
+TOMMY_API FILE* tommy_file_create(const char* path, tommy_size_t element_size, tommy_size_t count, tommy_size_t capacity);
+
+/** \internal
+ * Reserves the space of the capacity, and closes the file.
+ * \param size Size in bytes of the elements already written.
+ * \param capacity Size in bytes of the space to reserve for the elements.
+ * \return 0 on success, or -1 on error.
+ */
+TOMMY_API int tommy_file_close(FILE* f, tommy_size_t size, tommy_size_t capacity);
+
+/** \internal
+ * Maps the file in memory and validates the header.
+ * \param mode One of ::TOMMY_MAP_READONLY or ::TOMMY_MAP_PRIVATE.
+ * \param element_size Expected size of the element in bytes.
+ * \param count Where the number of elements is stored.
+ * \param capacity Where the number of elements reserved is stored.
+ * \param size Where the size of the mapping is stored.
+ * \return The mapped file, with the first element at ::TOMMY_FILE_OFFSET, or 0 on error.
+ */
+TOMMY_API void* tommy_file_map(const char* path, tommy_uint_t mode, tommy_size_t element_size, tommy_size_t* count, tommy_size_t* capacity, tommy_size_t* size);
+
+/** \internal
+ * Unmaps the file.
+ */
+TOMMY_API void tommy_file_unmap(void* map, tommy_size_t size);
+
+#endif
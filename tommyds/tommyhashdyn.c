@@ -2,6 +2,7 @@
 // Copyright (C) 2010 Andrea Mazzoleni
 
 #include "tommyhashdyn.h"
+#include "tommyfileint.h"
 #include "tommylist.h"
 
 /******************************************************************************/
@@ -16,6 +17,9 @@ TOMMY_API void tommy_hashdyn_init(tommy_hashdyn* hashdyn)
 	hashdyn->bucket = tommy_cast(tommy_hashdyn_node**, tommy_calloc(hashdyn->bucket_max, sizeof(tommy_hashdyn_node*)));
 
 	hashdyn->count = 0;
+
+	tommy_stats_init(hashdyn);
+	tommy_stats_inc(hashdyn, segment);
 }
 
 TOMMY_API void tommy_hashdyn_done(tommy_hashdyn* hashdyn)
@@ -44,11 +48,15 @@ static void tommy_hashdyn_resize(tommy_hashdyn* hashdyn, tommy_uint_t new_bucket
 	/* because data is fully initialized in the update process */
 	new_bucket = tommy_cast(tommy_hashdyn_node**, tommy_malloc(new_bucket_max * sizeof(tommy_hashdyn_node*)));
 
+	tommy_stats_inc(hashdyn, segment);
+	tommy_stats_inc(hashdyn, rehash);
+
 	/* reinsert all the elements */
 	if (new_bucket_bit > bucket_bit) {
 		tommy_size_t i;
 
 		/* grow */
+		tommy_stats_add(hashdyn, grow, bucket_max);
 		for (i = 0; i < bucket_max; ++i) {
 			tommy_hashdyn_node* j;
 
@@ -72,6 +80,7 @@ static void tommy_hashdyn_resize(tommy_hashdyn* hashdyn, tommy_uint_t new_bucket
 		tommy_size_t i;
 
 		/* shrink */
+		tommy_stats_add(hashdyn, shrink, new_bucket_max);
 		for (i = 0; i < new_bucket_max; ++i) {
 			/* setup the new bucket with the lower bucket*/
 			new_bucket[i] = hashdyn->bucket[i];
@@ -192,6 +201,83 @@ TOMMY_API void tommy_hashdyn_foreach_arg(tommy_hashdyn* hashdyn, tommy_foreach_a
 	}
 }
 
+TOMMY_API int tommy_hashdyn_save(tommy_hashdyn* hashdyn, const char* path, tommy_save_func* func, void* arg)
+{
+	FILE* f;
+	tommy_size_t bucket_max;
+	tommy_size_t pos;
+
+	f = tommy_file_create(path, sizeof(tommy_file_record), hashdyn->count, hashdyn->count);
+	if (!f)
+		return -1;
+
+	bucket_max = hashdyn->bucket_max;
+
+	for (pos = 0; pos < bucket_max; ++pos) {
+		tommy_hashdyn_node* node = hashdyn->bucket[pos];
+
+		while (node) {
+			tommy_file_record record;
+
+			record.hash = node->index;
+			record.offset = func(arg, node->data);
+
+			if (fwrite(&record, sizeof(record), 1, f) != 1) {
+				fclose(f);
+				return -1;
+			}
+
+			node = node->next;
+		}
+	}
+
+	return tommy_file_close(f, 0, 0);
+}
+
+TOMMY_API int tommy_hashdyn_load(tommy_hashdyn* hashdyn, const char* path, tommy_load_func* func, void* arg)
+{
+	void* map;
+	void* base;
+	tommy_file_record* record;
+	tommy_size_t count;
+	tommy_size_t capacity;
+	tommy_size_t size;
+	tommy_size_t i;
+
+	map = tommy_file_map(path, TOMMY_MAP_READONLY, sizeof(tommy_file_record), &count, &capacity, &size);
+	if (!map)
+		return -1;
+
+	/* the same size reached inserting all the elements */
+	hashdyn->bucket_bit = TOMMY_HASHDYN_BIT;
+	while (count >= ((tommy_size_t)1 << hashdyn->bucket_bit) / 2)
+		++hashdyn->bucket_bit;
+	hashdyn->bucket_max = (tommy_size_t)1 << hashdyn->bucket_bit;
+	hashdyn->bucket_mask = hashdyn->bucket_max - 1;
+	hashdyn->bucket = tommy_cast(tommy_hashdyn_node**, tommy_calloc(hashdyn->bucket_max, sizeof(tommy_hashdyn_node*)));
+
+	hashdyn->count = count;
+
+	tommy_stats_init(hashdyn);
+	tommy_stats_inc(hashdyn, segment);
+
+	base = tommy_cast(unsigned char*, map) + TOMMY_FILE_OFFSET;
+	record = tommy_cast(tommy_file_record*, base);
+	for (i = 0; i < count; ++i) {
+		tommy_hashdyn_node* node;
+		void* data = func(arg, record[i].offset, &node);
+		tommy_hash_t hash = (tommy_hash_t)record[i].hash;
+
+		tommy_list_insert_tail(&hashdyn->bucket[hash & hashdyn->bucket_mask], node, data);
+
+		node->index = hash;
+	}
+
+	tommy_file_unmap(map, size);
+
+	return 0;
+}
+
 TOMMY_API tommy_size_t tommy_hashdyn_memory_usage(tommy_hashdyn* hashdyn)
 {
 	return hashdyn->bucket_max * (tommy_size_t)sizeof(hashdyn->bucket[0])
@@ -256,3 +342,8 @@ TOMMY_API void tommy_hashdyn_to_list(tommy_hashdyn* hashdyn, tommy_list* list)
 	memset(hashdyn->bucket, 0, hashdyn->bucket_max * sizeof(tommy_hashdyn_node*));
 	hashdyn->count = 0;
 }
+
+TOMMY_API void tommy_hashdyn_stats(tommy_hashdyn* hashdyn, tommy_stats* stats)
+{
+	tommy_stats_get(hashdyn, stats);
+}
@@ -114,6 +114,7 @@
 #define __TOMMYHASHDYN_H
 
 #include "tommyhash.h"
+#include "tommyfile.h"
 
 /******************************************************************************/
 /* hashdyn */
@@ -140,8 +141,16 @@ typedef struct tommy_hashdyn_struct {
 	tommy_size_t bucket_mask; /**< Bit mask to access the buckets. */
 	tommy_size_t count; /**< Number of elements. */
 	tommy_uint_t bucket_bit; /**< Bits used in the bit mask. */
+#ifdef TOMMY_STATS
+	tommy_stats stats; /**< Operation statistics. */
+#endif
 } tommy_hashdyn;
 
+/** \internal
+ * Links only with a library compiled with the same TOMMY_STATS setting.
+ */
+#define tommy_hashdyn_init tommy_stats_name(tommy_hashdyn_init)
+
 /**
  * Initializes the hashtable.
  */
@@ -199,13 +208,20 @@ tommy_inline tommy_hashdyn_node* tommy_hashdyn_bucket(tommy_hashdyn* hashdyn, to
 tommy_inline void* tommy_hashdyn_search(tommy_hashdyn* hashdyn, tommy_search_func* cmp, const void* cmp_arg, tommy_hash_t hash)
 {
 	tommy_hashdyn_node* i = tommy_hashdyn_bucket(hashdyn, hash);
+#ifdef TOMMY_STATS
+	tommy_size_t visit = 0;
+#endif
 
 	while (i) {
+		tommy_stats_visit(visit);
 		/* we first check if the hash matches, as in the same bucket we may have multiple hash values */
-		if (i->index == hash && cmp(cmp_arg, i->data) == 0)
+		if (i->index == hash && cmp(cmp_arg, i->data) == 0) {
+			tommy_stats_search(hashdyn, visit, 1);
 			return i->data;
+		}
 		i = i->next;
 	}
+	tommy_stats_search(hashdyn, visit, 0);
 	return 0;
 }
 
@@ -262,12 +278,47 @@ tommy_inline tommy_size_t tommy_hashdyn_count(tommy_hashdyn* hashdyn)
 	return hashdyn->count;
 }
 
+/**
+ * Saves the hashtable in a file, that can be later loaded with tommy_hashdyn_load().
+ * For each element, the file contains only its hash and the position of the
+ * object, that you have to provide. The objects have to be saved separately.
+ * \param path Path of the file to create.
+ * \param func Function called to get the position of each object.
+ * \param arg Argument passed to the function.
+ * \return 0 on success, or -1 on error.
+ */
+TOMMY_API int tommy_hashdyn_save(tommy_hashdyn* hashdyn, const char* path, tommy_save_func* func, void* arg);
+
+/** \internal
+ * Links only with a library compiled with the same TOMMY_STATS setting.
+ */
+#define tommy_hashdyn_load tommy_stats_name(tommy_hashdyn_load)
+
+/**
+ * Initializes the hashtable loading a file saved with tommy_hashdyn_save().
+ * The bucket vector is allocated at once with the final size, and the
+ * elements are inserted with the saved hash, in a sequential pass of the
+ * file, without resizing and without computing any hash.
+ * \param path Path of the file to load.
+ * \param func Function called to get the object at each position.
+ * \param arg Argument passed to the function.
+ * \return 0 on success, or -1 on error. On error the hashtable is not initialized.
+ */
+TOMMY_API int tommy_hashdyn_load(tommy_hashdyn* hashdyn, const char* path, tommy_load_func* func, void* arg);
+
 /**
  * Gets the size of allocated memory.
  * It includes the size of the ::tommy_hashdyn_node of the stored elements.
  */
 TOMMY_API tommy_size_t tommy_hashdyn_memory_usage(tommy_hashdyn* hashdyn);
 
+/**
+ * Gets the operation statistics.
+ * They are collected only if the library is compiled with TOMMY_STATS defined,
+ * otherwise they are all reported as 0.
+ */
+TOMMY_API void tommy_hashdyn_stats(tommy_hashdyn* hashdyn, tommy_stats* stats);
+
 /**
  * \brief Transfers all elements from the hashtable into a tommy_list.
  *
@@ -0,0 +1,227 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+#include "tommyhashdync.h"
+
+/******************************************************************************/
+/* hashdync */
+
+TOMMY_API void tommy_hashdync_init(tommy_hashdync* hashdync, tommy_size_t offset)
+{
+	/* fixed initial size */
+	hashdync->bucket_bit = TOMMY_HASHDYNC_BIT;
+	hashdync->bucket_max = (tommy_size_t)1 << hashdync->bucket_bit;
+	hashdync->bucket_mask = hashdync->bucket_max - 1;
+	hashdync->bucket = tommy_cast(tommy_hashdync_node**, tommy_calloc(hashdync->bucket_max, sizeof(tommy_hashdync_node*)));
+
+	hashdync->count = 0;
+	hashdync->offset = offset;
+
+	tommy_stats_init(hashdync);
+	tommy_stats_inc(hashdync, segment);
+}
+
+TOMMY_API void tommy_hashdync_done(tommy_hashdync* hashdync)
+{
+	tommy_free(hashdync->bucket);
+}
+
+/**
+ * Resize the bucket vector.
+ */
+static void tommy_hashdync_resize(tommy_hashdync* hashdync, tommy_uint_t new_bucket_bit)
+{
+	tommy_size_t bucket_bit;
+	tommy_size_t bucket_max;
+	tommy_size_t new_bucket_max;
+	tommy_size_t new_bucket_mask;
+	tommy_hashdync_node** new_bucket;
+
+	bucket_bit = hashdync->bucket_bit;
+	bucket_max = hashdync->bucket_max;
+
+	new_bucket_max = (tommy_size_t)1 << new_bucket_bit;
+	new_bucket_mask = new_bucket_max - 1;
+
+	/* allocate the new vector using malloc() and not calloc() */
+	/* because data is fully initialized in the update process */
+	new_bucket = tommy_cast(tommy_hashdync_node**, tommy_malloc(new_bucket_max * sizeof(tommy_hashdync_node*)));
+
+	tommy_stats_inc(hashdync, segment);
+	tommy_stats_inc(hashdync, rehash);
+
+	/* reinsert all the elements */
+	if (new_bucket_bit > bucket_bit) {
+		tommy_size_t i;
+
+		/* grow */
+		tommy_stats_add(hashdync, grow, bucket_max);
+		for (i = 0; i < bucket_max; ++i) {
+			tommy_hashdync_node** tail[2];
+			tommy_hashdync_node* j;
+
+			/* setup the new two buckets, keeping a pointer at their tail */
+			tail[0] = &new_bucket[i];
+			tail[1] = &new_bucket[i + bucket_max];
+
+			/* split the bucket, keeping the order */
+			j = hashdync->bucket[i];
+			while (j) {
+				tommy_size_t pos = (j->index & bucket_max) != 0;
+				*tail[pos] = j;
+				tail[pos] = &j->next;
+				j = j->next;
+			}
+
+			*tail[0] = 0;
+			*tail[1] = 0;
+		}
+	} else {
+		tommy_size_t i;
+
+		/* shrink */
+		tommy_stats_add(hashdync, shrink, new_bucket_max);
+		for (i = 0; i < new_bucket_max; ++i) {
+			tommy_hashdync_node** tail;
+
+			/* setup the new bucket with the lower bucket */
+			new_bucket[i] = hashdync->bucket[i];
+
+			/* concat the upper bucket at the tail */
+			tail = &new_bucket[i];
+			while (*tail)
+				tail = &(*tail)->next;
+			*tail = hashdync->bucket[i + new_bucket_max];
+		}
+	}
+
+	tommy_free(hashdync->bucket);
+
+	/* setup */
+	hashdync->bucket_bit = new_bucket_bit;
+	hashdync->bucket_max = new_bucket_max;
+	hashdync->bucket_mask = new_bucket_mask;
+	hashdync->bucket = new_bucket;
+}
+
+/**
+ * Grow.
+ */
+tommy_inline void hashdync_grow_step(tommy_hashdync* hashdync)
+{
+	/* grow if more than 50% full */
+	if (hashdync->count >= hashdync->bucket_max / 2)
+		tommy_hashdync_resize(hashdync, hashdync->bucket_bit + 1);
+}
+
+/**
+ * Shrink.
+ */
+tommy_inline void hashdync_shrink_step(tommy_hashdync* hashdync)
+{
+	/* shrink if less than 12.5% full */
+	if (hashdync->count <= hashdync->bucket_max / 8 && hashdync->bucket_bit > TOMMY_HASHDYNC_BIT)
+		tommy_hashdync_resize(hashdync, hashdync->bucket_bit - 1);
+}
+
+TOMMY_API void tommy_hashdync_insert(tommy_hashdync* hashdync, tommy_hashdync_node* node, tommy_hash_t hash)
+{
+	tommy_size_t pos = hash & hashdync->bucket_mask;
+
+	/* insert at the head, as the list is singly linked */
+	node->next = hashdync->bucket[pos];
+	node->index = hash;
+	hashdync->bucket[pos] = node;
+
+	++hashdync->count;
+
+	hashdync_grow_step(hashdync);
+}
+
+TOMMY_API void* tommy_hashdync_remove_existing(tommy_hashdync* hashdync, tommy_hashdync_node* node)
+{
+	tommy_hashdync_node** let = &hashdync->bucket[node->index & hashdync->bucket_mask];
+
+	/* search the pointer to the node */
+	while (*let != node)
+		let = &(*let)->next;
+
+	*let = node->next;
+
+	--hashdync->count;
+
+	hashdync_shrink_step(hashdync);
+
+	return tommy_hashdync_data(hashdync, node);
+}
+
+TOMMY_API void* tommy_hashdync_remove(tommy_hashdync* hashdync, tommy_search_func* cmp, const void* cmp_arg, tommy_hash_t hash)
+{
+	tommy_hashdync_node** let = &hashdync->bucket[hash & hashdync->bucket_mask];
+
+	while (*let) {
+		tommy_hashdync_node* node = *let;
+
+		/* we first check if the hash matches, as in the same bucket we may have multiples hash values */
+		if (node->index == hash) {
+			void* data = tommy_hashdync_data(hashdync, node);
+			if (cmp(cmp_arg, data) == 0) {
+				*let = node->next;
+
+				--hashdync->count;
+
+				hashdync_shrink_step(hashdync);
+
+				return data;
+			}
+		}
+		let = &node->next;
+	}
+
+	return 0;
+}
+
+TOMMY_API void tommy_hashdync_foreach(tommy_hashdync* hashdync, tommy_foreach_func* func)
+{
+	tommy_size_t bucket_max = hashdync->bucket_max;
+	tommy_hashdync_node** bucket = hashdync->bucket;
+	tommy_size_t pos;
+
+	for (pos = 0; pos < bucket_max; ++pos) {
+		tommy_hashdync_node* node = bucket[pos];
+
+		while (node) {
+			void* data = tommy_hashdync_data(hashdync, node);
+			node = node->next;
+			func(data);
+		}
+	}
+}
+
+TOMMY_API void tommy_hashdync_foreach_arg(tommy_hashdync* hashdync, tommy_foreach_arg_func* func, void* arg)
+{
+	tommy_size_t bucket_max = hashdync->bucket_max;
+	tommy_hashdync_node** bucket = hashdync->bucket;
+	tommy_size_t pos;
+
+	for (pos = 0; pos < bucket_max; ++pos) {
+		tommy_hashdync_node* node = bucket[pos];
+
+		while (node) {
+			void* data = tommy_hashdync_data(hashdync, node);
+			node = node->next;
+			func(arg, data);
+		}
+	}
+}
+
+TOMMY_API tommy_size_t tommy_hashdync_memory_usage(tommy_hashdync* hashdync)
+{
+	return hashdync->bucket_max * (tommy_size_t)sizeof(hashdync->bucket[0])
+	       + tommy_hashdync_count(hashdync) * (tommy_size_t)sizeof(tommy_hashdync_node);
+}
+
+TOMMY_API void tommy_hashdync_stats(tommy_hashdync* hashdync, tommy_stats* stats)
+{
+	tommy_stats_get(hashdync, stats);
+}
@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+/** \file
+ * Dynamic chained hashtable with compact nodes.
+ *
+ * This hashtable is like ::tommy_hashdyn, but it uses the ::tommy_cnode node
+ * of 16 bytes, instead of the ::tommy_node of 32 bytes, on 64 bit platforms.
+ *
+ * The node doesn't store the object address, and the object is recovered from the
+ * node address, subtracting the offset of the node inside the object,
+ * specified when initializing the hashtable.
+ *
+ * The collisions are stored in singly linked lists, and new elements are inserted
+ * at the head of the list, so equal elements are found in reverse insertion order.
+ * Removing an element with tommy_hashdync_remove_existing() needs to walk the list of its bucket,
+ * that it's short on average.
+ *
+ * \code
+ * struct object {
+ *     int value;
+ *     // other fields
+ *     tommy_cnode node;
+ * };
+ *
+ * tommy_hashdync hashdync;
+ *
+ * tommy_hashdync_init(&hashdync, offsetof(struct object, node));
+ *
+ * struct object* obj = malloc(sizeof(struct object)); // creates the object
+ *
+ * obj->value = ...; // initializes the object
+ *
+ * tommy_hashdync_insert(&hashdync, &obj->node, tommy_inthash_u32(obj->value)); // inserts the object
+ * \endcode
+ *
+ * The search and remove functions are the same of ::tommy_hashdyn.
+ *
+ * \code
+ * struct object* obj = tommy_hashdync_search(&hashdync, compare, &value_to_find, tommy_inthash_u32(value_to_find));
+ * \endcode
+ *
+ * To iterate over all the elements with the same key, you have to use tommy_hashdync_bucket(),
+ * follow the tommy_cnode::next pointer until NULL, and get the object with tommy_hashdync_data().
+ */
+
+#ifndef __TOMMYHASHDYNC_H
+#define __TOMMYHASHDYNC_H
+
+#include "tommyhash.h"
+
+/******************************************************************************/
+/* hashdync */
+
+/** \internal
+ * Initial and minimal size of the hashtable expressed as a power of 2.
+ * The initial size is 2^TOMMY_HASHDYNC_BIT.
+ */
+#define TOMMY_HASHDYNC_BIT 4
+
+/**
+ * Hashtable node.
+ * This is the node that you have to include inside your objects.
+ */
+typedef tommy_cnode tommy_hashdync_node;
+
+/**
+ * Hashtable container type.
+ * \note Don't use internal fields directly, but access the container only using functions.
+ */
+typedef struct tommy_hashdync_struct {
+	tommy_hashdync_node** bucket; /**< Hash buckets. One list for each hash modulus. */
+	tommy_size_t bucket_max; /**< Number of buckets. */
+	tommy_size_t bucket_mask; /**< Bit mask to access the buckets. */
+	tommy_size_t count; /**< Number of elements. */
+	tommy_size_t offset; /**< Offset of the node inside the objects. */
+	tommy_uint_t bucket_bit; /**< Bits used in the bit mask. */
+#ifdef TOMMY_STATS
+	tommy_stats stats; /**< Operation statistics. */
+#endif
+} tommy_hashdync;
+
+/** \internal
+ * Links only with a library compiled with the same TOMMY_STATS setting.
+ */
+#define tommy_hashdync_init tommy_stats_name(tommy_hashdync_init)
+
+/**
+ * Initializes the hashtable.
+ * \param offset Offset of the node inside the objects, usually computed with offsetof().
+ */
+TOMMY_API void tommy_hashdync_init(tommy_hashdync* hashdync, tommy_size_t offset);
+
+/**
+ * Deinitializes the hashtable.
+ *
+ * You can call this function with elements still contained,
+ * but such elements are not going to be freed by this call.
+ */
+TOMMY_API void tommy_hashdync_done(tommy_hashdync* hashdync);
+
+/**
+ * Inserts an element in the hashtable.
+ */
+TOMMY_API void tommy_hashdync_insert(tommy_hashdync* hashdync, tommy_hashdync_node* node, tommy_hash_t hash);
+
+/**
+ * Searches and removes an element from the hashtable.
+ * You have to provide a compare function and the hash of the element you want to remove.
+ * If the element is not found, 0 is returned.
+ * If more equal elements are present, the last inserted is removed.
+ * \param cmp Compare function called with cmp_arg as first argument and with the element to compare as a second one.
+ * The function should return 0 for equal elements, anything other for different elements.
+ * \param cmp_arg Compare argument passed as first argument of the compare function.
+ * \param hash Hash of the element to find and remove.
+ * \return The removed element, or 0 if not found.
+ */
+TOMMY_API void* tommy_hashdync_remove(tommy_hashdync* hashdync, tommy_search_func* cmp, const void* cmp_arg, tommy_hash_t hash);
+
+/**
+ * Gets the object containing the node.
+ */
+tommy_inline void* tommy_hashdync_data(tommy_hashdync* hashdync, tommy_hashdync_node* node)
+{
+	void* ptr = node;
+
+	return tommy_cast(unsigned char*, ptr) - hashdync->offset;
+}
+
+/**
+ * Gets the bucket of the specified hash.
+ * The bucket is guaranteed to contain ALL the elements with the specified hash,
+ * but it can contain also others.
+ * You can access elements in the bucket following the ::next pointer until 0.
+ * \param hash Hash of the element to find.
+ * \return The head of the bucket, or 0 if empty.
+ */
+tommy_inline tommy_hashdync_node* tommy_hashdync_bucket(tommy_hashdync* hashdync, tommy_hash_t hash)
+{
+	return hashdync->bucket[hash & hashdync->bucket_mask];
+}
+
+/**
+ * Searches an element in the hashtable.
+ * You have to provide a compare function and the hash of the element you want to find.
+ * If more equal elements are present, the last inserted is returned.
+ * \param cmp Compare function called with cmp_arg as first argument and with the element to compare as a second one.
+ * The function should return 0 for equal elements, anything other for different elements.
+ * \param cmp_arg Compare argument passed as first argument of the compare function.
+ * \param hash Hash of the element to find.
+ * \return The first element found, or 0 if none.
+ */
+tommy_inline void* tommy_hashdync_search(tommy_hashdync* hashdync, tommy_search_func* cmp, const void* cmp_arg, tommy_hash_t hash)
+{
+	tommy_hashdync_node* i = tommy_hashdync_bucket(hashdync, hash);
+#ifdef TOMMY_STATS
+	tommy_size_t visit = 0;
+#endif
+
+	while (i) {
+		tommy_stats_visit(visit);
+		/* we first check if the hash matches, as in the same bucket we may have multiples hash values */
+		if (i->index == hash) {
+			void* data = tommy_hashdync_data(hashdync, i);
+			if (cmp(cmp_arg, data) == 0) {
+				tommy_stats_search(hashdync, visit, 1);
+				return data;
+			}
+		}
+		i = i->next;
+	}
+	tommy_stats_search(hashdync, visit, 0);
+	return 0;
+}
+
+/**
+ * Removes an element from the hashtable.
+ * You must already have the address of the element to remove.
+ * The list of the bucket is walked to find the previous node.
+ * \return The object containing the node.
+ */
+TOMMY_API void* tommy_hashdync_remove_existing(tommy_hashdync* hashdync, tommy_hashdync_node* node);
+
+/**
+ * Calls the specified function for each element in the hashtable.
+ *
+ * You cannot add or remove elements from the inside of the callback,
+ * but can use it to deallocate them.
+ */
+TOMMY_API void tommy_hashdync_foreach(tommy_hashdync* hashdync, tommy_foreach_func* func);
+
+/**
+ * Calls the specified function with an argument for each element in the hashtable.
+ */
+TOMMY_API void tommy_hashdync_foreach_arg(tommy_hashdync* hashdync, tommy_foreach_arg_func* func, void* arg);
+
+/**
+ * Gets the number of elements.
+ */
+tommy_inline tommy_size_t tommy_hashdync_count(tommy_hashdync* hashdync)
+{
+	return hashdync->count;
+}
+
+/**
+ * Gets the size of allocated memory.
+ * It includes the size of the ::tommy_hashdync_node of the stored elements.
+ */
+TOMMY_API tommy_size_t tommy_hashdync_memory_usage(tommy_hashdync* hashdync);
+
+/**
+ * Gets the operation statistics.
+ * They are collected only if the library is compiled with TOMMY_STATS defined,
+ * otherwise they are all reported as 0.
+ */
+TOMMY_API void tommy_hashdync_stats(tommy_hashdync* hashdync, tommy_stats* stats);
+
+#endif
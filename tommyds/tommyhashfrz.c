@@ -0,0 +1,251 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+#include "tommyhashfrz.h"
+#include "tommyfileint.h"
+
+/******************************************************************************/
+/* hashfrozen */
+
+/**
+ * Layout of the memory block, as vector of tommy_size_t words.
+ * [0] Number of elements.
+ * [1] Bits of the bucket mask.
+ * [2 ...] Position of the first element of each bucket, and one more with the count.
+ * [...] Elements sorted by bucket, as tommy_hashfrozen_entry.
+ */
+#define TOMMY_HASHFROZEN_HEADER 2
+
+/**
+ * Number of words of the memory block.
+ */
+static tommy_size_t hashfrozen_words(tommy_size_t count, tommy_uint_t bucket_bit)
+{
+	return TOMMY_HASHFROZEN_HEADER + ((tommy_size_t)1 << bucket_bit) + 1 + count * (sizeof(tommy_hashfrozen_entry) / sizeof(tommy_size_t));
+}
+
+/**
+ * Setup the pointers in the memory block.
+ */
+static void hashfrozen_setup(tommy_hashfrozen* frozen, tommy_size_t* word, void* base)
+{
+	tommy_uint_t bucket_bit = (tommy_uint_t)word[1];
+	void* entry;
+
+	frozen->count = word[0];
+	frozen->bucket_mask = ((tommy_size_t)1 << bucket_bit) - 1;
+	frozen->bucket = word + TOMMY_HASHFROZEN_HEADER;
+
+	entry = frozen->bucket + frozen->bucket_mask + 2;
+	frozen->entry = tommy_cast(tommy_hashfrozen_entry*, entry);
+
+	frozen->base = (tommy_uintptr_t)base;
+}
+
+/**
+ * Allocates the memory block for the specified number of elements.
+ */
+static void hashfrozen_alloc(tommy_hashfrozen* frozen, tommy_size_t count, void* base)
+{
+	tommy_uint_t bucket_bit;
+	tommy_size_t* word;
+
+	/* an average of two elements for each bucket */
+	bucket_bit = 0;
+	while (((tommy_size_t)1 << bucket_bit) < count / 2)
+		++bucket_bit;
+
+	frozen->data_size = hashfrozen_words(count, bucket_bit) * sizeof(tommy_size_t);
+	frozen->data = tommy_calloc(frozen->data_size, 1);
+	frozen->map = 0;
+
+	word = tommy_cast(tommy_size_t*, frozen->data);
+	word[0] = count;
+	word[1] = bucket_bit;
+
+	hashfrozen_setup(frozen, word, base);
+}
+
+/**
+ * Counts the elements of the list for each bucket.
+ */
+static void hashfrozen_count(tommy_hashfrozen* frozen, tommy_node* node)
+{
+	while (node) {
+		++frozen->bucket[(node->index & frozen->bucket_mask) + 1];
+		node = node->next;
+	}
+}
+
+/**
+ * Computes the position of the first element of each bucket.
+ */
+static void hashfrozen_start(tommy_hashfrozen* frozen)
+{
+	tommy_size_t i;
+
+	for (i = 1; i <= frozen->bucket_mask + 1; ++i)
+		frozen->bucket[i] += frozen->bucket[i - 1];
+}
+
+/**
+ * Inserts the elements of the list, moving forward the position of their buckets.
+ */
+static void hashfrozen_insert(tommy_hashfrozen* frozen, tommy_node* node)
+{
+	while (node) {
+		tommy_hashfrozen_entry* entry = &frozen->entry[frozen->bucket[node->index & frozen->bucket_mask]++];
+		entry->hash = node->index;
+		entry->offset = (tommy_uintptr_t)node->data - frozen->base;
+
+		node = node->next;
+	}
+}
+
+/**
+ * Restores the position of the first element of each bucket.
+ */
+static void hashfrozen_finish(tommy_hashfrozen* frozen)
+{
+	tommy_size_t i;
+
+	/* after the insert every bucket points at the start of the next one */
+	for (i = frozen->bucket_mask + 1; i > 0; --i)
+		frozen->bucket[i] = frozen->bucket[i - 1];
+	frozen->bucket[0] = 0;
+}
+
+TOMMY_API void tommy_hashfrozen_init_hashdyn(tommy_hashfrozen* frozen, tommy_hashdyn* hashdyn, void* base)
+{
+	tommy_size_t pos;
+
+	hashfrozen_alloc(frozen, hashdyn->count, base);
+
+	for (pos = 0; pos < hashdyn->bucket_max; ++pos)
+		hashfrozen_count(frozen, hashdyn->bucket[pos]);
+
+	hashfrozen_start(frozen);
+
+	for (pos = 0; pos < hashdyn->bucket_max; ++pos)
+		hashfrozen_insert(frozen, hashdyn->bucket[pos]);
+
+	hashfrozen_finish(frozen);
+}
+
+TOMMY_API void tommy_hashfrozen_init_hashlin(tommy_hashfrozen* frozen, tommy_hashlin* hashlin, void* base)
+{
+	tommy_size_t bucket_max;
+	tommy_size_t pos;
+
+	hashfrozen_alloc(frozen, hashlin->count, base);
+
+	/* number of valid buckets */
+	bucket_max = hashlin->low_max + hashlin->split;
+
+	for (pos = 0; pos < bucket_max; ++pos)
+		hashfrozen_count(frozen, *tommy_hashlin_pos(hashlin, pos));
+
+	hashfrozen_start(frozen);
+
+	for (pos = 0; pos < bucket_max; ++pos)
+		hashfrozen_insert(frozen, *tommy_hashlin_pos(hashlin, pos));
+
+	hashfrozen_finish(frozen);
+}
+
+TOMMY_API void tommy_hashfrozen_done(tommy_hashfrozen* frozen)
+{
+	if (frozen->map)
+		tommy_file_unmap(frozen->data, frozen->data_size);
+	else
+		tommy_free(frozen->data);
+}
+
+TOMMY_API int tommy_hashfrozen_save(tommy_hashfrozen* frozen, const char* path)
+{
+	FILE* f;
+	tommy_size_t words;
+
+	words = hashfrozen_words(frozen->count, tommy_ilog2(frozen->bucket_mask + 1));
+
+	f = tommy_file_create(path, sizeof(tommy_size_t), words, words);
+	if (!f)
+		return -1;
+
+	/* the words start just before the bucket vector */
+	if (fwrite(frozen->bucket - TOMMY_HASHFROZEN_HEADER, sizeof(tommy_size_t), words, f) != words) {
+		fclose(f);
+		return -1;
+	}
+
+	return tommy_file_close(f, 0, 0);
+}
+
+/**
+ * Checks the memory block read from a file.
+ * The searches read the entries between two consecutive buckets, so the buckets
+ * must be non-decreasing up to the last one, that is the number of elements.
+ * \return 0 if valid, or -1 on error.
+ */
+static int hashfrozen_check(tommy_size_t* word, tommy_size_t words)
+{
+	tommy_size_t* bucket;
+	tommy_size_t bucket_max;
+	tommy_size_t i;
+
+	/* check that the layout matches the file size */
+	if (words < TOMMY_HASHFROZEN_HEADER
+		|| word[1] >= TOMMY_SIZE_BIT
+		|| word[0] > words
+		|| ((tommy_size_t)1 << word[1]) >= words
+		|| hashfrozen_words(word[0], (tommy_uint_t)word[1]) != words)
+		return -1;
+
+	bucket = word + TOMMY_HASHFROZEN_HEADER;
+	bucket_max = (tommy_size_t)1 << word[1];
+
+	for (i = 0; i < bucket_max; ++i) {
+		if (bucket[i] > bucket[i + 1])
+			return -1;
+	}
+
+	if (bucket[bucket_max] != word[0])
+		return -1;
+
+	return 0;
+}
+
+TOMMY_API int tommy_hashfrozen_map(tommy_hashfrozen* frozen, const char* path, void* base)
+{
+	void* map;
+	void* data;
+	tommy_size_t* word;
+	tommy_size_t words;
+	tommy_size_t capacity;
+	tommy_size_t size;
+
+	map = tommy_file_map(path, TOMMY_MAP_READONLY, sizeof(tommy_size_t), &words, &capacity, &size);
+	if (!map)
+		return -1;
+
+	data = tommy_cast(unsigned char*, map) + TOMMY_FILE_OFFSET;
+	word = tommy_cast(tommy_size_t*, data);
+
+	if (hashfrozen_check(word, words) != 0) {
+		tommy_file_unmap(map, size);
+		return -1;
+	}
+
+	frozen->data = map;
+	frozen->data_size = size;
+	frozen->map = 1;
+
+	hashfrozen_setup(frozen, word, base);
+
+	return 0;
+}
+
+TOMMY_API tommy_size_t tommy_hashfrozen_memory_usage(tommy_hashfrozen* frozen)
+{
+	return frozen->data_size;
+}
@@ -0,0 +1,162 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+/** \file
+ * Frozen hashtable.
+ *
+ * This hashtable is read-only, and it's built at once from all the elements
+ * of a ::tommy_hashdyn or of a ::tommy_hashlin.
+ *
+ * It's stored in a single contiguous memory block, with a vector containing
+ * the position of the first element of each bucket, followed by the vector of the
+ * elements sorted by bucket. Every element is stored with its hash and the offset of the
+ * object from a base address, without any pointer or ::tommy_node.
+ * A search reads two consecutive positions in the bucket vector, and the few
+ * elements of the bucket that are contiguous in memory.
+ *
+ * With a 64 bit platform every element uses 16 bytes, plus about 8 bytes of the bucket vector.
+ * Compared to the 32 bytes of the node and the 16 bytes of the buckets of ::tommy_hashdyn.
+ *
+ * To build it, you have to provide a populated hashtable and the base address of the objects.
+ * The hashtable is not changed, and you can deinitialize it after the build, and
+ * remove the nodes from the objects.
+ *
+ * \code
+ * tommy_hashfrozen frozen;
+ *
+ * tommy_hashfrozen_init_hashdyn(&frozen, &hashdyn, 0); // with base 0 the offsets are the object addresses
+ *
+ * struct object* obj = tommy_hashfrozen_search(&frozen, compare, &value_to_find, tommy_inthash_u32(value_to_find));
+ * \endcode
+ *
+ * If all the objects are in a single vector, like in a ::tommy_arrayof mapped from
+ * a file, you can use the start of the vector as base address. The index is then
+ * position independent, and it can be saved with tommy_hashfrozen_save() and
+ * later mapped with tommy_hashfrozen_map() providing the new base address.
+ */
+
+#ifndef __TOMMYHASHFRZ_H
+#define __TOMMYHASHFRZ_H
+
+#include "tommyhashdyn.h"
+#include "tommyhashlin.h"
+#include "tommyfile.h"
+
+/******************************************************************************/
+/* hashfrozen */
+
+/**
+ * Element of the frozen hashtable.
+ */
+typedef struct tommy_hashfrozen_entry_struct {
+	tommy_hash_t hash; /**< Hash of the element. */
+	tommy_size_t offset; /**< Offset of the object from the base address. */
+} tommy_hashfrozen_entry;
+
+/**
+ * Frozen hashtable.
+ * \note Don't use internal fields directly, but access the container only using functions.
+ */
+typedef struct tommy_hashfrozen_struct {
+	tommy_size_t* bucket; /**< Position of the first element of each bucket, and one more with the count. */
+	tommy_hashfrozen_entry* entry; /**< Elements sorted by bucket. */
+	tommy_uintptr_t base; /**< Base address of the objects. */
+	void* data; /**< Memory block with all the data. */
+	tommy_size_t data_size; /**< Size of the memory block. */
+	tommy_size_t bucket_mask; /**< Bit mask to access the buckets. */
+	tommy_size_t count; /**< Number of elements. */
+	tommy_uint_t map; /**< If the memory block is a mapped file. */
+} tommy_hashfrozen;
+
+/** \internal
+ * Links only with a library compiled with the same TOMMY_STATS setting.
+ */
+#define tommy_hashfrozen_init_hashdyn tommy_stats_name(tommy_hashfrozen_init_hashdyn)
+
+/**
+ * Initializes the frozen hashtable with all the elements of a ::tommy_hashdyn.
+ * \param hashdyn Hashtable to copy. It's not changed.
+ * \param base Base address of the objects. Every object must have an address greater or equal than it.
+ */
+TOMMY_API void tommy_hashfrozen_init_hashdyn(tommy_hashfrozen* frozen, tommy_hashdyn* hashdyn, void* base);
+
+/** \internal
+ * Links only with a library compiled with the same TOMMY_STATS and TOMMY_HASHLIN_FINGERPRINT settings.
+ */
+#define tommy_hashfrozen_init_hashlin tommy_hashlin_name(tommy_hashfrozen_init_hashlin)
+
+/**
+ * Initializes the frozen hashtable with all the elements of a ::tommy_hashlin.
+ * \param hashlin Hashtable to copy. It's not changed.
+ * \param base Base address of the objects. Every object must have an address greater or equal than it.
+ */
+TOMMY_API void tommy_hashfrozen_init_hashlin(tommy_hashfrozen* frozen, tommy_hashlin* hashlin, void* base);
+
+/**
+ * Deinitializes the frozen hashtable.
+ */
+TOMMY_API void tommy_hashfrozen_done(tommy_hashfrozen* frozen);
+
+/**
+ * Saves the frozen hashtable in a file, that can be later mapped with tommy_hashfrozen_map().
+ * \param path Path of the file to create.
+ * \return 0 on success, or -1 on error.
+ */
+TOMMY_API int tommy_hashfrozen_save(tommy_hashfrozen* frozen, const char* path);
+
+/**
+ * Initializes the frozen hashtable mapping a file saved with tommy_hashfrozen_save().
+ * The file is used directly, in read-only mode, reading only the bucket vector
+ * to check that the searches stay inside the file. It takes a time proportional
+ * to the number of buckets.
+ * The offsets of the objects are not checked, and the file must be trusted
+ * to point to valid objects from the base address.
+ * \param path Path of the file to map.
+ * \param base New base address of the objects.
+ * \return 0 on success, or -1 on error. On error the hashtable is not initialized.
+ */
+TOMMY_API int tommy_hashfrozen_map(tommy_hashfrozen* frozen, const char* path, void* base);
+
+/**
+ * Searches an element in the frozen hashtable.
+ * You have to provide a compare function and the hash of the element you want to find.
+ * If more equal elements are present, the first one is returned.
+ * \param cmp Compare function called with cmp_arg as first argument and with the element to compare as a second one.
+ * The function should return 0 for equal elements, anything other for different elements.
+ * \param cmp_arg Compare argument passed as first argument of the compare function.
+ * \param hash Hash of the element to find.
+ * \return The first element found, or 0 if none.
+ */
+tommy_inline void* tommy_hashfrozen_search(tommy_hashfrozen* frozen, tommy_search_func* cmp, const void* cmp_arg, tommy_hash_t hash)
+{
+	tommy_size_t pos = hash & frozen->bucket_mask;
+	tommy_size_t i = frozen->bucket[pos];
+	tommy_size_t end = frozen->bucket[pos + 1];
+
+	while (i < end) {
+		/* we first check if the hash matches, as in the same bucket we may have multiples hash values */
+		if (frozen->entry[i].hash == hash) {
+			void* obj = (void*)(frozen->base + frozen->entry[i].offset);
+			if (cmp(cmp_arg, obj) == 0)
+				return obj;
+		}
+		++i;
+	}
+
+	return 0;
+}
+
+/**
+ * Gets the number of elements.
+ */
+tommy_inline tommy_size_t tommy_hashfrozen_count(tommy_hashfrozen* frozen)
+{
+	return frozen->count;
+}
+
+/**
+ * Gets the size of allocated memory.
+ */
+TOMMY_API tommy_size_t tommy_hashfrozen_memory_usage(tommy_hashfrozen* frozen);
+
+#endif
@@ -2,6 +2,7 @@
 // Copyright (C) 2010 Andrea Mazzoleni
 
 #include "tommyhashlin.h"
+#include "tommyfileint.h"
 #include "tommylist.h"
 
 #include <assert.h> /* for assert */
@@ -38,7 +39,7 @@ TOMMY_API void tommy_hashlin_init(tommy_hashlin* hashlin)
 	hashlin->bucket_bit = TOMMY_HASHLIN_BIT;
 	hashlin->bucket_max = (tommy_size_t)1 << hashlin->bucket_bit;
 	hashlin->bucket_mask = hashlin->bucket_max - 1;
-	hashlin->bucket[0] = tommy_cast(tommy_hashlin_node**, tommy_calloc(hashlin->bucket_max, sizeof(tommy_hashlin_node*)));
+	hashlin->bucket[0] = tommy_cast(tommy_hashlin_slot*, tommy_calloc(hashlin->bucket_max, sizeof(tommy_hashlin_slot)));
 	for (i = 1; i < TOMMY_HASHLIN_BIT; ++i)
 		hashlin->bucket[i] = hashlin->bucket[0];
 
@@ -46,6 +47,9 @@ TOMMY_API void tommy_hashlin_init(tommy_hashlin* hashlin)
 	tommy_hashlin_stable(hashlin);
 
 	hashlin->count = 0;
+
+	tommy_stats_init(hashlin);
+	tommy_stats_inc(hashlin, segment);
 }
 
 TOMMY_API void tommy_hashlin_done(tommy_hashlin* hashlin)
@@ -54,7 +58,7 @@ TOMMY_API void tommy_hashlin_done(tommy_hashlin* hashlin)
 
 	tommy_free(hashlin->bucket[0]);
 	for (i = TOMMY_HASHLIN_BIT; i < hashlin->bucket_bit; ++i) {
-		tommy_hashlin_node** segment = hashlin->bucket[i];
+		tommy_hashlin_slot* segment = hashlin->bucket[i];
 		tommy_free(&segment[(tommy_ptrdiff_t)1 << i]);
 	}
 }
@@ -72,7 +76,7 @@ tommy_inline void hashlin_grow_step(tommy_hashlin* hashlin)
 		/* otherwise continue with the already setup shrink one */
 		/* but in backward direction */
 		if (hashlin->state == TOMMY_HASHLIN_STATE_STABLE) {
-			tommy_hashlin_node** segment;
+			tommy_hashlin_slot* segment;
 
 			/* set the lower size */
 			hashlin->low_max = hashlin->bucket_max;
@@ -80,7 +84,10 @@ tommy_inline void hashlin_grow_step(tommy_hashlin* hashlin)
 
 			/* allocate the new vector using malloc() and not calloc() */
 			/* because data is fully initialized in the split process */
-			segment = tommy_cast(tommy_hashlin_node**, tommy_malloc(hashlin->low_max * sizeof(tommy_hashlin_node*)));
+			segment = tommy_cast(tommy_hashlin_slot*, tommy_malloc(hashlin->low_max * sizeof(tommy_hashlin_slot)));
+
+			tommy_stats_inc(hashlin, segment);
+			tommy_stats_inc(hashlin, rehash);
 
 			/* store it adjusting the offset */
 			/* cast to ptrdiff_t to ensure to get a negative value */
@@ -122,6 +129,10 @@ tommy_inline void hashlin_grow_step(tommy_hashlin* hashlin)
 			/* reinitialize the buckets */
 			*split[0] = 0;
 			*split[1] = 0;
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+			*tommy_hashlin_filter(split[0]) = 0;
+			*tommy_hashlin_filter(split[1]) = 0;
+#endif
 
 			/* the bit used to identify the bucket */
 			mask = hashlin->low_max;
@@ -134,9 +145,14 @@ tommy_inline void hashlin_grow_step(tommy_hashlin* hashlin)
 					tommy_list_insert_tail_not_empty(*split[pos], j);
 				else
 					tommy_list_insert_first(split[pos], j);
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+				*tommy_hashlin_filter(split[pos]) |= tommy_hashlin_fingerprint(j->index);
+#endif
 				j = j_next;
 			}
 
+			tommy_stats_inc(hashlin, grow);
+
 			/* go forward */
 			++hashlin->split;
 
@@ -190,6 +206,8 @@ tommy_inline void hashlin_shrink_step(tommy_hashlin* hashlin)
 			/* go backward position */
 			--hashlin->split;
 
+			tommy_stats_inc(hashlin, shrink);
+
 			/* get the low bucket */
 			split[0] = tommy_hashlin_pos(hashlin, hashlin->split);
 
@@ -198,10 +216,15 @@ tommy_inline void hashlin_shrink_step(tommy_hashlin* hashlin)
 
 			/* concat the high bucket into the low one */
 			tommy_list_concat(split[0], split[1]);
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+			*tommy_hashlin_filter(split[0]) |= *tommy_hashlin_filter(split[1]);
+#endif
 
 			/* if we have finished, clean up and change the state */
 			if (hashlin->split == 0) {
-				tommy_hashlin_node** segment;
+				tommy_hashlin_slot* segment;
+
+				tommy_stats_inc(hashlin, rehash);
 
 				/* shrink the hash size */
 				--hashlin->bucket_bit;
@@ -220,12 +243,33 @@ tommy_inline void hashlin_shrink_step(tommy_hashlin* hashlin)
 	}
 }
 
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+/**
+ * Updates the fingerprint of a bucket, after a removal.
+ * The bit of the removed element is left set, as clearing it requires to walk
+ * all the chain, and it only causes a chain walk on a miss.
+ * All the bits are cleared when the bucket becomes empty, and recomputed
+ * when the bucket is split.
+ */
+tommy_inline void tommy_hashlin_refilter(tommy_hashlin_node** head)
+{
+	if (!*head)
+		*tommy_hashlin_filter(head) = 0;
+}
+#endif
+
 TOMMY_API void tommy_hashlin_insert(tommy_hashlin* hashlin, tommy_hashlin_node* node, void* data, tommy_hash_t hash)
 {
-	tommy_list_insert_tail(tommy_hashlin_bucket_ref(hashlin, hash), node, data);
+	tommy_hashlin_node** head = tommy_hashlin_bucket_ref(hashlin, hash);
+
+	tommy_list_insert_tail(head, node, data);
 
 	node->index = hash;
 
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+	*tommy_hashlin_filter(head) |= tommy_hashlin_fingerprint(hash);
+#endif
+
 	++hashlin->count;
 
 	hashlin_grow_step(hashlin);
@@ -233,7 +277,13 @@ TOMMY_API void tommy_hashlin_insert(tommy_hashlin* hashlin, tommy_hashlin_node*
 
 TOMMY_API void* tommy_hashlin_remove_existing(tommy_hashlin* hashlin, tommy_hashlin_node* node)
 {
-	tommy_list_remove_existing(tommy_hashlin_bucket_ref(hashlin, node->index), node);
+	tommy_hashlin_node** head = tommy_hashlin_bucket_ref(hashlin, node->index);
+
+	tommy_list_remove_existing(head, node);
+
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+	tommy_hashlin_refilter(head);
+#endif
 
 	--hashlin->count;
 
@@ -252,6 +302,10 @@ TOMMY_API void* tommy_hashlin_remove(tommy_hashlin* hashlin, tommy_search_func*
 		if (node->index == hash && cmp(cmp_arg, node->data) == 0) {
 			tommy_list_remove_existing(let_ptr, node);
 
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+			tommy_hashlin_refilter(let_ptr);
+#endif
+
 			--hashlin->count;
 
 			hashlin_shrink_step(hashlin);
@@ -302,9 +356,106 @@ TOMMY_API void tommy_hashlin_foreach_arg(tommy_hashlin* hashlin, tommy_foreach_a
 	}
 }
 
+TOMMY_API int tommy_hashlin_save(tommy_hashlin* hashlin, const char* path, tommy_save_func* func, void* arg)
+{
+	FILE* f;
+	tommy_size_t bucket_max;
+	tommy_size_t pos;
+
+	f = tommy_file_create(path, sizeof(tommy_file_record), hashlin->count, hashlin->count);
+	if (!f)
+		return -1;
+
+	/* number of valid buckets */
+	bucket_max = hashlin->low_max + hashlin->split;
+
+	for (pos = 0; pos < bucket_max; ++pos) {
+		tommy_hashlin_node* node = *tommy_hashlin_pos(hashlin, pos);
+
+		while (node) {
+			tommy_file_record record;
+
+			record.hash = node->index;
+			record.offset = func(arg, node->data);
+
+			if (fwrite(&record, sizeof(record), 1, f) != 1) {
+				fclose(f);
+				return -1;
+			}
+
+			node = node->next;
+		}
+	}
+
+	return tommy_file_close(f, 0, 0);
+}
+
+TOMMY_API int tommy_hashlin_load(tommy_hashlin* hashlin, const char* path, tommy_load_func* func, void* arg)
+{
+	void* map;
+	void* base;
+	tommy_file_record* record;
+	tommy_size_t count;
+	tommy_size_t capacity;
+	tommy_size_t size;
+	tommy_size_t i;
+
+	map = tommy_file_map(path, TOMMY_MAP_READONLY, sizeof(tommy_file_record), &count, &capacity, &size);
+	if (!map)
+		return -1;
+
+	tommy_hashlin_init(hashlin);
+
+	/* allocate all the segments to have the hashtable at most 50% full */
+	while (count > hashlin->bucket_max / 2) {
+		tommy_hashlin_slot* segment;
+
+		segment = tommy_cast(tommy_hashlin_slot*, tommy_calloc(hashlin->bucket_max, sizeof(tommy_hashlin_slot)));
+
+		tommy_stats_inc(hashlin, segment);
+
+		/* store it adjusting the offset */
+		/* cast to ptrdiff_t to ensure to get a negative value */
+		hashlin->bucket[hashlin->bucket_bit] = &segment[-(tommy_ptrdiff_t)hashlin->bucket_max];
+
+		++hashlin->bucket_bit;
+		hashlin->bucket_max = (tommy_size_t)1 << hashlin->bucket_bit;
+		hashlin->bucket_mask = hashlin->bucket_max - 1;
+	}
+
+	tommy_hashlin_stable(hashlin);
+
+	hashlin->count = count;
+
+	base = tommy_cast(unsigned char*, map) + TOMMY_FILE_OFFSET;
+	record = tommy_cast(tommy_file_record*, base);
+	for (i = 0; i < count; ++i) {
+		tommy_hashlin_node* node;
+		void* data = func(arg, record[i].offset, &node);
+		tommy_hash_t hash = (tommy_hash_t)record[i].hash;
+		tommy_hashlin_node** head = tommy_hashlin_bucket_ref(hashlin, hash);
+
+		tommy_list_insert_tail(head, node, data);
+
+		node->index = hash;
+
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+		*tommy_hashlin_filter(head) |= tommy_hashlin_fingerprint(hash);
+#endif
+	}
+
+	tommy_file_unmap(map, size);
+
+	return 0;
+}
+
 TOMMY_API tommy_size_t tommy_hashlin_memory_usage(tommy_hashlin* hashlin)
 {
 	return hashlin->bucket_max * (tommy_size_t)sizeof(hashlin->bucket[0][0])
 	       + hashlin->count * (tommy_size_t)sizeof(tommy_hashlin_node);
 }
 
+TOMMY_API void tommy_hashlin_stats(tommy_hashlin* hashlin, tommy_stats* stats)
+{
+	tommy_stats_get(hashlin, stats);
+}
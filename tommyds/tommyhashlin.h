@@ -111,12 +111,27 @@
  * If you need a more precise control with a real iteration, you have to insert
  * all the elements also in a ::tommy_list, and use the list to iterate.
  * See the \ref multiindex example for more detail.
+ *
+ * If you compile with TOMMY_HASHLIN_FINGERPRINT defined, each bucket stores
+ * also a fingerprint of the hashes of its elements, as a bit mask with one bit
+ * set for each element, selected by a mix of all the hash bits.
+ * In this way, tommy_hashlin_search() resolves most of the misses without
+ * accessing any node, at the cost of doubling the size of the buckets,
+ * and of making the successful searches about 75% slower.
+ * The option changes the layout of the buckets, so it must be defined, or not,
+ * in all the sources including the Tommy headers, and in the library.
+ * A mismatch is detected at link time, as the init functions get different names.
+ * The bits of the removed elements are cleared only when the bucket becomes empty,
+ * or when it's split by a resize, to keep the removal in constant time.
+ * This is convenient only in workloads with many unsuccessful searches
+ * in large tables, as measured by the hashlin_search tests of tommymicro.
  */
 
 #ifndef __TOMMYHASHLIN_H
 #define __TOMMYHASHLIN_H
 
 #include "tommyhash.h"
+#include "tommyfile.h"
 
 /******************************************************************************/
 /* hashlin */
@@ -133,12 +148,39 @@
  */
 typedef tommy_node tommy_hashlin_node;
 
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+/** \internal
+ * Hashtable bucket with fingerprint.
+ * The head must be the first field, as a pointer at it is used to access the whole bucket.
+ */
+typedef struct tommy_hashlin_slot_struct {
+	tommy_hashlin_node* head; /**< Head of the list of the bucket. */
+	tommy_size_t filter; /**< Fingerprint of the hashes contained in the bucket. */
+} tommy_hashlin_slot;
+#else
+/** \internal
+ * Hashtable bucket.
+ */
+typedef tommy_hashlin_node* tommy_hashlin_slot;
+#endif
+
+/** \internal
+ * Name of a function depending on the layout of the buckets.
+ * It differs with TOMMY_HASHLIN_FINGERPRINT, and with TOMMY_STATS,
+ * to make a mismatch with the library fail at link time.
+ */
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+#define tommy_hashlin_name(name) tommy_stats_name(name##_fingerprint)
+#else
+#define tommy_hashlin_name(name) tommy_stats_name(name)
+#endif
+
 /**
  * Hashtable container type.
  * \note Don't use internal fields directly, but access the container only using functions.
  */
 typedef struct tommy_hashlin_struct {
-	tommy_hashlin_node** bucket[TOMMY_SIZE_BIT]; /**< Dynamic array of hash buckets. One list for each hash modulus. */
+	tommy_hashlin_slot* bucket[TOMMY_SIZE_BIT]; /**< Dynamic array of hash buckets. One list for each hash modulus. */
 	tommy_size_t bucket_max; /**< Number of buckets. */
 	tommy_size_t bucket_mask; /**< Bit mask to access the buckets. */
 	tommy_size_t low_max; /**< Low order max value. */
@@ -147,8 +189,16 @@ typedef struct tommy_hashlin_struct {
 	tommy_size_t count; /**< Number of elements. */
 	tommy_uint_t bucket_bit; /**< Bits used in the bit mask. */
 	tommy_uint_t state; /**< Reallocation state. */
+#ifdef TOMMY_STATS
+	tommy_stats stats; /**< Operation statistics. */
+#endif
 } tommy_hashlin;
 
+/** \internal
+ * Links only with a library compiled with the same TOMMY_STATS and TOMMY_HASHLIN_FINGERPRINT settings.
+ */
+#define tommy_hashlin_init tommy_hashlin_name(tommy_hashlin_init)
+
 /**
  * Initializes the hashtable.
  */
@@ -190,9 +240,51 @@ tommy_inline tommy_hashlin_node** tommy_hashlin_pos(tommy_hashlin* hashlin, tomm
 	/* get the highest bit set, in case of all 0, return 0 */
 	bsr = tommy_ilog2(pos | 1);
 
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+	return &hashlin->bucket[bsr][pos].head;
+#else
 	return &hashlin->bucket[bsr][pos];
+#endif
+}
+
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+/** \internal
+ * Multiplier and number of bits used to compute the fingerprint.
+ * The multiplier is the golden ratio, as in the Fibonacci hashing.
+ */
+#if TOMMY_SIZE_BIT == 64
+#define TOMMY_HASHLIN_FINGERPRINT_MUL (((tommy_size_t)0x9E3779B9 << 32) | 0x7F4A7C15)
+#define TOMMY_HASHLIN_FINGERPRINT_BIT 6
+#else
+#define TOMMY_HASHLIN_FINGERPRINT_MUL ((tommy_size_t)0x9E3779B9)
+#define TOMMY_HASHLIN_FINGERPRINT_BIT 5
+#endif
+
+/** \internal
+ * Returns the fingerprint bit of the specified hash.
+ * The bit is selected by the top bits of the hash multiplied by a large odd constant,
+ * that depend on all the hash bits. Taking some bits directly from the hash doesn't work,
+ * as the low ones select the bucket, and the high ones are 0 with the 32 bits hash functions.
+ */
+tommy_inline tommy_size_t tommy_hashlin_fingerprint(tommy_hash_t hash)
+{
+	tommy_size_t mix = (tommy_size_t)hash * TOMMY_HASHLIN_FINGERPRINT_MUL;
+
+	return (tommy_size_t)1 << (mix >> (TOMMY_SIZE_BIT - TOMMY_HASHLIN_FINGERPRINT_BIT));
 }
 
+/** \internal
+ * Returns the fingerprint of the bucket, given the pointer at its head.
+ */
+tommy_inline tommy_size_t* tommy_hashlin_filter(tommy_hashlin_node** head)
+{
+	void* ptr = head;
+	tommy_hashlin_slot* slot = tommy_cast(tommy_hashlin_slot*, ptr);
+
+	return &slot->filter;
+}
+#endif
+
 /** \internal
  * Returns a pointer to the bucket of the specified hash.
  */
@@ -247,14 +339,35 @@ tommy_inline tommy_hashlin_node* tommy_hashlin_bucket(tommy_hashlin* hashlin, to
  */
 tommy_inline void* tommy_hashlin_search(tommy_hashlin* hashlin, tommy_search_func* cmp, const void* cmp_arg, tommy_hash_t hash)
 {
+#ifdef TOMMY_STATS
+	tommy_size_t visit = 0;
+#endif
+#ifdef TOMMY_HASHLIN_FINGERPRINT
+	tommy_hashlin_node** head = tommy_hashlin_bucket_ref(hashlin, hash);
+	tommy_hashlin_node* i;
+
+	/* if the fingerprint doesn't match, the hash is not in the bucket */
+	/* this also covers the empty bucket, as it has an empty fingerprint */
+	if ((*tommy_hashlin_filter(head) & tommy_hashlin_fingerprint(hash)) == 0) {
+		tommy_stats_search(hashlin, 0, 0);
+		return 0;
+	}
+
+	i = *head;
+#else
 	tommy_hashlin_node* i = tommy_hashlin_bucket(hashlin, hash);
+#endif
 
 	while (i) {
+		tommy_stats_visit(visit);
 		/* we first check if the hash matches, as in the same bucket we may have multiple hash values */
-		if (i->index == hash && cmp(cmp_arg, i->data) == 0)
+		if (i->index == hash && cmp(cmp_arg, i->data) == 0) {
+			tommy_stats_search(hashlin, visit, 1);
 			return i->data;
+		}
 		i = i->next;
 	}
+	tommy_stats_search(hashlin, visit, 0);
 	return 0;
 }
 
@@ -311,10 +424,45 @@ tommy_inline tommy_size_t tommy_hashlin_count(tommy_hashlin* hashlin)
 	return hashlin->count;
 }
 
+/**
+ * Saves the hashtable in a file, that can be later loaded with tommy_hashlin_load().
+ * For each element, the file contains only its hash and the position of the
+ * object, that you have to provide. The objects have to be saved separately.
+ * \param path Path of the file to create.
+ * \param func Function called to get the position of each object.
+ * \param arg Argument passed to the function.
+ * \return 0 on success, or -1 on error.
+ */
+TOMMY_API int tommy_hashlin_save(tommy_hashlin* hashlin, const char* path, tommy_save_func* func, void* arg);
+
+/** \internal
+ * Links only with a library compiled with the same TOMMY_STATS and TOMMY_HASHLIN_FINGERPRINT settings.
+ */
+#define tommy_hashlin_load tommy_hashlin_name(tommy_hashlin_load)
+
+/**
+ * Initializes the hashtable loading a file saved with tommy_hashlin_save().
+ * All the bucket segments are allocated at once with the final size, and the
+ * elements are inserted with the saved hash, in a sequential pass of the
+ * file, without resizing and without computing any hash.
+ * \param path Path of the file to load.
+ * \param func Function called to get the object at each position.
+ * \param arg Argument passed to the function.
+ * \return 0 on success, or -1 on error. On error the hashtable is not initialized.
+ */
+TOMMY_API int tommy_hashlin_load(tommy_hashlin* hashlin, const char* path, tommy_load_func* func, void* arg);
+
 /**
  * Gets the size of allocated memory.
  * It includes the size of the ::tommy_hashlin_node of the stored elements.
  */
 TOMMY_API tommy_size_t tommy_hashlin_memory_usage(tommy_hashlin* hashlin);
 
+/**
+ * Gets the operation statistics.
+ * They are collected only if the library is compiled with TOMMY_STATS defined,
+ * otherwise they are all reported as 0.
+ */
+TOMMY_API void tommy_hashlin_stats(tommy_hashlin* hashlin, tommy_stats* stats);
+
 #endif
@@ -0,0 +1,332 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+#include "tommyhashlinc.h"
+
+/******************************************************************************/
+/* hashlinc */
+
+/**
+ * Reallocation states.
+ */
+#define TOMMY_HASHLINC_STATE_STABLE 0
+#define TOMMY_HASHLINC_STATE_GROW 1
+#define TOMMY_HASHLINC_STATE_SHRINK 2
+
+/**
+ * Set the hashtable in stable state.
+ */
+tommy_inline void tommy_hashlinc_stable(tommy_hashlinc* hashlinc)
+{
+	hashlinc->state = TOMMY_HASHLINC_STATE_STABLE;
+
+	/* setup low_mask/max/split to allow tommy_hashlinc_bucket_ref() */
+	/* and tommy_hashlinc_foreach() to work regardless we are in stable state */
+	hashlinc->low_max = hashlinc->bucket_max;
+	hashlinc->low_mask = hashlinc->bucket_mask;
+	hashlinc->split = 0;
+}
+
+TOMMY_API void tommy_hashlinc_init(tommy_hashlinc* hashlinc, tommy_size_t offset)
+{
+	tommy_uint_t i;
+
+	/* fixed initial size */
+	hashlinc->bucket_bit = TOMMY_HASHLINC_BIT;
+	hashlinc->bucket_max = (tommy_size_t)1 << hashlinc->bucket_bit;
+	hashlinc->bucket_mask = hashlinc->bucket_max - 1;
+	hashlinc->bucket[0] = tommy_cast(tommy_hashlinc_node**, tommy_calloc(hashlinc->bucket_max, sizeof(tommy_hashlinc_node*)));
+	for (i = 1; i < TOMMY_HASHLINC_BIT; ++i)
+		hashlinc->bucket[i] = hashlinc->bucket[0];
+
+	/* stable state */
+	tommy_hashlinc_stable(hashlinc);
+
+	hashlinc->count = 0;
+	hashlinc->offset = offset;
+
+	tommy_stats_init(hashlinc);
+	tommy_stats_inc(hashlinc, segment);
+}
+
+TOMMY_API void tommy_hashlinc_done(tommy_hashlinc* hashlinc)
+{
+	tommy_uint_t i;
+
+	tommy_free(hashlinc->bucket[0]);
+	for (i = TOMMY_HASHLINC_BIT; i < hashlinc->bucket_bit; ++i) {
+		tommy_hashlinc_node** segment = hashlinc->bucket[i];
+		tommy_free(&segment[(tommy_ptrdiff_t)1 << i]);
+	}
+}
+
+/**
+ * Grow one step.
+ */
+tommy_inline void hashlinc_grow_step(tommy_hashlinc* hashlinc)
+{
+	/* grow if more than 50% full */
+	if (hashlinc->state != TOMMY_HASHLINC_STATE_GROW
+		&& hashlinc->count > hashlinc->bucket_max / 2
+	) {
+		/* if we are stable, setup a new grow state */
+		/* otherwise continue with the already setup shrink one */
+		/* but in backward direction */
+		if (hashlinc->state == TOMMY_HASHLINC_STATE_STABLE) {
+			tommy_hashlinc_node** segment;
+
+			/* set the lower size */
+			hashlinc->low_max = hashlinc->bucket_max;
+			hashlinc->low_mask = hashlinc->bucket_mask;
+
+			/* allocate the new vector using malloc() and not calloc() */
+			/* because data is fully initialized in the split process */
+			segment = tommy_cast(tommy_hashlinc_node**, tommy_malloc(hashlinc->low_max * sizeof(tommy_hashlinc_node*)));
+
+			tommy_stats_inc(hashlinc, segment);
+			tommy_stats_inc(hashlinc, rehash);
+
+			/* store it adjusting the offset */
+			/* cast to ptrdiff_t to ensure to get a negative value */
+			hashlinc->bucket[hashlinc->bucket_bit] = &segment[-(tommy_ptrdiff_t)hashlinc->low_max];
+
+			/* grow the hash size */
+			++hashlinc->bucket_bit;
+			hashlinc->bucket_max = (tommy_size_t)1 << hashlinc->bucket_bit;
+			hashlinc->bucket_mask = hashlinc->bucket_max - 1;
+
+			/* start from the beginning going forward */
+			hashlinc->split = 0;
+		}
+
+		/* grow state */
+		hashlinc->state = TOMMY_HASHLINC_STATE_GROW;
+	}
+
+	/* if we are growing */
+	if (hashlinc->state == TOMMY_HASHLINC_STATE_GROW) {
+		/* compute the split target required to finish the reallocation before the next resize */
+		tommy_size_t split_target = 2 * hashlinc->count;
+
+		/* reallocate buckets until the split target */
+		while (hashlinc->split + hashlinc->low_max < split_target) {
+			tommy_hashlinc_node** split[2];
+			tommy_hashlinc_node* j;
+			tommy_size_t mask;
+
+			/* get the low bucket */
+			split[0] = tommy_hashlinc_pos(hashlinc, hashlinc->split);
+
+			/* get the high bucket */
+			split[1] = tommy_hashlinc_pos(hashlinc, hashlinc->split + hashlinc->low_max);
+
+			/* save the low bucket */
+			j = *split[0];
+
+			/* the bit used to identify the bucket */
+			mask = hashlinc->low_max;
+
+			/* flush the bucket, keeping the order, using split[] as pointers at the tails */
+			while (j) {
+				tommy_size_t pos = (j->index & mask) != 0;
+				*split[pos] = j;
+				split[pos] = &j->next;
+				j = j->next;
+			}
+
+			*split[0] = 0;
+			*split[1] = 0;
+
+			tommy_stats_inc(hashlinc, grow);
+
+			/* go forward */
+			++hashlinc->split;
+
+			/* if we have finished, change the state */
+			if (hashlinc->split == hashlinc->low_max) {
+				/* go in stable mode */
+				tommy_hashlinc_stable(hashlinc);
+				break;
+			}
+		}
+	}
+}
+
+/**
+ * Shrink one step.
+ */
+tommy_inline void hashlinc_shrink_step(tommy_hashlinc* hashlinc)
+{
+	/* shrink if less than 12.5% full */
+	if (hashlinc->state != TOMMY_HASHLINC_STATE_SHRINK
+		&& hashlinc->count < hashlinc->bucket_max / 8
+	) {
+		/* avoid to shrink the first bucket */
+		if (hashlinc->bucket_bit > TOMMY_HASHLINC_BIT) {
+			/* if we are stable, setup a new shrink state */
+			/* otherwise continue with the already setup grow one */
+			/* but in backward direction */
+			if (hashlinc->state == TOMMY_HASHLINC_STATE_STABLE) {
+				/* set the lower size */
+				hashlinc->low_max = hashlinc->bucket_max / 2;
+				hashlinc->low_mask = hashlinc->bucket_mask / 2;
+
+				/* start from the half going backward */
+				hashlinc->split = hashlinc->low_max;
+			}
+
+			/* start reallocation */
+			hashlinc->state = TOMMY_HASHLINC_STATE_SHRINK;
+		}
+	}
+
+	/* if we are shrinking */
+	if (hashlinc->state == TOMMY_HASHLINC_STATE_SHRINK) {
+		/* compute the split target required to finish the reallocation before the next resize */
+		tommy_size_t split_target = 8 * hashlinc->count;
+
+		/* reallocate buckets until the split target */
+		while (hashlinc->split + hashlinc->low_max > split_target) {
+			tommy_hashlinc_node** tail;
+
+			/* go backward position */
+			--hashlinc->split;
+
+			tommy_stats_inc(hashlinc, shrink);
+
+			/* get the tail of the low bucket */
+			tail = tommy_hashlinc_pos(hashlinc, hashlinc->split);
+			while (*tail)
+				tail = &(*tail)->next;
+
+			/* concat the high bucket into the low one */
+			*tail = *tommy_hashlinc_pos(hashlinc, hashlinc->split + hashlinc->low_max);
+
+			/* if we have finished, clean up and change the state */
+			if (hashlinc->split == 0) {
+				tommy_hashlinc_node** segment;
+
+				tommy_stats_inc(hashlinc, rehash);
+
+				/* shrink the hash size */
+				--hashlinc->bucket_bit;
+				hashlinc->bucket_max = (tommy_size_t)1 << hashlinc->bucket_bit;
+				hashlinc->bucket_mask = hashlinc->bucket_max - 1;
+
+				/* free the last segment */
+				segment = hashlinc->bucket[hashlinc->bucket_bit];
+				tommy_free(&segment[(tommy_ptrdiff_t)1 << hashlinc->bucket_bit]);
+
+				/* go in stable mode */
+				tommy_hashlinc_stable(hashlinc);
+				break;
+			}
+		}
+	}
+}
+
+TOMMY_API void tommy_hashlinc_insert(tommy_hashlinc* hashlinc, tommy_hashlinc_node* node, tommy_hash_t hash)
+{
+	tommy_hashlinc_node** bucket = tommy_hashlinc_bucket_ref(hashlinc, hash);
+
+	/* insert at the head, as the list is singly linked */
+	node->next = *bucket;
+	node->index = hash;
+	*bucket = node;
+
+	++hashlinc->count;
+
+	hashlinc_grow_step(hashlinc);
+}
+
+TOMMY_API void* tommy_hashlinc_remove_existing(tommy_hashlinc* hashlinc, tommy_hashlinc_node* node)
+{
+	tommy_hashlinc_node** let = tommy_hashlinc_bucket_ref(hashlinc, node->index);
+
+	/* search the pointer to the node */
+	while (*let != node)
+		let = &(*let)->next;
+
+	*let = node->next;
+
+	--hashlinc->count;
+
+	hashlinc_shrink_step(hashlinc);
+
+	return tommy_hashlinc_data(hashlinc, node);
+}
+
+TOMMY_API void* tommy_hashlinc_remove(tommy_hashlinc* hashlinc, tommy_search_func* cmp, const void* cmp_arg, tommy_hash_t hash)
+{
+	tommy_hashlinc_node** let = tommy_hashlinc_bucket_ref(hashlinc, hash);
+
+	while (*let) {
+		tommy_hashlinc_node* node = *let;
+
+		/* we first check if the hash matches, as in the same bucket we may have multiples hash values */
+		if (node->index == hash) {
+			void* data = tommy_hashlinc_data(hashlinc, node);
+			if (cmp(cmp_arg, data) == 0) {
+				*let = node->next;
+
+				--hashlinc->count;
+
+				hashlinc_shrink_step(hashlinc);
+
+				return data;
+			}
+		}
+		let = &node->next;
+	}
+
+	return 0;
+}
+
+TOMMY_API void tommy_hashlinc_foreach(tommy_hashlinc* hashlinc, tommy_foreach_func* func)
+{
+	tommy_size_t bucket_max;
+	tommy_size_t pos;
+
+	/* number of valid buckets */
+	bucket_max = hashlinc->low_max + hashlinc->split;
+
+	for (pos = 0; pos < bucket_max; ++pos) {
+		tommy_hashlinc_node* node = *tommy_hashlinc_pos(hashlinc, pos);
+
+		while (node) {
+			void* data = tommy_hashlinc_data(hashlinc, node);
+			node = node->next;
+			func(data);
+		}
+	}
+}
+
+TOMMY_API void tommy_hashlinc_foreach_arg(tommy_hashlinc* hashlinc, tommy_foreach_arg_func* func, void* arg)
+{
+	tommy_size_t bucket_max;
+	tommy_size_t pos;
+
+	/* number of valid buckets */
+	bucket_max = hashlinc->low_max + hashlinc->split;
+
+	for (pos = 0; pos < bucket_max; ++pos) {
+		tommy_hashlinc_node* node = *tommy_hashlinc_pos(hashlinc, pos);
+
+		while (node) {
+			void* data = tommy_hashlinc_data(hashlinc, node);
+			node = node->next;
+			func(arg, data);
+		}
+	}
+}
+
+TOMMY_API tommy_size_t tommy_hashlinc_memory_usage(tommy_hashlinc* hashlinc)
+{
+	return hashlinc->bucket_max * (tommy_size_t)sizeof(hashlinc->bucket[0][0])
+	       + hashlinc->count * (tommy_size_t)sizeof(tommy_hashlinc_node);
+}
+
+TOMMY_API void tommy_hashlinc_stats(tommy_hashlinc* hashlinc, tommy_stats* stats)
+{
+	tommy_stats_get(hashlinc, stats);
+}
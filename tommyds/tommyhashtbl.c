@@ -27,6 +27,9 @@ TOMMY_API void tommy_hashtable_init(tommy_hashtable* hashtable, tommy_size_t buc
 	memset(hashtable->bucket, 0, hashtable->bucket_max * sizeof(tommy_hashtable_node*));
 
 	hashtable->count = 0;
+
+	tommy_stats_init(hashtable);
+	tommy_stats_inc(hashtable, segment);
 }
 
 TOMMY_API void tommy_hashtable_done(tommy_hashtable* hashtable)
@@ -116,3 +119,7 @@ TOMMY_API tommy_size_t tommy_hashtable_memory_usage(tommy_hashtable* hashtable)
 	       + tommy_hashtable_count(hashtable) * (tommy_size_t)sizeof(tommy_hashtable_node);
 }
 
+TOMMY_API void tommy_hashtable_stats(tommy_hashtable* hashtable, tommy_stats* stats)
+{
+	tommy_stats_get(hashtable, stats);
+}
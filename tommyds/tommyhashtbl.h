@@ -123,8 +123,16 @@ typedef struct tommy_hashtable_struct {
 	tommy_size_t bucket_max; /**< Number of buckets. */
 	tommy_size_t bucket_mask; /**< Bit mask to access the buckets. */
 	tommy_size_t count; /**< Number of elements. */
+#ifdef TOMMY_STATS
+	tommy_stats stats; /**< Operation statistics. */
+#endif
 } tommy_hashtable;
 
+/** \internal
+ * Links only with a library compiled with the same TOMMY_STATS setting.
+ */
+#define tommy_hashtable_init tommy_stats_name(tommy_hashtable_init)
+
 /**
  * Initializes the hashtable.
  * \param buckets Minimum number of buckets to allocate. The effective number used is the next power of 2.
@@ -183,13 +191,20 @@ tommy_inline tommy_hashtable_node* tommy_hashtable_bucket(tommy_hashtable* hasht
 tommy_inline void* tommy_hashtable_search(tommy_hashtable* hashtable, tommy_search_func* cmp, const void* cmp_arg, tommy_hash_t hash)
 {
 	tommy_hashtable_node* i = tommy_hashtable_bucket(hashtable, hash);
+#ifdef TOMMY_STATS
+	tommy_size_t visit = 0;
+#endif
 
 	while (i) {
+		tommy_stats_visit(visit);
 		/* we first check if the hash matches, as in the same bucket we may have multiple hash values */
-		if (i->index == hash && cmp(cmp_arg, i->data) == 0)
+		if (i->index == hash && cmp(cmp_arg, i->data) == 0) {
+			tommy_stats_search(hashtable, visit, 1);
 			return i->data;
+		}
 		i = i->next;
 	}
+	tommy_stats_search(hashtable, visit, 0);
 	return 0;
 }
 
@@ -252,4 +267,11 @@ tommy_inline tommy_size_t tommy_hashtable_count(tommy_hashtable* hashtable)
  */
 TOMMY_API tommy_size_t tommy_hashtable_memory_usage(tommy_hashtable* hashtable);
 
+/**
+ * Gets the operation statistics.
+ * They are collected only if the library is compiled with TOMMY_STATS defined,
+ * otherwise they are all reported as 0.
+ */
+TOMMY_API void tommy_hashtable_stats(tommy_hashtable* hashtable, tommy_stats* stats);
+
 #endif
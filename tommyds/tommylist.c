@@ -34,3 +34,197 @@ TOMMY_API void tommy_list_sort(tommy_list* list, tommy_compare_func* cmp)
 	tommy_list_set(list, chain.head, chain.tail);
 }
 
+/** \internal
+ * Context of the parallel sort jobs.
+ */
+struct tommy_list_sort_context {
+	tommy_chain* run; /**< Vector of runs. */
+	tommy_compare_func* cmp; /**< Compare function. */
+	tommy_size_t runs; /**< Number of runs. */
+	tommy_size_t step; /**< Distance between the runs to merge. */
+};
+
+/** \internal
+ * Job sorting a single run.
+ */
+static void tommy_list_sort_job(void* void_context, tommy_size_t index)
+{
+	struct tommy_list_sort_context* context = tommy_cast(struct tommy_list_sort_context*, void_context);
+
+	tommy_chain_mergesort(&context->run[index], context->cmp);
+}
+
+/** \internal
+ * Job merging two consecutive runs.
+ */
+static void tommy_list_merge_job(void* void_context, tommy_size_t index)
+{
+	struct tommy_list_sort_context* context = tommy_cast(struct tommy_list_sort_context*, void_context);
+	tommy_size_t first = index * 2 * context->step;
+	tommy_size_t second = first + context->step;
+
+	/* the last run may not have a pair */
+	if (second >= context->runs)
+		return;
+
+	/* merge keeping the stability, as the first run contains the preceding elements */
+	tommy_chain_merge_degenerated(&context->run[first], &context->run[second], context->cmp);
+}
+
+TOMMY_API void tommy_list_sort_parallel(tommy_list* list, tommy_compare_func* cmp, tommy_size_t runs, tommy_parallel_func* parallel, void* arg)
+{
+	struct tommy_list_sort_context context;
+	tommy_size_t count;
+	tommy_size_t i;
+	tommy_node* node;
+
+	count = tommy_list_count(list);
+
+	/* at least two elements for each run */
+	if (runs > count / 2)
+		runs = count / 2;
+
+	if (runs <= 1) {
+		tommy_list_sort(list, cmp);
+		return;
+	}
+
+	context.run = tommy_cast(tommy_chain*, tommy_malloc(runs * sizeof(tommy_chain)));
+	context.cmp = cmp;
+	context.runs = runs;
+
+	/* split the list in runs of about the same size */
+	node = tommy_list_head(list);
+	for (i = 0; i < runs; ++i) {
+		tommy_size_t size = count / runs + (i < count % runs);
+
+		context.run[i].head = node;
+		while (--size)
+			node = node->next;
+		context.run[i].tail = node;
+		node = node->next;
+	}
+
+	/* sort all the runs */
+	if (parallel)
+		parallel(arg, tommy_list_sort_job, &context, runs);
+	else
+		for (i = 0; i < runs; ++i)
+			tommy_list_sort_job(&context, i);
+
+	/* merge the runs by pairs, doubling the distance at each round */
+	for (context.step = 1; context.step < runs; context.step *= 2) {
+		tommy_size_t jobs = (runs + 2 * context.step - 1) / (2 * context.step);
+
+		if (parallel)
+			parallel(arg, tommy_list_merge_job, &context, jobs);
+		else
+			for (i = 0; i < jobs; ++i)
+				tommy_list_merge_job(&context, i);
+	}
+
+	/* restore the list */
+	tommy_list_set(list, context.run[0].head, context.run[0].tail);
+
+	tommy_free(context.run);
+}
+
+/** \internal
+ * Max bits of the radix digit.
+ */
+#define TOMMY_LIST_RADIX_BIT 11
+
+/** \internal
+ * Max number of buckets of the radix sort.
+ */
+#define TOMMY_LIST_RADIX_MAX (1 << TOMMY_LIST_RADIX_BIT)
+
+TOMMY_API void tommy_list_sort_index(tommy_list* list)
+{
+	tommy_node** bucket_head;
+	tommy_node** bucket_tail;
+	tommy_node* head;
+	tommy_node* tail;
+	tommy_node* node;
+	tommy_node* prev;
+	tommy_size_t first;
+	tommy_size_t diff;
+	tommy_size_t mask;
+	tommy_uint_t low;
+	tommy_uint_t bits;
+	tommy_uint_t pass;
+	tommy_uint_t width;
+	tommy_uint_t shift;
+	tommy_size_t i;
+
+	if (tommy_list_empty(list))
+		return;
+
+	head = tommy_list_head(list);
+	tail = head->prev;
+
+	/* get the bits that differ in the keys */
+	first = head->index;
+	diff = 0;
+	for (node = head->next; node; node = node->next)
+		diff |= node->index ^ first;
+
+	/* all equal keys, nothing to do */
+	if (!diff)
+		return;
+
+	/* sort only the range of bits that differ, using digits of the same width */
+	low = tommy_ctz(diff);
+	bits = tommy_ilog2(diff) + 1 - low;
+	pass = (bits + TOMMY_LIST_RADIX_BIT - 1) / TOMMY_LIST_RADIX_BIT;
+	width = (bits + pass - 1) / pass;
+	mask = ((tommy_size_t)1 << width) - 1;
+
+	bucket_head = tommy_cast(tommy_node**, tommy_malloc(2 * (mask + 1) * sizeof(tommy_node*)));
+	bucket_tail = bucket_head + mask + 1;
+
+	for (shift = low; shift < low + bits; shift += width) {
+		for (i = 0; i <= mask; ++i)
+			bucket_head[i] = 0;
+
+		/* distribute in the buckets, keeping the order */
+		node = head;
+		while (node) {
+			tommy_node* next = node->next;
+			tommy_size_t digit = (node->index >> shift) & mask;
+
+			if (bucket_head[digit])
+				bucket_tail[digit]->next = node;
+			else
+				bucket_head[digit] = node;
+			bucket_tail[digit] = node;
+
+			node = next;
+		}
+
+		/* collect the buckets */
+		head = 0;
+		for (i = 0; i <= mask; ++i) {
+			if (!bucket_head[i])
+				continue;
+			if (head)
+				tail->next = bucket_head[i];
+			else
+				head = bucket_head[i];
+			tail = bucket_tail[i];
+		}
+		tail->next = 0;
+	}
+
+	tommy_free(bucket_head);
+
+	/* rebuild the prev pointers */
+	prev = head;
+	for (node = head->next; node; node = node->next) {
+		node->prev = prev;
+		prev = node;
+	}
+
+	/* restore the list */
+	tommy_list_set(list, head, tail);
+}
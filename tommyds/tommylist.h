@@ -331,6 +331,33 @@ tommy_inline void tommy_list_concat(tommy_list* first, tommy_list* second)
  */
 TOMMY_API void tommy_list_sort(tommy_list* list, tommy_compare_func* cmp);
 
+/**
+ * Sorts a list using multiple threads.
+ * The list is split in the specified number of runs of about the same size,
+ * every run is sorted by a different job, and the sorted runs are merged
+ * together in log2(runs) rounds of parallel jobs.
+ *
+ * The jobs are run by the provided parallel function, that allows you to use
+ * your threads without adding any threading dependency to Tommy.
+ *
+ * It's a stable sort, with the same result of tommy_list_sort().
+ * \param cmp Compare function called with two elements.
+ * \param runs Number of runs in which the list is split. Usually the number of threads available.
+ * \param parallel Parallel function used to run the jobs. If 0, all the jobs are run in the calling thread.
+ * \param arg Argument passed to the parallel function.
+ */
+TOMMY_API void tommy_list_sort_parallel(tommy_list* list, tommy_compare_func* cmp, tommy_size_t runs, tommy_parallel_func* parallel, void* arg);
+
+/**
+ * Sorts a list using the tommy_node::index field as key.
+ * It's a stable LSD radix sort with O(N) complexity, that relinks the nodes
+ * without calling any compare function.
+ * Only the range of bits that differ in the keys is sorted, in passes of
+ * at most 11 bits, so keys in a range of 2^22 values are sorted in two passes.
+ * It allocates a temporary vector of buckets of at most 32 kB.
+ */
+TOMMY_API void tommy_list_sort_index(tommy_list* list);
+
 /**
  * Checks if empty.
  * \return If the list is empty.
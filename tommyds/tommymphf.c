@@ -0,0 +1,396 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+#include "tommymphf.h"
+#include "tommyfileint.h"
+
+#include <string.h> /* for memcpy, memmove */
+#include <stdlib.h> /* for qsort */
+
+/******************************************************************************/
+/* mphf */
+
+/**
+ * Layout of the memory block, as vector of tommy_size_t words.
+ * [0] Number of keys.
+ * [1] Number of keys not placed in any level.
+ * [2] Number of levels.
+ * [3] Number of words of the bits.
+ * [4 ...] Number of bits of each level, for all the TOMMY_MPHF_LEVEL_MAX levels.
+ * [...] Keys not placed in any level, sorted, as tommy_uint64_t.
+ * [...] Padding to align the blocks at the cache line.
+ * [...] Blocks, each one with the number of bits set before it, and the bits of the levels.
+ *
+ * The memory block is aligned at the cache line, and then all the blocks are.
+ */
+#define TOMMY_MPHF_HEADER (4 + TOMMY_MPHF_LEVEL_MAX)
+
+/**
+ * Number of words of a key.
+ */
+#define TOMMY_MPHF_KEY_WORD (sizeof(tommy_uint64_t) / sizeof(tommy_size_t))
+
+/**
+ * Position of the first block in the memory block.
+ */
+static tommy_size_t mphf_offset(tommy_size_t fallback_count)
+{
+	tommy_size_t offset = TOMMY_MPHF_HEADER + fallback_count * TOMMY_MPHF_KEY_WORD;
+
+	return (offset + TOMMY_MPHF_BLOCK_WORD - 1) / TOMMY_MPHF_BLOCK_WORD * TOMMY_MPHF_BLOCK_WORD;
+}
+
+/**
+ * Number of blocks containing the specified number of words of bits.
+ */
+static tommy_size_t mphf_blocks(tommy_size_t bit_words)
+{
+	return (bit_words + TOMMY_MPHF_BLOCK_WORD - 2) / (TOMMY_MPHF_BLOCK_WORD - 1);
+}
+
+/**
+ * Number of words of the memory block.
+ */
+static tommy_size_t mphf_words(tommy_size_t fallback_count, tommy_size_t bit_words)
+{
+	return mphf_offset(fallback_count) + mphf_blocks(bit_words) * TOMMY_MPHF_BLOCK_WORD;
+}
+
+/**
+ * Setup the pointers in the memory block.
+ */
+static void mphf_setup(tommy_mphf* mphf, tommy_size_t* word)
+{
+	void* fallback;
+
+	mphf->count = word[0];
+	mphf->fallback_count = word[1];
+	mphf->level_count = (tommy_uint_t)word[2];
+	mphf->level = word + 4;
+
+	fallback = word + TOMMY_MPHF_HEADER;
+	mphf->fallback = tommy_cast(tommy_uint64_t*, fallback);
+
+	mphf->block = word + mphf_offset(mphf->fallback_count);
+}
+
+/**
+ * Sets a bit of a word shared by multiple jobs.
+ * \return If the bit was already set.
+ */
+static tommy_bool_t mphf_set(tommy_size_t volatile* ptr, tommy_size_t mask)
+{
+	tommy_size_t value;
+
+	do {
+		value = tommy_atomic_load(ptr);
+		if (value & mask)
+			return 1;
+	} while (!tommy_atomic_cas(ptr, value, value | mask));
+
+	return 0;
+}
+
+/**
+ * Context of the jobs building a level.
+ */
+struct tommy_mphf_context {
+	tommy_uint64_t* key; /**< Keys still to place. */
+	tommy_size_t count; /**< Number of keys still to place. */
+	tommy_size_t size; /**< Number of bits of the level. */
+	tommy_uint_t level; /**< Level. */
+	tommy_size_t* bit; /**< Bits of the keys hashed in the level. */
+	tommy_size_t* collide; /**< Bits of the keys colliding in the level. */
+	tommy_size_t* kept; /**< Number of keys kept by each job. */
+};
+
+/**
+ * Job setting the bits of a range of keys.
+ */
+static void tommy_mphf_mark_job(void* void_context, tommy_size_t index)
+{
+	struct tommy_mphf_context* context = tommy_cast(struct tommy_mphf_context*, void_context);
+	tommy_size_t begin = index * TOMMY_MPHF_JOB;
+	tommy_size_t end = begin + TOMMY_MPHF_JOB;
+	tommy_size_t i;
+
+	if (end > context->count)
+		end = context->count;
+
+	for (i = begin; i < end; ++i) {
+		tommy_size_t bit = tommy_mphf_bit(context->key[i], context->level, context->size);
+		tommy_size_t word = bit / TOMMY_SIZE_BIT;
+		tommy_size_t mask = (tommy_size_t)1 << (bit % TOMMY_SIZE_BIT);
+
+		if (mphf_set(&context->bit[word], mask))
+			mphf_set(&context->collide[word], mask);
+	}
+}
+
+/**
+ * Job keeping the colliding keys of a range, moving them at the start of the range.
+ */
+static void tommy_mphf_keep_job(void* void_context, tommy_size_t index)
+{
+	struct tommy_mphf_context* context = tommy_cast(struct tommy_mphf_context*, void_context);
+	tommy_size_t begin = index * TOMMY_MPHF_JOB;
+	tommy_size_t end = begin + TOMMY_MPHF_JOB;
+	tommy_size_t kept = begin;
+	tommy_size_t i;
+
+	if (end > context->count)
+		end = context->count;
+
+	for (i = begin; i < end; ++i) {
+		tommy_size_t bit = tommy_mphf_bit(context->key[i], context->level, context->size);
+		tommy_size_t word = bit / TOMMY_SIZE_BIT;
+		tommy_size_t mask = (tommy_size_t)1 << (bit % TOMMY_SIZE_BIT);
+
+		if (context->collide[word] & mask)
+			context->key[kept++] = context->key[i];
+	}
+
+	context->kept[index] = kept - begin;
+}
+
+/**
+ * Runs the jobs, in parallel if requested.
+ */
+static void mphf_run(tommy_job_func* job, struct tommy_mphf_context* context, tommy_size_t count, tommy_parallel_func* parallel, void* arg)
+{
+	tommy_size_t i;
+
+	if (parallel) {
+		parallel(arg, job, context, count);
+	} else {
+		for (i = 0; i < count; ++i)
+			job(context, i);
+	}
+}
+
+/**
+ * Compares two keys for qsort().
+ */
+static int mphf_compare(const void* void_a, const void* void_b)
+{
+	const tommy_uint64_t* a = tommy_cast(const tommy_uint64_t*, void_a);
+	const tommy_uint64_t* b = tommy_cast(const tommy_uint64_t*, void_b);
+
+	if (*a < *b)
+		return -1;
+	if (*a > *b)
+		return 1;
+	return 0;
+}
+
+TOMMY_API void tommy_mphf_init(tommy_mphf* mphf, const tommy_uint64_t* key, tommy_size_t count, tommy_parallel_func* parallel, void* arg)
+{
+	struct tommy_mphf_context context;
+	tommy_size_t* level_bit[TOMMY_MPHF_LEVEL_MAX];
+	tommy_size_t level_size[TOMMY_MPHF_LEVEL_MAX];
+	tommy_uint_t level_count;
+	tommy_size_t bit_words;
+	tommy_size_t remaining;
+	tommy_size_t* word;
+	tommy_size_t blocks;
+	tommy_size_t rank;
+	tommy_size_t pos;
+	tommy_size_t i;
+	tommy_uint_t j;
+	void* align;
+
+	context.key = tommy_cast(tommy_uint64_t*, tommy_malloc(count * sizeof(tommy_uint64_t)));
+	if (count != 0)
+		memcpy(context.key, key, count * sizeof(tommy_uint64_t));
+
+	remaining = count;
+	level_count = 0;
+	bit_words = 0;
+	while (remaining != 0 && level_count < TOMMY_MPHF_LEVEL_MAX) {
+		tommy_size_t words = (TOMMY_MPHF_GAMMA * remaining + TOMMY_SIZE_BIT - 1) / TOMMY_SIZE_BIT;
+		tommy_size_t jobs = (remaining + TOMMY_MPHF_JOB - 1) / TOMMY_MPHF_JOB;
+
+		context.count = remaining;
+		context.size = words * TOMMY_SIZE_BIT;
+		context.level = level_count;
+		context.bit = tommy_cast(tommy_size_t*, tommy_calloc(words, sizeof(tommy_size_t)));
+		context.collide = tommy_cast(tommy_size_t*, tommy_calloc(words, sizeof(tommy_size_t)));
+		context.kept = tommy_cast(tommy_size_t*, tommy_malloc(jobs * sizeof(tommy_size_t)));
+
+		/* set the bits of all the keys, marking the collisions */
+		mphf_run(tommy_mphf_mark_job, &context, jobs, parallel, arg);
+
+		/* keep the keys that collide, for the next level */
+		mphf_run(tommy_mphf_keep_job, &context, jobs, parallel, arg);
+
+		/* pack the kept keys at the start */
+		remaining = 0;
+		for (i = 0; i < jobs; ++i) {
+			memmove(context.key + remaining, context.key + i * TOMMY_MPHF_JOB, context.kept[i] * sizeof(tommy_uint64_t));
+			remaining += context.kept[i];
+		}
+
+		/* only the keys without collisions are placed */
+		for (i = 0; i < words; ++i)
+			context.bit[i] &= ~context.collide[i];
+
+		tommy_free(context.collide);
+		tommy_free(context.kept);
+
+		level_bit[level_count] = context.bit;
+		level_size[level_count] = context.size;
+		++level_count;
+		bit_words += words;
+	}
+
+	/* allocate one more cache line to align the blocks */
+	mphf->data_size = mphf_words(remaining, bit_words) * sizeof(tommy_size_t) + TOMMY_CACHELINE;
+	mphf->data = tommy_calloc(mphf->data_size, 1);
+	mphf->map = 0;
+
+	align = (void*)(((tommy_uintptr_t)mphf->data + TOMMY_CACHELINE - 1) & ~(tommy_uintptr_t)(TOMMY_CACHELINE - 1));
+	word = tommy_cast(tommy_size_t*, align);
+	word[0] = count;
+	word[1] = remaining;
+	word[2] = level_count;
+	word[3] = bit_words;
+
+	mphf_setup(mphf, word);
+
+	/* the keys not placed get the last positions, in order */
+	if (remaining != 0) {
+		qsort(context.key, remaining, sizeof(tommy_uint64_t), mphf_compare);
+		memcpy(mphf->fallback, context.key, remaining * sizeof(tommy_uint64_t));
+	}
+
+	tommy_free(context.key);
+
+	/* concatenate the levels, skipping the first word of each block */
+	pos = 0;
+	for (j = 0; j < level_count; ++j) {
+		mphf->level[j] = level_size[j];
+		for (i = 0; i < level_size[j] / TOMMY_SIZE_BIT; ++i) {
+			mphf->block[pos / (TOMMY_MPHF_BLOCK_WORD - 1) * TOMMY_MPHF_BLOCK_WORD + pos % (TOMMY_MPHF_BLOCK_WORD - 1) + 1] = level_bit[j][i];
+			++pos;
+		}
+		tommy_free(level_bit[j]);
+	}
+
+	/* count the bits set before each block */
+	rank = 0;
+	blocks = mphf_blocks(bit_words);
+	for (i = 0; i < blocks; ++i) {
+		tommy_size_t* block = mphf->block + i * TOMMY_MPHF_BLOCK_WORD;
+		block[0] = rank;
+		for (pos = 1; pos < TOMMY_MPHF_BLOCK_WORD; ++pos)
+			rank += tommy_popcount(block[pos]);
+	}
+}
+
+TOMMY_API void tommy_mphf_done(tommy_mphf* mphf)
+{
+	if (mphf->map)
+		tommy_file_unmap(mphf->data, mphf->data_size);
+	else
+		tommy_free(mphf->data);
+}
+
+TOMMY_API tommy_size_t tommy_mphf_fallback(tommy_mphf* mphf, tommy_uint64_t key)
+{
+	tommy_size_t first = 0;
+	tommy_size_t last = mphf->fallback_count;
+
+	/* binary search */
+	while (first < last) {
+		tommy_size_t middle = first + (last - first) / 2;
+
+		if (mphf->fallback[middle] < key)
+			first = middle + 1;
+		else
+			last = middle;
+	}
+
+	if (first < mphf->fallback_count && mphf->fallback[first] == key)
+		return mphf->count - mphf->fallback_count + first;
+
+	return mphf->count;
+}
+
+TOMMY_API int tommy_mphf_save(tommy_mphf* mphf, const char* path)
+{
+	FILE* f;
+	tommy_size_t* word;
+	tommy_size_t words;
+
+	/* the words start just before the level sizes */
+	word = mphf->level - 4;
+	words = mphf_words(word[1], word[3]);
+
+	f = tommy_file_create(path, sizeof(tommy_size_t), words, words);
+	if (!f)
+		return -1;
+
+	if (fwrite(word, sizeof(tommy_size_t), words, f) != words) {
+		fclose(f);
+		return -1;
+	}
+
+	return tommy_file_close(f, 0, 0);
+}
+
+TOMMY_API int tommy_mphf_map(tommy_mphf* mphf, const char* path)
+{
+	void* map;
+	void* data;
+	tommy_size_t* word;
+	tommy_size_t words;
+	tommy_size_t capacity;
+	tommy_size_t size;
+	tommy_size_t bit_size;
+	tommy_uint_t j;
+
+	map = tommy_file_map(path, TOMMY_MAP_READONLY, sizeof(tommy_size_t), &words, &capacity, &size);
+	if (!map)
+		return -1;
+
+	data = tommy_cast(unsigned char*, map) + TOMMY_FILE_OFFSET;
+	word = tommy_cast(tommy_size_t*, data);
+
+	/* check that the layout matches the file size */
+	if (words < TOMMY_MPHF_HEADER
+		|| word[1] > word[0]
+		|| word[1] > words
+		|| word[2] > TOMMY_MPHF_LEVEL_MAX
+		|| word[3] > words
+		|| mphf_words(word[1], word[3]) != words) {
+		tommy_file_unmap(map, size);
+		return -1;
+	}
+
+	/* check that the levels match the bits */
+	bit_size = 0;
+	for (j = 0; j < word[2]; ++j) {
+		if (word[4 + j] == 0 || word[4 + j] % TOMMY_SIZE_BIT != 0 || word[4 + j] / TOMMY_SIZE_BIT > word[3]) {
+			tommy_file_unmap(map, size);
+			return -1;
+		}
+		bit_size += word[4 + j] / TOMMY_SIZE_BIT;
+	}
+	if (bit_size != word[3]) {
+		tommy_file_unmap(map, size);
+		return -1;
+	}
+
+	mphf->data = map;
+	mphf->data_size = size;
+	mphf->map = 1;
+
+	mphf_setup(mphf, word);
+
+	return 0;
+}
+
+TOMMY_API tommy_size_t tommy_mphf_memory_usage(tommy_mphf* mphf)
+{
+	return mphf->data_size;
+}
@@ -0,0 +1,213 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+/** \file
+ * Minimal perfect hash function.
+ *
+ * This is a function that maps a static set of N distinct keys into the positions
+ * from 0 to N - 1, without any collision and without storing the keys.
+ * You can use the position to access a plain vector of objects, without any
+ * other structure, and with a single cache miss of the function itself.
+ *
+ * It's implemented like BBHash, with a sequence of levels of bits.
+ * Every key is hashed in the first level, and if it doesn't collide with any other key,
+ * its bit is set. The keys that collide are hashed again in the next level, that
+ * has space only for them, and so on. The position of a key is the number of bits set
+ * before its bit.
+ *
+ * The bits are stored in blocks of a cache line, each one starting with the number
+ * of bits set in the previous blocks, so the position is computed reading only
+ * the cache line containing the bit.
+ *
+ * Every level is ::TOMMY_MPHF_GAMMA times bigger than the number of its keys,
+ * using about 3.8 bits for each key, including the counts of the blocks.
+ * A search checks on average less than two levels.
+ *
+ * The keys are 64 bits values that you have to compute from the real keys,
+ * for example with tommy_hash_u64(). These values must be distinct. If two keys have the
+ * same 64 bits value, only one of them gets a position.
+ *
+ * \code
+ * tommy_uint64_t* key = malloc(count * sizeof(tommy_uint64_t));
+ *
+ * for (i = 0; i < count; ++i)
+ *     key[i] = tommy_hash_u64(0, obj[i].name, strlen(obj[i].name));
+ *
+ * tommy_mphf mphf;
+ *
+ * tommy_mphf_init(&mphf, key, count, 0, 0); // builds the function
+ * \endcode
+ *
+ * The key vector is not used after the build, and you can free it.
+ * The objects can then be moved in the vector at the position of their key.
+ *
+ * To search, you compute the position of a key and compare the object stored at
+ * that position. For a key not in the set, the position is arbitrary, and it can
+ * also be equal at the number of keys, so the object found has always to be checked.
+ *
+ * \code
+ * tommy_size_t pos = tommy_mphf_search(&mphf, tommy_hash_u64(0, name, strlen(name)));
+ *
+ * if (pos < count && strcmp(vector[pos].name, name) == 0)
+ *     ... // found
+ * \endcode
+ *
+ * The build can be done in parallel with multiple threads, providing a
+ * ::tommy_parallel_func, and the function can be saved with tommy_mphf_save()
+ * and later mapped with tommy_mphf_map().
+ */
+
+#ifndef __TOMMYMPHF_H
+#define __TOMMYMPHF_H
+
+#include "tommyhash.h"
+#include "tommyfile.h"
+
+/******************************************************************************/
+/* mphf */
+
+/**
+ * Max number of levels.
+ * The few keys still colliding after the last level are stored in a sorted vector.
+ */
+#define TOMMY_MPHF_LEVEL_MAX 32
+
+/**
+ * Ratio between the number of bits of a level and the number of its keys.
+ * Greater values use more memory, and have less levels, with a faster build and search.
+ */
+#define TOMMY_MPHF_GAMMA 2
+
+/**
+ * Number of words of a block, containing the count of the bits set before
+ * it and the bits.
+ */
+#define TOMMY_MPHF_BLOCK_WORD (TOMMY_CACHELINE / (tommy_size_t)sizeof(tommy_size_t))
+
+/**
+ * Number of keys processed by every job of the parallel build.
+ */
+#define TOMMY_MPHF_JOB (64 * 1024)
+
+/**
+ * Minimal perfect hash function.
+ * \note Don't use internal fields directly, but access the container only using functions.
+ */
+typedef struct tommy_mphf_struct {
+	tommy_size_t* level; /**< Number of bits of each level. */
+	tommy_uint64_t* fallback; /**< Keys not placed in any level, sorted. */
+	tommy_size_t* block; /**< Blocks with the bits of all the levels. */
+	void* data; /**< Memory block with all the data. */
+	tommy_size_t data_size; /**< Size of the memory block. */
+	tommy_size_t count; /**< Number of keys. */
+	tommy_size_t fallback_count; /**< Number of keys not placed in any level. */
+	tommy_uint_t level_count; /**< Number of levels. */
+	tommy_uint_t map; /**< If the memory block is a mapped file. */
+} tommy_mphf;
+
+/**
+ * Initializes the function building it for the specified keys.
+ * \param key Vector of distinct keys. It's not changed.
+ * \param count Number of keys.
+ * \param parallel Parallel function used to run the jobs. If 0, all the jobs are run in the calling thread.
+ * \param arg Argument passed to the parallel function.
+ */
+TOMMY_API void tommy_mphf_init(tommy_mphf* mphf, const tommy_uint64_t* key, tommy_size_t count, tommy_parallel_func* parallel, void* arg);
+
+/**
+ * Deinitializes the function.
+ */
+TOMMY_API void tommy_mphf_done(tommy_mphf* mphf);
+
+/**
+ * Saves the function in a file, that can be later mapped with tommy_mphf_map().
+ * \param path Path of the file to create.
+ * \return 0 on success, or -1 on error.
+ */
+TOMMY_API int tommy_mphf_save(tommy_mphf* mphf, const char* path);
+
+/**
+ * Initializes the function mapping a file saved with tommy_mphf_save().
+ * The file is used directly, in read-only mode, without reading it.
+ * \param path Path of the file to map.
+ * \return 0 on success, or -1 on error. On error the function is not initialized.
+ */
+TOMMY_API int tommy_mphf_map(tommy_mphf* mphf, const char* path);
+
+/** \internal
+ * Hashes the key for the specified level.
+ */
+tommy_inline tommy_uint64_t tommy_mphf_hash(tommy_uint64_t key, tommy_uint_t level)
+{
+	return tommy_inthash_u64(key + level * (tommy_uint64_t)0x9E3779B9);
+}
+
+/** \internal
+ * Gets the bit of the key in a level of the specified number of bits.
+ * It's the range reduction of the high 32 bits of the hash with a multiplication, much faster
+ * than a division, used for all the levels with less than 2^32 bits.
+ */
+tommy_inline tommy_size_t tommy_mphf_bit(tommy_uint64_t key, tommy_uint_t level, tommy_size_t size)
+{
+	tommy_uint64_t hash = tommy_mphf_hash(key, level);
+
+	if ((tommy_uint64_t)size >> 32 == 0)
+		return (tommy_size_t)(((hash >> 32) * size) >> 32);
+
+	return (tommy_size_t)(hash % size);
+}
+
+/** \internal
+ * Searches a key in the sorted vector of the keys not placed in any level.
+ */
+TOMMY_API tommy_size_t tommy_mphf_fallback(tommy_mphf* mphf, tommy_uint64_t key);
+
+/**
+ * Searches the position of a key.
+ * \param key Key to search.
+ * \return The position of the key, from 0 to the number of keys - 1.
+ * For a key not in the set, an arbitrary position from 0 to the number of keys.
+ */
+tommy_inline tommy_size_t tommy_mphf_search(tommy_mphf* mphf, tommy_uint64_t key)
+{
+	tommy_size_t base = 0;
+	tommy_uint_t i;
+
+	for (i = 0; i < mphf->level_count; ++i) {
+		tommy_size_t bit = base + tommy_mphf_bit(key, i, mphf->level[i]);
+		tommy_size_t word = bit / TOMMY_SIZE_BIT;
+		tommy_size_t* block = mphf->block + word / (TOMMY_MPHF_BLOCK_WORD - 1) * TOMMY_MPHF_BLOCK_WORD;
+		tommy_size_t offset = word % (TOMMY_MPHF_BLOCK_WORD - 1) + 1;
+		tommy_size_t mask = (tommy_size_t)1 << (bit % TOMMY_SIZE_BIT);
+
+		if (block[offset] & mask) {
+			/* count the bits set before it, starting from the count of the block */
+			tommy_size_t pos = block[0];
+			tommy_size_t j;
+
+			for (j = 1; j < offset; ++j)
+				pos += tommy_popcount(block[j]);
+
+			return pos + tommy_popcount(block[offset] & (mask - 1));
+		}
+
+		base += mphf->level[i];
+	}
+
+	return tommy_mphf_fallback(mphf, key);
+}
+
+/**
+ * Gets the number of keys.
+ */
+tommy_inline tommy_size_t tommy_mphf_count(tommy_mphf* mphf)
+{
+	return mphf->count;
+}
+
+/**
+ * Gets the size of allocated memory.
+ */
+TOMMY_API tommy_size_t tommy_mphf_memory_usage(tommy_mphf* mphf);
+
+#endif
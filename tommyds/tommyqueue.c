@@ -0,0 +1,119 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+#include "tommyqueue.h"
+
+/******************************************************************************/
+/* queue */
+
+TOMMY_API void tommy_queue_init(tommy_queue* queue)
+{
+	queue->stub.next = 0;
+	queue->stub.data = 0;
+	queue->tail = &queue->stub;
+	queue->head = &queue->stub;
+}
+
+/**
+ * Links a chain of nodes at the tail of the queue.
+ * \param first First node of the chain.
+ * \param last Last node of the chain. Its next field must be 0.
+ */
+static void queue_link(tommy_queue* queue, tommy_node* first, tommy_node* last)
+{
+	tommy_node* prev;
+
+	/* take the place of the tail */
+	prev = tommy_cast(tommy_node*, tommy_atomic_exchange_ptr((void* volatile*)&queue->tail, last));
+
+	/* link the previous tail, making the chain visible to the consumer */
+	tommy_atomic_store_ptr((void* volatile*)&prev->next, first);
+}
+
+TOMMY_API void tommy_queue_insert(tommy_queue* queue, tommy_node* node, void* data)
+{
+	node->data = data;
+	node->next = 0;
+
+	queue_link(queue, node, node);
+}
+
+TOMMY_API void tommy_queue_insert_list(tommy_queue* queue, tommy_list* list)
+{
+	tommy_node* head = tommy_list_head(list);
+
+	if (!head)
+		return;
+
+	/* the list is already a chain with the tail next at 0 */
+	queue_link(queue, head, head->prev);
+
+	tommy_list_init(list);
+}
+
+/**
+ * Removes the oldest node from the queue.
+ * \return The removed node, or 0 if no node is available.
+ */
+static tommy_node* queue_remove(tommy_queue* queue)
+{
+	tommy_node* head = queue->head;
+	tommy_node* next = tommy_cast(tommy_node*, tommy_atomic_load_ptr((void* volatile*)&head->next));
+	tommy_node* tail;
+
+	/* skip the stub */
+	if (head == &queue->stub) {
+		if (!next)
+			return 0; /* empty */
+		queue->head = next;
+		head = next;
+		next = tommy_cast(tommy_node*, tommy_atomic_load_ptr((void* volatile*)&head->next));
+	}
+
+	/* if it's not the last node, just remove it */
+	if (next) {
+		queue->head = next;
+		return head;
+	}
+
+	/* if the last node is not the tail, a producer is inserting */
+	tail = tommy_cast(tommy_node*, tommy_atomic_load_ptr((void* volatile*)&queue->tail));
+	if (head != tail)
+		return 0;
+
+	/* insert again the stub to be able to remove the last node */
+	queue->stub.next = 0;
+	queue_link(queue, &queue->stub, &queue->stub);
+
+	next = tommy_cast(tommy_node*, tommy_atomic_load_ptr((void* volatile*)&head->next));
+	if (next) {
+		queue->head = next;
+		return head;
+	}
+
+	/* a producer is inserting after the last node, before the stub */
+	return 0;
+}
+
+TOMMY_API void* tommy_queue_remove(tommy_queue* queue)
+{
+	tommy_node* node = queue_remove(queue);
+
+	if (!node)
+		return 0;
+
+	return node->data;
+}
+
+TOMMY_API tommy_size_t tommy_queue_remove_list(tommy_queue* queue, tommy_list* list)
+{
+	tommy_size_t count = 0;
+	tommy_node* node;
+
+	while ((node = queue_remove(queue)) != 0) {
+		tommy_list_insert_tail(list, node, node->data);
+		++count;
+	}
+
+	return count;
+}
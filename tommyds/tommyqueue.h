@@ -0,0 +1,116 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+/** \file
+ * Lock-free intrusive queue with multiple producers and a single consumer.
+ *
+ * This queue allows to pass objects between threads without locks and without
+ * any memory allocation, as it links the objects using the tommy_node::next field
+ * of the node embedded in them. It's the intrusive queue of Dmitry Vyukov.
+ *
+ * Any number of threads can insert elements concurrently, but only one thread
+ * at time can remove them.
+ * The insertion is wait-free, and it's done with a single atomic exchange also
+ * when inserting a whole ::tommy_list with tommy_queue_insert_list().
+ *
+ * To initialize the queue you have to call tommy_queue_init().
+ * The queue cannot be moved in memory after the initialization, as it contains
+ * the node used as stub.
+ *
+ * \code
+ * tommy_queue queue;
+ *
+ * tommy_queue_init(&queue);
+ * \endcode
+ *
+ * To insert elements in the queue you have to call tommy_queue_insert() for
+ * each element, from any thread.
+ *
+ * \code
+ * struct object {
+ *     int value;
+ *     // other fields
+ *     tommy_node node;
+ * };
+ *
+ * struct object* obj = malloc(sizeof(struct object)); // creates the object
+ *
+ * obj->value = ...; // initializes the object
+ *
+ * tommy_queue_insert(&queue, &obj->node, obj); // inserts the object
+ * \endcode
+ *
+ * To remove elements you have to call tommy_queue_remove() from the consumer thread,
+ * or tommy_queue_remove_list() to move all the available elements into a ::tommy_list.
+ *
+ * \code
+ * struct object* obj = tommy_queue_remove(&queue);
+ * if (obj) {
+ *     // process the object
+ * }
+ * \endcode
+ *
+ * Note that tommy_queue_remove() may return 0 also if the queue is not empty,
+ * when a producer is in the middle of an insertion. The element will be
+ * available as soon as the producer completes it.
+ *
+ * The queue is completely inplace, so it doesn't need to be deinitialized.
+ */
+
+#ifndef __TOMMYQUEUE_H
+#define __TOMMYQUEUE_H
+
+#include "tommytypes.h"
+#include "tommylist.h"
+
+/******************************************************************************/
+/* queue */
+
+/**
+ * Lock-free queue.
+ */
+typedef struct tommy_queue_struct {
+	tommy_node* tail; /**< Last inserted node. Modified by the producers. */
+	char pad[TOMMY_CACHELINE - sizeof(tommy_node*)]; /**< Padding to keep the producers and the consumer fields in different cache lines. */
+	tommy_node* head; /**< Next node to remove. Modified only by the consumer. */
+	tommy_node stub; /**< Node kept in the queue when it's empty. */
+} tommy_queue;
+
+/**
+ * Initializes the queue.
+ */
+TOMMY_API void tommy_queue_init(tommy_queue* queue);
+
+/**
+ * Inserts an element in the queue.
+ * It can be called by multiple threads at the same time.
+ * \param node The node to insert.
+ * \param data The object containing the node. It's used to set the tommy_node::data field of the node. It cannot be 0.
+ */
+TOMMY_API void tommy_queue_insert(tommy_queue* queue, tommy_node* node, void* data);
+
+/**
+ * Inserts all the elements of a list in the queue, with a single atomic operation.
+ * The elements must already have the tommy_node::data field set, like it happens
+ * when inserted in the list.
+ * It can be called by multiple threads at the same time.
+ * \param list The list to insert. After the call the list is empty.
+ */
+TOMMY_API void tommy_queue_insert_list(tommy_queue* queue, tommy_list* list);
+
+/**
+ * Removes the oldest element from the queue.
+ * It can be called only by one thread at time.
+ * \return The tommy_node::data field of the removed node, or 0 if no element is available.
+ */
+TOMMY_API void* tommy_queue_remove(tommy_queue* queue);
+
+/**
+ * Removes all the available elements from the queue, and inserts them at the tail of a list.
+ * It can be called only by one thread at time.
+ * \param list The list where to insert the elements.
+ * \return The number of elements removed.
+ */
+TOMMY_API tommy_size_t tommy_queue_remove_list(tommy_queue* queue, tommy_list* list);
+
+#endif
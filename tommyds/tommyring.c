@@ -0,0 +1,112 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+#include "tommyring.h"
+
+/******************************************************************************/
+/* ring */
+
+TOMMY_API void tommy_ring_init(tommy_ring* ring, tommy_size_t size)
+{
+	tommy_size_t i;
+
+	if (size < 2)
+		size = 2;
+	size = tommy_roundup_pow2(size);
+
+	ring->cell = tommy_cast(tommy_ring_cell*, tommy_malloc(size * sizeof(tommy_ring_cell)));
+	ring->mask = size - 1;
+
+	/* each cell is ready for the insertion with the same position */
+	for (i = 0; i < size; ++i) {
+		ring->cell[i].sequence = i;
+		ring->cell[i].list = 0;
+	}
+
+	ring->insert_pos = 0;
+	ring->remove_pos = 0;
+}
+
+TOMMY_API void tommy_ring_done(tommy_ring* ring)
+{
+	tommy_free(ring->cell);
+}
+
+TOMMY_API int tommy_ring_insert_list(tommy_ring* ring, tommy_list* list)
+{
+	tommy_ring_cell* cell;
+	tommy_size_t pos;
+
+	if (tommy_list_empty(list))
+		return 0;
+
+	pos = tommy_atomic_load(&ring->insert_pos);
+	while (1) {
+		tommy_ssize_t diff;
+
+		cell = &ring->cell[pos & ring->mask];
+		diff = (tommy_ssize_t)(tommy_atomic_load(&cell->sequence) - pos);
+
+		if (diff == 0) {
+			/* the cell is free, try to reserve it */
+			if (tommy_atomic_cas(&ring->insert_pos, pos, pos + 1))
+				break;
+			pos = tommy_atomic_load(&ring->insert_pos);
+		} else if (diff < 0) {
+			/* the cell still contains the list of the previous round */
+			return -1; /* full */
+		} else {
+			/* another producer reserved the cell */
+			pos = tommy_atomic_load(&ring->insert_pos);
+		}
+	}
+
+	cell->list = *list;
+
+	/* publish the cell to the consumers */
+	tommy_atomic_store(&cell->sequence, pos + 1);
+
+	tommy_list_init(list);
+
+	return 0;
+}
+
+TOMMY_API int tommy_ring_remove_list(tommy_ring* ring, tommy_list* list)
+{
+	tommy_ring_cell* cell;
+	tommy_size_t pos;
+
+	pos = tommy_atomic_load(&ring->remove_pos);
+	while (1) {
+		tommy_ssize_t diff;
+
+		cell = &ring->cell[pos & ring->mask];
+		diff = (tommy_ssize_t)(tommy_atomic_load(&cell->sequence) - (pos + 1));
+
+		if (diff == 0) {
+			/* the cell is filled, try to reserve it */
+			if (tommy_atomic_cas(&ring->remove_pos, pos, pos + 1))
+				break;
+			pos = tommy_atomic_load(&ring->remove_pos);
+		} else if (diff < 0) {
+			/* the cell is not yet filled */
+			return -1; /* empty */
+		} else {
+			/* another consumer reserved the cell */
+			pos = tommy_atomic_load(&ring->remove_pos);
+		}
+	}
+
+	tommy_list_concat(list, &cell->list);
+	cell->list = 0;
+
+	/* free the cell for the producers of the next round */
+	tommy_atomic_store(&cell->sequence, pos + ring->mask + 1);
+
+	return 0;
+}
+
+TOMMY_API tommy_size_t tommy_ring_memory_usage(tommy_ring* ring)
+{
+	return (ring->mask + 1) * (tommy_size_t)sizeof(tommy_ring_cell);
+}
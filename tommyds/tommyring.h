@@ -0,0 +1,136 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+/** \file
+ * Lock-free bounded queue with multiple producers and multiple consumers.
+ *
+ * This queue is a ring of a fixed number of cells, where each cell contains a
+ * whole ::tommy_list of elements. It's the bounded queue of Dmitry Vyukov, and
+ * any number of threads can insert and remove at the same time.
+ *
+ * The elements are linked using the node embedded in the objects, and the
+ * only allocation is the vector of cells done at the initialization.
+ * Inserting or removing a list costs the same of a single element, so to reduce
+ * the contention it's better to pass elements in batches.
+ *
+ * To initialize the ring you have to call tommy_ring_init() specifying the
+ * number of cells, and to deinitialize it tommy_ring_done().
+ *
+ * \code
+ * tommy_ring ring;
+ *
+ * tommy_ring_init(&ring, 1024);
+ * \endcode
+ *
+ * To insert elements you have to call tommy_ring_insert() for a single element,
+ * or tommy_ring_insert_list() for a whole list. Both fail if the ring is full.
+ *
+ * \code
+ * struct object {
+ *     int value;
+ *     // other fields
+ *     tommy_node node;
+ * };
+ *
+ * struct object* obj = malloc(sizeof(struct object)); // creates the object
+ *
+ * obj->value = ...; // initializes the object
+ *
+ * if (tommy_ring_insert(&ring, &obj->node, obj) != 0) {
+ *     // full
+ * }
+ * \endcode
+ *
+ * To remove elements you have to call tommy_ring_remove_list() that moves the
+ * elements of the oldest cell at the tail of your list.
+ *
+ * \code
+ * tommy_list list;
+ *
+ * tommy_list_init(&list);
+ *
+ * if (tommy_ring_remove_list(&ring, &list) == 0) {
+ *     // process the elements in the list
+ * }
+ * \endcode
+ */
+
+#ifndef __TOMMYRING_H
+#define __TOMMYRING_H
+
+#include "tommytypes.h"
+#include "tommylist.h"
+
+/******************************************************************************/
+/* ring */
+
+/** \internal
+ * Cell of the ring.
+ */
+typedef struct tommy_ring_cell_struct {
+	tommy_size_t sequence; /**< Sequence number of the cell, used to synchronize the threads. */
+	tommy_node* list; /**< List stored in the cell. */
+} tommy_ring_cell;
+
+/**
+ * Lock-free ring.
+ */
+typedef struct tommy_ring_struct {
+	tommy_ring_cell* cell; /**< Vector of cells. */
+	tommy_size_t mask; /**< Mask of the cell index. */
+	char pad0[TOMMY_CACHELINE - sizeof(tommy_ring_cell*) - sizeof(tommy_size_t)]; /**< Padding. */
+	tommy_size_t insert_pos; /**< Position of the next insertion. Modified by the producers. */
+	char pad1[TOMMY_CACHELINE - sizeof(tommy_size_t)]; /**< Padding. */
+	tommy_size_t remove_pos; /**< Position of the next removal. Modified by the consumers. */
+	char pad2[TOMMY_CACHELINE - sizeof(tommy_size_t)]; /**< Padding. */
+} tommy_ring;
+
+/**
+ * Initializes the ring.
+ * \param size Number of cells. It's rounded up to a power of 2, and it's at least 2.
+ */
+TOMMY_API void tommy_ring_init(tommy_ring* ring, tommy_size_t size);
+
+/**
+ * Deinitializes the ring.
+ * The elements still in the ring are not touched.
+ */
+TOMMY_API void tommy_ring_done(tommy_ring* ring);
+
+/**
+ * Inserts a list of elements in the ring, using a single cell.
+ * \param list The list to insert. If the insertion succeeds, the list becomes empty.
+ * An empty list is not inserted.
+ * \return 0 on success, or -1 if the ring is full and the list is left unchanged.
+ */
+TOMMY_API int tommy_ring_insert_list(tommy_ring* ring, tommy_list* list);
+
+/**
+ * Inserts an element in the ring, using a single cell.
+ * \param node The node to insert.
+ * \param data The object containing the node. It's used to set the tommy_node::data field of the node.
+ * \return 0 on success, or -1 if the ring is full.
+ */
+tommy_inline int tommy_ring_insert(tommy_ring* ring, tommy_node* node, void* data)
+{
+	tommy_list list;
+
+	tommy_list_init(&list);
+	tommy_list_insert_tail(&list, node, data);
+
+	return tommy_ring_insert_list(ring, &list);
+}
+
+/**
+ * Removes the oldest list of elements from the ring.
+ * \param list The list where the elements are inserted at the tail.
+ * \return 0 on success, or -1 if the ring is empty and the list is left unchanged.
+ */
+TOMMY_API int tommy_ring_remove_list(tommy_ring* ring, tommy_list* list);
+
+/**
+ * Gets the size of allocated memory.
+ */
+TOMMY_API tommy_size_t tommy_ring_memory_usage(tommy_ring* ring);
+
+#endif
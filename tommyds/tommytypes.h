@@ -155,6 +155,17 @@ typedef tommy_uint32_t tommy_uint_t;
 #endif
 #endif
 
+/** \internal
+ * Hints the processor to load in the cache the memory at the specified address.
+ */
+#if !defined(tommy_prefetch)
+#if defined(__GNUC__)
+#define tommy_prefetch(x) __builtin_prefetch(x)
+#else
+#define tommy_prefetch(x) ((void)(x))
+#endif
+#endif
+
 /******************************************************************************/
 /* key/hash */
 
@@ -212,6 +223,31 @@ typedef struct tommy_node_struct {
 	tommy_size_t index;
 } tommy_node;
 
+/**
+ * Compact data structure node.
+ * This node has only the tommy_node::next and tommy_node::index fields, using half
+ * the memory of ::tommy_node, and it's used by the compact hashtables
+ * ::tommy_hashdync and ::tommy_hashlinc.
+ *
+ * Without the tommy_node::data field, the object is recovered from the node address,
+ * subtracting the offset of the node inside the object, as specified when
+ * initializing the container.
+ * Without the tommy_node::prev field, lists of these nodes are singly linked.
+ */
+typedef struct tommy_cnode_struct {
+	/**
+	 * Next node.
+	 * The tail node has it at 0, like a 0 terminated list.
+	 */
+	struct tommy_cnode_struct* next;
+
+	/**
+	 * Index of the node.
+	 * With hashtables this field is used to store the hash value.
+	 */
+	tommy_size_t index;
+} tommy_cnode;
+
 /******************************************************************************/
 /* compare */
 
@@ -300,6 +336,140 @@ typedef void tommy_foreach_func(void* obj);
  */
 typedef void tommy_foreach_arg_func(void* arg, void* obj);
 
+/******************************************************************************/
+/* parallel */
+
+/**
+ * Job function.
+ * \param context Pointer to the context of the jobs, as passed to the ::tommy_parallel_func function.
+ * \param index Index of the job to run, from 0 to count - 1.
+ */
+typedef void tommy_job_func(void* context, tommy_size_t index);
+
+/**
+ * Parallel function.
+ * It's provided by the user to run a set of jobs using its own threads,
+ * and it allows Tommy to remain free of any threading dependency.
+ *
+ * The function has to call job(context, index) for each index from 0 to count - 1,
+ * in any order and possibly concurrently, returning only when all the jobs are completed.
+ *
+ * \param arg Pointer to a generic argument, as passed to the Tommy function.
+ * \param job Job function to call.
+ * \param context Context to pass to the job function.
+ * \param count Number of jobs to run.
+ *
+ * A trivial implementation running all the jobs in the calling thread is:
+ * \code
+ * void parallel(void* arg, tommy_job_func* job, void* context, tommy_size_t count)
+ * {
+ *     tommy_size_t i;
+ *     for (i = 0; i < count; ++i)
+ *         job(context, i);
+ * }
+ * \endcode
+ */
+typedef void tommy_parallel_func(void* arg, tommy_job_func* job, void* context, tommy_size_t count);
+
+/**
+ * Span function.
+ * Called with a span of elements stored contiguously in memory.
+ * \param arg Pointer to a generic argument.
+ * \param pos Position in the container of the first element of the span.
+ * \param span Pointer to the first element of the span.
+ * \param size Number of elements in the span.
+ */
+typedef void tommy_span_func(void* arg, tommy_size_t pos, void* span, tommy_size_t size);
+
+/******************************************************************************/
+/* stats */
+
+/**
+ * Operation statistics of a hashtable.
+ * They are collected only if the library is compiled with TOMMY_STATS defined,
+ * otherwise the counters are not present in the containers and they are always reported as 0.
+ *
+ * TOMMY_STATS changes the layout of the containers, so it must be defined, or not,
+ * in all the sources including the Tommy headers, and in the library.
+ * A mismatch is detected at link time, as the init functions get different names.
+ *
+ * The searches update the counters inside the container, so with TOMMY_STATS
+ * concurrent searches from different threads are no longer read-only, and need
+ * the same locking of the writes.
+ *
+ * Only the searches are counted in search, hit, miss, visit and chain_max.
+ * The chains walked by the removes are not.
+ */
+typedef struct tommy_stats_struct {
+	tommy_size_t search; /**< Number of searches. */
+	tommy_size_t hit; /**< Number of searches that found an element. */
+	tommy_size_t miss; /**< Number of searches that didn't find any element. */
+	tommy_size_t visit; /**< Number of chain nodes visited by all the searches. */
+	tommy_size_t chain_max; /**< Max number of chain nodes visited by a single search. */
+	tommy_size_t grow; /**< Number of buckets split growing the hashtable. */
+	tommy_size_t shrink; /**< Number of buckets merged shrinking the hashtable. */
+	tommy_size_t rehash; /**< Number of changes of the hashtable size. */
+	tommy_size_t segment; /**< Number of bucket vectors allocated. */
+} tommy_stats;
+
+/** \internal
+ * Clears the statistics.
+ */
+tommy_inline void tommy_stats_clear(tommy_stats* stats)
+{
+	stats->search = 0;
+	stats->hit = 0;
+	stats->miss = 0;
+	stats->visit = 0;
+	stats->chain_max = 0;
+	stats->grow = 0;
+	stats->shrink = 0;
+	stats->rehash = 0;
+	stats->segment = 0;
+}
+
+#ifdef TOMMY_STATS
+/** \internal
+ * Accounts a search that visited the specified number of chain nodes.
+ */
+tommy_inline void tommy_stats_record(tommy_stats* stats, tommy_size_t visit, int found)
+{
+	++stats->search;
+	if (found)
+		++stats->hit;
+	else
+		++stats->miss;
+	stats->visit += visit;
+	if (stats->chain_max < visit)
+		stats->chain_max = visit;
+}
+
+/** \internal
+ * Statistics hooks used inside the containers.
+ * Without TOMMY_STATS they expand to nothing, and the arguments are not evaluated.
+ */
+#define tommy_stats_init(container) tommy_stats_clear(&(container)->stats)
+#define tommy_stats_inc(container, field) ++(container)->stats.field
+#define tommy_stats_add(container, field, value) (container)->stats.field += (value)
+#define tommy_stats_visit(visit) ++(visit)
+#define tommy_stats_search(container, visit, found) tommy_stats_record(&(container)->stats, (visit), (found))
+#define tommy_stats_get(container, stats) (*(stats) = (container)->stats)
+
+/** \internal
+ * Name of a function depending on the layout of the containers.
+ * It differs with TOMMY_STATS to make a mismatch with the library fail at link time.
+ */
+#define tommy_stats_name(name) name##_stats
+#else
+#define tommy_stats_name(name) name
+#define tommy_stats_init(container) do { } while (0)
+#define tommy_stats_inc(container, field) do { } while (0)
+#define tommy_stats_add(container, field, value) do { } while (0)
+#define tommy_stats_visit(visit) do { } while (0)
+#define tommy_stats_search(container, visit, found) do { } while (0)
+#define tommy_stats_get(container, stats) ((void)(container), tommy_stats_clear(stats))
+#endif
+
 /******************************************************************************/
 /* bit hacks */
 
@@ -446,6 +616,37 @@ tommy_inline tommy_uint_t tommy_ctz_u64(tommy_uint64_t value)
 }
 #endif
 
+/**
+ * Population count.
+ * \return The number of bits set.
+ */
+tommy_inline tommy_uint_t tommy_popcount_u32(tommy_uint32_t value)
+{
+#if defined(__GNUC__)
+	return __builtin_popcount(value);
+#else
+	/* Count the bits set in parallel */
+	/* from http://graphics.stanford.edu/~seander/bithacks.html */
+	value = value - ((value >> 1) & 0x55555555U);
+	value = (value & 0x33333333U) + ((value >> 2) & 0x33333333U);
+	return (tommy_uint32_t)(((value + (value >> 4)) & 0x0F0F0F0FU) * 0x01010101U) >> 24;
+#endif
+}
+
+#if TOMMY_SIZE_BIT == 64
+/**
+ * Population count for 64 bits.
+ */
+tommy_inline tommy_uint_t tommy_popcount_u64(tommy_uint64_t value)
+{
+#if defined(__GNUC__)
+	return __builtin_popcountll(value);
+#else
+	return tommy_popcount_u32(value & 0xFFFFFFFFU) + tommy_popcount_u32(value >> 32);
+#endif
+}
+#endif
+
 /**
  * Rounds up to the next power of 2.
  * For the value 0, the result is undefined.
@@ -499,11 +700,219 @@ tommy_inline int tommy_haszero_u32(tommy_uint32_t value)
 #if TOMMY_SIZE_BIT == 64
 #define tommy_ilog2 tommy_ilog2_u64
 #define tommy_ctz tommy_ctz_u64
+#define tommy_popcount tommy_popcount_u64
 #define tommy_roundup_pow2 tommy_roundup_pow2_u64
 #else
 #define tommy_ilog2 tommy_ilog2_u32
 #define tommy_ctz tommy_ctz_u32
+#define tommy_popcount tommy_popcount_u32
 #define tommy_roundup_pow2 tommy_roundup_pow2_u32
 #endif
 
+
+/******************************************************************************/
+/* atomic */
+
+/**
+ * Size of a cache line.
+ * It's used to separate the fields modified by different threads.
+ */
+#define TOMMY_CACHELINE 64
+
+/** \internal
+ * Atomic operations used by the lock-free containers.
+ * The loads have acquire semantics, the stores release semantics,
+ * and the read-modify-write operations both.
+ * They use the GCC/Clang builtins, the MSVC intrinsics, or the C11 <stdatomic.h>.
+ * With other compilers the build fails, unless TOMMY_SINGLE_THREAD is defined
+ * to use plain memory accesses, stating that Tommy is used only by a single thread.
+ */
+#if defined(__GNUC__)
+tommy_inline void* tommy_atomic_load_ptr(void* volatile* ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+tommy_inline void tommy_atomic_store_ptr(void* volatile* ptr, void* value)
+{
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+tommy_inline void* tommy_atomic_exchange_ptr(void* volatile* ptr, void* value)
+{
+	return __atomic_exchange_n(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+tommy_inline tommy_size_t tommy_atomic_load(tommy_size_t volatile* ptr)
+{
+	return __atomic_load_n(ptr, __ATOMIC_ACQUIRE);
+}
+
+tommy_inline void tommy_atomic_store(tommy_size_t volatile* ptr, tommy_size_t value)
+{
+	__atomic_store_n(ptr, value, __ATOMIC_RELEASE);
+}
+
+tommy_inline tommy_size_t tommy_atomic_add(tommy_size_t volatile* ptr, tommy_size_t value)
+{
+	return __atomic_add_fetch(ptr, value, __ATOMIC_ACQ_REL);
+}
+
+tommy_inline tommy_bool_t tommy_atomic_cas(tommy_size_t volatile* ptr, tommy_size_t expected, tommy_size_t value)
+{
+	return __atomic_compare_exchange_n(ptr, &expected, value, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED);
+}
+#elif defined(_MSC_VER)
+#include <intrin.h>
+
+/** \internal
+ * Barrier making a plain load acquire, and a plain store release.
+ * With x86 and x64 the hardware already keeps this order, and only the compiler has to be stopped.
+ * With ARM a data memory barrier is required.
+ * ARM64EC is checked first, as it also defines _M_X64.
+ */
+#if defined(_M_ARM64) || defined(_M_ARM64EC)
+#define tommy_atomic_barrier() __dmb(_ARM64_BARRIER_ISH)
+#elif defined(_M_ARM)
+#define tommy_atomic_barrier() __dmb(_ARM_BARRIER_ISH)
+#elif defined(_M_IX86) || defined(_M_X64)
+#pragma intrinsic(_ReadWriteBarrier)
+#define tommy_atomic_barrier() _ReadWriteBarrier()
+#else
+#error Unsupported MSVC target for the Tommy atomic operations
+#endif
+
+tommy_inline void* tommy_atomic_load_ptr(void* volatile* ptr)
+{
+	void* value = *ptr;
+	tommy_atomic_barrier();
+	return value;
+}
+
+tommy_inline void tommy_atomic_store_ptr(void* volatile* ptr, void* value)
+{
+	tommy_atomic_barrier();
+	*ptr = value;
+}
+
+tommy_inline void* tommy_atomic_exchange_ptr(void* volatile* ptr, void* value)
+{
+	return _InterlockedExchangePointer(ptr, value);
+}
+
+tommy_inline tommy_size_t tommy_atomic_load(tommy_size_t volatile* ptr)
+{
+	tommy_size_t value = *ptr;
+	tommy_atomic_barrier();
+	return value;
+}
+
+tommy_inline void tommy_atomic_store(tommy_size_t volatile* ptr, tommy_size_t value)
+{
+	tommy_atomic_barrier();
+	*ptr = value;
+}
+
+#ifdef _WIN64
+tommy_inline tommy_size_t tommy_atomic_add(tommy_size_t volatile* ptr, tommy_size_t value)
+{
+	return _InterlockedExchangeAdd64((__int64 volatile*)ptr, value) + value;
+}
+
+tommy_inline tommy_bool_t tommy_atomic_cas(tommy_size_t volatile* ptr, tommy_size_t expected, tommy_size_t value)
+{
+	return _InterlockedCompareExchange64((__int64 volatile*)ptr, value, expected) == (__int64)expected;
+}
+#else
+tommy_inline tommy_size_t tommy_atomic_add(tommy_size_t volatile* ptr, tommy_size_t value)
+{
+	return _InterlockedExchangeAdd((long volatile*)ptr, value) + value;
+}
+
+tommy_inline tommy_bool_t tommy_atomic_cas(tommy_size_t volatile* ptr, tommy_size_t expected, tommy_size_t value)
+{
+	return _InterlockedCompareExchange((long volatile*)ptr, value, expected) == (long)expected;
+}
+#endif
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L && !defined(__STDC_NO_ATOMICS__)
+#include <stdatomic.h>
+
+tommy_inline void* tommy_atomic_load_ptr(void* volatile* ptr)
+{
+	return atomic_load_explicit((_Atomic(void*) volatile*)ptr, memory_order_acquire);
+}
+
+tommy_inline void tommy_atomic_store_ptr(void* volatile* ptr, void* value)
+{
+	atomic_store_explicit((_Atomic(void*) volatile*)ptr, value, memory_order_release);
+}
+
+tommy_inline void* tommy_atomic_exchange_ptr(void* volatile* ptr, void* value)
+{
+	return atomic_exchange_explicit((_Atomic(void*) volatile*)ptr, value, memory_order_acq_rel);
+}
+
+tommy_inline tommy_size_t tommy_atomic_load(tommy_size_t volatile* ptr)
+{
+	return atomic_load_explicit((_Atomic(tommy_size_t) volatile*)ptr, memory_order_acquire);
+}
+
+tommy_inline void tommy_atomic_store(tommy_size_t volatile* ptr, tommy_size_t value)
+{
+	atomic_store_explicit((_Atomic(tommy_size_t) volatile*)ptr, value, memory_order_release);
+}
+
+tommy_inline tommy_size_t tommy_atomic_add(tommy_size_t volatile* ptr, tommy_size_t value)
+{
+	return atomic_fetch_add_explicit((_Atomic(tommy_size_t) volatile*)ptr, value, memory_order_acq_rel) + value;
+}
+
+tommy_inline tommy_bool_t tommy_atomic_cas(tommy_size_t volatile* ptr, tommy_size_t expected, tommy_size_t value)
+{
+	return atomic_compare_exchange_strong_explicit((_Atomic(tommy_size_t) volatile*)ptr, &expected, value, memory_order_acq_rel, memory_order_relaxed);
+}
+#elif defined(TOMMY_SINGLE_THREAD)
+tommy_inline void* tommy_atomic_load_ptr(void* volatile* ptr)
+{
+	return *ptr;
+}
+
+tommy_inline void tommy_atomic_store_ptr(void* volatile* ptr, void* value)
+{
+	*ptr = value;
+}
+
+tommy_inline void* tommy_atomic_exchange_ptr(void* volatile* ptr, void* value)
+{
+	void* prev = *ptr;
+	*ptr = value;
+	return prev;
+}
+
+tommy_inline tommy_size_t tommy_atomic_load(tommy_size_t volatile* ptr)
+{
+	return *ptr;
+}
+
+tommy_inline void tommy_atomic_store(tommy_size_t volatile* ptr, tommy_size_t value)
+{
+	*ptr = value;
+}
+
+tommy_inline tommy_size_t tommy_atomic_add(tommy_size_t volatile* ptr, tommy_size_t value)
+{
+	return *ptr += value;
+}
+
+tommy_inline tommy_bool_t tommy_atomic_cas(tommy_size_t volatile* ptr, tommy_size_t expected, tommy_size_t value)
+{
+	if (*ptr != expected)
+		return 0;
+	*ptr = value;
+	return 1;
+}
+#else
+#error "Atomic operations not supported by this compiler. Define TOMMY_SINGLE_THREAD if you use Tommy from a single thread."
+#endif
+
 #endif
@@ -0,0 +1,176 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+#include "tommyulist.h"
+
+/******************************************************************************/
+/* ulist */
+
+TOMMY_API void tommy_ulist_init(tommy_ulist* list, tommy_allocator* alloc)
+{
+	list->head = 0;
+	list->tail = 0;
+	list->alloc = alloc;
+	list->count = 0;
+	list->chunk_count = 0;
+}
+
+TOMMY_API void tommy_ulist_done(tommy_ulist* list)
+{
+	tommy_ulist_chunk* chunk = list->head;
+
+	while (chunk) {
+		tommy_ulist_chunk* next = chunk->next;
+		tommy_allocator_free(list->alloc, chunk);
+		chunk = next;
+	}
+
+	tommy_ulist_init(list, list->alloc);
+}
+
+/**
+ * Allocates a new empty chunk.
+ * \param pos Initial begin and end of the chunk.
+ */
+static tommy_ulist_chunk* ulist_chunk_alloc(tommy_ulist* list, tommy_uint_t pos)
+{
+	tommy_ulist_chunk* chunk = tommy_cast(tommy_ulist_chunk*, tommy_allocator_alloc(list->alloc));
+
+	chunk->begin = pos;
+	chunk->end = pos;
+	chunk->count = 0;
+
+	++list->chunk_count;
+
+	return chunk;
+}
+
+/**
+ * Removes an empty chunk from the list, and frees it.
+ */
+static void ulist_chunk_free(tommy_ulist* list, tommy_ulist_chunk* chunk)
+{
+	if (chunk->prev)
+		chunk->prev->next = chunk->next;
+	else
+		list->head = chunk->next;
+
+	if (chunk->next)
+		chunk->next->prev = chunk->prev;
+	else
+		list->tail = chunk->prev;
+
+	tommy_allocator_free(list->alloc, chunk);
+
+	--list->chunk_count;
+}
+
+TOMMY_API void tommy_ulist_insert_head(tommy_ulist* list, void* data, tommy_ulist_iterator* iterator)
+{
+	tommy_ulist_chunk* chunk = list->head;
+
+	/* if no space at the head, add a new chunk filled from the end */
+	if (!chunk || chunk->begin == 0) {
+		chunk = ulist_chunk_alloc(list, TOMMY_ULIST_SLOT_MAX);
+		chunk->prev = 0;
+		chunk->next = list->head;
+		if (list->head)
+			list->head->prev = chunk;
+		else
+			list->tail = chunk;
+		list->head = chunk;
+	}
+
+	chunk->slot[--chunk->begin] = data;
+	++chunk->count;
+	++list->count;
+
+	if (iterator) {
+		iterator->chunk = chunk;
+		iterator->pos = chunk->begin;
+	}
+}
+
+TOMMY_API void tommy_ulist_insert_tail(tommy_ulist* list, void* data, tommy_ulist_iterator* iterator)
+{
+	tommy_ulist_chunk* chunk = list->tail;
+
+	/* if no space at the tail, add a new chunk filled from the start */
+	if (!chunk || chunk->end == TOMMY_ULIST_SLOT_MAX) {
+		chunk = ulist_chunk_alloc(list, 0);
+		chunk->next = 0;
+		chunk->prev = list->tail;
+		if (list->tail)
+			list->tail->next = chunk;
+		else
+			list->head = chunk;
+		list->tail = chunk;
+	}
+
+	chunk->slot[chunk->end++] = data;
+	++chunk->count;
+	++list->count;
+
+	if (iterator) {
+		iterator->chunk = chunk;
+		iterator->pos = chunk->end - 1;
+	}
+}
+
+/**
+ * Clears a used slot, updating the chunk limits.
+ * The begin and end are moved over the holes, to keep them at a used slot,
+ * and if the chunk becomes empty, it's freed.
+ */
+static void* ulist_chunk_clear(tommy_ulist* list, tommy_ulist_chunk* chunk, tommy_uint_t pos)
+{
+	void* data = chunk->slot[pos];
+
+	chunk->slot[pos] = 0;
+	--chunk->count;
+	--list->count;
+
+	if (chunk->count == 0) {
+		ulist_chunk_free(list, chunk);
+		return data;
+	}
+
+	while (chunk->slot[chunk->begin] == 0)
+		++chunk->begin;
+	while (chunk->slot[chunk->end - 1] == 0)
+		--chunk->end;
+
+	return data;
+}
+
+TOMMY_API void* tommy_ulist_remove_head(tommy_ulist* list)
+{
+	tommy_ulist_chunk* chunk = list->head;
+
+	if (!chunk)
+		return 0;
+
+	/* the begin is always at a used slot */
+	return ulist_chunk_clear(list, chunk, chunk->begin);
+}
+
+TOMMY_API void* tommy_ulist_remove_tail(tommy_ulist* list)
+{
+	tommy_ulist_chunk* chunk = list->tail;
+
+	if (!chunk)
+		return 0;
+
+	/* the end is always after a used slot */
+	return ulist_chunk_clear(list, chunk, chunk->end - 1);
+}
+
+TOMMY_API void* tommy_ulist_remove_existing(tommy_ulist* list, tommy_ulist_iterator* iterator)
+{
+	return ulist_chunk_clear(list, iterator->chunk, iterator->pos);
+}
+
+TOMMY_API tommy_size_t tommy_ulist_memory_usage(tommy_ulist* list)
+{
+	return list->chunk_count * (tommy_size_t)TOMMY_ULIST_BLOCK_SIZE;
+}
@@ -0,0 +1,319 @@
+// SPDX-License-Identifier: BSD-2-Clause
+// Copyright (C) 2010 Andrea Mazzoleni
+
+/** \file
+ * Unrolled list.
+ *
+ * This list stores the pointers to the objects in chunks of ::TOMMY_ULIST_SLOT_MAX
+ * pointers, each one of ::TOMMY_ULIST_BLOCK_SIZE bytes, linked together.
+ *
+ * Compared to ::tommy_list, iterating over the elements requires only one dependent
+ * load for each chunk, instead of one for each element, and the pointers of a chunk
+ * are contiguous in memory, making it a good choice for queues and for scan-heavy workloads.
+ * On the other side, the objects don't contain any node, and a pointer to the object
+ * is not enough to remove it. To remove an element from the middle, you need the
+ * ::tommy_ulist_iterator returned by the insertion, or got iterating the list.
+ *
+ * The chunks are allocated with an external ::tommy_allocator, initialized with
+ * *both* the size and align with TOMMY_ULIST_BLOCK_SIZE.
+ *
+ * \code
+ * tommy_allocator alloc;
+ * tommy_ulist list;
+ *
+ * tommy_allocator_init(&alloc, TOMMY_ULIST_BLOCK_SIZE, TOMMY_ULIST_BLOCK_SIZE);
+ *
+ * tommy_ulist_init(&list, &alloc);
+ * \endcode
+ *
+ * To insert elements in the list you have to call tommy_ulist_insert_tail()
+ * or tommy_ulist_insert_head() for each element, and to remove them
+ * tommy_ulist_remove_head() or tommy_ulist_remove_tail(). All these operations are O(1).
+ * The object pointer cannot be 0, as it's the value used to report an empty list.
+ *
+ * \code
+ * struct object {
+ *     int value;
+ *     // other fields
+ * };
+ *
+ * struct object* obj = malloc(sizeof(struct object)); // creates the object
+ *
+ * obj->value = ...; // initializes the object
+ *
+ * tommy_ulist_insert_tail(&list, obj, 0); // inserts the object
+ *
+ * ...
+ *
+ * obj = tommy_ulist_remove_head(&list); // removes the first object
+ * \endcode
+ *
+ * To iterate over all the elements in the list you have to call
+ * tommy_ulist_begin() and tommy_ulist_next() until 0 is returned.
+ *
+ * \code
+ * tommy_ulist_iterator i;
+ * struct object* obj = tommy_ulist_begin(&list, &i);
+ * while (obj) {
+ *     printf("%d\n", obj->value); // process the object
+ *
+ *     obj = tommy_ulist_next(&i); // go to the next element
+ * }
+ * \endcode
+ *
+ * To remove an element in the middle you have to call tommy_ulist_remove_existing()
+ * with its iterator. The removal leaves a hole in the chunk, which is skipped in the
+ * iteration, and recovered only when the whole chunk is empty.
+ * This keeps valid the iterators of all the other elements, until they are removed.
+ *
+ * To destroy the list you have to call tommy_ulist_done(), or tommy_allocator_done()
+ * if the allocator is used only for this list.
+ *
+ * \code
+ * // deallocates all the objects iterating the list
+ * tommy_ulist_foreach(&list, free);
+ *
+ * // deallocates the list
+ * tommy_ulist_done(&list);
+ * \endcode
+ */
+
+#ifndef __TOMMYULIST_H
+#define __TOMMYULIST_H
+
+#include "tommytypes.h"
+#include "tommyalloc.h"
+
+/******************************************************************************/
+/* ulist */
+
+/**
+ * Size of the memory block of each chunk.
+ * You must use this value to initialize the allocator.
+ */
+#define TOMMY_ULIST_BLOCK_SIZE 256
+
+/**
+ * Number of object pointers in each chunk.
+ */
+#define TOMMY_ULIST_SLOT_MAX ((TOMMY_ULIST_BLOCK_SIZE - 2 * sizeof(void*) - 4 * sizeof(tommy_uint_t)) / sizeof(void*))
+
+/** \internal
+ * Chunk of the list.
+ * The used slots are the ones from begin to end, and some of them may be 0
+ * if removed with tommy_ulist_remove_existing().
+ */
+typedef struct tommy_ulist_chunk_struct {
+	struct tommy_ulist_chunk_struct* next; /**< Next chunk. 0 for the tail. */
+	struct tommy_ulist_chunk_struct* prev; /**< Previous chunk. 0 for the head. */
+	tommy_uint_t begin; /**< Index of the first used slot. */
+	tommy_uint_t end; /**< Index after the last used slot. */
+	tommy_uint_t count; /**< Number of not 0 slots. */
+	void* slot[TOMMY_ULIST_SLOT_MAX]; /**< Object pointers. */
+} tommy_ulist_chunk;
+
+/**
+ * Unrolled list.
+ */
+typedef struct tommy_ulist_struct {
+	tommy_ulist_chunk* head; /**< First chunk. */
+	tommy_ulist_chunk* tail; /**< Last chunk. */
+	tommy_allocator* alloc; /**< Allocator for the chunks. */
+	tommy_size_t count; /**< Number of elements. */
+	tommy_size_t chunk_count; /**< Number of chunks. */
+} tommy_ulist;
+
+/**
+ * Position of an element in the list.
+ * It's used to iterate over the list, and to remove an element from the middle.
+ */
+typedef struct tommy_ulist_iterator_struct {
+	tommy_ulist_chunk* chunk; /**< Chunk of the element. */
+	tommy_uint_t pos; /**< Slot of the element. */
+} tommy_ulist_iterator;
+
+/**
+ * Initializes the list.
+ * You have to provide an allocator initialized with *both* the size and align with TOMMY_ULIST_BLOCK_SIZE.
+ * You can share this allocator with other lists.
+ */
+TOMMY_API void tommy_ulist_init(tommy_ulist* list, tommy_allocator* alloc);
+
+/**
+ * Deinitializes the list, returning all the chunks to the allocator.
+ * The objects are not touched.
+ */
+TOMMY_API void tommy_ulist_done(tommy_ulist* list);
+
+/**
+ * Inserts an element at the head of the list.
+ * \param data The object to insert. It cannot be 0.
+ * \param iterator Where to store the position of the element. It can be 0 if not required.
+ */
+TOMMY_API void tommy_ulist_insert_head(tommy_ulist* list, void* data, tommy_ulist_iterator* iterator);
+
+/**
+ * Inserts an element at the tail of the list.
+ * \param data The object to insert. It cannot be 0.
+ * \param iterator Where to store the position of the element. It can be 0 if not required.
+ */
+TOMMY_API void tommy_ulist_insert_tail(tommy_ulist* list, void* data, tommy_ulist_iterator* iterator);
+
+/**
+ * Removes the element at the head of the list.
+ * \return The removed object, or 0 if the list is empty.
+ */
+TOMMY_API void* tommy_ulist_remove_head(tommy_ulist* list);
+
+/**
+ * Removes the element at the tail of the list.
+ * \return The removed object, or 0 if the list is empty.
+ */
+TOMMY_API void* tommy_ulist_remove_tail(tommy_ulist* list);
+
+/**
+ * Removes an element from the list.
+ * The iterators of the other elements remain valid, but if the chunk becomes empty,
+ * it's freed, and the iterator cannot be used anymore with tommy_ulist_next().
+ * To remove elements while iterating, first advance the iterator with a copy.
+ * \param iterator The position of the element to remove, as returned by the insertion or by the iteration.
+ * \return The removed object.
+ */
+TOMMY_API void* tommy_ulist_remove_existing(tommy_ulist* list, tommy_ulist_iterator* iterator);
+
+/**
+ * Gets the first element of the list.
+ * \param iterator Where to store the position of the element.
+ * \return The first object, or 0 if the list is empty.
+ */
+tommy_inline void* tommy_ulist_begin(tommy_ulist* list, tommy_ulist_iterator* iterator)
+{
+	tommy_ulist_chunk* chunk = list->head;
+
+	while (chunk) {
+		tommy_uint_t pos;
+
+		tommy_prefetch(chunk->next);
+
+		for (pos = chunk->begin; pos < chunk->end; ++pos) {
+			if (chunk->slot[pos]) {
+				iterator->chunk = chunk;
+				iterator->pos = pos;
+				return chunk->slot[pos];
+			}
+		}
+
+		chunk = chunk->next;
+	}
+
+	return 0;
+}
+
+/**
+ * Gets the next element of the list.
+ * \param iterator The position of the current element, updated with the position of the next one.
+ * \return The next object, or 0 at the end of the list.
+ */
+tommy_inline void* tommy_ulist_next(tommy_ulist_iterator* iterator)
+{
+	tommy_ulist_chunk* chunk = iterator->chunk;
+	tommy_uint_t pos = iterator->pos + 1;
+
+	while (1) {
+		for (; pos < chunk->end; ++pos) {
+			if (chunk->slot[pos]) {
+				iterator->chunk = chunk;
+				iterator->pos = pos;
+				return chunk->slot[pos];
+			}
+		}
+
+		chunk = chunk->next;
+		if (!chunk)
+			return 0;
+
+		/* load the chunk after the next one, while processing this */
+		tommy_prefetch(chunk->next);
+
+		pos = chunk->begin;
+	}
+}
+
+/**
+ * Gets the object at the specified position.
+ */
+tommy_inline void* tommy_ulist_get(tommy_ulist_iterator* iterator)
+{
+	return iterator->chunk->slot[iterator->pos];
+}
+
+/**
+ * Gets the number of elements.
+ */
+tommy_inline tommy_size_t tommy_ulist_count(tommy_ulist* list)
+{
+	return list->count;
+}
+
+/**
+ * Checks if empty.
+ * \return If the list is empty.
+ */
+tommy_inline tommy_bool_t tommy_ulist_empty(tommy_ulist* list)
+{
+	return list->count == 0;
+}
+
+/**
+ * Calls the specified function for each element in the list.
+ *
+ * You cannot add or remove elements from the inside of the callback,
+ * but can use it to deallocate them.
+ */
+tommy_inline void tommy_ulist_foreach(tommy_ulist* list, tommy_foreach_func* func)
+{
+	tommy_ulist_chunk* chunk = list->head;
+
+	while (chunk) {
+		tommy_uint_t pos;
+
+		tommy_prefetch(chunk->next);
+
+		for (pos = chunk->begin; pos < chunk->end; ++pos) {
+			void* data = chunk->slot[pos];
+			if (data)
+				func(data);
+		}
+
+		chunk = chunk->next;
+	}
+}
+
+/**
+ * Calls the specified function with an argument for each element in the list.
+ */
+tommy_inline void tommy_ulist_foreach_arg(tommy_ulist* list, tommy_foreach_arg_func* func, void* arg)
+{
+	tommy_ulist_chunk* chunk = list->head;
+
+	while (chunk) {
+		tommy_uint_t pos;
+
+		tommy_prefetch(chunk->next);
+
+		for (pos = chunk->begin; pos < chunk->end; ++pos) {
+			void* data = chunk->slot[pos];
+			if (data)
+				func(arg, data);
+		}
+
+		chunk = chunk->next;
+	}
+}
+
+/**
+ * Gets the size of allocated memory.
+ */
+TOMMY_API tommy_size_t tommy_ulist_memory_usage(tommy_ulist* list);
+
+#endif